@@ -0,0 +1,68 @@
+#include "log.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+
+namespace common {
+
+namespace {
+
+std::atomic<int> min_level{static_cast<int>(LogLevel::Info)};
+std::mutex output_mutex;
+
+} // namespace
+
+LogLevel parse_log_level(const std::string& name) {
+    if (name == "debug") return LogLevel::Debug;
+    if (name == "info") return LogLevel::Info;
+    if (name == "warn") return LogLevel::Warn;
+    if (name == "error") return LogLevel::Error;
+    throw std::invalid_argument("Unknown log level: " + name + " (expected debug, info, warn or error)");
+}
+
+void set_log_level(LogLevel level) {
+    min_level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void set_log_level_from_env(const char* variable) {
+    const char* env = std::getenv(variable);
+    if (!env) return;
+    try {
+        set_log_level(parse_log_level(env));
+    } catch (const std::invalid_argument& e) {
+        set_log_level(LogLevel::Info);
+        LOG(Warn) << variable << ": " << e.what() << ", using info";
+    }
+}
+
+bool log_enabled(LogLevel level) {
+    return static_cast<int>(level) >= min_level.load(std::memory_order_relaxed);
+}
+
+bool RateLimiter::allow() {
+    int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                      std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t current = window.load(std::memory_order_relaxed);
+    // The first caller of a new second restarts the count; racing callers may each get a line through
+    if (current != now && window.compare_exchange_strong(current, now, std::memory_order_relaxed)) {
+        in_window.store(0, std::memory_order_relaxed);
+    }
+    if (in_window.fetch_add(1, std::memory_order_relaxed) < per_second) return true;
+    suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+LogLine::~LogLine() {
+    if (suppressed > 0) out << " (" << suppressed << " similar lines suppressed)";
+    out << '\n';
+    std::string line = out.str();
+    std::ostream& stream = level >= LogLevel::Warn ? std::cerr : std::cout;
+    std::lock_guard<std::mutex> lock(output_mutex);
+    stream.write(line.data(), static_cast<std::streamsize>(line.size()));
+    stream.flush();
+}
+
+} // namespace common
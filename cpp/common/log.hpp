@@ -0,0 +1,76 @@
+#ifndef COMMON_LOG_HPP
+#define COMMON_LOG_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace common {
+
+enum class LogLevel { Debug = 0, Info, Warn, Error };
+
+// "debug", "info", "warn" or "error". Throws std::invalid_argument otherwise.
+LogLevel parse_log_level(const std::string& name);
+
+// Lines below the level are dropped before they are formatted. Info by default.
+void set_log_level(LogLevel level);
+bool log_enabled(LogLevel level);
+
+// Sets the level named by the environment variable (see parse_log_level()). Unset, it stays info; an
+// unknown name is reported and falls back to info rather than stopping the service.
+void set_log_level_from_env(const char* variable = "LOG_LEVEL");
+
+// Lets through at most `per_second` events per second and counts the others. Lock-free; thread-safe.
+class RateLimiter {
+public:
+    explicit RateLimiter(uint32_t per_second) : per_second(per_second) {}
+
+    bool allow();
+    // Events refused since the last call.
+    uint64_t take_suppressed() { return suppressed.exchange(0, std::memory_order_relaxed); }
+
+private:
+    const uint32_t per_second;
+    std::atomic<int64_t> window{-1};  // Second the count is for
+    std::atomic<uint32_t> in_window{0};
+    std::atomic<uint64_t> suppressed{0};
+};
+
+// One log line, written whole (and flushed) when it goes out of scope: to stdout up to Info, to stderr
+// from Warn. Lines from different threads never interleave.
+class LogLine {
+public:
+    explicit LogLine(LogLevel level, uint64_t suppressed = 0) : level(level), suppressed(suppressed) {}
+    ~LogLine();
+
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    std::ostringstream& stream() { return out; }
+
+private:
+    LogLevel level;
+    uint64_t suppressed;  // Lines of the same call site dropped by its rate limit, noted at the end
+    std::ostringstream out;
+};
+
+} // namespace common
+
+// LOG(Info) << "Connected to " << host;
+// The arguments are only evaluated when the level is enabled.
+#define LOG(level)                                                        \
+    if (!::common::log_enabled(::common::LogLevel::level)) {              \
+    } else                                                                \
+        ::common::LogLine(::common::LogLevel::level).stream()
+
+// LOG_RATE_LIMITED(Warn, 10) << "Failed to fetch " << url;
+// For lines logged per document: each call site prints at most `per_second` lines a second, and the
+// next line it prints says how many were dropped.
+#define LOG_RATE_LIMITED(level, per_second)                                             \
+    if (!::common::log_enabled(::common::LogLevel::level)) {                            \
+    } else if (static ::common::RateLimiter log_limiter_(per_second); !log_limiter_.allow()) { \
+    } else                                                                              \
+        ::common::LogLine(::common::LogLevel::level, log_limiter_.take_suppressed()).stream()
+
+#endif // COMMON_LOG_HPP
@@ -0,0 +1,267 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace common {
+
+namespace {
+
+const int ACCEPT_POLL_MS = 200;          // How quickly the server notices it is stopping
+const int CLIENT_TIMEOUT_SECONDS = 2;    // A scraper that stalls does not hold the server longer
+const size_t MAX_REQUEST_BYTES = 8192;
+
+bool valid_name(const std::string& name) {
+    size_t end = name.find('{');
+    if (name.empty() || end == 0 || (end != std::string::npos && name.back() != '}')) return false;
+    for (size_t i = 0; i < std::min(end, name.size()); ++i) {
+        char c = name[i];
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':' || (i > 0 && c >= '0' && c <= '9');
+        if (!ok) return false;
+    }
+    return true;
+}
+
+// Up to 12 significant digits: exact for the bucket bounds, microseconds for sums in seconds.
+std::string format_double(double value) {
+    std::ostringstream out;
+    out.precision(12);
+    out << value;
+    return out.str();
+}
+
+void write_all(int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        written += static_cast<size_t>(n);
+    }
+}
+
+} // namespace
+
+size_t metric_shard() {
+    static std::atomic<size_t> next_thread{0};
+    thread_local size_t shard = next_thread.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    return shard;
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const Slot& slot : slots) total += slot.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+size_t Histogram::bucket_index(uint64_t value) {
+    if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+    int msb = 63 - __builtin_clzll(value);
+    if (msb >= MAX_BITS) return BUCKETS - 1;
+    int shift = msb - SUB_BUCKET_BITS;
+    return static_cast<size_t>((shift + 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS));
+}
+
+uint64_t Histogram::bucket_lower(size_t index) {
+    if (index < SUB_BUCKETS) return index;
+    int shift = static_cast<int>(index / SUB_BUCKETS) - 1;
+    return (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+}
+
+uint64_t Histogram::bucket_upper(size_t index) {
+    if (index < SUB_BUCKETS) return index;
+    int shift = static_cast<int>(index / SUB_BUCKETS) - 1;
+    return bucket_lower(index) + (uint64_t(1) << shift) - 1;
+}
+
+void Histogram::record(uint64_t value) {
+    Slot& slot = slots[metric_shard()];
+    slot.buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    slot.sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot snapshot;
+    snapshot.buckets.assign(BUCKETS, 0);
+    for (const Slot& slot : slots) {
+        for (size_t i = 0; i < BUCKETS; ++i) snapshot.buckets[i] += slot.buckets[i].load(std::memory_order_relaxed);
+        snapshot.sum += slot.sum.load(std::memory_order_relaxed);
+    }
+    // From the buckets, so the count always matches them
+    for (uint64_t n : snapshot.buckets) snapshot.count += n;
+    return snapshot;
+}
+
+uint64_t Histogram::Snapshot::quantile(double q) const {
+    if (count == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count)));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) return bucket_upper(i);
+    }
+    return bucket_upper(buckets.size() - 1);
+}
+
+uint64_t Histogram::Snapshot::count_below(uint64_t bound) const {
+    uint64_t below = 0;
+    for (size_t i = 0; i < buckets.size() && bucket_upper(i) < bound; ++i) below += buckets[i];
+    return below;
+}
+
+MetricsRegistry::Entry& MetricsRegistry::find_or_add(const std::string& name, const std::string& help, Type type,
+                                                     double unit) {
+    if (!valid_name(name) || (type == Type::Histogram && name.find('{') != std::string::npos)) {
+        throw std::invalid_argument("Invalid metric name: " + name);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : entries) {
+        if (entry->name != name) continue;
+        if (entry->type != type) throw std::invalid_argument("Metric registered with another type: " + name);
+        return *entry;
+    }
+    auto entry = std::make_unique<Entry>();
+    entry->name = name;
+    entry->family = name.substr(0, name.find('{'));
+    entry->help = help;
+    entry->type = type;
+    entry->unit = unit;
+    if (type == Type::Counter) entry->counter = std::make_unique<Counter>();
+    if (type == Type::Gauge) entry->gauge = std::make_unique<Gauge>();
+    if (type == Type::Histogram) entry->histogram = std::make_unique<Histogram>();
+    entries.push_back(std::move(entry));
+    return *entries.back();
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help) {
+    return *find_or_add(name, help, Type::Counter, 1.0).counter;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help) {
+    return *find_or_add(name, help, Type::Gauge, 1.0).gauge;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help, double unit) {
+    return *find_or_add(name, help, Type::Histogram, unit).histogram;
+}
+
+std::string MetricsRegistry::render() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ostringstream out;
+    std::vector<const std::string*> described;
+    for (const auto& entry : entries) {
+        bool seen = std::any_of(described.begin(), described.end(), [&](const std::string* f) { return *f == entry->family; });
+        if (!seen) {
+            static const char* const TYPES[] = {"counter", "gauge", "histogram"};
+            out << "# HELP " << entry->family << ' ' << entry->help << '\n'
+                << "# TYPE " << entry->family << ' ' << TYPES[static_cast<int>(entry->type)] << '\n';
+            described.push_back(&entry->family);
+        }
+        switch (entry->type) {
+        case Type::Counter:
+            out << entry->name << ' ' << entry->counter->value() << '\n';
+            break;
+        case Type::Gauge:
+            out << entry->name << ' ' << entry->gauge->value() << '\n';
+            break;
+        case Type::Histogram: {
+            Histogram::Snapshot snapshot = entry->histogram->snapshot();
+            // `le` is inclusive: the bucket of values below 2^k is labelled with the largest of them
+            for (int bits = 0; bits <= Histogram::MAX_BITS; bits += 2) {
+                uint64_t bound = uint64_t(1) << bits;
+                out << entry->name << "_bucket{le=\"" << format_double(static_cast<double>(bound - 1) * entry->unit)
+                    << "\"} " << snapshot.count_below(bound) << '\n';
+            }
+            out << entry->name << "_bucket{le=\"+Inf\"} " << snapshot.count << '\n'
+                << entry->name << "_sum " << format_double(static_cast<double>(snapshot.sum) * entry->unit) << '\n'
+                << entry->name << "_count " << snapshot.count << '\n';
+            break;
+        }
+        }
+    }
+    return out.str();
+}
+
+MetricsRegistry& metrics() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsServer::MetricsServer(const MetricsRegistry& registry, int port) : registry(registry) {
+    listen_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) throw std::runtime_error(std::string("socket failed: ") + std::strerror(errno));
+    int reuse = 1;
+    ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    socklen_t length = sizeof(address);
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listen_fd, 16) != 0 ||
+        ::getsockname(listen_fd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        std::string error = std::strerror(errno);
+        ::close(listen_fd);
+        throw std::runtime_error("Cannot serve metrics on port " + std::to_string(port) + ": " + error);
+    }
+    port_ = ntohs(address.sin_port);
+    thread = std::thread(&MetricsServer::serve, this);
+}
+
+MetricsServer::~MetricsServer() {
+    stopping = true;
+    thread.join();
+    ::close(listen_fd);
+}
+
+void MetricsServer::serve() {
+    while (!stopping) {
+        pollfd listener{listen_fd, POLLIN, 0};
+        if (::poll(&listener, 1, ACCEPT_POLL_MS) <= 0) continue;
+        int client = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) continue;
+        handle(client);
+        ::close(client);
+    }
+}
+
+void MetricsServer::handle(int client) {
+    timeval timeout{CLIENT_TIMEOUT_SECONDS, 0};
+    ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // Only the request line matters; read until the end of the headers
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.find("\n\n") == std::string::npos &&
+           request.size() < MAX_REQUEST_BYTES) {
+        ssize_t n = ::recv(client, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        request.append(buffer, static_cast<size_t>(n));
+    }
+
+    std::string request_line = request.substr(0, request.find_first_of("\r\n"));
+    bool metrics_path = request_line.rfind("GET /metrics ", 0) == 0 || request_line.rfind("GET /metrics?", 0) == 0 ||
+                        request_line == "GET /metrics";
+    std::string body = metrics_path ? registry.render() : "Not found\n";
+    std::string response = std::string(metrics_path ? "HTTP/1.0 200 OK\r\n" : "HTTP/1.0 404 Not Found\r\n") +
+                           "Content-Type: " + (metrics_path ? "text/plain; version=0.0.4" : "text/plain") + "\r\n" +
+                           "Content-Length: " + std::to_string(body.size()) + "\r\n" +
+                           "Connection: close\r\n\r\n" + body;
+    write_all(client, response);
+}
+
+} // namespace common
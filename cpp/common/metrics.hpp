@@ -0,0 +1,172 @@
+#ifndef COMMON_METRICS_HPP
+#define COMMON_METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace common {
+
+// Metrics shared by every thread are split into METRIC_SHARDS cache-line-sized slots. Each thread
+// updates its own slot (threads are dealt slots round-robin on first use) with relaxed atomic adds,
+// so the hot path takes no lock and threads do not contend on a line until there are more of them
+// than slots. Reading a value sums the slots.
+const size_t METRIC_SHARDS = 16;
+
+// Slot of the calling thread, in [0, METRIC_SHARDS).
+size_t metric_shard();
+
+// Monotonic count, e.g. of documents or bytes.
+class Counter {
+public:
+    void add(uint64_t n = 1) { slots[metric_shard()].value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Slot, METRIC_SHARDS> slots;
+};
+
+// Value that goes up and down, e.g. a queue length. Set by one owner, so a single atomic suffices.
+class Gauge {
+public:
+    void set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+    void add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+// HDR-style histogram of non-negative integers (microseconds, bytes): 16 linear sub-buckets per power
+// of two, so any recorded value is known to within 1/16 (6.25%) over the whole range, from 1 to 2^40,
+// in fixed memory and without knowing the range up front. Values from 2^40 on count as 2^40 - 1.
+class Histogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAX_BITS = 40;
+    static constexpr size_t BUCKETS = (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    void record(uint64_t value);
+
+    // Bucket of `value`, and the range [lower, upper] of the values sharing it.
+    static size_t bucket_index(uint64_t value);
+    static uint64_t bucket_lower(size_t index);
+    static uint64_t bucket_upper(size_t index);
+
+    // Merged view of every thread's slot. Concurrent records may or may not be included.
+    struct Snapshot {
+        std::vector<uint64_t> buckets;  // BUCKETS counts
+        uint64_t count = 0;
+        uint64_t sum = 0;
+
+        // Highest value that may share a bucket with the value at quantile `q` (0..1); 0 if empty.
+        uint64_t quantile(double q) const;
+        // Recorded values below `bound`; exact when `bound` is a power of two.
+        uint64_t count_below(uint64_t bound) const;
+    };
+    Snapshot snapshot() const;
+
+private:
+    struct alignas(64) Slot {
+        std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+        std::atomic<uint64_t> sum{0};
+    };
+    std::array<Slot, METRIC_SHARDS> slots;
+};
+
+// Records the time from construction to destruction into `histogram`, in microseconds.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram) : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { histogram.record(micros_since(start)); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    static uint64_t micros_since(std::chrono::steady_clock::time_point start) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                         std::chrono::steady_clock::now() - start).count());
+    }
+
+private:
+    Histogram& histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Named metrics of a process, rendered in the Prometheus text format. Metrics are created once (at
+// startup, typically into globals) and live as long as the registry, so references to them stay valid.
+// Counter and gauge names may carry a label set, e.g. `queue_length{stage="parse"}`; every metric of one
+// name shares its HELP line. All methods are thread-safe.
+class MetricsRegistry {
+public:
+    // Asking again for a name returns the same metric. Throws std::invalid_argument if the name is
+    // malformed or already registered as another type.
+    Counter& counter(const std::string& name, const std::string& help);
+    Gauge& gauge(const std::string& name, const std::string& help);
+    // Exported in base units: recorded values times `unit` (1e-6 for microseconds to seconds, 1 for bytes).
+    // Exported buckets end just below the powers of four up to 2^40: `le` is 4^k - 1, inclusive, as in Prometheus.
+    Histogram& histogram(const std::string& name, const std::string& help, double unit = 1e-6);
+
+    // Text exposition format 0.0.4, metrics in registration order.
+    std::string render() const;
+
+private:
+    enum class Type { Counter, Gauge, Histogram };
+    struct Entry {
+        std::string name;    // With labels, if any
+        std::string family;  // Name without labels
+        std::string help;
+        Type type;
+        double unit;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+    Entry& find_or_add(const std::string& name, const std::string& help, Type type, double unit);
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<Entry>> entries;
+};
+
+// The process-wide registry.
+MetricsRegistry& metrics();
+
+// Serves GET /metrics (the registry's render()) over HTTP/1.0 on its own thread, one connection at a time.
+// Anything else gets a 404.
+class MetricsServer {
+public:
+    // Listens on all interfaces; port 0 picks a free one. Throws std::runtime_error if it cannot listen.
+    MetricsServer(const MetricsRegistry& registry, int port);
+    // Stops accepting and joins the thread.
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    int port() const { return port_; }
+
+private:
+    void serve();
+    void handle(int client);
+
+    const MetricsRegistry& registry;
+    int listen_fd = -1;
+    int port_ = 0;
+    std::atomic<bool> stopping{false};
+    std::thread thread;
+};
+
+} // namespace common
+
+#endif // COMMON_METRICS_HPP
@@ -0,0 +1,221 @@
+#include "../metrics.hpp"
+#include "../log.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Simple assertion macro
+#define ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "Assertion failed: " << (message) << "\n" \
+                      << "File: " << __FILE__ << ", Line: " << __LINE__ << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+bool contains(const std::string& text, const std::string& part) {
+    return text.find(part) != std::string::npos;
+}
+
+// --- Test: counters from many threads ---
+void test_counter_threads() {
+    common::Counter counter;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 24; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 10000; ++i) counter.add();
+            counter.add(5);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    ASSERT(counter.value() == 24 * 10005, "No increment should be lost");
+    std::cout << "test_counter_threads passed" << std::endl;
+}
+
+// --- Test: histogram buckets and quantiles ---
+void test_histogram_buckets() {
+    using common::Histogram;
+    for (uint64_t v = 0; v < 100000; ++v) {
+        size_t i = Histogram::bucket_index(v);
+        ASSERT(Histogram::bucket_lower(i) <= v && v <= Histogram::bucket_upper(i), "A value should fall in its bucket");
+        ASSERT(Histogram::bucket_upper(i) - Histogram::bucket_lower(i) <= v / Histogram::SUB_BUCKETS,
+               "Buckets should be within 1/16 of their values");
+        if (v > 0) ASSERT(i == Histogram::bucket_index(v - 1) || i == Histogram::bucket_index(v - 1) + 1, "Buckets should be contiguous");
+    }
+    ASSERT(Histogram::bucket_upper(Histogram::BUCKETS - 1) == (uint64_t(1) << Histogram::MAX_BITS) - 1,
+           "The last bucket should end at 2^40");
+    ASSERT(Histogram::bucket_index(UINT64_MAX) == Histogram::BUCKETS - 1, "Huge values should be clamped");
+
+    Histogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (uint64_t v = 1 + t; v <= 10000; v += 4) histogram.record(v);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    Histogram::Snapshot snapshot = histogram.snapshot();
+    ASSERT(snapshot.count == 10000 && snapshot.sum == 10000ULL * 10001 / 2, "Every value should be counted once");
+    for (double q : {0.5, 0.95, 0.99}) {
+        double exact = q * 10000;
+        double estimate = static_cast<double>(snapshot.quantile(q));
+        ASSERT(estimate >= exact && estimate <= exact * (1 + 1.0 / 16) + 1, "Quantiles should be within 1/16");
+    }
+    ASSERT(snapshot.quantile(0) == 1 && snapshot.count_below(1024) == 1023, "Small values should be exact");
+    ASSERT(Histogram().snapshot().quantile(0.5) == 0, "An empty histogram has no quantiles");
+    std::cout << "test_histogram_buckets passed" << std::endl;
+}
+
+// --- Test: Prometheus text format ---
+void test_render() {
+    common::MetricsRegistry registry;
+    registry.counter("docs_total", "Documents").add(3);
+    ASSERT(&registry.counter("docs_total", "Documents") == &registry.counter("docs_total", "Documents"),
+           "Names should map to one metric");
+    registry.gauge("queued{stage=\"read\"}", "Queued documents").set(7);
+    registry.gauge("queued{stage=\"parse\"}", "Queued documents").set(-2);
+    common::Histogram& latency = registry.histogram("latency_seconds", "Latency");
+    latency.record(3);        // 3 us
+    latency.record(2000000);  // 2 s
+
+    std::string text = registry.render();
+    ASSERT(contains(text, "# HELP docs_total Documents\n# TYPE docs_total counter\ndocs_total 3\n"), text);
+    ASSERT(contains(text, "# TYPE queued gauge\nqueued{stage=\"read\"} 7\nqueued{stage=\"parse\"} -2\n"),
+           "Labelled metrics should share their family's header: " + text);
+    ASSERT(text.find("# TYPE queued") == text.rfind("# TYPE queued"), "Families should be described once");
+    // A value equal to a bound (3 us) counts in that bucket
+    ASSERT(contains(text, "latency_seconds_bucket{le=\"0\"} 0\n") && contains(text, "latency_seconds_bucket{le=\"3e-06\"} 1\n") &&
+           contains(text, "latency_seconds_bucket{le=\"1.048575\"} 1\n") && contains(text, "latency_seconds_bucket{le=\"4.194303\"} 2\n") &&
+           contains(text, "latency_seconds_bucket{le=\"+Inf\"} 2\n") && contains(text, "latency_seconds_sum 2.000003\n") &&
+           contains(text, "latency_seconds_count 2\n"),
+           "Histograms should be cumulative and in seconds: " + text);
+
+    for (auto bad : {"", "9lives", "has space", "{x=\"1\"}"}) {
+        bool threw = false;
+        try {
+            registry.counter(bad, "");
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        ASSERT(threw, std::string("Malformed names should be rejected: ") + bad);
+    }
+    bool threw = false;
+    try {
+        registry.gauge("docs_total", "Documents");
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ASSERT(threw, "A name should keep its type");
+    std::cout << "test_render passed" << std::endl;
+}
+
+std::string http_get(int port, const std::string& path) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    ASSERT(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0, "Should connect to the server");
+    std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ASSERT(send(fd, request.data(), request.size(), 0) == static_cast<ssize_t>(request.size()), "Should send the request");
+    std::string response;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) response.append(buffer, static_cast<size_t>(n));
+    close(fd);
+    return response;
+}
+
+// --- Test: HTTP endpoint ---
+void test_server() {
+    common::MetricsRegistry registry;
+    common::Counter& requests = registry.counter("requests_total", "Requests");
+    common::MetricsServer server(registry, 0);
+    ASSERT(server.port() > 0, "Port 0 should pick a free port");
+
+    requests.add(41);
+    std::string response = http_get(server.port(), "/metrics");
+    ASSERT(response.rfind("HTTP/1.0 200 OK\r\n", 0) == 0 && contains(response, "text/plain; version=0.0.4") &&
+           contains(response, "\r\n\r\n# HELP requests_total Requests\n") && contains(response, "requests_total 41\n"),
+           "GET /metrics should return the registry: " + response);
+    requests.add();
+    ASSERT(contains(http_get(server.port(), "/metrics"), "requests_total 42\n"), "Every scrape should be current");
+    ASSERT(http_get(server.port(), "/").rfind("HTTP/1.0 404", 0) == 0, "Other paths should be 404");
+    std::cout << "test_server passed" << std::endl;
+}
+
+// --- Test: log levels and rate limits ---
+void test_logging() {
+    ASSERT(common::parse_log_level("debug") == common::LogLevel::Debug &&
+           common::parse_log_level("error") == common::LogLevel::Error, "Level names should parse");
+    bool threw = false;
+    try {
+        common::parse_log_level("verbose");
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ASSERT(threw, "Unknown levels should be rejected");
+
+    common::set_log_level(common::LogLevel::Warn);
+    ASSERT(!common::log_enabled(common::LogLevel::Info) && common::log_enabled(common::LogLevel::Error),
+           "Levels below the threshold should be off");
+    int evaluated = 0;
+    auto count = [&] { return ++evaluated; };
+    LOG(Info) << "hidden " << count();
+    ASSERT(evaluated == 0, "Disabled lines should not evaluate their arguments");
+    common::set_log_level(common::LogLevel::Info);
+
+    ::unsetenv("TEST_LOG_LEVEL");
+    common::set_log_level_from_env("TEST_LOG_LEVEL");
+    ASSERT(common::log_enabled(common::LogLevel::Info), "An unset variable should keep the level");
+    ::setenv("TEST_LOG_LEVEL", "error", 1);
+    common::set_log_level_from_env("TEST_LOG_LEVEL");
+    ASSERT(!common::log_enabled(common::LogLevel::Warn), "The variable should set the level");
+    ::setenv("TEST_LOG_LEVEL", "verbose", 1);
+    common::set_log_level_from_env("TEST_LOG_LEVEL");
+    ASSERT(common::log_enabled(common::LogLevel::Info) && !common::log_enabled(common::LogLevel::Debug),
+           "An unknown level should fall back to info");
+    ::unsetenv("TEST_LOG_LEVEL");
+
+    common::RateLimiter limiter(5);
+    int allowed = 0;
+    for (int i = 0; i < 1000; ++i) allowed += limiter.allow();
+    // The loop may straddle a second boundary
+    ASSERT(allowed == 5 || allowed == 10, "At most 5 a second should get through");
+    ASSERT(limiter.take_suppressed() == static_cast<uint64_t>(1000 - allowed) && limiter.take_suppressed() == 0,
+           "Refused events should be counted once");
+
+    for (int i = 0; i < 100; ++i) {
+        LOG_RATE_LIMITED(Debug, 1) << "never " << count();
+    }
+    ASSERT(evaluated == 0, "Rate-limited lines below the level should not evaluate their arguments");
+    for (int i = 0; i < 100; ++i) {
+        LOG_RATE_LIMITED(Info, 2) << "rate-limited line " << count();
+    }
+    ASSERT(evaluated == 2 || evaluated == 4, "A call site should only format the lines it prints");
+    std::cout << "test_logging passed" << std::endl;
+}
+
+int main() {
+    try {
+        test_counter_threads();
+        test_histogram_buckets();
+        test_render();
+        test_server();
+        test_logging();
+        std::cout << "All tests passed!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include "../src/warc_writer.hpp"
+#include "../../indexer/bench/synthetic_corpus.hpp"
+
+#include <benchmark/benchmark.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+const bench::SyntheticCorpus& corpus() {
+    static const bench::SyntheticCorpus instance;
+    return instance;
+}
+
+const size_t PAGES = 64;
+
+const std::vector<std::string>& pages() {
+    static const std::vector<std::string> cache = [] {
+        std::vector<std::string> out;
+        for (size_t i = 0; i < PAGES; ++i) out.push_back(corpus().page(i));
+        return out;
+    }();
+    return cache;
+}
+
+int64_t average_page_bytes() {
+    size_t bytes = 0;
+    for (const std::string& page : pages()) bytes += page.size();
+    return static_cast<int64_t>(bytes / PAGES);
+}
+
+std::string temp_warc(const char* name) {
+    return "/tmp/" + std::string(name) + "_" + std::to_string(getpid()) + ".warc.gz";
+}
+
+} // namespace
+
+// compress_record() is the header plus compress_string(), with the thread's reused deflate state.
+// Arg: zlib level.
+static void BM_CompressRecord(benchmark::State& state) {
+    std::string path = temp_warc("bench_compress");
+    crawler::WarcWriterOptions options;
+    options.compression_level = static_cast<int>(state.range(0));
+    {
+        crawler::WarcWriter writer(path, options);
+        size_t i = 0;
+        size_t compressed = 0;
+        for (auto _ : state) {
+            std::string record = writer.compress_record(corpus().url(i), pages()[i % PAGES]);
+            compressed += record.size();
+            benchmark::DoNotOptimize(record.data());
+            ++i;
+        }
+        state.SetBytesProcessed(state.iterations() * average_page_bytes());
+        state.counters["ratio"] = static_cast<double>(state.iterations() * average_page_bytes()) /
+                                  static_cast<double>(compressed ? compressed : 1);
+    }
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_CompressRecord)->Arg(1)->Arg(6)->Arg(9);
+
+// The whole write path into the buffer and the file, without syncing. Arg: threads writing.
+static void BM_WarcWriterWriteRecord(benchmark::State& state) {
+    static crawler::WarcWriter* writer = nullptr;
+    static std::string path;
+    if (state.thread_index() == 0) {
+        path = temp_warc("bench_write");
+        crawler::WarcWriterOptions options;
+        options.durability = crawler::WarcDurability::None;
+        writer = new crawler::WarcWriter(path, options);
+    }
+    size_t i = static_cast<size_t>(state.thread_index());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(writer->write_record(corpus().url(i), pages()[i % PAGES]));
+        i += static_cast<size_t>(state.threads());
+    }
+    state.SetBytesProcessed(state.iterations() * average_page_bytes());
+    if (state.thread_index() == 0) {
+        delete writer;
+        std::remove(path.c_str());
+    }
+}
+BENCHMARK(BM_WarcWriterWriteRecord)->Threads(1)->Threads(4)->UseRealTime();
+
+BENCHMARK_MAIN();
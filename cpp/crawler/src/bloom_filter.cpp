@@ -0,0 +1,114 @@
+#include "bloom_filter.hpp"
+#include "hash.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+namespace crawler {
+
+namespace {
+
+const char FILE_MAGIC[4] = {'S', 'E', 'B', 'F'};
+const uint32_t FILE_VERSION = 1;
+
+// Odd constants from the Parquet split-block Bloom filter spec; each picks one bit in one word.
+const uint32_t SALT[8] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+};
+
+} // namespace
+
+BloomFilter::BloomFilter(size_t expected_items, double bits_per_item) {
+    double total_bits = std::max(1.0, static_cast<double>(expected_items) * bits_per_item);
+    size_t num_blocks = static_cast<size_t>(std::ceil(total_bits / (sizeof(Block) * 8)));
+    blocks.assign(std::max<size_t>(1, num_blocks), Block{});
+}
+
+size_t BloomFilter::block_index(uint64_t hash) const {
+    // Map the high 32 bits onto [0, blocks.size()) without a modulo
+    return static_cast<size_t>(((hash >> 32) * static_cast<uint64_t>(blocks.size())) >> 32);
+}
+
+BloomFilter::Block BloomFilter::block_mask(uint64_t hash) {
+    Block mask;
+    uint32_t key = static_cast<uint32_t>(hash);
+    for (int i = 0; i < 8; ++i) {
+        mask.words[i] = 1U << ((key * SALT[i]) >> 27);
+    }
+    return mask;
+}
+
+void BloomFilter::insert(std::string_view key) {
+    uint64_t hash = hash64(key);
+    Block& block = blocks[block_index(hash)];
+    Block mask = block_mask(hash);
+    for (int i = 0; i < 8; ++i) {
+        block.words[i] |= mask.words[i];
+    }
+    item_count++;
+}
+
+bool BloomFilter::possibly_contains(std::string_view key) const {
+    uint64_t hash = hash64(key);
+    const Block& block = blocks[block_index(hash)];
+    Block mask = block_mask(hash);
+    for (int i = 0; i < 8; ++i) {
+        if ((block.words[i] & mask.words[i]) == 0) return false;
+    }
+    return true;
+}
+
+void BloomFilter::save(const std::string& path) const {
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            throw std::runtime_error("Failed to open Bloom filter file for writing: " + tmp_path);
+        }
+        uint64_t num_blocks = blocks.size();
+        out.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+        out.write(reinterpret_cast<const char*>(&FILE_VERSION), sizeof(FILE_VERSION));
+        out.write(reinterpret_cast<const char*>(&num_blocks), sizeof(num_blocks));
+        out.write(reinterpret_cast<const char*>(&item_count), sizeof(item_count));
+        out.write(reinterpret_cast<const char*>(blocks.data()), static_cast<std::streamsize>(size_bytes()));
+        out.flush();
+        if (!out.good()) {
+            throw std::runtime_error("Failed to write Bloom filter file: " + tmp_path);
+        }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Failed to replace Bloom filter file: " + path);
+    }
+}
+
+BloomFilter BloomFilter::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("Failed to open Bloom filter file: " + path);
+    }
+
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t num_blocks = 0;
+    BloomFilter filter;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    in.read(reinterpret_cast<char*>(&num_blocks), sizeof(num_blocks));
+    in.read(reinterpret_cast<char*>(&filter.item_count), sizeof(filter.item_count));
+    if (!in.good() || std::char_traits<char>::compare(magic, FILE_MAGIC, sizeof(magic)) != 0 ||
+        version != FILE_VERSION || num_blocks == 0) {
+        throw std::runtime_error("Invalid Bloom filter file: " + path);
+    }
+
+    filter.blocks.resize(num_blocks);
+    in.read(reinterpret_cast<char*>(filter.blocks.data()), static_cast<std::streamsize>(filter.size_bytes()));
+    if (in.gcount() != static_cast<std::streamsize>(filter.size_bytes())) {
+        throw std::runtime_error("Truncated Bloom filter file: " + path);
+    }
+    return filter;
+}
+
+} // namespace crawler
@@ -0,0 +1,74 @@
+#ifndef BLOOM_FILTER_HPP
+#define BLOOM_FILTER_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace crawler {
+
+/**
+ * @brief Split-block Bloom filter for approximate set membership.
+ *
+ * Keys map to a single 32-byte block (half a cache line) and set one bit in each of the
+ * block's eight 32-bit words. Blocks are 32-byte aligned, so none straddles two lines and
+ * every lookup touches exactly one cache line. At 10 bits
+ * per key the false-positive rate is roughly 1%. There are no false negatives.
+ *
+ * @note This class is not thread-safe.
+ */
+class BloomFilter {
+public:
+    /**
+     * @brief Creates an empty filter sized for the expected number of keys.
+     * @param expected_items Number of keys the filter should hold at the target accuracy.
+     * @param bits_per_item Memory budget per key; 10 gives ~1% false positives, 16 gives ~0.1%.
+     */
+    explicit BloomFilter(size_t expected_items, double bits_per_item = 10.0);
+
+    /**
+     * @brief Adds a key to the set.
+     */
+    void insert(std::string_view key);
+
+    /**
+     * @brief Tests a key for membership.
+     * @return false if the key was definitely never inserted, true if it probably was.
+     */
+    bool possibly_contains(std::string_view key) const;
+
+    /**
+     * @brief Atomically replaces the file at `path` with the filter contents (write to temp, then rename).
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void save(const std::string& path) const;
+
+    /**
+     * @brief Loads a filter previously written by save().
+     * @throws std::runtime_error if the file is missing, truncated or not a filter file.
+     */
+    static BloomFilter load(const std::string& path);
+
+    size_t size_bytes() const { return blocks.size() * sizeof(Block); }
+    uint64_t inserted_count() const { return item_count; }
+
+private:
+    // Aligned to its size: std::vector allocates over-aligned types with aligned new (C++17)
+    struct alignas(32) Block {
+        uint32_t words[8];
+    };
+    static_assert(sizeof(Block) == 32, "Blocks are saved as 32 raw bytes");
+
+    BloomFilter() = default;
+
+    size_t block_index(uint64_t hash) const;
+    static Block block_mask(uint64_t hash);
+
+    std::vector<Block> blocks;
+    uint64_t item_count = 0;
+};
+
+} // namespace crawler
+
+#endif // BLOOM_FILTER_HPP
@@ -0,0 +1,155 @@
+#include "crawl_state_writer.hpp"
+
+#include <algorithm>
+
+namespace crawler {
+
+namespace {
+
+std::string id_list(const std::vector<int>& ids) {
+    std::string out;
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (i > 0) out += ",";
+        out += std::to_string(ids[i]);
+    }
+    return out;
+}
+
+} // namespace
+
+std::vector<std::pair<int, std::string>> claim_urls(pqxx::connection& C, const std::vector<std::string>& urls,
+                                                    const std::string& crawler_id) {
+    std::vector<std::pair<int, std::string>> claimed;
+    if (urls.empty()) return claimed;
+
+    pqxx::work W(C);
+    std::string owner = W.quote(crawler_id);
+    std::string sql = "INSERT INTO documents (url, status, claimed_by) VALUES ";
+    for (size_t i = 0; i < urls.size(); ++i) {
+        if (i > 0) sql += ",";
+        sql += "(" + W.quote(urls[i]) + ", 'processing', " + owner + ")";
+    }
+    sql += " ON CONFLICT (url) DO NOTHING RETURNING id, url";
+
+    pqxx::result R = W.exec(sql);
+    W.commit();
+
+    claimed.reserve(R.size());
+    for (const auto& row : R) {
+        claimed.emplace_back(row[0].as<int>(), row[1].as<std::string>());
+    }
+    return claimed;
+}
+
+std::vector<std::pair<int, std::string>> recover_processing(pqxx::connection& C, const std::string& crawler_id) {
+    pqxx::work W(C);
+    // An UPDATE rather than a SELECT, so concurrent replicas adopt each unowned row only once
+    pqxx::result R = W.exec(
+        "UPDATE documents SET claimed_by = " + W.quote(crawler_id) + " WHERE status = 'processing' AND "
+        "(claimed_by = " + W.quote(crawler_id) + " OR claimed_by IS NULL) RETURNING id, url");
+    W.commit();
+
+    std::vector<std::pair<int, std::string>> docs;
+    docs.reserve(R.size());
+    for (const auto& row : R) {
+        docs.emplace_back(row[0].as<int>(), row[1].as<std::string>());
+    }
+    std::sort(docs.begin(), docs.end());  // RETURNING has no order
+    return docs;
+}
+
+std::vector<std::pair<int, std::string>> load_content_hashes(pqxx::connection& C, size_t limit) {
+    pqxx::work W(C);
+    pqxx::result R = W.exec(
+        "SELECT id, content_hash FROM (SELECT id, content_hash FROM documents "
+        "WHERE status IN ('crawled', 'crawled_not_queued') AND content_hash IS NOT NULL "
+        "ORDER BY id DESC LIMIT " + std::to_string(limit) + ") AS recent ORDER BY id");
+    W.commit();
+
+    std::vector<std::pair<int, std::string>> hashes;
+    hashes.reserve(R.size());
+    for (const auto& row : R) {
+        hashes.emplace_back(row[0].as<int>(), row[1].as<std::string>());
+    }
+    return hashes;
+}
+
+CrawlStateWriter::CrawlStateWriter(size_t max_batch, std::chrono::milliseconds max_delay)
+    : max_batch(max_batch), max_delay(max_delay) {}
+
+void CrawlStateWriter::note_pending(Clock::time_point now) {
+    if (empty()) oldest_pending = now;
+}
+
+void CrawlStateWriter::mark_crawled(int doc_id, const std::string& file_path, int64_t offset, int64_t length,
+                                    const std::string& content_hash) {
+    note_pending(Clock::now());
+    crawled.push_back({doc_id, file_path, offset, length, content_hash});
+}
+
+void CrawlStateWriter::mark_duplicate(int doc_id, const std::string& content_hash) {
+    note_pending(Clock::now());
+    duplicates.push_back({doc_id, content_hash});
+}
+
+void CrawlStateWriter::mark_failed(int doc_id) {
+    note_pending(Clock::now());
+    failed.push_back(doc_id);
+}
+
+void CrawlStateWriter::mark_not_queued(int doc_id) {
+    note_pending(Clock::now());
+    not_queued.push_back(doc_id);
+}
+
+bool CrawlStateWriter::should_flush(Clock::time_point now) const {
+    if (empty()) return false;
+    return pending() >= max_batch || now - oldest_pending >= max_delay;
+}
+
+std::vector<int> CrawlStateWriter::flush(pqxx::connection& C) {
+    std::vector<int> committed;
+    if (empty()) return committed;
+
+    pqxx::work W(C);
+    if (!crawled.empty()) {
+        std::string sql =
+            "UPDATE documents AS d SET status = 'crawled', file_path = v.file_path, \"offset\" = v.\"offset\", length = v.length, "
+            "content_hash = v.content_hash FROM (VALUES ";
+        for (size_t i = 0; i < crawled.size(); ++i) {
+            const CrawledDoc& doc = crawled[i];
+            if (i > 0) sql += ",";
+            sql += "(" + std::to_string(doc.doc_id) + ", " + W.quote(doc.file_path) + ", " +
+                   std::to_string(doc.offset) + "::bigint, " + std::to_string(doc.length) + "::bigint, " +
+                   W.quote(doc.content_hash) + ")";
+        }
+        sql += ") AS v(id, file_path, \"offset\", length, content_hash) WHERE d.id = v.id";
+        W.exec(sql);
+    }
+    if (!duplicates.empty()) {
+        std::string sql = "UPDATE documents AS d SET status = 'duplicate', content_hash = v.content_hash FROM (VALUES ";
+        for (size_t i = 0; i < duplicates.size(); ++i) {
+            if (i > 0) sql += ",";
+            sql += "(" + std::to_string(duplicates[i].doc_id) + ", " + W.quote(duplicates[i].content_hash) + ")";
+        }
+        sql += ") AS v(id, content_hash) WHERE d.id = v.id";
+        W.exec(sql);
+    }
+    if (!failed.empty()) {
+        W.exec("UPDATE documents SET status = 'error' WHERE id IN (" + id_list(failed) + ")");
+    }
+    if (!not_queued.empty()) {
+        W.exec("UPDATE documents SET status = 'crawled_not_queued' WHERE id IN (" + id_list(not_queued) + ")");
+    }
+    W.commit();
+
+    committed.reserve(crawled.size());
+    for (const auto& doc : crawled) committed.push_back(doc.doc_id);
+    crawled.clear();
+    duplicates.clear();
+    failed.clear();
+    not_queued.clear();
+    return committed;
+}
+
+} // namespace crawler
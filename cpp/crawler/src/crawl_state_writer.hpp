@@ -0,0 +1,101 @@
+#ifndef CRAWL_STATE_WRITER_HPP
+#define CRAWL_STATE_WRITER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <pqxx/pqxx>
+
+namespace crawler {
+
+/**
+ * @brief Registers URLs as 'processing', claimed by `crawler_id`, with a single multi-row INSERT.
+ * @return (doc_id, url) for every URL that was not already in the documents table.
+ */
+std::vector<std::pair<int, std::string>> claim_urls(pqxx::connection& C, const std::vector<std::string>& urls,
+                                                    const std::string& crawler_id);
+
+/**
+ * @brief Loads the documents `crawler_id` left in 'processing' in a previous run so they can be crawled again.
+ *
+ * Other replicas' documents are left alone: they may still be fetching them. Rows claimed before
+ * claimed_by existed are adopted by whichever crawler recovers first.
+ */
+std::vector<std::pair<int, std::string>> recover_processing(pqxx::connection& C, const std::string& crawler_id);
+
+/**
+ * @brief Loads the content hashes of the `limit` most recently crawled documents, oldest first.
+ * @return (doc_id, content_hash) pairs, to seed the in-memory duplicate index at startup.
+ */
+std::vector<std::pair<int, std::string>> load_content_hashes(pqxx::connection& C, size_t limit);
+
+/**
+ * @brief Write-behind buffer for per-document crawl state transitions.
+ *
+ * Transitions are applied in one transaction of multi-row statements when the buffer reaches
+ * max_batch entries or its oldest entry is older than max_delay. Nothing is durable until
+ * flush() returns; a crash before that simply leaves the documents in 'processing', and they
+ * are re-crawled by the next run (see recover_processing()).
+ *
+ * @note This class is not thread-safe.
+ */
+class CrawlStateWriter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CrawlStateWriter(size_t max_batch, std::chrono::milliseconds max_delay);
+
+    // Document was stored in a WARC file and is ready for indexing.
+    void mark_crawled(int doc_id, const std::string& file_path, int64_t offset, int64_t length,
+                      const std::string& content_hash);
+
+    // Document duplicates an earlier one: it is not stored or indexed.
+    void mark_duplicate(int doc_id, const std::string& content_hash);
+
+    // Document could not be downloaded.
+    void mark_failed(int doc_id);
+
+    // Document was crawled but could not be handed to the indexer.
+    void mark_not_queued(int doc_id);
+
+    bool should_flush(Clock::time_point now) const;
+    bool empty() const { return crawled.empty() && duplicates.empty() && failed.empty() && not_queued.empty(); }
+    size_t pending() const { return crawled.size() + duplicates.size() + failed.size() + not_queued.size(); }
+
+    /**
+     * @brief Applies all buffered transitions in a single transaction.
+     * @return IDs of the documents committed as 'crawled', in the order they were marked.
+     * @throws std::exception from pqxx on failure; the buffer is kept so the flush can be retried.
+     */
+    std::vector<int> flush(pqxx::connection& C);
+
+private:
+    struct CrawledDoc {
+        int doc_id;
+        std::string file_path;
+        int64_t offset;
+        int64_t length;
+        std::string content_hash;
+    };
+
+    struct DuplicateDoc {
+        int doc_id;
+        std::string content_hash;
+    };
+
+    void note_pending(Clock::time_point now);
+
+    size_t max_batch;
+    std::chrono::milliseconds max_delay;
+    Clock::time_point oldest_pending;
+    std::vector<CrawledDoc> crawled;
+    std::vector<DuplicateDoc> duplicates;
+    std::vector<int> failed;
+    std::vector<int> not_queued;
+};
+
+} // namespace crawler
+
+#endif // CRAWL_STATE_WRITER_HPP
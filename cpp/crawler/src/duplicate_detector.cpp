@@ -0,0 +1,187 @@
+#include "duplicate_detector.hpp"
+#include "hash.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+
+namespace crawler {
+
+namespace {
+
+const size_t SHINGLE_WORDS = 3;
+const size_t MIN_SHINGLES = 16;        // Fewer make the SimHash too noisy to trust
+const size_t BAND_VALUES = 1 << 16;
+
+inline bool is_word_byte(unsigned char c) {
+    // Bytes >= 0x80 are UTF-8 sequences: kept, so non-ASCII text still forms words
+    return static_cast<unsigned char>((c | 0x20) - 'a') < 26 || static_cast<unsigned char>(c - '0') < 10 || c >= 0x80;
+}
+
+inline char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c;
+}
+
+// Whether the tag starting at html[pos] (just past '<') is named `name`, case-insensitively.
+bool tag_is(std::string_view html, size_t pos, std::string_view name) {
+    if (html.size() - pos < name.size()) return false;
+    for (size_t i = 0; i < name.size(); ++i) {
+        if (to_lower(html[pos + i]) != name[i]) return false;
+    }
+    size_t end = pos + name.size();
+    return end == html.size() || !is_word_byte(static_cast<unsigned char>(html[end]));
+}
+
+// Position just past the closing tag "</name ...>" at or after `pos`, or the end of `html`.
+size_t skip_element(std::string_view html, size_t pos, std::string_view name) {
+    for (pos = html.find("</", pos); pos != std::string_view::npos; pos = html.find("</", pos + 2)) {
+        if (tag_is(html, pos + 2, name)) {
+            size_t close = html.find('>', pos);
+            return close == std::string_view::npos ? html.size() : close + 1;
+        }
+    }
+    return html.size();
+}
+
+// Calls fn(word) for every lowercased word of the text outside tags, scripts and styles.
+template <class Fn>
+void for_each_word(std::string_view html, Fn&& fn) {
+    std::string word;
+    auto end_word = [&] {
+        if (!word.empty()) fn(std::string_view(word));
+        word.clear();
+    };
+    size_t i = 0;
+    while (i < html.size()) {
+        char c = html[i];
+        if (c == '<') {
+            end_word();
+            size_t close = html.find('>', i);
+            size_t after = close == std::string_view::npos ? html.size() : close + 1;
+            if (tag_is(html, i + 1, "script")) after = skip_element(html, after, "script");
+            else if (tag_is(html, i + 1, "style")) after = skip_element(html, after, "style");
+            i = after;
+            continue;
+        }
+        if (is_word_byte(static_cast<unsigned char>(c))) {
+            word.push_back(to_lower(c));
+        } else {
+            end_word();
+        }
+        ++i;
+    }
+    end_word();
+}
+
+} // namespace
+
+ContentFingerprint fingerprint_content(std::string_view body) {
+    ContentFingerprint fingerprint;
+    fingerprint.exact = hash64(body);
+
+    // Each shingle votes on every bit of the SimHash with the corresponding bit of its hash
+    int32_t votes[64] = {0};
+    uint64_t window[SHINGLE_WORDS] = {0};
+    size_t words = 0;
+    size_t shingles = 0;
+    for_each_word(body, [&](std::string_view word) {
+        window[words++ % SHINGLE_WORDS] = hash64(word);
+        if (words < SHINGLE_WORDS) return;
+        uint64_t ordered[SHINGLE_WORDS];
+        for (size_t i = 0; i < SHINGLE_WORDS; ++i) ordered[i] = window[(words + i) % SHINGLE_WORDS];
+        uint64_t shingle = hash64(std::string_view(reinterpret_cast<const char*>(ordered), sizeof(ordered)));
+        for (int bit = 0; bit < 64; ++bit) votes[bit] += ((shingle >> bit) & 1) ? 1 : -1;
+        ++shingles;
+    });
+    if (shingles < MIN_SHINGLES) return fingerprint;
+
+    for (int bit = 0; bit < 64; ++bit) {
+        if (votes[bit] > 0) fingerprint.simhash |= uint64_t(1) << bit;
+    }
+    fingerprint.has_simhash = true;
+    return fingerprint;
+}
+
+std::string format_fingerprint(const ContentFingerprint& fingerprint) {
+    char buffer[40];
+    if (fingerprint.has_simhash) {
+        std::snprintf(buffer, sizeof(buffer), "%016llx:%016llx", static_cast<unsigned long long>(fingerprint.exact),
+                      static_cast<unsigned long long>(fingerprint.simhash));
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(fingerprint.exact));
+    }
+    return buffer;
+}
+
+std::optional<ContentFingerprint> parse_fingerprint(std::string_view value) {
+    auto parse_hex = [](std::string_view hex, uint64_t& out) {
+        auto [end, error] = std::from_chars(hex.data(), hex.data() + hex.size(), out, 16);
+        return hex.size() == 16 && error == std::errc() && end == hex.data() + hex.size();
+    };
+    ContentFingerprint fingerprint;
+    if (!parse_hex(value.substr(0, 16), fingerprint.exact)) return std::nullopt;
+    if (value.size() == 16) return fingerprint;
+    if (value.size() != 33 || value[16] != ':' || !parse_hex(value.substr(17), fingerprint.simhash)) return std::nullopt;
+    fingerprint.has_simhash = true;
+    return fingerprint;
+}
+
+DuplicateIndex::DuplicateIndex(size_t max_documents, int max_distance)
+    : max_documents(std::max<size_t>(1, max_documents)),
+      max_distance(std::clamp(max_distance, 0, MAX_DISTANCE_LIMIT)) {
+    for (auto& buckets : by_band) buckets.resize(BAND_VALUES);
+}
+
+std::optional<int> DuplicateIndex::lookup(const ContentFingerprint& fingerprint) {
+    auto exact = by_exact.find(fingerprint.exact);
+    if (exact != by_exact.end()) {
+        ++exact_hits;
+        return entries[exact->second].doc_id;
+    }
+    if (fingerprint.has_simhash) {
+        for (int b = 0; b < BANDS; ++b) {
+            for (uint32_t slot : by_band[b][band(fingerprint.simhash, b)]) {
+                const Entry& entry = entries[slot];
+                if (__builtin_popcountll(entry.fingerprint.simhash ^ fingerprint.simhash) <= max_distance) {
+                    ++near_hits;
+                    return entry.doc_id;
+                }
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+void DuplicateIndex::insert(int doc_id, const ContentFingerprint& fingerprint) {
+    uint32_t slot = next_slot;
+    if (entries.size() < max_documents) {
+        entries.push_back({fingerprint, doc_id});
+    } else {
+        evict(slot);
+        entries[slot] = {fingerprint, doc_id};
+    }
+    next_slot = static_cast<uint32_t>((slot + 1) % max_documents);
+    count = entries.size();
+
+    by_exact[fingerprint.exact] = slot;
+    if (fingerprint.has_simhash) {
+        for (int b = 0; b < BANDS; ++b) by_band[b][band(fingerprint.simhash, b)].push_back(slot);
+    }
+}
+
+void DuplicateIndex::evict(uint32_t slot) {
+    const ContentFingerprint& old = entries[slot].fingerprint;
+    auto exact = by_exact.find(old.exact);
+    if (exact != by_exact.end() && exact->second == slot) by_exact.erase(exact);  // Unless a newer page took it
+    if (!old.has_simhash) return;
+    for (int b = 0; b < BANDS; ++b) {
+        std::vector<uint32_t>& bucket = by_band[b][band(old.simhash, b)];
+        auto it = std::find(bucket.begin(), bucket.end(), slot);
+        if (it != bucket.end()) {
+            *it = bucket.back();
+            bucket.pop_back();
+        }
+    }
+}
+
+} // namespace crawler
@@ -0,0 +1,99 @@
+#ifndef DUPLICATE_DETECTOR_HPP
+#define DUPLICATE_DETECTOR_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace crawler {
+
+/**
+ * @brief Fingerprints of a page body: an exact hash of its bytes and a SimHash of its text.
+ *
+ * The SimHash is computed over 3-word shingles of the text outside tags, scripts and styles, so
+ * pages that differ only in markup or a few words end up a few bits apart. Pages too short to
+ * shingle reliably get no SimHash and are only matched exactly.
+ */
+struct ContentFingerprint {
+    uint64_t exact = 0;
+    uint64_t simhash = 0;
+    bool has_simhash = false;
+};
+
+ContentFingerprint fingerprint_content(std::string_view body);
+
+/**
+ * @brief Formats a fingerprint for documents.content_hash: "<exact>:<simhash>" (or "<exact>") in hex.
+ */
+std::string format_fingerprint(const ContentFingerprint& fingerprint);
+
+/**
+ * @brief Parses a value written by format_fingerprint(); nothing if it is malformed.
+ */
+std::optional<ContentFingerprint> parse_fingerprint(std::string_view value);
+
+/**
+ * @brief In-memory index of the fingerprints of recently crawled pages.
+ *
+ * Exact hashes are looked up in a hash map. SimHashes are split into four 16-bit bands, each
+ * indexing the fingerprints that share it: two SimHashes at most 3 bits apart agree on at least
+ * one band, so a lookup only compares against the fingerprints in four buckets.
+ * Holds at most max_documents pages and forgets the oldest first.
+ *
+ * @note This class is not thread-safe.
+ */
+class DuplicateIndex {
+public:
+    static constexpr int MAX_DISTANCE_LIMIT = 3;  // Largest distance the four bands are guaranteed to find
+
+    /**
+     * @param max_documents Pages remembered; roughly 100 bytes each.
+     * @param max_distance SimHash bits two pages may differ in and still be near duplicates (0..3).
+     */
+    explicit DuplicateIndex(size_t max_documents, int max_distance = MAX_DISTANCE_LIMIT);
+
+    /**
+     * @brief Looks up a page and counts the hit.
+     * @return The doc_id of a remembered page with the same body or a SimHash within max_distance,
+     *         or nothing if the page is new.
+     */
+    std::optional<int> lookup(const ContentFingerprint& fingerprint);
+
+    /**
+     * @brief Remembers a page, once it has been stored (or when reloading fingerprints at startup).
+     */
+    void insert(int doc_id, const ContentFingerprint& fingerprint);
+
+    size_t size() const { return count; }
+    uint64_t exact_duplicates() const { return exact_hits; }
+    uint64_t near_duplicates() const { return near_hits; }
+
+private:
+    static constexpr int BANDS = 4;
+
+    struct Entry {
+        ContentFingerprint fingerprint;
+        int doc_id;
+    };
+
+    static uint16_t band(uint64_t simhash, int b) { return static_cast<uint16_t>(simhash >> (16 * b)); }
+    void evict(uint32_t slot);
+
+    size_t max_documents;
+    int max_distance;
+    std::vector<Entry> entries;  // Ring buffer; `next_slot` is the oldest entry once it is full
+    uint32_t next_slot = 0;
+    size_t count = 0;
+    std::unordered_map<uint64_t, uint32_t> by_exact;
+    std::array<std::vector<std::vector<uint32_t>>, BANDS> by_band;  // band -> 16-bit value -> slots
+    uint64_t exact_hits = 0;
+    uint64_t near_hits = 0;
+};
+
+} // namespace crawler
+
+#endif // DUPLICATE_DETECTOR_HPP
@@ -0,0 +1,142 @@
+#include "fetcher.hpp"
+#include <stdexcept>
+
+namespace crawler {
+
+namespace {
+
+size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
+    static_cast<std::string*>(userp)->append(static_cast<const char*>(contents), size * nmemb);
+    return size * nmemb;
+}
+
+} // namespace
+
+Fetcher::Fetcher(size_t max_in_flight, long max_host_connections, long timeout_seconds, const std::string& user_agent)
+    : multi(nullptr), active_count(0) {
+    if (max_in_flight == 0) {
+        throw std::runtime_error("Fetcher requires at least one transfer slot");
+    }
+
+    multi = curl_multi_init();
+    if (!multi) {
+        throw std::runtime_error("curl_multi_init failed");
+    }
+    curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, static_cast<long>(max_in_flight));
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, max_host_connections);
+
+    // Transfers hold pointers into this vector (CURLOPT_WRITEDATA), so it is sized once and never grows.
+    transfers.resize(max_in_flight);
+    free_slots.reserve(max_in_flight);
+    for (size_t i = 0; i < max_in_flight; ++i) {
+        CURL* easy = curl_easy_init();
+        if (!easy) {
+            for (size_t j = 0; j < i; ++j) curl_easy_cleanup(transfers[j].easy);
+            curl_multi_cleanup(multi);
+            throw std::runtime_error("curl_easy_init failed");
+        }
+        transfers[i].easy = easy;
+        transfers[i].active = false;
+        transfers[i].doc_id = -1;
+
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, write_callback);
+        curl_easy_setopt(easy, CURLOPT_WRITEDATA, &transfers[i].body);
+        curl_easy_setopt(easy, CURLOPT_PRIVATE, reinterpret_cast<void*>(i));
+        curl_easy_setopt(easy, CURLOPT_TIMEOUT, timeout_seconds);
+        curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(easy, CURLOPT_USERAGENT, user_agent.c_str());
+        curl_easy_setopt(easy, CURLOPT_SSL_VERIFYPEER, 1L);
+        curl_easy_setopt(easy, CURLOPT_SSL_VERIFYHOST, 2L);
+        curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+
+        // Hand out low slots first so the most recently used handles stay hot.
+        free_slots.push_back(max_in_flight - 1 - i);
+    }
+}
+
+Fetcher::~Fetcher() {
+    for (auto& transfer : transfers) {
+        if (transfer.active) {
+            curl_multi_remove_handle(multi, transfer.easy);
+        }
+        curl_easy_cleanup(transfer.easy);
+    }
+    curl_multi_cleanup(multi);
+}
+
+bool Fetcher::submit(int doc_id, const std::string& url) {
+    if (free_slots.empty()) return false;
+
+    size_t slot = free_slots.back();
+    Transfer& transfer = transfers[slot];
+    transfer.doc_id = doc_id;
+    transfer.url = url;
+    transfer.body.clear();
+    curl_easy_setopt(transfer.easy, CURLOPT_URL, transfer.url.c_str());
+
+    CURLMcode rc = curl_multi_add_handle(multi, transfer.easy);
+    if (rc != CURLM_OK) {
+        throw std::runtime_error(std::string("curl_multi_add_handle failed: ") + curl_multi_strerror(rc));
+    }
+
+    transfer.active = true;
+    free_slots.pop_back();
+    active_count++;
+    return true;
+}
+
+std::vector<FetchResult> Fetcher::poll(int timeout_ms) {
+    std::vector<FetchResult> results;
+    if (active_count == 0) return results;
+
+    int running = 0;
+    CURLMcode rc = curl_multi_perform(multi, &running);
+    if (rc == CURLM_OK && running > 0) {
+        rc = curl_multi_poll(multi, nullptr, 0, timeout_ms, nullptr);
+        if (rc == CURLM_OK) rc = curl_multi_perform(multi, &running);
+    }
+    if (rc != CURLM_OK) {
+        throw std::runtime_error(std::string("curl multi error: ") + curl_multi_strerror(rc));
+    }
+
+    int msgs_left = 0;
+    while (CURLMsg* msg = curl_multi_info_read(multi, &msgs_left)) {
+        if (msg->msg != CURLMSG_DONE) continue;
+
+        void* priv = nullptr;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &priv);
+        size_t slot = reinterpret_cast<size_t>(priv);
+        Transfer& transfer = transfers[slot];
+
+        FetchResult result;
+        result.doc_id = transfer.doc_id;
+        result.url = std::move(transfer.url);
+        result.http_code = 0;
+        curl_easy_getinfo(transfer.easy, CURLINFO_RESPONSE_CODE, &result.http_code);
+        curl_easy_getinfo(transfer.easy, CURLINFO_TOTAL_TIME, &result.total_seconds);
+
+        CURLcode code = msg->data.result;
+        if (code != CURLE_OK) {
+            result.success = false;
+            result.error = curl_easy_strerror(code);
+        } else if (transfer.body.empty()) {
+            result.success = false;
+            result.error = "empty response body";
+        } else {
+            result.success = true;
+            result.body = std::move(transfer.body);
+        }
+
+        curl_multi_remove_handle(multi, transfer.easy);
+        transfer.active = false;
+        transfer.body.clear();
+        free_slots.push_back(slot);
+        active_count--;
+
+        results.push_back(std::move(result));
+    }
+
+    return results;
+}
+
+} // namespace crawler
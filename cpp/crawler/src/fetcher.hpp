@@ -0,0 +1,82 @@
+#ifndef FETCHER_HPP
+#define FETCHER_HPP
+
+#include <string>
+#include <vector>
+#include <curl/curl.h>
+
+namespace crawler {
+
+struct FetchResult {
+    int doc_id;         // Document ID the fetch was submitted for
+    std::string url;    // URL that was requested
+    std::string body;   // Response body (empty on failure)
+    long http_code;     // HTTP status code, 0 if no response was received
+    bool success;       // True if the transfer completed and returned a body
+    std::string error;  // Human-readable error when success is false
+    double total_seconds = 0;  // Transfer time, from name lookup to the last byte
+};
+
+/**
+ * @brief Event-driven HTTP fetch engine built on the libcurl multi interface.
+ *
+ * Runs up to max_in_flight transfers concurrently on the calling thread. Easy handles are
+ * created once and reused across transfers, so connections, DNS results and TLS sessions are
+ * kept warm by the multi handle's connection cache.
+ *
+ * @note This class is not thread-safe. submit() and poll() must be called from the same thread.
+ */
+class Fetcher {
+public:
+    /**
+     * @brief Constructs a Fetcher.
+     * @param max_in_flight Maximum number of concurrent transfers.
+     * @param max_host_connections Maximum concurrent connections to a single host (0 = unlimited).
+     * @param timeout_seconds Per-transfer timeout.
+     * @param user_agent User-Agent header sent with every request.
+     * @throws std::runtime_error if the curl handles cannot be created.
+     */
+    Fetcher(size_t max_in_flight, long max_host_connections, long timeout_seconds, const std::string& user_agent);
+
+    /**
+     * @brief Destructor. Aborts any in-flight transfers and releases all curl handles.
+     */
+    ~Fetcher();
+
+    Fetcher(const Fetcher&) = delete;
+    Fetcher& operator=(const Fetcher&) = delete;
+
+    /**
+     * @brief Starts fetching a URL.
+     * @return false if all transfer slots are busy; the URL is not queued in that case.
+     */
+    bool submit(int doc_id, const std::string& url);
+
+    /**
+     * @brief Drives all active transfers and collects the ones that finished.
+     * @param timeout_ms Maximum time to wait for network activity when nothing is ready.
+     * @return Results of the transfers that completed during this call.
+     */
+    std::vector<FetchResult> poll(int timeout_ms);
+
+    size_t in_flight() const { return active_count; }
+    bool has_capacity() const { return !free_slots.empty(); }
+
+private:
+    struct Transfer {
+        CURL* easy;
+        bool active;
+        int doc_id;
+        std::string url;
+        std::string body;
+    };
+
+    CURLM* multi;
+    std::vector<Transfer> transfers;
+    std::vector<size_t> free_slots;  // Indices into transfers that are not in use
+    size_t active_count;
+};
+
+} // namespace crawler
+
+#endif // FETCHER_HPP
@@ -0,0 +1,52 @@
+#ifndef CRAWLER_HASH_HPP
+#define CRAWLER_HASH_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace crawler {
+
+namespace detail {
+
+inline uint64_t mum(uint64_t a, uint64_t b) {
+    __uint128_t r = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+}
+
+inline uint64_t read64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+} // namespace detail
+
+// Fast, stable 64-bit hash (wyhash-style multiply-mix over 16-byte strides).
+// Output is identical across runs, so it is safe for anything persisted to disk.
+inline uint64_t hash64(std::string_view data, uint64_t seed = 0) {
+    constexpr uint64_t P0 = 0xa0761d6478bd642fULL;
+    constexpr uint64_t P1 = 0xe7037ed1a0b428dbULL;
+    constexpr uint64_t P2 = 0x8ebc6af09c88c6e3ULL;
+
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data());
+    size_t len = data.size();
+    uint64_t h = seed ^ P0;
+
+    while (len > 16) {
+        h = detail::mum(detail::read64(p) ^ P1, detail::read64(p + 8) ^ h);
+        p += 16;
+        len -= 16;
+    }
+
+    unsigned char tail[16] = {0};
+    std::memcpy(tail, p, len);
+    uint64_t a = detail::read64(tail);
+    uint64_t b = detail::read64(tail + 8);
+
+    return detail::mum(P1 ^ data.size(), detail::mum(a ^ P2, b ^ h));
+}
+
+} // namespace crawler
+
+#endif // CRAWLER_HASH_HPP
@@ -0,0 +1,86 @@
+#include "host_scheduler.hpp"
+#include "url_utils.hpp"
+
+namespace crawler {
+
+HostScheduler::HostScheduler(Clock::duration crawl_delay)
+    : crawl_delay(crawl_delay), pending_count(0) {}
+
+void HostScheduler::push(int doc_id, const std::string& url) {
+    std::string host = extract_host(url);
+    auto [it, inserted] = hosts.try_emplace(host);
+    HostState& state = it->second;
+    if (inserted) {
+        state.next_allowed = Clock::time_point::min();
+    }
+
+    // A host gets a heap entry when it goes from "nothing to do" to "has a URL waiting".
+    if (state.pending.empty() && !state.in_flight) {
+        ready_heap.push({state.next_allowed, host});
+    }
+    state.pending.push_back({doc_id, url});
+    pending_count++;
+}
+
+bool HostScheduler::pop_ready(Clock::time_point now, ScheduledUrl& out) {
+    expire_idle_hosts(now);
+    discard_stale_entries();
+    if (ready_heap.empty() || ready_heap.top().ready_at > now) {
+        return false;
+    }
+
+    HostState& state = hosts[ready_heap.top().host];
+    ready_heap.pop();
+
+    out = std::move(state.pending.front());
+    state.pending.pop_front();
+    state.in_flight = true;
+    pending_count--;
+    return true;
+}
+
+void HostScheduler::release(const std::string& url, Clock::time_point now) {
+    std::string host = extract_host(url);
+    auto it = hosts.find(host);
+    if (it == hosts.end()) return;
+
+    HostState& state = it->second;
+    state.in_flight = false;
+    state.next_allowed = now + crawl_delay;
+    if (!state.pending.empty()) {
+        ready_heap.push({state.next_allowed, host});
+    } else {
+        idle_hosts.push_back({state.next_allowed, host});
+    }
+}
+
+HostScheduler::Clock::time_point HostScheduler::next_ready_time() {
+    discard_stale_entries();
+    if (ready_heap.empty()) return Clock::time_point::max();
+    return ready_heap.top().ready_at;
+}
+
+void HostScheduler::discard_stale_entries() {
+    while (!ready_heap.empty()) {
+        const HeapEntry& top = ready_heap.top();
+        auto it = hosts.find(top.host);
+        if (it != hosts.end() && !it->second.in_flight && !it->second.pending.empty() &&
+            it->second.next_allowed == top.ready_at) {
+            return;
+        }
+        ready_heap.pop();
+    }
+}
+
+void HostScheduler::expire_idle_hosts(Clock::time_point now) {
+    while (!idle_hosts.empty() && idle_hosts.front().ready_at <= now) {
+        auto it = hosts.find(idle_hosts.front().host);
+        if (it != hosts.end() && !it->second.in_flight && it->second.pending.empty() &&
+            it->second.next_allowed <= now) {
+            hosts.erase(it);
+        }
+        idle_hosts.pop_front();
+    }
+}
+
+} // namespace crawler
@@ -0,0 +1,92 @@
+#ifndef HOST_SCHEDULER_HPP
+#define HOST_SCHEDULER_HPP
+
+#include <chrono>
+#include <deque>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace crawler {
+
+struct ScheduledUrl {
+    int doc_id;
+    std::string url;
+};
+
+/**
+ * @brief In-memory crawl frontier that enforces a per-host politeness delay.
+ *
+ * Each host has its own FIFO of pending URLs. Hosts are ordered in a min-heap keyed on the
+ * time they may next be fetched, so the scheduler can always hand out some eligible URL
+ * while other hosts are cooling down. A host is ineligible while one of its fetches is in
+ * flight, and its delay is counted from the moment that fetch completes.
+ *
+ * @note This class is not thread-safe.
+ */
+class HostScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @param crawl_delay Minimum time between the end of one fetch and the start of the next on a host.
+     */
+    explicit HostScheduler(Clock::duration crawl_delay);
+
+    /**
+     * @brief Queues a URL behind any other pending URLs for the same host.
+     */
+    void push(int doc_id, const std::string& url);
+
+    /**
+     * @brief Takes the next URL whose host may be fetched at `now`.
+     *
+     * The URL's host is marked in flight until release() is called for it.
+     * @return false if no host is eligible yet.
+     */
+    bool pop_ready(Clock::time_point now, ScheduledUrl& out);
+
+    /**
+     * @brief Marks the fetch of `url` as finished; its host becomes eligible again after the crawl delay.
+     */
+    void release(const std::string& url, Clock::time_point now);
+
+    /**
+     * @brief Earliest time at which pop_ready() could succeed, or Clock::time_point::max() if nothing is pending.
+     */
+    Clock::time_point next_ready_time();
+
+    size_t size() const { return pending_count; }
+    bool empty() const { return pending_count == 0; }
+    size_t host_count() const { return hosts.size(); }
+
+private:
+    struct HostState {
+        std::deque<ScheduledUrl> pending;
+        Clock::time_point next_allowed;
+        bool in_flight = false;
+    };
+
+    struct HeapEntry {
+        Clock::time_point ready_at;
+        std::string host;
+        bool operator>(const HeapEntry& other) const { return ready_at > other.ready_at; }
+    };
+
+    // Drops heap entries that no longer describe a schedulable host.
+    void discard_stale_entries();
+
+    // Forgets hosts that have nothing pending and whose delay has fully elapsed.
+    void expire_idle_hosts(Clock::time_point now);
+
+    Clock::duration crawl_delay;
+    std::unordered_map<std::string, HostState> hosts;
+    std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> ready_heap;
+    std::deque<HeapEntry> idle_hosts;  // Ordered by expiry, since the delay is constant
+    size_t pending_count;
+};
+
+} // namespace crawler
+
+#endif // HOST_SCHEDULER_HPP
@@ -0,0 +1,130 @@
+#include "link_extractor.hpp"
+#include "url_utils.hpp"
+#include <cctype>
+#include <unordered_set>
+
+namespace crawler {
+
+namespace {
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != b[i]) return false;
+    }
+    return true;
+}
+
+// Case-insensitive search for a lowercase needle.
+size_t find_ci(std::string_view haystack, std::string_view needle, size_t from) {
+    for (size_t i = from; i + needle.size() <= haystack.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(haystack[i])) == needle[0] &&
+            iequals(haystack.substr(i, needle.size()), needle)) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+struct TagAttributes {
+    std::string_view href;
+    bool has_href = false;
+    bool nofollow = false;
+};
+
+// Parses attributes starting just after the tag name; returns the position after the closing '>'.
+size_t parse_attributes(std::string_view html, size_t pos, TagAttributes& attrs) {
+    const size_t n = html.size();
+    while (pos < n) {
+        while (pos < n && (is_space(html[pos]) || html[pos] == '/')) pos++;
+        if (pos >= n) break;
+        if (html[pos] == '>') return pos + 1;
+
+        size_t name_start = pos;
+        while (pos < n && !is_space(html[pos]) && html[pos] != '=' && html[pos] != '>' && html[pos] != '/') pos++;
+        std::string_view name = html.substr(name_start, pos - name_start);
+
+        while (pos < n && is_space(html[pos])) pos++;
+        std::string_view value;
+        if (pos < n && html[pos] == '=') {
+            pos++;
+            while (pos < n && is_space(html[pos])) pos++;
+            if (pos < n && (html[pos] == '"' || html[pos] == '\'')) {
+                char quote = html[pos++];
+                size_t end = html.find(quote, pos);
+                if (end == std::string_view::npos) return n;
+                value = html.substr(pos, end - pos);
+                pos = end + 1;
+            } else {
+                size_t value_start = pos;
+                while (pos < n && !is_space(html[pos]) && html[pos] != '>') pos++;
+                value = html.substr(value_start, pos - value_start);
+            }
+        }
+
+        if (iequals(name, "href")) {
+            attrs.href = value;
+            attrs.has_href = true;
+        } else if (iequals(name, "rel") && find_ci(value, "nofollow", 0) != std::string_view::npos) {
+            attrs.nofollow = true;
+        }
+    }
+    return n;
+}
+
+} // namespace
+
+std::vector<std::string> extract_links(std::string_view html, const std::string& page_url, size_t max_links) {
+    std::vector<std::string> links;
+    std::unordered_set<std::string> seen;
+    std::string base_url = page_url;
+
+    const size_t n = html.size();
+    size_t pos = 0;
+    while (links.size() < max_links && (pos = html.find('<', pos)) != std::string_view::npos) {
+        pos++;
+        if (html.compare(pos, 3, "!--") == 0) {
+            size_t end = html.find("-->", pos + 3);
+            if (end == std::string_view::npos) break;
+            pos = end + 3;
+            continue;
+        }
+
+        size_t name_start = pos;
+        while (pos < n && std::isalnum(static_cast<unsigned char>(html[pos]))) pos++;
+        std::string_view name = html.substr(name_start, pos - name_start);
+        if (name.empty()) continue;  // Closing tag, doctype, stray '<'
+
+        if (iequals(name, "script") || iequals(name, "style")) {
+            std::string closing = iequals(name, "script") ? "</script" : "</style";
+            size_t end = find_ci(html, closing, pos);
+            if (end == std::string_view::npos) break;
+            pos = end + closing.size();
+            continue;
+        }
+
+        bool is_anchor = iequals(name, "a") || iequals(name, "area");
+        bool is_base = iequals(name, "base");
+        if (!is_anchor && !is_base) continue;
+
+        TagAttributes attrs;
+        pos = parse_attributes(html, pos, attrs);
+        if (!attrs.has_href) continue;
+
+        std::string resolved = resolve_url(base_url, attrs.href);
+        if (resolved.empty()) continue;
+
+        if (is_base) {
+            base_url = resolved;
+        } else if (!attrs.nofollow && seen.insert(resolved).second) {
+            links.push_back(std::move(resolved));
+        }
+    }
+    return links;
+}
+
+} // namespace crawler
@@ -0,0 +1,26 @@
+#ifndef LINK_EXTRACTOR_HPP
+#define LINK_EXTRACTOR_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace crawler {
+
+/**
+ * @brief Extracts outlinks from raw HTML with a single forward scan (no DOM is built).
+ *
+ * Picks up href targets of <a> and <area> tags, honors <base href>, skips links marked
+ * rel="nofollow", and ignores comments and the bodies of <script>/<style>. Every target is
+ * resolved against the page URL and normalized with resolve_url(); non-http(s) targets are
+ * dropped and each URL is returned at most once.
+ *
+ * @param html Raw page body.
+ * @param page_url Absolute URL the page was fetched from, used to resolve relative links.
+ * @param max_links Stop after this many distinct links.
+ */
+std::vector<std::string> extract_links(std::string_view html, const std::string& page_url, size_t max_links = 1000);
+
+} // namespace crawler
+
+#endif // LINK_EXTRACTOR_HPP
@@ -1,77 +1,353 @@
 #include <iostream>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <thread>
 #include <chrono>
+#include <cctype>
+#include <cstdlib>
+#include <unordered_map>
+#include <unistd.h>
 #include <curl/curl.h>
 #include <pqxx/pqxx>
 #include <hiredis/hiredis.h>
 #include "warc_writer.hpp"
+#include "warc_writer_pool.hpp"
+#include "fetcher.hpp"
+#include "host_scheduler.hpp"
+#include "bloom_filter.hpp"
+#include "link_extractor.hpp"
+#include "crawl_state_writer.hpp"
+#include "duplicate_detector.hpp"
+#include "../../common/log.hpp"
+#include "../../common/metrics.hpp"
 
 // --- Config ---
 const std::string REDIS_HOST = "redis_service";
 const std::string DB_CONN_STR = "dbname=search_engine user=admin password=password123 host=postgres_service port=5432";
 const std::string SEED_URL = "https://en.wikipedia.org/wiki/Main_Page";
-const std::string WARC_FILENAME = "/shared_data/crawled.warc.gz";
+const std::string WARC_DIR = "/shared_data";
+const uint64_t WARC_SEGMENT_MAX_BYTES = 1ULL << 30;
+const int WARC_SEGMENT_MAX_AGE_SECONDS = 3600;
+const size_t WARC_BATCH_BYTES = 4 * 1024 * 1024;
+const crawler::WarcDurability WARC_DURABILITY = crawler::WarcDurability::FlushPerBatch;
+const int WARC_COMPRESSION_LEVEL = -1;  // zlib default; 1 trades ~10% size for a much faster compressor
+const size_t WARC_COMPRESSION_THREADS = 4;
+const size_t WARC_COMPRESSION_QUEUE = 256;
+const std::string SEEN_FILTER_DIR = "/shared_data";  // Each replica keeps its own crawler_seen-<CRAWLER_ID>.bloom
+const size_t SEEN_FILTER_EXPECTED_URLS = 10000000;
+const int SEEN_FILTER_SAVE_INTERVAL_SECONDS = 60;
 const long CURL_TIMEOUT_SECONDS = 10;
 const int DB_MAX_RETRIES = 10;
 const int DB_RETRY_DELAY_SECONDS = 5;
 const int QUEUE_POLL_INTERVAL_SECONDS = 5;
-const int CRAWL_DELAY_SECONDS = 1;
+const int CRAWL_DELAY_SECONDS = 1;  // Per host
 const size_t MIN_URL_LENGTH = 10;
+const size_t MAX_IN_FLIGHT_FETCHES = 128;
+const long MAX_HOST_CONNECTIONS = 1;
+const int FETCH_POLL_TIMEOUT_MS = 100;
+const size_t FRONTIER_MAX_PENDING = 10000;
+const size_t FRONTIER_REFILL_BATCH = 256;
+const size_t MAX_LINKS_PER_PAGE = 1000;
+const size_t LINK_PUSH_BATCH = 512;
+const int LINK_PUSH_INTERVAL_MS = 500;
+const size_t STATE_FLUSH_BATCH = 256;
+const int STATE_FLUSH_INTERVAL_MS = 1000;
+const int INDEX_PUSH_MAX_RETRIES = 3;
+const size_t DUPLICATE_INDEX_MAX_DOCUMENTS = 2000000;  // Recent pages checked for duplicates (~200 MB)
+const int NEAR_DUPLICATE_MAX_DISTANCE = 3;             // SimHash bits; 0 only catches exact duplicates
+const std::string USER_AGENT = "MaxSearchEngineBot/1.0 (Open source search engine)";
+const int METRICS_SAMPLE_INTERVAL_SECONDS = 5;  // Gauges that need a Redis round trip
+const uint32_t DOCUMENT_LOG_LINES_PER_SECOND = 10;
 
-// --- CURL Callback ---
-size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* userp) {
-    userp->append(static_cast<const char*>(contents), size * nmemb);
-    return size * nmemb;
+// --- Metrics ---
+// Served on METRICS_PORT at /metrics. Durations are recorded in microseconds and exported in seconds.
+struct CrawlerMetrics {
+    common::Histogram& fetch = common::metrics().histogram("crawler_fetch_seconds", "Page transfer time, from name lookup to the last byte");
+    common::Counter& pages_fetched = common::metrics().counter("crawler_pages_fetched_total", "Pages downloaded");
+    common::Counter& fetched_bytes = common::metrics().counter("crawler_fetched_bytes_total", "Bytes of downloaded pages");
+    common::Counter& fetch_errors = common::metrics().counter("crawler_fetch_errors_total", "Failed downloads");
+    common::Counter& duplicates = common::metrics().counter("crawler_duplicates_total", "Pages skipped as duplicates of a stored page");
+    common::Histogram& compress = common::metrics().histogram("crawler_compress_seconds", "WARC record compression time");
+    common::Histogram& warc_append = common::metrics().histogram("crawler_warc_append_seconds", "Time to append a record to the WARC buffer");
+    common::Counter& warc_bytes = common::metrics().counter("crawler_warc_bytes_total", "Compressed bytes appended to WARC segments");
+    common::Counter& warc_errors = common::metrics().counter("crawler_warc_errors_total", "Pages that could not be archived");
+    common::Histogram& warc_flush = common::metrics().histogram("crawler_warc_flush_seconds", "Time to write out (and sync) a WARC batch");
+    common::Histogram& db_claim = common::metrics().histogram("crawler_db_claim_seconds", "Time to claim a batch of URLs in Postgres");
+    common::Histogram& db_write = common::metrics().histogram("crawler_db_write_seconds", "Time to commit a batch of crawl state in Postgres");
+    common::Counter& documents_committed = common::metrics().counter("crawler_documents_committed_total", "Crawled documents committed and queued for indexing");
+    common::Gauge& crawl_queue = common::metrics().gauge("crawler_crawl_queue_length", "URLs waiting in the Redis crawl queue");
+    common::Gauge& frontier = common::metrics().gauge("crawler_frontier_urls", "URLs in the in-memory frontier");
+    common::Gauge& in_flight = common::metrics().gauge("crawler_fetches_in_flight", "Downloads in progress");
+    common::Gauge& warc_pending = common::metrics().gauge("crawler_warc_pool_pending", "Pages waiting to be compressed or appended");
+};
+const CrawlerMetrics METRICS;
+
+// --- Helper: Validate URL ---
+bool is_valid_url(const std::string& url) {
+    if (url.length() < MIN_URL_LENGTH) return false;
+    if (url.compare(0, 7, "http://") == 0) return true;
+    if (url.compare(0, 8, "https://") == 0) return true;
+    return false;
+}
+
+// --- Helper: Crawler Identity ---
+// CRAWLER_ID if set, otherwise the hostname (unique per container), restricted to file-name-safe characters.
+// Each replica writes WARC segments under its own prefix, so no two crawlers ever append to the same file,
+// and claims URLs under it, so a restarting replica only re-crawls its own. Set it explicitly for replicas
+// whose hostname changes across restarts.
+std::string get_crawler_id() {
+    std::string id;
+    if (const char* env = std::getenv("CRAWLER_ID")) {
+        id = env;
+    } else {
+        char host[256] = {0};
+        if (gethostname(host, sizeof(host) - 1) == 0) id = host;
+    }
+    for (char& c : id) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_' && c != '.') c = '_';
+    }
+    return id.empty() ? "crawler" : id;
+}
+
+// --- Helper: Index Shard Count ---
+// INDEX_SHARD_COUNT if set (default 1): crawled documents go to the queue of shard doc_id % count.
+// Must match the indexers' INDEX_SHARD_COUNT.
+int get_index_shard_count() {
+    const char* env = std::getenv("INDEX_SHARD_COUNT");
+    int count = env ? std::atoi(env) : 1;
+    if (count < 1) {
+        std::cerr << "Invalid INDEX_SHARD_COUNT " << env << ", using 1" << std::endl;
+        return 1;
+    }
+    return count;
+}
+const int INDEX_SHARD_COUNT = get_index_shard_count();
+
+// --- Helper: Metrics Port ---
+// METRICS_PORT (default 9100; 0 turns the endpoint off). LOG_LEVEL (debug, info, warn or error; default info) is
+// read by common::set_log_level_from_env(); per-document lines are debug, and rate limited.
+int get_metrics_port() {
+    const char* env = std::getenv("METRICS_PORT");
+    return env ? std::atoi(env) : 9100;
+}
+
+// --- Helper: Redis List Length ---
+// -1 if it could not be read.
+long long redis_list_length(redisContext* redis, const std::string& key) {
+    redisReply* reply = (redisReply*)redisCommand(redis, "LLEN %s", key.c_str());
+    long long length = reply && reply->type == REDIS_REPLY_INTEGER ? reply->integer : -1;
+    if (reply) freeReplyObject(reply);
+    return length;
+}
+
+// Redis list the indexer of `shard` pops from (the indexer's ShardConfig::queue_key()).
+std::string indexing_queue_key(int shard, int shard_count) {
+    return shard_count == 1 ? "indexing_queue" : "indexing_queue:" + std::to_string(shard);
+}
+
+// --- Helper: Load URL-Seen Filter ---
+// Reloads the filter persisted by a previous run of this replica, or starts an empty one.
+crawler::BloomFilter load_seen_filter(const std::string& path) {
+    try {
+        crawler::BloomFilter filter = crawler::BloomFilter::load(path);
+        std::cout << "Loaded URL-seen filter (" << filter.inserted_count() << " URLs)" << std::endl;
+        return filter;
+    } catch (const std::exception &e) {
+        std::cout << "Starting empty URL-seen filter: " << e.what() << std::endl;
+        return crawler::BloomFilter(SEEN_FILTER_EXPECTED_URLS);
+    }
+}
+
+// --- Helper: Batched RPUSH ---
+// Sends all values as a single variadic RPUSH, i.e. one Redis round trip.
+bool rpush_batch(redisContext* redis, const std::string& key, const std::vector<std::string>& values) {
+    if (values.empty()) return true;
+
+    std::vector<const char*> argv;
+    std::vector<size_t> argvlen;
+    argv.reserve(values.size() + 2);
+    argvlen.reserve(values.size() + 2);
+    argv.push_back("RPUSH");
+    argvlen.push_back(5);
+    argv.push_back(key.data());
+    argvlen.push_back(key.size());
+    for (const auto& value : values) {
+        argv.push_back(value.data());
+        argvlen.push_back(value.size());
+    }
+
+    redisReply* reply = (redisReply*)redisCommandArgv(redis, static_cast<int>(argv.size()), argv.data(), argvlen.data());
+    if (reply == NULL) {
+        std::cerr << "Redis RPUSH of " << values.size() << " values to " << key << " failed: "
+                  << (redis->err ? redis->errstr : "NULL reply") << std::endl;
+        return false;
+    }
+    bool ok = reply->type != REDIS_REPLY_ERROR;
+    if (!ok) {
+        std::cerr << "Redis RPUSH of " << values.size() << " values to " << key << " failed: " << reply->str << std::endl;
+    }
+    freeReplyObject(reply);
+    return ok;
 }
 
-// --- Helper: Download URL ---
-std::string download_url(const std::string& url) {
-    CURL* curl;
-    CURLcode res;
-    std::string readBuffer;
+// --- Helper: Pop URLs from Crawl Queue ---
+// Pops up to `count` URLs with one LPOP; sets queue_empty when the queue ran dry.
+std::vector<std::string> pop_crawl_urls(redisContext* redis, size_t count, bool& queue_empty) {
+    std::vector<std::string> urls;
+    redisReply* reply = (redisReply*)redisCommand(redis, "LPOP crawl_queue %d", static_cast<int>(count));
 
-    curl = curl_easy_init();
-    if(curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, CURL_TIMEOUT_SECONDS);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, "MaxSearchEngineBot/1.0 (Open source search engine)");
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
+    if (reply == NULL || reply->type == REDIS_REPLY_NIL) {
+        if (reply) freeReplyObject(reply);
+        queue_empty = true;
+        return urls;
+    }
 
-        res = curl_easy_perform(curl);
-        curl_easy_cleanup(curl);
+    if (reply->type != REDIS_REPLY_ARRAY) {
+        std::cerr << "Unexpected Redis reply type: " << reply->type << std::endl;
+        freeReplyObject(reply);
+        return urls;
+    }
 
-        if(res != CURLE_OK) {
-            std::cerr << "CURL failed: " << curl_easy_strerror(res) << std::endl;
-            return "";
+    urls.reserve(reply->elements);
+    for (size_t i = 0; i < reply->elements; ++i) {
+        redisReply* element = reply->element[i];
+        if (element && element->type == REDIS_REPLY_STRING) {
+            urls.emplace_back(element->str, element->len);
         }
     }
-    return readBuffer;
+    queue_empty = reply->elements < count;
+    freeReplyObject(reply);
+    return urls;
 }
 
-// --- Helper: Validate URL ---
-bool is_valid_url(const std::string& url) {
-    if (url.length() < MIN_URL_LENGTH) return false;
-    if (url.compare(0, 7, "http://") == 0) return true;
-    if (url.compare(0, 8, "https://") == 0) return true;
-    return false;
+// --- Helper: Collect Outlinks ---
+// Queues links from a fetched page that the URL-seen filter has not seen yet.
+void collect_new_links(const crawler::FetchResult& result, crawler::BloomFilter& seen_filter,
+                       std::vector<std::string>& pending_links) {
+    if (!result.success) return;
+    for (auto& link : crawler::extract_links(result.body, result.url, MAX_LINKS_PER_PAGE)) {
+        if (!is_valid_url(link) || seen_filter.possibly_contains(link)) continue;
+        seen_filter.insert(link);
+        pending_links.push_back(std::move(link));
+    }
+}
+
+// --- Helper: Push to Indexing Queue ---
+// One batched RPUSH per index shard. Returns the documents that could not be queued.
+std::vector<int> push_to_indexing_queue(redisContext* redis, const std::vector<int>& doc_ids) {
+    std::vector<std::vector<int>> by_shard(INDEX_SHARD_COUNT);
+    for (int doc_id : doc_ids) by_shard[((doc_id % INDEX_SHARD_COUNT) + INDEX_SHARD_COUNT) % INDEX_SHARD_COUNT].push_back(doc_id);
+
+    std::vector<int> failed;
+    for (int shard = 0; shard < INDEX_SHARD_COUNT; ++shard) {
+        if (by_shard[shard].empty()) continue;
+        std::string key = indexing_queue_key(shard, INDEX_SHARD_COUNT);
+        std::vector<std::string> values;
+        values.reserve(by_shard[shard].size());
+        for (int doc_id : by_shard[shard]) values.push_back(std::to_string(doc_id));
+
+        bool pushed = false;
+        for (int attempt = 0; attempt < INDEX_PUSH_MAX_RETRIES && !pushed; ++attempt) {
+            pushed = rpush_batch(redis, key, values);
+            if (!pushed) std::cerr << "Retrying " << key << " push (attempt " << (attempt + 1) << ")" << std::endl;
+        }
+        if (!pushed) failed.insert(failed.end(), by_shard[shard].begin(), by_shard[shard].end());
+    }
+    return failed;
+}
+
+// --- Helper: Flush Crawl State ---
+// Ends the WARC batch, commits buffered state transitions, then hands the newly crawled documents
+// to the indexer. The WARC flush comes first so no offset is published before its bytes are in the file.
+void flush_crawl_state(crawler::CrawlStateWriter& state_writer, crawler::WarcWriter& warc_writer,
+                       pqxx::connection& C, redisContext* redis) {
+    try {
+        common::ScopedTimer timer(METRICS.warc_flush);
+        warc_writer.flush();
+    } catch (const std::exception &e) {
+        std::cerr << "Failed to flush WARC file, postponing state flush: " << e.what() << std::endl;
+        return;
+    }
+
+    std::vector<int> crawled_ids;
+    try {
+        common::ScopedTimer timer(METRICS.db_write);
+        crawled_ids = state_writer.flush(C);
+    } catch (const std::exception &e) {
+        std::cerr << "Failed to flush crawl state (" << state_writer.pending() << " pending): " << e.what() << std::endl;
+        return;
+    }
+    if (crawled_ids.empty()) return;
+
+    LOG(Info) << "Committed " << crawled_ids.size() << " crawled documents";
+    std::vector<int> not_queued = push_to_indexing_queue(redis, crawled_ids);
+    METRICS.documents_committed.add(crawled_ids.size() - not_queued.size());
+    if (!not_queued.empty()) {
+        // Recorded with the next flush
+        for (int doc_id : not_queued) state_writer.mark_not_queued(doc_id);
+        std::cerr << "Failed to queue " << not_queued.size() << " docs for indexing after " << INDEX_PUSH_MAX_RETRIES
+                  << " attempts, marking as crawled_not_queued" << std::endl;
+    }
+}
+
+// --- Helper: Load Duplicate Index ---
+// Seeds the index with the fingerprints of the most recently crawled documents.
+void load_duplicate_index(crawler::DuplicateIndex& index, pqxx::connection& C) {
+    try {
+        size_t loaded = 0;
+        for (const auto& [doc_id, content_hash] : crawler::load_content_hashes(C, DUPLICATE_INDEX_MAX_DOCUMENTS)) {
+            if (auto fingerprint = crawler::parse_fingerprint(content_hash)) {
+                index.insert(doc_id, *fingerprint);
+                ++loaded;
+            }
+        }
+        std::cout << "Loaded " << loaded << " content fingerprints" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "Failed to load content fingerprints: " << e.what() << std::endl;
+    }
 }
 
-// --- Helper: Extract Filename ---
-std::string get_filename_from_path(const std::string& path) {
-    size_t found = path.find_last_of("/\\");
-    if (found != std::string::npos) {
-        return path.substr(found + 1);
+// --- Helper: Handle Archived Record ---
+// Buffers the new state of a page the WARC pool has finished; the DB update happens in batches.
+// Only stored pages join the duplicate index, so a page that failed to save never suppresses its copies.
+void handle_archived_record(const crawler::ArchivedRecord& record, crawler::CrawlStateWriter& state_writer,
+                            crawler::DuplicateIndex& duplicate_index,
+                            std::unordered_map<int, crawler::ContentFingerprint>& archiving_fingerprints) {
+    crawler::ContentFingerprint fingerprint = archiving_fingerprints[record.doc_id];
+    archiving_fingerprints.erase(record.doc_id);
+    if (!record.success) {
+        LOG_RATE_LIMITED(Warn, DOCUMENT_LOG_LINES_PER_SECOND) << "Error saving WARC for " << record.url << ": " << record.error;
+        METRICS.warc_errors.add();
+        state_writer.mark_failed(record.doc_id);
+        return;
     }
-    return path;
+    METRICS.compress.record(static_cast<uint64_t>(record.compress_time.count()));
+    METRICS.warc_append.record(static_cast<uint64_t>(record.append_time.count()));
+    METRICS.warc_bytes.add(static_cast<uint64_t>(record.info.length));
+
+    // E. Queue the DB update
+    duplicate_index.insert(record.doc_id, fingerprint);
+    state_writer.mark_crawled(record.doc_id, record.info.filename, record.info.offset, record.info.length,
+                              crawler::format_fingerprint(fingerprint));
+    LOG_RATE_LIMITED(Debug, DOCUMENT_LOG_LINES_PER_SECOND) << "Saved " << record.url << " to " << record.info.filename
+                                                           << " at offset " << record.info.offset << " (" << record.info.length << " bytes)";
 }
 
 int main() {
     std::cout << "--- Crawler Service Started (WARC Mode) ---" << std::endl;
+    common::set_log_level_from_env();
+
+    // Scraped from its own thread for as long as the crawler runs
+    std::unique_ptr<common::MetricsServer> metrics_server;
+    if (int port = get_metrics_port(); port > 0) {
+        try {
+            metrics_server = std::make_unique<common::MetricsServer>(common::metrics(), port);
+            std::cout << "Serving metrics on port " << metrics_server->port() << std::endl;
+        } catch (const std::exception &e) {
+            std::cerr << "Metrics endpoint disabled: " << e.what() << std::endl;
+        }
+    }
 
     curl_global_init(CURL_GLOBAL_DEFAULT);
 
@@ -137,117 +413,175 @@ int main() {
         return 1;
     }
 
-    // 4. Initialize WarcWriter
-    crawler::WarcWriter warc_writer(WARC_FILENAME);
-    std::string warc_db_filename = get_filename_from_path(WARC_FILENAME);
+    // 4. Initialize WarcWriter, rotating into "<WARC_DIR>/crawled-<id>-NNNNN.warc.gz" segments
+    crawler::WarcWriterOptions warc_options;
+    warc_options.batch_bytes = WARC_BATCH_BYTES;
+    warc_options.durability = WARC_DURABILITY;
+    warc_options.compression_level = WARC_COMPRESSION_LEVEL;
+    warc_options.max_segment_bytes = WARC_SEGMENT_MAX_BYTES;
+    warc_options.max_segment_age = std::chrono::seconds(WARC_SEGMENT_MAX_AGE_SECONDS);
+    const std::string crawler_id = get_crawler_id();
+    std::string warc_prefix = WARC_DIR + "/crawled-" + crawler_id;
+    crawler::WarcWriter warc_writer(warc_prefix, warc_options);
+    crawler::WarcWriterPool warc_pool(warc_writer, WARC_COMPRESSION_THREADS, WARC_COMPRESSION_QUEUE);
+    std::cout << "Writing WARC segments to " << warc_prefix << "-*.warc.gz" << std::endl;
+
+    // 5. Initialize Fetcher and Frontier
+    crawler::Fetcher fetcher(MAX_IN_FLIGHT_FETCHES, MAX_HOST_CONNECTIONS, CURL_TIMEOUT_SECONDS, USER_AGENT);
+    crawler::HostScheduler scheduler{std::chrono::seconds(CRAWL_DELAY_SECONDS)};
 
-    // 5. The Infinite Crawl Loop
+    // 6. Load the URL-seen filter. Links are checked against it before they are enqueued, so
+    //    Postgres only sees URLs that are probably new; it stays authoritative for the rest. One file per
+    //    replica, like the WARC segments: replicas sharing one would overwrite each other's inserts.
+    const std::string seen_filter_path = SEEN_FILTER_DIR + "/crawler_seen-" + crawler_id + ".bloom";
+    crawler::BloomFilter seen_filter = load_seen_filter(seen_filter_path);
+    auto last_filter_save = std::chrono::steady_clock::now();
+    uint64_t saved_filter_count = seen_filter.inserted_count();
+
+    // Discovered links waiting to be pushed to crawl_queue in one batch
+    std::vector<std::string> pending_links;
+    auto last_link_push = std::chrono::steady_clock::now();
+
+    // 7. Batch per-document state transitions into multi-row statements
+    crawler::CrawlStateWriter state_writer(STATE_FLUSH_BATCH, std::chrono::milliseconds(STATE_FLUSH_INTERVAL_MS));
+
+    // 8. Anything still 'processing' was in flight when a previous run stopped; crawl it again
+    try {
+        auto recovered = crawler::recover_processing(*C, crawler_id);
+        for (const auto& [doc_id, url] : recovered) {
+            seen_filter.insert(url);
+            scheduler.push(doc_id, url);
+        }
+        if (!recovered.empty()) {
+            std::cout << "Recovered " << recovered.size() << " documents left in 'processing'" << std::endl;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Failed to recover 'processing' documents: " << e.what() << std::endl;
+    }
+
+    // 9. Pages whose body (or, by SimHash, text) matches a stored page are recorded as duplicates
+    //    and neither archived nor indexed
+    crawler::DuplicateIndex duplicate_index(DUPLICATE_INDEX_MAX_DOCUMENTS, NEAR_DUPLICATE_MAX_DISTANCE);
+    load_duplicate_index(duplicate_index, *C);
+    std::unordered_map<int, crawler::ContentFingerprint> archiving_fingerprints;  // Pages in the WARC pool
+    auto last_metrics_sample = std::chrono::steady_clock::time_point();
+
+    // 10. The Infinite Crawl Loop
     while (true) {
-        reply = (redisReply*)redisCommand(redis, "LPOP crawl_queue");
-        
-        if (reply == NULL || reply->type == REDIS_REPLY_NIL) {
-            if (reply) freeReplyObject(reply);
-            std::this_thread::sleep_for(std::chrono::seconds(QUEUE_POLL_INTERVAL_SECONDS));
-            continue;
+        for (const auto& record : warc_pool.drain()) {
+            handle_archived_record(record, state_writer, duplicate_index, archiving_fingerprints);
         }
 
-        if (reply->type != REDIS_REPLY_STRING) {
-            std::cerr << "Unexpected Redis reply type: " << reply->type << std::endl;
-            freeReplyObject(reply);
-            continue;
+        auto loop_start = std::chrono::steady_clock::now();
+        if (pending_links.size() >= LINK_PUSH_BATCH ||
+            (!pending_links.empty() && loop_start - last_link_push >= std::chrono::milliseconds(LINK_PUSH_INTERVAL_MS))) {
+            if (rpush_batch(redis, "crawl_queue", pending_links)) pending_links.clear();
+            last_link_push = loop_start;
+        }
+        if (state_writer.should_flush(loop_start)) {
+            flush_crawl_state(state_writer, warc_writer, *C, redis);
+        }
+        if (loop_start - last_metrics_sample >= std::chrono::seconds(METRICS_SAMPLE_INTERVAL_SECONDS)) {
+            METRICS.crawl_queue.set(redis_list_length(redis, "crawl_queue"));
+            last_metrics_sample = loop_start;
         }
+        METRICS.frontier.set(static_cast<int64_t>(scheduler.size()));
+        METRICS.in_flight.set(static_cast<int64_t>(fetcher.in_flight()));
+        METRICS.warc_pending.set(static_cast<int64_t>(warc_pool.pending()));
 
-        std::string url = reply->str;
-        freeReplyObject(reply);
-        
-        if (!is_valid_url(url)) continue;
-        
-        std::cout << "Fetching: " << url << std::endl;
+        // A. Refill the in-memory frontier from the queue
+        bool queue_empty = false;
+        if (scheduler.size() < FRONTIER_MAX_PENDING) {
+            std::vector<std::string> urls;
+            for (auto& url : pop_crawl_urls(redis, FRONTIER_REFILL_BATCH, queue_empty)) {
+                if (is_valid_url(url)) urls.push_back(std::move(url));
+            }
 
-        // B. Insert into DB "Pending"
-        int doc_id = -1;
-        try {
-            pqxx::work W(*C);
-            
-            pqxx::result R = W.exec_params(
-                "INSERT INTO documents (url, status) VALUES ($1, 'processing') ON CONFLICT (url) DO NOTHING RETURNING id",
-                url
-            );
-            
-            if (R.empty()) {
-                std::cout << "Skipping duplicate: " << url << std::endl;
-                W.commit();
-                continue;
+            // B. Insert into DB "Pending", one statement for the whole batch
+            try {
+                auto claim_start = std::chrono::steady_clock::now();
+                auto claimed = crawler::claim_urls(*C, urls, crawler_id);
+                METRICS.db_claim.record(common::ScopedTimer::micros_since(claim_start));
+                for (const auto& url : urls) seen_filter.insert(url);
+                if (claimed.size() < urls.size()) {
+                    LOG(Debug) << "Skipping " << (urls.size() - claimed.size()) << " duplicate URLs";
+                }
+                for (const auto& [doc_id, url] : claimed) scheduler.push(doc_id, url);
+            } catch (const std::exception &e) {
+                std::cerr << "DB Error: " << e.what() << std::endl;
             }
-            
-            doc_id = R[0][0].as<int>();
-            W.commit();
-        } catch (const std::exception &e) {
-            std::cerr << "DB Error: " << e.what() << std::endl;
-            continue;
         }
 
-        // C. Download HTML
-        std::string html = download_url(url);
-        if (html.empty()) {
-            std::cerr << "Failed to download: " << url << std::endl;
-            continue;
+        // C. Start downloads for every host that is allowed to be fetched now
+        auto now = crawler::HostScheduler::Clock::now();
+        if (now - last_filter_save >= std::chrono::seconds(SEEN_FILTER_SAVE_INTERVAL_SECONDS) &&
+            seen_filter.inserted_count() != saved_filter_count) {
+            try {
+                seen_filter.save(seen_filter_path);
+                saved_filter_count = seen_filter.inserted_count();
+            } catch (const std::exception &e) {
+                std::cerr << "Failed to save URL-seen filter: " << e.what() << std::endl;
+            }
+            last_filter_save = now;
         }
 
-        // D. Save to WARC
-        try {
-            crawler::WarcRecordInfo info = warc_writer.write_record(url, html);
-
-            // E. Update DB
-            pqxx::work W(*C);
-            W.exec_params(
-                "UPDATE documents SET status = 'crawled', file_path = $1, \"offset\" = $2, length = $3 WHERE id = $4",
-                warc_db_filename, info.offset, info.length, doc_id
-            );
-            W.commit();
-            std::cout << "Saved to WARC at offset " << info.offset << " (" << info.length << " bytes)" << std::endl;
-
-            // F. Push to Indexing Queue with error handling and retries
-            const int MAX_RETRIES = 3;
-            bool push_success = false;
-            for (int attempt = 0; attempt < MAX_RETRIES; ++attempt) {
-                reply = (redisReply*)redisCommand(redis, "RPUSH indexing_queue %d", doc_id);
-                if (reply == NULL) {
-                    std::cerr << "Redis RPUSH failed for doc_id " << doc_id << " (attempt " << (attempt + 1) << "): NULL reply";
-                    if (redis->err) {
-                        std::cerr << ", Redis error: " << redis->errstr;
-                    }
-                    std::cerr << std::endl;
-                    // No reply to free
-                    continue;
-                }
-                if (reply->type == REDIS_REPLY_ERROR) {
-                    std::cerr << "Redis RPUSH error for doc_id " << doc_id << " (attempt " << (attempt + 1) << "): " << reply->str << std::endl;
-                    freeReplyObject(reply);
-                    continue;
-                }
-                // Success
-                freeReplyObject(reply);
-                push_success = true;
-                break;
+        crawler::ScheduledUrl next;
+        while (fetcher.has_capacity() && scheduler.pop_ready(now, next)) {
+            LOG_RATE_LIMITED(Debug, DOCUMENT_LOG_LINES_PER_SECOND) << "Fetching: " << next.url;
+            fetcher.submit(next.doc_id, next.url);
+        }
+
+        // With a free slot, never wait longer than it takes for the next host to become eligible
+        auto wait = std::chrono::milliseconds(FETCH_POLL_TIMEOUT_MS);
+        auto next_ready = scheduler.next_ready_time();
+        if (fetcher.has_capacity() && next_ready != crawler::HostScheduler::Clock::time_point::max()) {
+            wait = std::min(wait, std::chrono::duration_cast<std::chrono::milliseconds>(next_ready - now));
+            wait = std::max(wait, std::chrono::milliseconds(1));
+        }
+
+        if (fetcher.in_flight() == 0) {
+            if (warc_pool.pending() > 0) {
+                // Let the pool finish so its records are part of the flush below
+                warc_pool.wait_idle();
+                continue;
             }
-            if (!push_success) {
-                // Handle failure: update DB status to indicate not queued
-                try {
-                    pqxx::work W_fail(*C);
-                    W_fail.exec_params("UPDATE documents SET status = 'crawled_not_queued' WHERE id = $1", doc_id);
-                    W_fail.commit();
-                    std::cerr << "Failed to queue doc_id " << doc_id << " for indexing after " << MAX_RETRIES << " attempts, marked as crawled_not_queued" << std::endl;
-                } catch (const std::exception &e) {
-                    std::cerr << "Failed to update DB status for failed queue: " << e.what() << std::endl;
-                }
+            if (scheduler.empty() && queue_empty) {
+                // Nothing left to do: publish everything that is still buffered before idling
+                bool pushed_links = !pending_links.empty() && rpush_batch(redis, "crawl_queue", pending_links);
+                if (pushed_links) pending_links.clear();
+                if (!state_writer.empty()) flush_crawl_state(state_writer, warc_writer, *C, redis);
+                if (pushed_links) continue;
+                std::this_thread::sleep_for(std::chrono::seconds(QUEUE_POLL_INTERVAL_SECONDS));
+            } else if (!scheduler.empty()) {
+                std::this_thread::sleep_for(wait);
             }
+            continue;
+        }
 
-        } catch (const std::exception &e) {
-            std::cerr << "Error saving WARC/DB: " << e.what() << std::endl;
+        // D. Drive transfers and hand finished pages to the WARC pool for compression
+        for (auto& result : fetcher.poll(static_cast<int>(wait.count()))) {
+            scheduler.release(result.url, crawler::HostScheduler::Clock::now());
+            if (!result.success) {
+                LOG_RATE_LIMITED(Warn, DOCUMENT_LOG_LINES_PER_SECOND) << "Failed to download: " << result.url << " (" << result.error << ")";
+                METRICS.fetch_errors.add();
+                state_writer.mark_failed(result.doc_id);
+                continue;
+            }
+            METRICS.fetch.record(static_cast<uint64_t>(result.total_seconds * 1e6));
+            METRICS.pages_fetched.add();
+            METRICS.fetched_bytes.add(result.body.size());
+            collect_new_links(result, seen_filter, pending_links);
+
+            crawler::ContentFingerprint fingerprint = crawler::fingerprint_content(result.body);
+            if (auto original = duplicate_index.lookup(fingerprint)) {
+                LOG_RATE_LIMITED(Debug, DOCUMENT_LOG_LINES_PER_SECOND) << "Duplicate of doc " << *original << ": " << result.url;
+                METRICS.duplicates.add();
+                state_writer.mark_duplicate(result.doc_id, crawler::format_fingerprint(fingerprint));
+                continue;
+            }
+            archiving_fingerprints[result.doc_id] = fingerprint;
+            warc_pool.submit(result.doc_id, std::move(result.url), std::move(result.body));
         }
-        
-        std::this_thread::sleep_for(std::chrono::seconds(CRAWL_DELAY_SECONDS));
     }
 
     return 0;
@@ -0,0 +1,186 @@
+#include "url_utils.hpp"
+#include <algorithm>
+#include <cctype>
+#include <vector>
+
+namespace crawler {
+
+namespace {
+
+struct UrlParts {
+    std::string scheme;
+    std::string authority;
+    std::string path;
+    std::string query;  // Includes the leading '?', or empty
+};
+
+std::string to_lower(std::string_view s) {
+    std::string out(s);
+    std::transform(out.begin(), out.end(), out.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return out;
+}
+
+// Length of a leading "scheme:" (excluding the colon), or 0 if there is none.
+size_t scheme_length(std::string_view s) {
+    if (s.empty() || !std::isalpha(static_cast<unsigned char>(s[0]))) return 0;
+    for (size_t i = 1; i < s.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c == ':') return i;
+        if (!std::isalnum(c) && c != '+' && c != '-' && c != '.') return 0;
+    }
+    return 0;
+}
+
+// Split an absolute "scheme://authority/path?query" URL (fragment already removed).
+bool split_url(std::string_view url, UrlParts& parts) {
+    size_t scheme_len = scheme_length(url);
+    if (scheme_len == 0 || url.compare(scheme_len, 3, "://") != 0) return false;
+
+    parts.scheme = to_lower(url.substr(0, scheme_len));
+    size_t pos = scheme_len + 3;
+    size_t authority_end = url.find_first_of("/?", pos);
+    if (authority_end == std::string_view::npos) authority_end = url.size();
+    parts.authority = std::string(url.substr(pos, authority_end - pos));
+
+    size_t query_start = url.find('?', authority_end);
+    if (query_start == std::string_view::npos) query_start = url.size();
+    parts.path = std::string(url.substr(authority_end, query_start - authority_end));
+    parts.query = std::string(url.substr(query_start));
+    return true;
+}
+
+std::string normalize_authority(const std::string& scheme, std::string_view authority) {
+    // Credentials in links are never crawled with, so they are dropped entirely
+    size_t at = authority.rfind('@');
+    if (at != std::string_view::npos) authority.remove_prefix(at + 1);
+
+    std::string host = to_lower(authority);
+    if (!host.empty() && host.back() == '.') host.pop_back();
+
+    size_t colon = host.rfind(':');
+    if (colon != std::string::npos && host.find(']', colon) == std::string::npos) {
+        std::string_view port(host.c_str() + colon + 1, host.size() - colon - 1);
+        if (port.empty() || (scheme == "http" && port == "80") || (scheme == "https" && port == "443")) {
+            host.resize(colon);
+        }
+    }
+    return host;
+}
+
+std::string remove_dot_segments(std::string_view path) {
+    std::vector<std::string_view> segments;
+    bool trailing_slash = false;
+
+    size_t pos = 1;  // Skip the leading '/'
+    while (pos <= path.size()) {
+        size_t end = path.find('/', pos);
+        if (end == std::string_view::npos) end = path.size();
+        std::string_view segment = path.substr(pos, end - pos);
+        bool last = end == path.size();
+
+        if (segment == ".") {
+            trailing_slash = last;
+        } else if (segment == "..") {
+            if (!segments.empty()) segments.pop_back();
+            trailing_slash = last;
+        } else {
+            segments.push_back(segment);
+            trailing_slash = false;
+        }
+        pos = end + 1;
+    }
+
+    std::string out;
+    for (std::string_view segment : segments) {
+        out += '/';
+        out.append(segment);
+    }
+    if (out.empty() || trailing_slash) out += '/';
+    return out;
+}
+
+// Strip surrounding whitespace, drop embedded tabs/newlines, decode "&amp;" and escape spaces.
+std::string clean_href(std::string_view href) {
+    while (!href.empty() && std::isspace(static_cast<unsigned char>(href.front()))) href.remove_prefix(1);
+    while (!href.empty() && std::isspace(static_cast<unsigned char>(href.back()))) href.remove_suffix(1);
+
+    std::string out;
+    out.reserve(href.size());
+    for (size_t i = 0; i < href.size(); ++i) {
+        char c = href[i];
+        if (c == '\t' || c == '\n' || c == '\r') continue;
+        if (c == ' ') {
+            out += "%20";
+        } else if (c == '&' && href.compare(i, 5, "&amp;") == 0) {
+            out += '&';
+            i += 4;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+std::string extract_host(const std::string& url) {
+    size_t scheme_end = url.find("://");
+    if (scheme_end == std::string::npos) return "";
+
+    size_t start = scheme_end + 3;
+    size_t end = url.find_first_of("/?#", start);
+    if (end == std::string::npos) end = url.size();
+
+    // Drop any "user:password@" prefix
+    size_t at = url.rfind('@', end);
+    if (at != std::string::npos && at >= start) start = at + 1;
+
+    return to_lower(std::string_view(url).substr(start, end - start));
+}
+
+std::string resolve_url(const std::string& base_url, std::string_view href) {
+    std::string ref = clean_href(href);
+    size_t fragment = ref.find('#');
+    if (fragment != std::string::npos) ref.resize(fragment);
+    if (ref.empty()) return "";  // Same-document reference
+
+    UrlParts parts;
+    if (scheme_length(ref) > 0) {
+        if (!split_url(ref, parts)) return "";
+    } else {
+        UrlParts base;
+        std::string base_clean = base_url.substr(0, base_url.find('#'));
+        if (!split_url(base_clean, base)) return "";
+        parts.scheme = base.scheme;
+
+        if (ref.compare(0, 2, "//") == 0) {
+            if (!split_url(base.scheme + ":" + ref, parts)) return "";
+        } else if (ref[0] == '/') {
+            parts.authority = base.authority;
+            size_t query_start = ref.find('?');
+            parts.path = ref.substr(0, query_start);
+            parts.query = query_start == std::string::npos ? "" : ref.substr(query_start);
+        } else if (ref[0] == '?') {
+            parts.authority = base.authority;
+            parts.path = base.path;
+            parts.query = ref;
+        } else {
+            parts.authority = base.authority;
+            size_t query_start = ref.find('?');
+            std::string directory = base.path.substr(0, base.path.rfind('/') + 1);
+            if (directory.empty()) directory = "/";
+            parts.path = directory + ref.substr(0, query_start);
+            parts.query = query_start == std::string::npos ? "" : ref.substr(query_start);
+        }
+    }
+
+    if (parts.scheme != "http" && parts.scheme != "https") return "";
+    std::string authority = normalize_authority(parts.scheme, parts.authority);
+    if (authority.empty()) return "";
+
+    std::string path = parts.path.empty() ? "/" : remove_dot_segments(parts.path);
+    return parts.scheme + "://" + authority + path + parts.query;
+}
+
+} // namespace crawler
@@ -0,0 +1,20 @@
+#ifndef URL_UTILS_HPP
+#define URL_UTILS_HPP
+
+#include <string>
+#include <string_view>
+
+namespace crawler {
+
+// Extract the lowercase host (including any explicit port) from an absolute URL.
+// Returns an empty string if the URL has no "scheme://" prefix.
+std::string extract_host(const std::string& url);
+
+// Resolve `href` against `base_url` and normalize the result: lowercase scheme and host,
+// default ports removed, dot segments collapsed, fragment dropped, empty path -> "/".
+// Returns an empty string for anything that is not an http(s) URL (mailto:, javascript:, ...).
+std::string resolve_url(const std::string& base_url, std::string_view href);
+
+} // namespace crawler
+
+#endif // URL_UTILS_HPP
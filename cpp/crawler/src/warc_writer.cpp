@@ -5,47 +5,257 @@
 #include <cstring>
 #include <stdexcept>
 #include <random>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <zlib.h>
 
 namespace crawler {
 
-WarcWriter::WarcWriter(const std::string& filename) : filename(filename) {
-    file_stream.open(filename, std::ios::binary | std::ios::app);
-    if (!file_stream.is_open()) {
-        throw std::runtime_error("Failed to open WARC file: " + filename);
+namespace {
+
+const std::string SEGMENT_SUFFIX = ".warc.gz";
+
+std::string base_name(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+std::string segment_path(const std::string& prefix, uint64_t number) {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "-%05llu", static_cast<unsigned long long>(number));
+    return prefix + suffix + SEGMENT_SUFFIX;
+}
+
+// Parses N out of "<prefix_name>-N.warc.gz"; false for any other file name.
+bool parse_segment_number(const std::string& name, const std::string& prefix_name, uint64_t& number) {
+    if (name.size() <= prefix_name.size() + 1 + SEGMENT_SUFFIX.size()) return false;
+    if (name.compare(0, prefix_name.size(), prefix_name) != 0 || name[prefix_name.size()] != '-') return false;
+    if (name.compare(name.size() - SEGMENT_SUFFIX.size(), SEGMENT_SUFFIX.size(), SEGMENT_SUFFIX) != 0) return false;
+
+    std::string digits = name.substr(prefix_name.size() + 1, name.size() - prefix_name.size() - 1 - SEGMENT_SUFFIX.size());
+    if (digits.empty() || !std::all_of(digits.begin(), digits.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return false;
     }
+    number = std::stoull(digits);
+    return true;
+}
+
+// Opens `path` for appending and reports its current size.
+int open_append(const std::string& path, int64_t& size) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open WARC file: " + path);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Failed to stat WARC file: " + path);
+    }
+    size = st.st_size;
+    return fd;
+}
+
+} // namespace
+
+WarcWriter::WarcWriter(const std::string& filename, const WarcWriterOptions& options)
+    : fd(-1), filename(filename), options(options), next_offset(0),
+      rotating(options.max_segment_bytes > 0 || options.max_segment_age.count() > 0) {
+    buffer.reserve(options.batch_bytes);
+    if (!rotating) {
+        fd = open_append(filename, next_offset);
+        record_filename = base_name(filename);
+        return;
+    }
+
+    // Continue numbering after every segment this prefix has ever produced, including
+    // segments that were moved away after being listed in the manifest.
+    prefix = filename;
+    manifest_path = prefix + ".manifest";
+    segments = load_manifest(manifest_path);
+
+    std::string prefix_name = base_name(prefix);
+    uint64_t number = 0;
+    for (const auto& segment : segments) {
+        if (parse_segment_number(segment.filename, prefix_name, number)) segment_number = std::max(segment_number, number);
+    }
+    std::filesystem::path dir = std::filesystem::path(prefix).parent_path();
+    if (dir.empty()) dir = ".";
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (parse_segment_number(entry.path().filename().string(), prefix_name, number)) {
+            segment_number = std::max(segment_number, number);
+        }
+    }
+
+    open_next_segment();
+    write_manifest();
 }
 
 WarcWriter::~WarcWriter() {
-    if (file_stream.is_open()) {
-        file_stream.close();
+    if (fd >= 0) {
+        try {
+            std::lock_guard<std::mutex> lock(write_mutex);
+            write_buffer();
+            if (rotating) write_manifest();
+        } catch (const std::exception&) {
+            // Nothing sensible to do from a destructor; the records were never published.
+        }
+        ::close(fd);
     }
 }
 
 WarcRecordInfo WarcWriter::write_record(const std::string& url, const std::string& content) {
+    return append_record(compress_record(url, content));
+}
+
+std::string WarcWriter::compress_record(const std::string& url, const std::string& content) const {
+    std::string full_record = create_warc_header(url, content.size());
+    full_record.reserve(full_record.size() + content.size() + 4);
+    full_record += content;
+    full_record += "\r\n\r\n";
+    return compress_string(full_record, options.compression_level);
+}
+
+WarcRecordInfo WarcWriter::append_record(const std::string& compressed_record) {
     std::lock_guard<std::mutex> lock(write_mutex);
-    
-    std::string warc_header = create_warc_header(url, content.size());
-    std::string full_record = warc_header + content + "\r\n\r\n";
-    std::string compressed_record = compress_string(full_record);
+    rotate_if_needed(compressed_record.size());
 
-    file_stream.seekp(0, std::ios::end);
-    int64_t offset = file_stream.tellp();
-    
-    file_stream.write(compressed_record.data(), compressed_record.size());
-    
-    if (!file_stream.good()) {
-        throw std::runtime_error("Failed to write WARC record to file: write error");
+    int64_t offset = next_offset;
+    buffer.insert(buffer.end(), compressed_record.begin(), compressed_record.end());
+    next_offset += static_cast<int64_t>(compressed_record.size());
+    if (rotating) {
+        ++segments.back().records;
+        segments.back().end_offset = next_offset;
     }
-    
-    // Ensure data is written to disk
-    file_stream.flush();
-    
-    if (!file_stream.good()) {
-        throw std::runtime_error("Failed to write WARC record to file: flush error");
+
+    if (buffer.size() >= options.batch_bytes) {
+        try {
+            write_buffer();
+        } catch (const std::exception&) {
+            // The caller treats a throw as "not archived", so the record must never reach the file later,
+            // at an offset nothing points to: take it back out. If part of it was already written, it can
+            // only be completed; it stays buffered and keeps the offset returned here.
+            if (buffer.size() < compressed_record.size()) {
+                return {offset, static_cast<int64_t>(compressed_record.size()), record_filename};
+            }
+            buffer.resize(buffer.size() - compressed_record.size());
+            next_offset = offset;
+            if (rotating) {
+                --segments.back().records;
+                segments.back().end_offset = offset;
+            }
+            throw;
+        }
+    }
+
+    return {offset, static_cast<int64_t>(compressed_record.size()), record_filename};
+}
+
+void WarcWriter::flush() {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    if (options.durability == WarcDurability::None) return;
+
+    write_buffer();
+    if (options.durability == WarcDurability::FdatasyncPerBatch) sync();
+    if (rotating) write_manifest();
+}
+
+std::vector<WarcSegmentInfo> WarcWriter::load_manifest(const std::string& path) {
+    std::vector<WarcSegmentInfo> segments;
+    std::ifstream in(path);
+    if (!in) return segments;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        WarcSegmentInfo segment;
+        if (!(fields >> segment.filename >> segment.records >> segment.start_offset >> segment.end_offset)) {
+            throw std::runtime_error("Malformed WARC manifest line in " + path + ": " + line);
+        }
+        segments.push_back(std::move(segment));
     }
+    return segments;
+}
 
-    return {offset, static_cast<int64_t>(compressed_record.size())};
+void WarcWriter::open_next_segment() {
+    uint64_t number = segment_number + 1;
+    std::string path = segment_path(prefix, number);
+    int64_t size = 0;
+    int new_fd = open_append(path, size);  // The old segment stays active if this throws
+
+    if (fd >= 0) ::close(fd);
+    fd = new_fd;
+    filename = path;
+    record_filename = base_name(path);
+    next_offset = size;
+    segment_number = number;
+    segment_opened = std::chrono::steady_clock::now();
+    segments.push_back({record_filename, 0, size, size});
+}
+
+void WarcWriter::rotate_if_needed(size_t incoming_bytes) {
+    // A segment always gets at least one record, even one larger than max_segment_bytes
+    if (!rotating || segments.back().records == 0) return;
+
+    bool too_big = options.max_segment_bytes > 0 &&
+                   static_cast<uint64_t>(next_offset) + incoming_bytes > options.max_segment_bytes;
+    bool too_old = options.max_segment_age.count() > 0 &&
+                   std::chrono::steady_clock::now() - segment_opened >= options.max_segment_age;
+    if (!too_big && !too_old) return;
+
+    // Records already handed out for this segment must be complete before it is closed;
+    // flush() only ever syncs the active segment.
+    write_buffer();
+    if (options.durability == WarcDurability::FdatasyncPerBatch) sync();
+    open_next_segment();
+    write_manifest();
+}
+
+void WarcWriter::sync() {
+    if (::fdatasync(fd) != 0) {
+        throw std::runtime_error("Failed to sync WARC file " + filename + ": " + std::strerror(errno));
+    }
+}
+
+void WarcWriter::write_manifest() const {
+    std::string tmp_path = manifest_path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::trunc);
+        out << "# filename\trecords\tstart_offset\tend_offset\n";
+        for (const auto& segment : segments) {
+            out << segment.filename << '\t' << segment.records << '\t'
+                << segment.start_offset << '\t' << segment.end_offset << '\n';
+        }
+        if (!out.flush()) {
+            throw std::runtime_error("Failed to write WARC manifest: " + tmp_path);
+        }
+    }
+    if (std::rename(tmp_path.c_str(), manifest_path.c_str()) != 0) {
+        throw std::runtime_error("Failed to replace WARC manifest " + manifest_path + ": " + std::strerror(errno));
+    }
+}
+
+void WarcWriter::write_buffer() {
+    size_t written = 0;
+    while (written < buffer.size()) {
+        ssize_t n = ::write(fd, buffer.data() + written, buffer.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            int err = errno;
+            buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(written));
+            throw std::runtime_error("Failed to write WARC record to file: " + std::string(std::strerror(err)));
+        }
+        written += static_cast<size_t>(n);
+    }
+    buffer.clear();
 }
 
 std::string WarcWriter::create_warc_header(const std::string& url, size_t content_length) {
@@ -73,8 +283,8 @@ std::string WarcWriter::create_warc_header(const std::string& url, size_t conten
 }
 
 std::string WarcWriter::generate_uuid() {
-    static std::random_device rd;
-    thread_local std::mt19937_64 gen(rd());
+    // Seeded per thread: compress_record() runs concurrently on worker threads
+    thread_local std::mt19937_64 gen(std::random_device{}());
     thread_local std::uniform_int_distribution<uint64_t> dis;
 
     uint64_t part1 = dis(gen);
@@ -96,43 +306,61 @@ std::string WarcWriter::generate_uuid() {
     return ss.str();
 }
 
-std::string WarcWriter::compress_string(const std::string& str) {
+namespace {
+
+// Per-thread deflate state, reset between records instead of being set up and torn down each time
+struct DeflateStream {
     z_stream zs;
-    memset(&zs, 0, sizeof(zs));
+    int level;
+    bool initialized = false;
 
-    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 | 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
-        throw std::runtime_error("deflateInit2 failed while compressing.");
+    ~DeflateStream() {
+        if (initialized) deflateEnd(&zs);
     }
 
-    // RAII-style cleanup for z_stream to ensure deflateEnd is called
-    struct ZStreamGuard {
-        z_stream* zs_ptr;
-        ~ZStreamGuard() { deflateEnd(zs_ptr); }
-    } guard{&zs};
-
-    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(str.data()));
-    zs.avail_in = str.size();
-
-    int ret;
-    char outbuffer[32768];
-    std::string outstring;
+    z_stream& get(int wanted_level) {
+        if (initialized && level != wanted_level) {
+            deflateEnd(&zs);
+            initialized = false;
+        }
+        if (!initialized) {
+            memset(&zs, 0, sizeof(zs));
+            // 15 | 16: maximum window with a gzip header, so every record is a standalone gzip member
+            if (deflateInit2(&zs, wanted_level, Z_DEFLATED, 15 | 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                throw std::runtime_error("deflateInit2 failed while compressing.");
+            }
+            initialized = true;
+            level = wanted_level;
+        } else if (deflateReset(&zs) != Z_OK) {
+            throw std::runtime_error("deflateReset failed while compressing.");
+        }
+        return zs;
+    }
+};
 
-    do {
-        zs.next_out = reinterpret_cast<Bytef*>(outbuffer);
-        zs.avail_out = sizeof(outbuffer);
+} // namespace
 
-        ret = deflate(&zs, Z_FINISH);
+std::string WarcWriter::compress_string(const std::string& str, int level) {
+    thread_local DeflateStream stream;
+    z_stream& zs = stream.get(level);
 
-        if (outstring.size() < zs.total_out) {
-            outstring.append(outbuffer, zs.total_out - outstring.size());
-        }
-    } while (ret == Z_OK);
+    // deflateBound() is an upper bound for a single Z_FINISH call, so the output never has to grow
+    std::string outstring(deflateBound(&zs, str.size()), '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(str.data()));
+    zs.avail_in = str.size();
+    zs.next_out = reinterpret_cast<Bytef*>(&outstring[0]);
+    zs.avail_out = outstring.size();
 
+    int ret = deflate(&zs, Z_FINISH);
     if (ret != Z_STREAM_END) {
         std::string msg = zs.msg ? zs.msg : "unknown error";
+        // Force a fresh stream for the next record on this thread
+        deflateEnd(&zs);
+        stream.initialized = false;
         throw std::runtime_error("Exception during zlib compression: (" + std::to_string(ret) + ") " + msg);
     }
 
+    outstring.resize(zs.total_out);
     return outstring;
 }
 
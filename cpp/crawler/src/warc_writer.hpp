@@ -2,9 +2,9 @@
 #define WARC_WRITER_HPP
 
 #include <string>
-#include <fstream>
 #include <vector>
 #include <cstdint>
+#include <chrono>
 #include <mutex>
 
 namespace crawler {
@@ -12,13 +12,56 @@ namespace crawler {
 struct WarcRecordInfo {
     int64_t offset;  // Byte offset where the compressed record starts in the WARC file
     int64_t length;  // Length of the compressed record in bytes
+    std::string filename;  // Name (without directory) of the WARC file holding the record
+};
+
+/**
+ * @brief One line of a segment manifest: a WARC segment and the records it holds.
+ */
+struct WarcSegmentInfo {
+    std::string filename;  // Segment name, without directory
+    uint64_t records;      // Records in [start_offset, end_offset)
+    int64_t start_offset;
+    int64_t end_offset;
+};
+
+/**
+ * @brief What WarcWriter::flush() guarantees once it returns.
+ */
+enum class WarcDurability {
+    None,               ///< flush() is a no-op; records reach the file when the buffer fills or on close
+    FlushPerBatch,      ///< flush() hands buffered records to the OS (visible to readers, survives a process crash)
+    FdatasyncPerBatch,  ///< flush() also calls fdatasync() (survives power loss)
+};
+
+struct WarcWriterOptions {
+    size_t batch_bytes = 1 << 20;  // Buffered bytes that trigger a write on their own
+    WarcDurability durability = WarcDurability::FlushPerBatch;
+    int compression_level = -1;    // zlib level: 1 (fastest) .. 9 (smallest), -1 for zlib's default (6)
+
+    // Rotation. When either limit is set, the path given to WarcWriter is a prefix: records go to
+    // numbered segments "<prefix>-00001.warc.gz", ... and "<prefix>.manifest" lists them.
+    uint64_t max_segment_bytes = 0;                 // 0 = no size limit
+    std::chrono::seconds max_segment_age{0};        // 0 = no age limit
 };
 
 /**
  * @brief Writes web crawl data to a WARC (Web ARChive) format file with gzip compression.
  *
  * This class is responsible for creating and writing WARC records to a file, with each record compressed using gzip.
- * 
+ * Records are appended to an in-memory buffer and written in large batches. The append position is tracked in
+ * memory, so offsets are returned immediately and stay exact. A record is only guaranteed to be readable from the
+ * file after the next flush(); callers must flush before publishing offsets to readers.
+ *
+ * Compression happens outside the write lock, so concurrent callers compress in parallel and only the final
+ * append is serialized. compress_record() and append_record() expose the two halves for callers that run
+ * compression on their own threads (see WarcWriterPool).
+ *
+ * With rotation enabled, a new segment is started whenever the current one would exceed max_segment_bytes or
+ * is older than max_segment_age. Each run starts a fresh segment numbered after the highest existing one, so
+ * a segment is only ever written by one process. The manifest is rewritten atomically on every flush() and
+ * rotation and describes everything up to the last flush.
+ *
  * @note This class is thread-safe. Multiple threads can safely call write_record() concurrently.
  */
 class WarcWriter {
@@ -26,20 +69,25 @@ public:
     /**
      * @brief Constructs a WarcWriter to write to the specified file.
      * @param filename The path to the WARC file to write. If the file does not exist, it will be created.
+     *                 Existing files are appended to. With rotation enabled this is the segment prefix instead.
+     * @param options Batching and durability settings.
      * @throws std::runtime_error if the file cannot be opened for writing.
      */
-    explicit WarcWriter(const std::string& filename);
+    explicit WarcWriter(const std::string& filename, const WarcWriterOptions& options = WarcWriterOptions());
     
     /**
-     * @brief Destructor. Closes the WARC file if open.
+     * @brief Destructor. Writes any buffered records and closes the WARC file.
      */
     ~WarcWriter();
 
+    WarcWriter(const WarcWriter&) = delete;
+    WarcWriter& operator=(const WarcWriter&) = delete;
+
     /**
      * @brief Writes a compressed WARC record for the given URL and content.
      *
      * The method creates a WARC record for the specified URL and content, compresses it using gzip,
-     * and writes it to the output file.
+     * and appends it to the write buffer. The buffer is written out once it reaches options.batch_bytes.
      *
      * @param url The URL associated with the WARC record. Must be a valid, absolute URL as a UTF-8 encoded string.
      * @param content The content to store in the WARC record. Should be a UTF-8 encoded string containing the HTTP response or payload.
@@ -50,14 +98,66 @@ public:
      */
     WarcRecordInfo write_record(const std::string& url, const std::string& content);
 
+    /**
+     * @brief Builds and gzip-compresses a complete WARC record without touching the file.
+     *
+     * @return One self-contained gzip member, ready for append_record().
+     * @throws std::runtime_error if compression fails.
+     * @note This method is thread-safe and takes no lock. Each thread reuses its own deflate state.
+     */
+    std::string compress_record(const std::string& url, const std::string& content) const;
+
+    /**
+     * @brief Appends a record produced by compress_record() to the write buffer.
+     *
+     * @return The offset and length of the record in the WARC file.
+     * @throws std::runtime_error if the buffer had to be written out and writing failed before reaching
+     *         the record. The record is then not appended; earlier records stay buffered for the next write.
+     * @note This method is thread-safe.
+     */
+    WarcRecordInfo append_record(const std::string& compressed_record);
+
+    /**
+     * @brief Ends the current batch: writes buffered records and applies the configured durability.
+     *
+     * @throws std::runtime_error if writing or syncing fails. Unwritten bytes stay buffered,
+     *         so a later flush() resumes exactly where this one stopped.
+     * @note This method is thread-safe.
+     */
+    void flush();
+
+    /**
+     * @brief Reads a manifest written by a rotating WarcWriter.
+     * @return The segments in the order they were written; empty if the manifest does not exist.
+     * @throws std::runtime_error if the manifest is malformed.
+     */
+    static std::vector<WarcSegmentInfo> load_manifest(const std::string& path);
+
 private:
-    std::ofstream file_stream;
-    std::string filename;
-    std::mutex write_mutex;  // Protects file operations for thread-safety
+    int fd;
+    std::string filename;    // Current file (the active segment when rotating)
+    std::string record_filename;  // filename without its directory, as reported in WarcRecordInfo
+    WarcWriterOptions options;
+    std::mutex write_mutex;  // Protects the buffer, the offset, the segment state and file operations
+    std::vector<char> buffer;
+    int64_t next_offset;     // File offset the next record will be written at
+
+    bool rotating;
+    std::string prefix;
+    std::string manifest_path;
+    uint64_t segment_number = 0;
+    std::chrono::steady_clock::time_point segment_opened;
+    std::vector<WarcSegmentInfo> segments;  // Finished segments plus the active one (last)
+
+    void open_next_segment();
+    void rotate_if_needed(size_t incoming_bytes);
+    void write_buffer();
+    void sync();
+    void write_manifest() const;
 
-    std::string create_warc_header(const std::string& url, size_t content_length);
-    std::string compress_string(const std::string& str);
-    std::string generate_uuid();
+    static std::string create_warc_header(const std::string& url, size_t content_length);
+    static std::string compress_string(const std::string& str, int level);
+    static std::string generate_uuid();
 };
 
 } // namespace crawler
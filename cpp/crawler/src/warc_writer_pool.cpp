@@ -0,0 +1,86 @@
+#include "warc_writer_pool.hpp"
+#include <exception>
+#include <utility>
+
+namespace crawler {
+
+WarcWriterPool::WarcWriterPool(WarcWriter& writer, size_t num_threads, size_t max_queued)
+    : writer(writer), max_queued(max_queued > 0 ? max_queued : 1) {
+    if (num_threads == 0) num_threads = 1;
+    workers.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers.emplace_back(&WarcWriterPool::worker_loop, this);
+    }
+}
+
+WarcWriterPool::~WarcWriterPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    job_ready.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void WarcWriterPool::submit(int doc_id, std::string url, std::string body) {
+    std::unique_lock<std::mutex> lock(mutex);
+    job_taken.wait(lock, [this] { return jobs.size() < max_queued; });
+    jobs.push_back({doc_id, std::move(url), std::move(body)});
+    lock.unlock();
+    job_ready.notify_one();
+}
+
+std::vector<ArchivedRecord> WarcWriterPool::drain() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<ArchivedRecord> out;
+    out.swap(done);
+    return out;
+}
+
+void WarcWriterPool::wait_idle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    job_taken.wait(lock, [this] { return jobs.empty() && active == 0; });
+}
+
+size_t WarcWriterPool::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return jobs.size() + active + done.size();
+}
+
+void WarcWriterPool::worker_loop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            job_ready.wait(lock, [this] { return stopping || !jobs.empty(); });
+            // Drain the queue before honouring stop so no submitted page is lost
+            if (jobs.empty()) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            ++active;
+        }
+        job_taken.notify_all();
+
+        ArchivedRecord record{job.doc_id, std::move(job.url), false, {}, ""};
+        try {
+            auto start = std::chrono::steady_clock::now();
+            std::string compressed = writer.compress_record(record.url, job.body);
+            auto compressed_at = std::chrono::steady_clock::now();
+            record.info = writer.append_record(compressed);
+            record.compress_time = std::chrono::duration_cast<std::chrono::microseconds>(compressed_at - start);
+            record.append_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - compressed_at);
+            record.success = true;
+        } catch (const std::exception& e) {
+            record.error = e.what();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.push_back(std::move(record));
+            --active;
+        }
+        job_taken.notify_all();
+    }
+}
+
+} // namespace crawler
@@ -0,0 +1,87 @@
+#ifndef WARC_WRITER_POOL_HPP
+#define WARC_WRITER_POOL_HPP
+
+#include "warc_writer.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace crawler {
+
+struct ArchivedRecord {
+    int doc_id;
+    std::string url;
+    bool success;
+    WarcRecordInfo info;  // Valid when success is true
+    std::string error;    // Set when success is false
+    std::chrono::microseconds compress_time{0};  // compress_record()
+    std::chrono::microseconds append_time{0};    // append_record(), including waiting for the writer
+};
+
+/**
+ * @brief Compresses and appends WARC records on a pool of worker threads.
+ *
+ * The crawl loop hands fetched pages to submit() and picks up finished records with drain().
+ * Workers run WarcWriter::compress_record() in parallel; only WarcWriter::append_record() is
+ * serialized. Every record returned by drain() has already been appended, so a subsequent
+ * WarcWriter::flush() covers it.
+ *
+ * @note submit(), drain() and wait_idle() may be called from any thread.
+ */
+class WarcWriterPool {
+public:
+    /**
+     * @param writer Destination for the records; must outlive the pool.
+     * @param num_threads Number of compression workers (at least one is started).
+     * @param max_queued Pages waiting for a worker before submit() blocks.
+     */
+    WarcWriterPool(WarcWriter& writer, size_t num_threads, size_t max_queued);
+
+    /**
+     * @brief Finishes every submitted page, then stops the workers.
+     */
+    ~WarcWriterPool();
+
+    WarcWriterPool(const WarcWriterPool&) = delete;
+    WarcWriterPool& operator=(const WarcWriterPool&) = delete;
+
+    // Queues a page for archiving. Blocks while max_queued pages are already waiting.
+    void submit(int doc_id, std::string url, std::string body);
+
+    // Returns the records finished since the last call, in completion order.
+    std::vector<ArchivedRecord> drain();
+
+    // Blocks until every submitted page has been archived (finished records stay available to drain()).
+    void wait_idle();
+
+    // Pages submitted but not yet returned by drain().
+    size_t pending() const;
+
+private:
+    struct Job {
+        int doc_id;
+        std::string url;
+        std::string body;
+    };
+
+    void worker_loop();
+
+    WarcWriter& writer;
+    size_t max_queued;
+    mutable std::mutex mutex;
+    std::condition_variable job_ready;   // Signalled when a job is queued or the pool stops
+    std::condition_variable job_taken;   // Signalled when queue space frees up or a job finishes
+    std::deque<Job> jobs;
+    std::vector<ArchivedRecord> done;
+    size_t active = 0;                   // Jobs currently being processed by a worker
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+} // namespace crawler
+
+#endif // WARC_WRITER_POOL_HPP
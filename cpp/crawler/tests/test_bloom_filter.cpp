@@ -0,0 +1,104 @@
+#include "../src/bloom_filter.hpp"
+#include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+// Simple assertion macro
+#define ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "Assertion failed: " << (message) << "\n" \
+                      << "File: " << __FILE__ << ", Line: " << __LINE__ << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+std::string make_url(int i) {
+    return "https://example.com/page/" + std::to_string(i);
+}
+
+void test_no_false_negatives() {
+    crawler::BloomFilter filter(10000);
+    for (int i = 0; i < 10000; ++i) filter.insert(make_url(i));
+    for (int i = 0; i < 10000; ++i) {
+        ASSERT(filter.possibly_contains(make_url(i)), "Inserted key must always be reported as present");
+    }
+    ASSERT(filter.inserted_count() == 10000, "Insert count should be tracked");
+    std::cout << "test_no_false_negatives passed" << std::endl;
+}
+
+void test_false_positive_rate() {
+    crawler::BloomFilter filter(100000, 10.0);
+    for (int i = 0; i < 100000; ++i) filter.insert(make_url(i));
+
+    int false_positives = 0;
+    const int probes = 100000;
+    for (int i = 0; i < probes; ++i) {
+        if (filter.possibly_contains(make_url(1000000 + i))) false_positives++;
+    }
+    double rate = static_cast<double>(false_positives) / probes;
+    ASSERT(rate < 0.03, "False-positive rate at 10 bits/key should be around 1%, got " + std::to_string(rate));
+    std::cout << "test_false_positive_rate passed (" << rate << ")" << std::endl;
+}
+
+void test_save_and_load() {
+    std::string filename = "test_seen.bloom";
+    if (std::filesystem::exists(filename)) std::filesystem::remove(filename);
+
+    crawler::BloomFilter filter(1000);
+    for (int i = 0; i < 1000; ++i) filter.insert(make_url(i));
+    filter.save(filename);
+    ASSERT(std::filesystem::exists(filename), "Filter file should be created");
+    ASSERT(!std::filesystem::exists(filename + ".tmp"), "Temp file should be renamed away");
+
+    crawler::BloomFilter loaded = crawler::BloomFilter::load(filename);
+    ASSERT(loaded.size_bytes() == filter.size_bytes(), "Loaded filter should have the same size");
+    ASSERT(loaded.inserted_count() == 1000, "Loaded filter should keep its insert count");
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT(loaded.possibly_contains(make_url(i)), "Loaded filter must contain every saved key");
+    }
+
+    std::filesystem::remove(filename);
+    std::cout << "test_save_and_load passed" << std::endl;
+}
+
+void test_load_rejects_bad_file() {
+    std::string filename = "test_bad.bloom";
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out << "definitely not a bloom filter";
+    }
+    bool threw = false;
+    try {
+        crawler::BloomFilter::load(filename);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT(threw, "Loading a corrupt file should throw");
+
+    threw = false;
+    try {
+        crawler::BloomFilter::load("does_not_exist.bloom");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT(threw, "Loading a missing file should throw");
+
+    std::filesystem::remove(filename);
+    std::cout << "test_load_rejects_bad_file passed" << std::endl;
+}
+
+int main() {
+    try {
+        test_no_false_negatives();
+        test_false_positive_rate();
+        test_save_and_load();
+        test_load_rejects_bad_file();
+        std::cout << "All tests passed!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "../src/duplicate_detector.hpp"
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Simple assertion macro
+#define ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "Assertion failed: " << (message) << "\n" \
+                      << "File: " << __FILE__ << ", Line: " << __LINE__ << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+// An article of `words` pseudo-random words; the same seed gives the same text
+std::vector<std::string> make_words(unsigned seed, size_t words) {
+    std::mt19937 rng(seed);
+    std::vector<std::string> out;
+    for (size_t i = 0; i < words; ++i) {
+        std::string word;
+        for (size_t len = 3 + rng() % 6; len > 0; --len) word.push_back(static_cast<char>('a' + rng() % 26));
+        out.push_back(word);
+    }
+    return out;
+}
+
+std::string make_page(const std::vector<std::string>& words) {
+    std::string html = "<html><head><title>Article</title><style>p { color: red; }</style></head><body><p>";
+    for (const auto& word : words) html += word + " ";
+    return html + "</p><script>var tracking = 123;</script></body></html>";
+}
+
+void test_exact_duplicates() {
+    std::string page = make_page(make_words(1, 300));
+    crawler::DuplicateIndex index(100);
+    auto fingerprint = crawler::fingerprint_content(page);
+    ASSERT(!index.lookup(fingerprint), "An empty index has no duplicates");
+    index.insert(7, fingerprint);
+    auto found = index.lookup(crawler::fingerprint_content(page));
+    ASSERT(found && *found == 7 && index.exact_duplicates() == 1, "The same body should be an exact duplicate");
+    std::cout << "test_exact_duplicates passed" << std::endl;
+}
+
+void test_near_duplicates() {
+    std::vector<std::string> words = make_words(2, 400);
+    crawler::DuplicateIndex index(100);
+    index.insert(1, crawler::fingerprint_content(make_page(words)));
+
+    // A mirror with different markup, scripts and one edited word
+    std::vector<std::string> edited = words;
+    edited[200] = "changed";
+    std::string mirror = "<HTML><BODY class=\"mirror\"><SCRIPT>other();</SCRIPT><div><p>";
+    for (const auto& word : edited) mirror += word + "\n";
+    mirror += "</p></div></BODY></HTML>";
+    auto found = index.lookup(crawler::fingerprint_content(mirror));
+    ASSERT(found && *found == 1 && index.near_duplicates() == 1, "A lightly edited mirror should be a near duplicate");
+
+    // Unrelated articles, and short pages (no SimHash), are not
+    for (unsigned seed = 10; seed < 60; ++seed) {
+        ASSERT(!index.lookup(crawler::fingerprint_content(make_page(make_words(seed, 400)))),
+               "A different article should not be a duplicate");
+    }
+    auto short_page = crawler::fingerprint_content("<p>Not found</p>");
+    ASSERT(!short_page.has_simhash, "Short pages should not get a SimHash");
+    ASSERT(!index.lookup(short_page), "A short page should only match exactly");
+
+    crawler::DuplicateIndex exact_only(100, 0);
+    exact_only.insert(1, crawler::fingerprint_content(make_page(words)));
+    ASSERT(!exact_only.lookup(crawler::fingerprint_content(mirror)), "Distance 0 should not match an edited page");
+    std::cout << "test_near_duplicates passed" << std::endl;
+}
+
+void test_eviction() {
+    crawler::DuplicateIndex index(50);
+    std::vector<crawler::ContentFingerprint> fingerprints;
+    for (int i = 0; i < 120; ++i) {
+        fingerprints.push_back(crawler::fingerprint_content(make_page(make_words(1000 + i, 100))));
+        index.insert(i, fingerprints.back());
+    }
+    ASSERT(index.size() == 50, "The index should stay within its capacity");
+    ASSERT(!index.lookup(fingerprints[0]), "The oldest pages should be forgotten");
+    auto found = index.lookup(fingerprints[119]);
+    ASSERT(found && *found == 119, "Recent pages should be remembered");
+    found = index.lookup(fingerprints[70]);
+    ASSERT(found && *found == 70, "The oldest remembered page should still be found");
+    std::cout << "test_eviction passed" << std::endl;
+}
+
+void test_fingerprint_format() {
+    auto fingerprint = crawler::fingerprint_content(make_page(make_words(3, 100)));
+    std::string text = crawler::format_fingerprint(fingerprint);
+    ASSERT(text.size() == 33 && text[16] == ':', "Fingerprints should be formatted as exact:simhash");
+    auto parsed = crawler::parse_fingerprint(text);
+    ASSERT(parsed && parsed->exact == fingerprint.exact && parsed->simhash == fingerprint.simhash && parsed->has_simhash,
+           "Formatted fingerprints should parse back");
+
+    auto short_page = crawler::fingerprint_content("tiny");
+    parsed = crawler::parse_fingerprint(crawler::format_fingerprint(short_page));
+    ASSERT(parsed && parsed->exact == short_page.exact && !parsed->has_simhash, "Exact-only fingerprints should parse back");
+    ASSERT(!crawler::parse_fingerprint("") && !crawler::parse_fingerprint("xyz") &&
+           !crawler::parse_fingerprint("0123456789abcdef-0123456789abcdef"), "Malformed values should be rejected");
+    std::cout << "test_fingerprint_format passed" << std::endl;
+}
+
+int main() {
+    try {
+        test_exact_duplicates();
+        test_near_duplicates();
+        test_eviction();
+        test_fingerprint_format();
+        std::cout << "All tests passed!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "../src/fetcher.hpp"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+// Simple assertion macro
+#define ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "Assertion failed: " << (message) << "\n" \
+                      << "File: " << __FILE__ << ", Line: " << __LINE__ << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+// Transfers are exercised against file:// URLs so the tests need no network access.
+std::string write_fixture(const std::string& name, const std::string& content) {
+    std::filesystem::path path = std::filesystem::absolute(name);
+    std::ofstream out(path, std::ios::binary);
+    out << content;
+    return "file://" + path.string();
+}
+
+std::vector<crawler::FetchResult> drain(crawler::Fetcher& fetcher) {
+    std::vector<crawler::FetchResult> all;
+    while (fetcher.in_flight() > 0) {
+        for (auto& result : fetcher.poll(100)) {
+            all.push_back(std::move(result));
+        }
+    }
+    return all;
+}
+
+void test_concurrent_fetches() {
+    crawler::Fetcher fetcher(4, 0, 5, "TestBot/1.0");
+
+    std::map<int, std::string> expected;
+    for (int i = 0; i < 4; ++i) {
+        std::string content = "<html><body>Page " + std::to_string(i) + "</body></html>";
+        std::string url = write_fixture("test_fetch_" + std::to_string(i) + ".html", content);
+        ASSERT(fetcher.submit(i, url), "Submit should succeed while slots are free");
+        expected[i] = content;
+    }
+    ASSERT(!fetcher.has_capacity(), "All slots should be busy");
+    ASSERT(!fetcher.submit(99, "file:///dev/null"), "Submit should fail when no slots are free");
+
+    auto results = drain(fetcher);
+    ASSERT(results.size() == 4, "Every submitted transfer should complete");
+    for (const auto& result : results) {
+        ASSERT(result.success, "Fetch should succeed: " + result.error);
+        ASSERT(result.body == expected[result.doc_id], "Body should match the fixture for its doc_id");
+    }
+    ASSERT(fetcher.has_capacity(), "Slots should be released after completion");
+
+    for (int i = 0; i < 4; ++i) {
+        std::filesystem::remove("test_fetch_" + std::to_string(i) + ".html");
+    }
+    std::cout << "test_concurrent_fetches passed" << std::endl;
+}
+
+void test_handle_reuse() {
+    crawler::Fetcher fetcher(1, 0, 5, "TestBot/1.0");
+    std::string first = write_fixture("test_fetch_reuse_a.html", "first body");
+    std::string second = write_fixture("test_fetch_reuse_b.html", "second");
+
+    ASSERT(fetcher.submit(1, first), "First submit should succeed");
+    auto results = drain(fetcher);
+    ASSERT(results.size() == 1 && results[0].body == "first body", "First fetch should return its body");
+
+    ASSERT(fetcher.submit(2, second), "Reused slot should accept a new transfer");
+    results = drain(fetcher);
+    ASSERT(results.size() == 1 && results[0].body == "second", "Reused handle must not leak the previous body");
+    ASSERT(results[0].doc_id == 2, "Result should carry the new doc_id");
+
+    std::filesystem::remove("test_fetch_reuse_a.html");
+    std::filesystem::remove("test_fetch_reuse_b.html");
+    std::cout << "test_handle_reuse passed" << std::endl;
+}
+
+void test_failed_fetch() {
+    crawler::Fetcher fetcher(1, 0, 5, "TestBot/1.0");
+    std::string missing = "file://" + std::filesystem::absolute("test_fetch_missing.html").string();
+
+    ASSERT(fetcher.submit(7, missing), "Submit should succeed");
+    auto results = drain(fetcher);
+    ASSERT(results.size() == 1, "Failed transfer should still complete");
+    ASSERT(!results[0].success, "Missing file should be reported as a failure");
+    ASSERT(!results[0].error.empty(), "Failure should carry an error message");
+    ASSERT(results[0].body.empty(), "Failed fetch should have no body");
+    std::cout << "test_failed_fetch passed" << std::endl;
+}
+
+int main() {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    try {
+        test_concurrent_fetches();
+        test_handle_reuse();
+        test_failed_fetch();
+        std::cout << "All tests passed!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        curl_global_cleanup();
+        return 1;
+    }
+    curl_global_cleanup();
+    return 0;
+}
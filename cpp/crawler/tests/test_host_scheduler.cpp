@@ -0,0 +1,114 @@
+#include "../src/host_scheduler.hpp"
+#include "../src/url_utils.hpp"
+#include <iostream>
+#include <set>
+#include <string>
+
+// Simple assertion macro
+#define ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "Assertion failed: " << (message) << "\n" \
+                      << "File: " << __FILE__ << ", Line: " << __LINE__ << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+using Clock = crawler::HostScheduler::Clock;
+
+void test_extract_host() {
+    ASSERT(crawler::extract_host("https://En.Wikipedia.org/wiki/Main_Page") == "en.wikipedia.org", "Host should be lowercased");
+    ASSERT(crawler::extract_host("http://example.com:8080?q=1") == "example.com:8080", "Port should be kept");
+    ASSERT(crawler::extract_host("http://user:pw@example.com/") == "example.com", "Userinfo should be dropped");
+    ASSERT(crawler::extract_host("http://example.com") == "example.com", "Host without path");
+    ASSERT(crawler::extract_host("not a url") == "", "Missing scheme should yield empty host");
+    std::cout << "test_extract_host passed" << std::endl;
+}
+
+void test_different_hosts_are_not_delayed() {
+    crawler::HostScheduler scheduler(std::chrono::seconds(1));
+    scheduler.push(1, "http://a.com/1");
+    scheduler.push(2, "http://b.com/1");
+    scheduler.push(3, "http://c.com/1");
+
+    Clock::time_point now = Clock::now();
+    std::set<int> popped;
+    crawler::ScheduledUrl next;
+    while (scheduler.pop_ready(now, next)) popped.insert(next.doc_id);
+
+    ASSERT(popped.size() == 3, "Every distinct host should be eligible immediately");
+    ASSERT(scheduler.empty(), "Scheduler should be drained");
+    std::cout << "test_different_hosts_are_not_delayed passed" << std::endl;
+}
+
+void test_same_host_is_delayed() {
+    crawler::HostScheduler scheduler(std::chrono::seconds(1));
+    scheduler.push(1, "http://a.com/1");
+    scheduler.push(2, "http://a.com/2");
+    scheduler.push(3, "http://b.com/1");
+
+    Clock::time_point t0 = Clock::now();
+    crawler::ScheduledUrl next;
+    ASSERT(scheduler.pop_ready(t0, next) && next.doc_id == 1, "First a.com URL should be eligible");
+    ASSERT(scheduler.pop_ready(t0, next) && next.doc_id == 3, "b.com should not wait behind a.com");
+    ASSERT(!scheduler.pop_ready(t0, next), "a.com is in flight and must not be handed out again");
+    ASSERT(scheduler.next_ready_time() == Clock::time_point::max(), "Nothing is schedulable while a.com is in flight");
+
+    Clock::time_point t1 = t0 + std::chrono::milliseconds(300);
+    scheduler.release("http://a.com/1", t1);
+    ASSERT(scheduler.next_ready_time() == t1 + std::chrono::seconds(1), "Delay should count from completion");
+    ASSERT(!scheduler.pop_ready(t1 + std::chrono::milliseconds(999), next), "a.com should still be cooling down");
+    ASSERT(scheduler.pop_ready(t1 + std::chrono::seconds(1), next) && next.doc_id == 2, "a.com should be eligible after the delay");
+    std::cout << "test_same_host_is_delayed passed" << std::endl;
+}
+
+void test_fifo_within_host() {
+    crawler::HostScheduler scheduler(std::chrono::seconds(0));
+    for (int i = 0; i < 5; ++i) scheduler.push(i, "http://a.com/" + std::to_string(i));
+
+    Clock::time_point now = Clock::now();
+    crawler::ScheduledUrl next;
+    for (int i = 0; i < 5; ++i) {
+        ASSERT(scheduler.pop_ready(now, next), "URL should be eligible");
+        ASSERT(next.doc_id == i, "URLs of one host should come out in FIFO order");
+        scheduler.release(next.url, now);
+    }
+    ASSERT(scheduler.empty(), "Scheduler should be drained");
+    std::cout << "test_fifo_within_host passed" << std::endl;
+}
+
+void test_idle_hosts_expire() {
+    crawler::HostScheduler scheduler(std::chrono::seconds(1));
+    scheduler.push(1, "http://a.com/1");
+
+    Clock::time_point t0 = Clock::now();
+    crawler::ScheduledUrl next;
+    ASSERT(scheduler.pop_ready(t0, next), "URL should be eligible");
+    scheduler.release(next.url, t0);
+    ASSERT(scheduler.host_count() == 1, "Host state should be kept during its delay");
+
+    // A URL arriving during the delay must still respect it
+    scheduler.push(2, "http://a.com/2");
+    ASSERT(!scheduler.pop_ready(t0 + std::chrono::milliseconds(500), next), "Re-queued host should still be delayed");
+    ASSERT(scheduler.pop_ready(t0 + std::chrono::seconds(1), next), "Host should be eligible after the delay");
+    scheduler.release(next.url, t0 + std::chrono::seconds(1));
+
+    scheduler.pop_ready(t0 + std::chrono::seconds(3), next);
+    ASSERT(scheduler.host_count() == 0, "Idle host should be forgotten once its delay has passed");
+    std::cout << "test_idle_hosts_expire passed" << std::endl;
+}
+
+int main() {
+    try {
+        test_extract_host();
+        test_different_hosts_are_not_delayed();
+        test_same_host_is_delayed();
+        test_fifo_within_host();
+        test_idle_hosts_expire();
+        std::cout << "All tests passed!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include "../src/link_extractor.hpp"
+#include "../src/url_utils.hpp"
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Simple assertion macro
+#define ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "Assertion failed: " << (message) << "\n" \
+                      << "File: " << __FILE__ << ", Line: " << __LINE__ << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+bool contains(const std::vector<std::string>& links, const std::string& url) {
+    return std::find(links.begin(), links.end(), url) != links.end();
+}
+
+// --- Test: resolve_url ---
+void test_resolve_relative() {
+    const std::string base = "https://example.com/wiki/Main_Page?x=1";
+    ASSERT(crawler::resolve_url(base, "Other") == "https://example.com/wiki/Other", "Relative path");
+    ASSERT(crawler::resolve_url(base, "/about") == "https://example.com/about", "Absolute path");
+    ASSERT(crawler::resolve_url(base, "//cdn.example.com/a") == "https://cdn.example.com/a", "Scheme-relative");
+    ASSERT(crawler::resolve_url(base, "?page=2") == "https://example.com/wiki/Main_Page?page=2", "Query-only");
+    ASSERT(crawler::resolve_url(base, "../a/./b/../c") == "https://example.com/a/c", "Dot segments");
+    ASSERT(crawler::resolve_url(base, "sub/") == "https://example.com/wiki/sub/", "Trailing slash kept");
+    std::cout << "test_resolve_relative passed" << std::endl;
+}
+
+void test_resolve_normalizes() {
+    const std::string base = "http://example.com/";
+    ASSERT(crawler::resolve_url(base, "HTTP://Example.COM:80/Path#frag") == "http://example.com/Path", "Scheme/host case, port, fragment");
+    ASSERT(crawler::resolve_url(base, "https://example.com:443") == "https://example.com/", "Empty path becomes /");
+    ASSERT(crawler::resolve_url(base, "https://example.com:8443/x") == "https://example.com:8443/x", "Non-default port kept");
+    ASSERT(crawler::resolve_url(base, " /a?b=1&amp;c=2 ") == "http://example.com/a?b=1&c=2", "Whitespace trimmed, &amp; decoded");
+    ASSERT(crawler::resolve_url(base, "#top") == "", "Fragment-only link is the same page");
+    ASSERT(crawler::resolve_url(base, "mailto:someone@example.com") == "", "mailto is not crawlable");
+    ASSERT(crawler::resolve_url(base, "javascript:void(0)") == "", "javascript is not crawlable");
+    std::cout << "test_resolve_normalizes passed" << std::endl;
+}
+
+// --- Test: extract_links ---
+void test_extract_basic() {
+    std::string html =
+        "<html><head><title>T</title></head><body>"
+        "<a href=\"/one\">1</a>"
+        "<A HREF='two'>2</A>"
+        "<a class=x href=three>3</a>"
+        "<a href=\"/one\">duplicate</a>"
+        "<area href=\"https://other.org/map\">"
+        "</body></html>";
+    auto links = crawler::extract_links(html, "https://example.com/dir/page");
+    ASSERT(links.size() == 4, "Should find 4 distinct links, got " + std::to_string(links.size()));
+    ASSERT(contains(links, "https://example.com/one"), "Double-quoted href");
+    ASSERT(contains(links, "https://example.com/dir/two"), "Single-quoted, uppercase tag");
+    ASSERT(contains(links, "https://example.com/dir/three"), "Unquoted href");
+    ASSERT(contains(links, "https://other.org/map"), "Area href");
+    std::cout << "test_extract_basic passed" << std::endl;
+}
+
+void test_extract_skips_non_links() {
+    std::string html =
+        "<!-- <a href=\"/commented\">x</a> -->"
+        "<script>var s = '<a href=\"/scripted\">';</script>"
+        "<style>a[href=\"/styled\"] {}</style>"
+        "<link href=\"/style.css\">"
+        "<a name=\"anchor\">no href</a>"
+        "<a href=\"/ugc\" rel=\"ugc nofollow\">nofollow</a>"
+        "<a href=\"/kept\">kept</a>";
+    auto links = crawler::extract_links(html, "http://example.com/");
+    ASSERT(links.size() == 1, "Only the plain link should be kept, got " + std::to_string(links.size()));
+    ASSERT(links[0] == "http://example.com/kept", "Plain link should be extracted");
+    std::cout << "test_extract_skips_non_links passed" << std::endl;
+}
+
+void test_extract_honors_base() {
+    std::string html = "<head><base href=\"https://static.example.net/base/\"></head><a href=\"page\">p</a>";
+    auto links = crawler::extract_links(html, "http://example.com/");
+    ASSERT(links.size() == 1 && links[0] == "https://static.example.net/base/page", "Links should resolve against <base>");
+    std::cout << "test_extract_honors_base passed" << std::endl;
+}
+
+void test_extract_limit_and_truncation() {
+    std::string html;
+    for (int i = 0; i < 50; ++i) html += "<a href=\"/p" + std::to_string(i) + "\">x</a>";
+    html += "<a href=\"/unterminated";
+    auto links = crawler::extract_links(html, "http://example.com/", 10);
+    ASSERT(links.size() == 10, "Extraction should stop at max_links");
+
+    auto all = crawler::extract_links(html, "http://example.com/");
+    ASSERT(all.size() == 50, "Unterminated trailing tag should be ignored without crashing");
+    std::cout << "test_extract_limit_and_truncation passed" << std::endl;
+}
+
+int main() {
+    try {
+        test_resolve_relative();
+        test_resolve_normalizes();
+        test_extract_basic();
+        test_extract_skips_non_links();
+        test_extract_honors_base();
+        test_extract_limit_and_truncation();
+        std::cout << "All tests passed!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
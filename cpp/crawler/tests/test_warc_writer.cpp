@@ -1,9 +1,15 @@
 #include "../src/warc_writer.hpp"
+#include "../src/warc_writer_pool.hpp"
 #include <iostream>
 #include <fstream>
 #include <cassert>
 #include <filesystem>
 #include <vector>
+#include <iterator>
+#include <algorithm>
+#include <zlib.h>
+#include <csignal>
+#include <sys/resource.h>
 
 // Simple assertion macro
 #define ASSERT(condition, message) \
@@ -53,10 +59,273 @@ void test_write_record() {
     std::cout << "test_write_record passed" << std::endl;
 }
 
+std::vector<char> read_file(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void test_offsets_are_exact() {
+    std::string filename = "test_warc_offsets.warc.gz";
+    std::filesystem::remove(filename);
+
+    std::vector<crawler::WarcRecordInfo> infos;
+    {
+        crawler::WarcWriterOptions options;
+        options.batch_bytes = 256;  // Force several batch writes
+        crawler::WarcWriter writer(filename, options);
+        for (int i = 0; i < 20; ++i) {
+            infos.push_back(writer.write_record("http://example.com/" + std::to_string(i),
+                                                std::string(100 + i * 37, 'a' + i % 26)));
+        }
+    }
+    {
+        // Reopening appends after the existing records
+        crawler::WarcWriter writer(filename);
+        infos.push_back(writer.write_record("http://example.com/again", "<html>again</html>"));
+    }
+
+    std::vector<char> data = read_file(filename);
+    int64_t expected_offset = 0;
+    for (const auto& info : infos) {
+        ASSERT(info.offset == expected_offset, "Records should be contiguous");
+        ASSERT(static_cast<unsigned char>(data[info.offset]) == 0x1f &&
+               static_cast<unsigned char>(data[info.offset + 1]) == 0x8b, "Each offset should start a gzip member");
+        expected_offset += info.length;
+    }
+    ASSERT(static_cast<int64_t>(data.size()) == expected_offset, "File size should equal the sum of record lengths");
+
+    std::filesystem::remove(filename);
+    std::cout << "test_offsets_are_exact passed" << std::endl;
+}
+
+void test_flush_durability() {
+    std::string filename = "test_warc_flush.warc.gz";
+    std::filesystem::remove(filename);
+
+    {
+        crawler::WarcWriter writer(filename);
+        auto info = writer.write_record("http://example.com", "<html>buffered</html>");
+        ASSERT(std::filesystem::file_size(filename) == 0, "Records should be buffered until flush");
+        writer.flush();
+        ASSERT(static_cast<int64_t>(std::filesystem::file_size(filename)) == info.length,
+               "flush() should write buffered records");
+    }
+    std::filesystem::remove(filename);
+
+    {
+        crawler::WarcWriterOptions options;
+        options.durability = crawler::WarcDurability::None;
+        crawler::WarcWriter writer(filename, options);
+        writer.write_record("http://example.com", "<html>buffered</html>");
+        writer.flush();
+        ASSERT(std::filesystem::file_size(filename) == 0, "flush() should not write in None mode");
+    }
+    ASSERT(std::filesystem::file_size(filename) > 0, "Destructor should write buffered records");
+    std::filesystem::remove(filename);
+
+    {
+        crawler::WarcWriterOptions options;
+        options.durability = crawler::WarcDurability::FdatasyncPerBatch;
+        crawler::WarcWriter writer(filename, options);
+        auto info = writer.write_record("http://example.com", "<html>synced</html>");
+        writer.flush();
+        ASSERT(static_cast<int64_t>(std::filesystem::file_size(filename)) == info.length,
+               "flush() should write and sync buffered records");
+    }
+    std::filesystem::remove(filename);
+    std::cout << "test_flush_durability passed" << std::endl;
+}
+
+// Inflate a single gzip member starting at data[offset]
+std::string gunzip(const std::vector<char>& data, int64_t offset, int64_t length) {
+    z_stream zs{};
+    ASSERT(inflateInit2(&zs, 15 | 16) == Z_OK, "inflateInit2 should succeed");
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data() + offset));
+    zs.avail_in = static_cast<uInt>(length);
+
+    std::string out;
+    char chunk[16384];
+    int ret;
+    do {
+        zs.next_out = reinterpret_cast<Bytef*>(chunk);
+        zs.avail_out = sizeof(chunk);
+        ret = inflate(&zs, Z_NO_FLUSH);
+        out.append(chunk, sizeof(chunk) - zs.avail_out);
+    } while (ret == Z_OK);
+    inflateEnd(&zs);
+    ASSERT(ret == Z_STREAM_END, "Record should be a complete gzip member");
+    ASSERT(zs.total_in == static_cast<uLong>(length), "Record length should cover exactly one gzip member");
+    return out;
+}
+
+// Limits the size of files this process writes; past it, write() fails with EFBIG instead of raising SIGXFSZ
+void limit_file_size(rlim_t bytes) {
+    std::signal(SIGXFSZ, SIG_IGN);
+    rlimit limit{};
+    ASSERT(getrlimit(RLIMIT_FSIZE, &limit) == 0, "getrlimit should succeed");
+    limit.rlim_cur = std::min(bytes, limit.rlim_max);
+    ASSERT(setrlimit(RLIMIT_FSIZE, &limit) == 0, "setrlimit should succeed");
+}
+
+void test_failed_write_leaves_no_orphan() {
+    std::string filename = "test_warc_failed_write.warc.gz";
+    std::filesystem::remove(filename);
+
+    std::vector<crawler::WarcRecordInfo> infos;
+    {
+        crawler::WarcWriterOptions options;
+        options.batch_bytes = 1;  // Every append writes
+        crawler::WarcWriter writer(filename, options);
+        infos.push_back(writer.write_record("http://example.com/first", "<html>first</html>"));
+
+        // Nothing of the record can be written: it is reported as failed and must never reach the file
+        limit_file_size(std::filesystem::file_size(filename));
+        bool threw = false;
+        try {
+            writer.write_record("http://example.com/lost", "<html>lost</html>");
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        ASSERT(threw, "A failed write should be reported");
+        limit_file_size(RLIM_INFINITY);
+        infos.push_back(writer.write_record("http://example.com/second", "<html>second</html>"));
+        ASSERT(infos[1].offset == infos[0].offset + infos[0].length, "The failed record's space should be reused");
+
+        // Part of the record was written: it can only be completed, so it is kept at its offset
+        limit_file_size(std::filesystem::file_size(filename) + 10);
+        infos.push_back(writer.write_record("http://example.com/partial", "<html>partial</html>"));
+        limit_file_size(RLIM_INFINITY);
+        writer.flush();
+    }
+
+    std::vector<char> data = read_file(filename);
+    int64_t expected_offset = 0;
+    for (const auto& info : infos) {
+        ASSERT(info.offset == expected_offset, "Records should be contiguous");
+        expected_offset += info.length;
+    }
+    ASSERT(static_cast<int64_t>(data.size()) == expected_offset, "The file should hold only the reported records");
+    ASSERT(gunzip(data, infos[1].offset, infos[1].length).find("http://example.com/second") != std::string::npos,
+           "The record after a failed one should be readable at its offset");
+    ASSERT(gunzip(data, infos[2].offset, infos[2].length).find("http://example.com/partial") != std::string::npos,
+           "A partly written record should be completed at its offset");
+
+    std::filesystem::remove(filename);
+    std::cout << "test_failed_write_leaves_no_orphan passed" << std::endl;
+}
+
+void test_pool_parallel_compression() {
+    std::string filename = "test_warc_pool.warc.gz";
+    std::filesystem::remove(filename);
+
+    const int num_records = 200;
+    std::vector<crawler::ArchivedRecord> records;
+    {
+        crawler::WarcWriterOptions options;
+        options.compression_level = 1;
+        crawler::WarcWriter writer(filename, options);
+        crawler::WarcWriterPool pool(writer, 4, 8);
+        for (int i = 0; i < num_records; ++i) {
+            pool.submit(i, "http://example.com/" + std::to_string(i), "<html>page " + std::to_string(i) + "</html>");
+        }
+        pool.wait_idle();
+        records = pool.drain();
+        ASSERT(pool.pending() == 0, "Nothing should be pending after drain");
+        writer.flush();
+    }
+
+    ASSERT(records.size() == static_cast<size_t>(num_records), "Every submitted page should be archived");
+    std::sort(records.begin(), records.end(),
+              [](const auto& a, const auto& b) { return a.info.offset < b.info.offset; });
+
+    std::vector<char> data = read_file(filename);
+    int64_t expected_offset = 0;
+    for (const auto& record : records) {
+        ASSERT(record.success, "Archiving should succeed");
+        ASSERT(record.info.offset == expected_offset, "Pool records should be contiguous");
+        std::string text = gunzip(data, record.info.offset, record.info.length);
+        ASSERT(text.find("WARC-Target-URI: " + record.url + "\r\n") != std::string::npos,
+               "Record should hold its own URL");
+        ASSERT(text.find("<html>page " + std::to_string(record.doc_id) + "</html>") != std::string::npos,
+               "Record should hold its own body");
+        expected_offset += record.info.length;
+    }
+    ASSERT(static_cast<int64_t>(data.size()) == expected_offset, "File size should equal the sum of record lengths");
+
+    std::filesystem::remove(filename);
+    std::cout << "test_pool_parallel_compression passed" << std::endl;
+}
+
+void test_segment_rotation() {
+    std::filesystem::path dir = "test_warc_segments";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::string prefix = (dir / "crawled-a").string();
+
+    crawler::WarcWriterOptions options;
+    options.max_segment_bytes = 1024;
+    std::vector<crawler::WarcRecordInfo> infos;
+    {
+        crawler::WarcWriter writer(prefix, options);
+        for (int i = 0; i < 30; ++i) {
+            // Random bodies barely compress, so each record is a few hundred bytes
+            std::string body;
+            for (int j = 0; j < 300; ++j) body += static_cast<char>('!' + (i * 7919 + j * 104729) % 90);
+            infos.push_back(writer.write_record("http://example.com/" + std::to_string(i), body));
+        }
+        writer.flush();
+    }
+
+    auto segments = crawler::WarcWriter::load_manifest(prefix + ".manifest");
+    ASSERT(segments.size() > 1, "Writer should rotate into several segments");
+    ASSERT(segments.front().filename == "crawled-a-00001.warc.gz", "Segments should be numbered from 1");
+
+    size_t next_info = 0;
+    uint64_t total_records = 0;
+    for (const auto& segment : segments) {
+        std::vector<char> data = read_file((dir / segment.filename).string());
+        ASSERT(segment.start_offset == 0, "New segments should start empty");
+        ASSERT(segment.end_offset == static_cast<int64_t>(data.size()), "Manifest should cover the whole segment");
+        ASSERT(segment.records > 0, "No segment should be empty");
+        ASSERT(segment.end_offset <= 1024 || segment.records == 1, "Segments should respect max_segment_bytes");
+
+        int64_t expected_offset = 0;
+        for (uint64_t r = 0; r < segment.records; ++r, ++next_info) {
+            const auto& info = infos[next_info];
+            ASSERT(info.filename == segment.filename, "Record should report the segment it was written to");
+            ASSERT(info.offset == expected_offset, "Records should be contiguous within a segment");
+            gunzip(data, info.offset, info.length);
+            expected_offset += info.length;
+        }
+        total_records += segment.records;
+    }
+    ASSERT(total_records == infos.size(), "Manifest should count every record");
+
+    {
+        // A new writer never appends to an existing segment
+        crawler::WarcWriter writer(prefix, options);
+        auto info = writer.write_record("http://example.com/next", "<html>next</html>");
+        char expected[32];
+        std::snprintf(expected, sizeof(expected), "crawled-a-%05zu.warc.gz", segments.size() + 1);
+        ASSERT(info.filename == expected, "Restart should continue numbering after the last segment");
+        ASSERT(info.offset == 0, "Restart should start a fresh segment");
+    }
+    ASSERT(crawler::WarcWriter::load_manifest(prefix + ".manifest").size() == segments.size() + 1,
+           "Manifest should keep earlier segments across restarts");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "test_segment_rotation passed" << std::endl;
+}
+
 int main() {
     try {
         test_file_creation();
         test_write_record();
+        test_offsets_are_exact();
+        test_flush_durability();
+        test_pool_parallel_compression();
+        test_segment_rotation();
+        test_failed_write_leaves_no_orphan();
         std::cout << "All tests passed!" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Test failed with exception: " << e.what() << std::endl;
@@ -0,0 +1,210 @@
+#include "synthetic_corpus.hpp"
+#include "../src/utils.hpp"
+#include "../src/gzip_decompressor.hpp"
+#include "../src/html_text.hpp"
+#include "../src/tokenizer.hpp"
+#include "../src/posting_list.hpp"
+#include "../src/snippet.hpp"
+#include "query_engine.hpp"
+
+#include <benchmark/benchmark.h>
+#include <gumbo.h>
+#include <zlib.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+const bench::SyntheticCorpus& corpus() {
+    static const bench::SyntheticCorpus instance;
+    return instance;
+}
+
+// Pages 0..n-1 of the corpus, generated once per size.
+const std::vector<std::string>& pages(size_t n) {
+    static std::vector<std::string> cache;
+    while (cache.size() < n) cache.push_back(corpus().page(cache.size()));
+    return cache;
+}
+
+size_t total_bytes(const std::vector<std::string>& docs, size_t n) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < n; ++i) bytes += docs[i].size();
+    return bytes;
+}
+
+// One gzip member, as the crawler writes them.
+std::string gzip(const std::string& data) {
+    z_stream zs = {};
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("deflateInit2 failed");
+    }
+    std::string out(deflateBound(&zs, static_cast<uLong>(data.size())), '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+    int status = deflate(&zs, Z_FINISH);
+    out.resize(out.size() - zs.avail_out);
+    deflateEnd(&zs);
+    if (status != Z_STREAM_END) throw std::runtime_error("deflate failed");
+    return out;
+}
+
+const size_t PAGES = 64;
+
+} // namespace
+
+// --- WARC records ---
+
+static void BM_DecompressGzip(benchmark::State& state) {
+    std::string compressed = gzip(pages(1)[0]);
+    for (auto _ : state) benchmark::DoNotOptimize(indexer::decompress_gzip(compressed));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(pages(1)[0].size()));
+}
+BENCHMARK(BM_DecompressGzip);
+
+static void BM_GzipDecompressorReuse(benchmark::State& state) {
+    std::string compressed = gzip(pages(1)[0]);
+    indexer::GzipDecompressor decompressor;
+    std::string out;
+    for (auto _ : state) {
+        decompressor.decompress(compressed, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(pages(1)[0].size()));
+}
+BENCHMARK(BM_GzipDecompressorReuse);
+
+// --- Text extraction ---
+
+static void BM_ExtractContent(benchmark::State& state) {
+    const auto& docs = pages(PAGES);
+    indexer::ExtractedContent content;
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& html = docs[i++ % PAGES];
+        GumboOutput* output = gumbo_parse_with_options(&kGumboDefaultOptions, html.data(), html.size());
+        indexer::extract_content(output->root, content);
+        gumbo_destroy_output(&kGumboDefaultOptions, output);
+        benchmark::DoNotOptimize(content.text.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * (total_bytes(docs, PAGES) / PAGES)));
+}
+BENCHMARK(BM_ExtractContent);
+
+static void BM_HtmlTextExtractor(benchmark::State& state) {
+    const auto& docs = pages(PAGES);
+    indexer::HtmlTextExtractor extractor(static_cast<indexer::HtmlExtractMode>(state.range(0)));
+    size_t i = 0;
+    for (auto _ : state) benchmark::DoNotOptimize(extractor.extract(docs[i++ % PAGES]).text.data());
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * (total_bytes(docs, PAGES) / PAGES)));
+}
+BENCHMARK(BM_HtmlTextExtractor)
+    ->Arg(static_cast<int>(indexer::HtmlExtractMode::Dom))
+    ->Arg(static_cast<int>(indexer::HtmlExtractMode::StripTags));
+
+// --- Tokenizing ---
+
+static void BM_Tokenize(benchmark::State& state) {
+    bench::Rng rng(1);
+    std::string text = corpus().text(rng, static_cast<size_t>(state.range(0)));
+    indexer::Tokenizer tokenizer;
+    for (auto _ : state) benchmark::DoNotOptimize(tokenizer.tokenize(text).data());
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+    state.SetLabel(indexer::tokenizer_kernel());
+}
+BENCHMARK(BM_Tokenize)->Arg(100)->Arg(1000)->Arg(10000);
+
+static void BM_TokenizeCopying(benchmark::State& state) {
+    bench::Rng rng(1);
+    std::string text = corpus().text(rng, static_cast<size_t>(state.range(0)));
+    for (auto _ : state) benchmark::DoNotOptimize(indexer::tokenize(text).data());
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+}
+BENCHMARK(BM_TokenizeCopying)->Arg(1000);
+
+static void BM_TextRecordEncode(benchmark::State& state) {
+    bench::Rng rng(1);
+    std::string text = corpus().text(rng, corpus().corpus_options().words_per_page);
+    indexer::Tokenizer tokenizer;
+    indexer::TextRecordWriter writer;
+    for (auto _ : state) {
+        const auto& tokens = tokenizer.tokenize(text);
+        benchmark::DoNotOptimize(writer.encode(text, tokens, tokenizer));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+}
+BENCHMARK(BM_TextRecordEncode);
+
+static void BM_SnippetGenerate(benchmark::State& state) {
+    bench::Rng rng(1);
+    std::string text = corpus().text(rng, corpus().corpus_options().words_per_page);
+    indexer::Tokenizer tokenizer;
+    indexer::TextRecordWriter writer;
+    std::string record = writer.encode(text, tokenizer.tokenize(text), tokenizer);
+    std::vector<std::string> terms = {corpus().word(30), corpus().word(300)};
+    indexer::SnippetGenerator generator;
+    for (auto _ : state) benchmark::DoNotOptimize(generator.generate(record, terms, 200));
+}
+BENCHMARK(BM_SnippetGenerate);
+
+// --- Posting lists ---
+
+// Rank 20 is in ~97% of the pages, rank 2000 in ~3%
+static void BM_PostingEncode(benchmark::State& state) {
+    std::vector<indexer::Posting> postings = corpus().postings(static_cast<size_t>(state.range(0)), 100000);
+    for (auto _ : state) benchmark::DoNotOptimize(indexer::encode_posting_list(postings));
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(postings.size()));
+}
+BENCHMARK(BM_PostingEncode)->Arg(20)->Arg(2000);
+
+static void BM_PostingDecode(benchmark::State& state) {
+    std::string encoded = indexer::encode_posting_list(corpus().postings(static_cast<size_t>(state.range(0)), 100000));
+    size_t count = 0;
+    for (auto _ : state) {
+        std::vector<indexer::Posting> decoded = indexer::decode_posting_list(encoded);
+        count = decoded.size();
+        benchmark::DoNotOptimize(decoded.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+BENCHMARK(BM_PostingDecode)->Arg(20)->Arg(2000);
+
+// --- Top-k scoring ---
+
+// A common (93% of the pages), a medium (16%) and a rare (1%) term over 1M documents, top 10, by algorithm
+static void BM_TopK(benchmark::State& state) {
+    const uint32_t docs = 1000000;
+    std::vector<ranker::QueryTerm> terms;
+    size_t postings = 0;
+    for (size_t rank : {25, 400, 6000}) {
+        std::string encoded = indexer::encode_posting_list(corpus().postings(rank, docs));
+        auto list = std::make_shared<const ranker::PostingList>(std::move(encoded));
+        postings += list->reader().size();
+        terms.push_back({list, 1, 0});
+    }
+    ranker::DocStats stats;
+    stats.total_docs = docs;
+    stats.avgdl = static_cast<double>(corpus().corpus_options().words_per_page);
+    auto algorithm = static_cast<ranker::QueryAlgorithm>(state.range(0));
+
+    ranker::QueryCounters counters;
+    for (auto _ : state) {
+        counters = ranker::QueryCounters();
+        benchmark::DoNotOptimize(ranker::bm25_top_k(terms, stats, 10, algorithm, ranker::Bm25Params(), &counters));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(postings));
+    state.counters["docs_scored"] = static_cast<double>(counters.docs_scored);
+    state.counters["blocks_decoded"] = static_cast<double>(counters.blocks_decoded);
+}
+BENCHMARK(BM_TopK)
+    ->Arg(static_cast<int>(ranker::QueryAlgorithm::Exhaustive))
+    ->Arg(static_cast<int>(ranker::QueryAlgorithm::Wand))
+    ->Arg(static_cast<int>(ranker::QueryAlgorithm::BlockMaxWand))
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,150 @@
+#ifndef INDEXER_BENCH_SYNTHETIC_CORPUS_HPP
+#define INDEXER_BENCH_SYNTHETIC_CORPUS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../src/posting_list.hpp"
+
+namespace bench {
+
+// SplitMix64. The std:: distributions differ between standard libraries; this gives the same
+// stream everywhere, so every machine benchmarks the same corpus.
+class Rng {
+public:
+    explicit Rng(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    double unit() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }  // [0, 1)
+    size_t below(size_t n) { return static_cast<size_t>(unit() * static_cast<double>(n)); }
+
+private:
+    uint64_t state;
+};
+
+struct CorpusOptions {
+    size_t vocabulary = 50000;     // Distinct words
+    double zipf_exponent = 1.0;    // Word frequencies fall off as 1 / rank^s, as in natural text
+    size_t words_per_page = 800;
+    uint64_t seed = 42;
+};
+
+// Deterministic pages, text and posting lists with a Zipf-distributed vocabulary.
+// page(i) and postings(rank, n) depend only on the options and their arguments, so benchmarks
+// can ask for any slice of the corpus in any order.
+class SyntheticCorpus {
+public:
+    explicit SyntheticCorpus(const CorpusOptions& options = CorpusOptions()) : options(options) {
+        static const char* const SYLLABLES[] = {"ka", "te", "ri", "so", "mu", "la", "ne", "po", "di", "gu", "ba",
+                                                "ve", "zo", "fi", "ho", "ce", "ja", "lu", "mi", "ro", "sa", "tu",
+                                                "we", "xi", "yo", "na", "de", "qu", "pe", "go", "bi", "to"};
+        words.reserve(options.vocabulary);
+        for (size_t rank = 0; rank < options.vocabulary; ++rank) {
+            // Rank in base 32, at least two digits: every word is unique and at least 4 letters
+            std::string word;
+            size_t r = rank;
+            for (int digits = 0; digits < 2 || r > 0; ++digits, r /= 32) word += SYLLABLES[r % 32];
+            words.push_back(word);
+        }
+
+        cdf.reserve(options.vocabulary);
+        double sum = 0;
+        for (size_t rank = 0; rank < options.vocabulary; ++rank) {
+            sum += 1.0 / std::pow(static_cast<double>(rank + 1), options.zipf_exponent);
+            cdf.push_back(sum);
+        }
+        for (double& c : cdf) c /= sum;
+    }
+
+    const CorpusOptions& corpus_options() const { return options; }
+    const std::string& word(size_t rank) const { return words[rank]; }
+
+    // Probability that a word of the text is the one of this rank.
+    double probability(size_t rank) const { return cdf[rank] - (rank > 0 ? cdf[rank - 1] : 0.0); }
+
+    // `count` words in sentences: capitalized starts, commas and full stops.
+    std::string text(Rng& rng, size_t count) const {
+        std::string out;
+        out.reserve(count * 8);
+        size_t sentence = 0;
+        for (size_t i = 0; i < count; ++i) {
+            std::string w = words[sample(rng)];
+            if (sentence == 0) w[0] = static_cast<char>(w[0] - 'a' + 'A');
+            out += w;
+            if (++sentence >= 6 + rng.below(14)) {
+                out += ". ";
+                sentence = 0;
+            } else {
+                out += rng.below(10) == 0 ? ", " : " ";
+            }
+        }
+        return out;
+    }
+
+    std::string url(size_t i) const { return "http://site" + std::to_string(i % 997) + ".example/page/" + std::to_string(i); }
+
+    // A crawled page: head with title, style and script, navigation links, then paragraphs of body text.
+    std::string page(size_t i) const {
+        Rng rng(options.seed ^ (0xD1B54A32D192ED03ULL * (i + 1)));
+        std::string html = "<!DOCTYPE html><html><head><meta charset=\"utf-8\"><title>" + text(rng, 3 + rng.below(6)) +
+                           "</title><style>body { font-family: sans-serif; } .nav a { margin: 0 4px; }</style>"
+                           "<script>window.dataLayer = window.dataLayer || []; dataLayer.push({page: " +
+                           std::to_string(i) + "});</script></head><body><div class=\"nav\">";
+        for (int link = 0; link < 8; ++link) {
+            html += "<a href=\"" + url(rng.below(1000000)) + "\">" + words[sample(rng)] + "</a>";
+        }
+        html += "</div><article>";
+        size_t remaining = options.words_per_page;
+        while (remaining > 0) {
+            size_t n = std::min(remaining, 40 + rng.below(80));
+            html += "<p>" + text(rng, n) + "</p>\n";
+            remaining -= n;
+        }
+        html += "</article><footer>&copy; Example &amp; Co.</footer></body></html>";
+        return html;
+    }
+
+    // Posting list of the word of `rank` over `doc_count` pages, with the document frequency and tf
+    // (on average) that pages of words_per_page words drawn from this distribution would give.
+    std::vector<indexer::Posting> postings(size_t rank, uint32_t doc_count) const {
+        Rng rng(options.seed ^ (0x9FB21C651E98DF25ULL * (rank + 1)));
+        double p = probability(rank);
+        double words_per_page = static_cast<double>(options.words_per_page);
+        double df_fraction = 1.0 - std::pow(1.0 - p, words_per_page);
+        double mean_tf = p * words_per_page / df_fraction;
+
+        std::vector<indexer::Posting> out;
+        for (uint32_t doc = 0; doc < doc_count; ++doc) {
+            if (rng.unit() >= df_fraction) continue;
+            // 1 + geometric, with the mean above
+            uint32_t tf = 1;
+            double more = 1.0 - 1.0 / mean_tf;
+            while (tf < 1000 && rng.unit() < more) ++tf;
+            out.push_back({doc + 1, tf});
+        }
+        return out;
+    }
+
+private:
+    size_t sample(Rng& rng) const {
+        size_t rank = static_cast<size_t>(std::lower_bound(cdf.begin(), cdf.end(), rng.unit()) - cdf.begin());
+        return std::min(rank, options.vocabulary - 1);
+    }
+
+    CorpusOptions options;
+    std::vector<std::string> words;  // By frequency rank
+    std::vector<double> cdf;
+};
+
+} // namespace bench
+
+#endif // INDEXER_BENCH_SYNTHETIC_CORPUS_HPP
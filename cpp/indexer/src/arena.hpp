@@ -0,0 +1,77 @@
+#ifndef INDEXER_ARENA_HPP
+#define INDEXER_ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace indexer {
+
+// Bump allocator for short-lived, per-document allocations (e.g. a Gumbo parse tree).
+// Individual allocations are never freed; reset() releases everything at once and keeps
+// enough memory for a document of the same size to fit in a single chunk. Not thread-safe.
+class BumpArena {
+public:
+    explicit BumpArena(size_t chunk_size = 256 << 10, size_t max_retained = 64 << 20)
+        : chunk_size(chunk_size), max_retained(max_retained) {}
+
+    BumpArena(const BumpArena&) = delete;
+    BumpArena& operator=(const BumpArena&) = delete;
+
+    void* allocate(size_t size) {
+        size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        if (chunks.empty() || chunks.back().capacity - position < size) add_chunk(size);
+        void* result = chunks.back().data.get() + position;
+        position += size;
+        used += size;
+        return result;
+    }
+
+    // Invalidates every allocation made since the last reset.
+    void reset() {
+        if (chunks.size() > 1) {
+            // Replace the chain by one chunk as large as this document needed, within the retention cap
+            size_t needed = std::min(std::max(used, chunk_size), max_retained);
+            chunks.clear();
+            chunks.push_back({std::unique_ptr<char[]>(new char[needed]), needed});
+        } else if (!chunks.empty() && chunks.back().capacity > max_retained) {
+            chunks.clear();
+        }
+        position = 0;
+        used = 0;
+    }
+
+    size_t bytes_used() const { return used; }
+
+    size_t bytes_reserved() const {
+        size_t total = 0;
+        for (const Chunk& chunk : chunks) total += chunk.capacity;
+        return total;
+    }
+
+private:
+    static constexpr size_t ALIGNMENT = alignof(std::max_align_t);
+
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        size_t capacity;
+    };
+
+    void add_chunk(size_t min_size) {
+        // Grow geometrically so a large document needs few chunks
+        size_t capacity = std::max(min_size, chunks.empty() ? chunk_size : chunks.back().capacity * 2);
+        chunks.push_back({std::unique_ptr<char[]>(new char[capacity]), capacity});  // Not zeroed
+        position = 0;
+    }
+
+    size_t chunk_size;
+    size_t max_retained;
+    std::vector<Chunk> chunks;
+    size_t position = 0;  // Offset into chunks.back()
+    size_t used = 0;      // Bytes handed out since the last reset
+};
+
+} // namespace indexer
+
+#endif // INDEXER_ARENA_HPP
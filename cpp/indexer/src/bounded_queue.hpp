@@ -0,0 +1,92 @@
+#ifndef INDEXER_BOUNDED_QUEUE_HPP
+#define INDEXER_BOUNDED_QUEUE_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace indexer {
+
+// Blocking multi-producer, multi-consumer FIFO with a fixed capacity. push() blocks while the
+// queue is full, which is how a slow pipeline stage holds back the stages feeding it.
+// After close(), push() fails and pop() drains what is left before failing too.
+// All methods are thread-safe.
+template <class T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity > 0 ? capacity : 1) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Returns false (dropping `item`) if the queue is closed.
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this] { return closed_ || items.size() < capacity; });
+        if (closed_) return false;
+        items.push_back(std::move(item));
+        lock.unlock();
+        not_empty.notify_one();
+        return true;
+    }
+
+    // Waits for the next item. Empty once the queue is closed and drained.
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this] { return closed_ || !items.empty(); });
+        return take(lock);
+    }
+
+    // Like pop(), but also gives up after `timeout`; closed() tells the two cases apart.
+    template <class Rep, class Period>
+    std::optional<T> pop_for(const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait_for(lock, timeout, [this] { return closed_ || !items.empty(); });
+        return take(lock);
+    }
+
+    // Wakes every waiter; producers fail from now on, consumers once the queue is empty.
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed_ = true;
+        }
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+    bool closed() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return closed_;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return items.size();
+    }
+
+private:
+    std::optional<T> take(std::unique_lock<std::mutex>& lock) {
+        if (items.empty()) return std::nullopt;
+        std::optional<T> item(std::move(items.front()));
+        items.pop_front();
+        lock.unlock();
+        not_full.notify_one();
+        return item;
+    }
+
+    size_t capacity;
+    mutable std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+    std::deque<T> items;
+    bool closed_ = false;
+};
+
+} // namespace indexer
+
+#endif // INDEXER_BOUNDED_QUEUE_HPP
@@ -0,0 +1,213 @@
+#include "doc_stats.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace indexer {
+
+namespace {
+
+const char DOC_STATS_MAGIC[8] = {'D', 'O', 'C', 'S', 'T', 'A', 'T', '1'};
+const size_t INITIAL_CAPACITY = 1 << 16;
+// A reader gives up waiting for a consistent snapshot after this many attempts (writer died mid-update)
+const int MAX_SNAPSHOT_ATTEMPTS = 1000;
+
+size_t file_bytes(size_t capacity) {
+    return sizeof(DocStatsHeader) + capacity * sizeof(uint32_t);
+}
+
+DocStatsHeader* header_of(char* data) {
+    return reinterpret_cast<DocStatsHeader*>(data);
+}
+
+std::atomic<uint32_t>* lengths_of(char* data) {
+    return reinterpret_cast<std::atomic<uint32_t>*>(data + sizeof(DocStatsHeader));
+}
+
+DocStatsTotals read_totals(const DocStatsHeader* header) {
+    DocStatsTotals totals;
+    for (int attempt = 0; attempt < MAX_SNAPSHOT_ATTEMPTS; ++attempt) {
+        uint64_t before = header->sequence.load(std::memory_order_acquire);
+        totals.total_docs = header->total_docs.load(std::memory_order_relaxed);
+        totals.total_length = header->total_length.load(std::memory_order_relaxed);
+        totals.min_length = header->min_length.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (before % 2 == 0 && header->sequence.load(std::memory_order_relaxed) == before) break;
+        std::this_thread::yield();
+    }
+    return totals;
+}
+
+} // namespace
+
+DocStatsWriter::DocStatsWriter(const std::string& path) : path(path) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open doc stats: " + path + " (" + std::strerror(errno) + ")");
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Could not stat doc stats: " + path);
+    }
+
+    bool created = static_cast<size_t>(st.st_size) < sizeof(DocStatsHeader);
+    size_t capacity = created ? INITIAL_CAPACITY : (static_cast<size_t>(st.st_size) - sizeof(DocStatsHeader)) / sizeof(uint32_t);
+    try {
+        map(capacity);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+
+    DocStatsHeader* header = header_of(data);
+    if (created) {
+        std::memcpy(header->magic, DOC_STATS_MAGIC, sizeof(DOC_STATS_MAGIC));
+        header->capacity.store(static_cast<uint32_t>(capacity), std::memory_order_release);
+        return;
+    }
+    if (std::memcmp(header->magic, DOC_STATS_MAGIC, sizeof(DOC_STATS_MAGIC)) != 0) {
+        ::munmap(data, mapped_bytes);
+        ::close(fd);
+        throw std::runtime_error("Not a doc stats file: " + path);
+    }
+
+    // Recompute the totals from the lengths, which also repairs a previous writer that died mid-update
+    DocStatsTotals totals;
+    std::atomic<uint32_t>* lengths = lengths_of(data);
+    for (size_t i = 0; i < capacity; ++i) {
+        uint32_t len = lengths[i].load(std::memory_order_relaxed);
+        if (len == 0) continue;
+        ++totals.total_docs;
+        totals.total_length += len;
+        if (totals.min_length == 0 || len < totals.min_length) totals.min_length = len;
+    }
+    header->total_docs.store(totals.total_docs, std::memory_order_relaxed);
+    header->total_length.store(totals.total_length, std::memory_order_relaxed);
+    header->min_length.store(totals.min_length, std::memory_order_relaxed);
+    header->capacity.store(static_cast<uint32_t>(capacity), std::memory_order_relaxed);
+    uint64_t sequence = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(sequence + (sequence % 2), std::memory_order_release);
+}
+
+DocStatsWriter::~DocStatsWriter() {
+    if (data) ::munmap(data, mapped_bytes);
+    if (fd >= 0) ::close(fd);
+}
+
+void DocStatsWriter::map(size_t capacity) {
+    size_t bytes = file_bytes(capacity);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        throw std::runtime_error("Could not stat doc stats: " + path);
+    }
+    if (static_cast<size_t>(st.st_size) < bytes && ::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        throw std::runtime_error("Could not grow doc stats: " + path + " (" + std::strerror(errno) + ")");
+    }
+
+    void* addr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("Could not map doc stats: " + path + " (" + std::strerror(errno) + ")");
+    }
+    if (data) ::munmap(data, mapped_bytes);
+    data = static_cast<char*>(addr);
+    mapped_bytes = bytes;
+}
+
+void DocStatsWriter::set_lengths(const std::vector<std::pair<uint32_t, uint32_t>>& lengths) {
+    if (lengths.empty()) return;
+
+    DocStatsHeader* header = header_of(data);
+    size_t capacity = header->capacity.load(std::memory_order_relaxed);
+    uint32_t max_doc_id = 0;
+    for (const auto& entry : lengths) max_doc_id = std::max(max_doc_id, entry.first);
+    if (max_doc_id >= capacity) {
+        size_t grown = std::max<size_t>(size_t(max_doc_id) + 1, capacity * 2);
+        map(grown);
+        header = header_of(data);
+        header->capacity.store(static_cast<uint32_t>(grown), std::memory_order_release);
+    }
+
+    DocStatsTotals totals{header->total_docs.load(std::memory_order_relaxed),
+                          header->total_length.load(std::memory_order_relaxed),
+                          header->min_length.load(std::memory_order_relaxed)};
+    uint64_t sequence = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::atomic<uint32_t>* slots = lengths_of(data);
+    for (const auto& [doc_id, len] : lengths) {
+        uint32_t old = slots[doc_id].load(std::memory_order_relaxed);
+        if (old == 0 && len > 0) ++totals.total_docs;
+        if (old > 0 && len == 0) --totals.total_docs;
+        totals.total_length = totals.total_length - old + len;
+        if (len > 0 && (totals.min_length == 0 || len < totals.min_length)) totals.min_length = len;
+        slots[doc_id].store(len, std::memory_order_relaxed);
+    }
+    header->total_docs.store(totals.total_docs, std::memory_order_relaxed);
+    header->total_length.store(totals.total_length, std::memory_order_relaxed);
+    header->min_length.store(totals.min_length, std::memory_order_relaxed);
+    header->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+DocStatsTotals DocStatsWriter::totals() const {
+    return read_totals(header_of(data));
+}
+
+uint32_t DocStatsWriter::length(uint32_t doc_id) const {
+    size_t capacity = header_of(data)->capacity.load(std::memory_order_relaxed);
+    return doc_id < capacity ? lengths_of(data)[doc_id].load(std::memory_order_relaxed) : 0;
+}
+
+void DocStatsWriter::mark_replaced() {
+    header_of(data)->replaced.store(1, std::memory_order_release);
+}
+
+DocStatsView::DocStatsView(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open doc stats: " + path + " (" + std::strerror(errno) + ")");
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(DocStatsHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Doc stats file is missing its header: " + path);
+    }
+    mapped_bytes = static_cast<size_t>(st.st_size);
+
+    void* addr = ::mmap(nullptr, mapped_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);  // The mapping stays valid without the descriptor
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("Could not map doc stats: " + path + " (" + std::strerror(errno) + ")");
+    }
+    data = static_cast<const char*>(addr);
+    header = reinterpret_cast<const DocStatsHeader*>(data);
+    if (std::memcmp(header->magic, DOC_STATS_MAGIC, sizeof(DOC_STATS_MAGIC)) != 0) {
+        ::munmap(const_cast<char*>(data), mapped_bytes);
+        throw std::runtime_error("Not a doc stats file: " + path);
+    }
+
+    // The header may already announce capacity beyond what this mapping covers
+    size_t mapped_slots = (mapped_bytes - sizeof(DocStatsHeader)) / sizeof(uint32_t);
+    capacity = static_cast<uint32_t>(std::min<size_t>(mapped_slots, header->capacity.load(std::memory_order_acquire)));
+    lengths = reinterpret_cast<const std::atomic<uint32_t>*>(data + sizeof(DocStatsHeader));
+}
+
+DocStatsView::~DocStatsView() {
+    if (data) ::munmap(const_cast<char*>(data), mapped_bytes);
+}
+
+DocStatsTotals DocStatsView::totals() const {
+    return read_totals(header);
+}
+
+} // namespace indexer
@@ -0,0 +1,105 @@
+#ifndef INDEXER_DOC_STATS_HPP
+#define INDEXER_DOC_STATS_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace indexer {
+
+// Doc-stats file: a dense array of document lengths indexed by doc_id, written by the indexer and
+// mapped read-only by the ranker, so BM25 never has to ask Postgres for lengths or corpus totals.
+//
+//   DocStatsHeader                  64 bytes
+//   uint32_t lengths[capacity]      0 for documents that are not indexed
+//
+// Values are in host byte order; the file is shared between processes on one machine through the
+// page cache. Lengths are updated in place; the totals are published under a sequence lock so a
+// reader never sees N and the total length from different batches.
+struct DocStatsHeader {
+    char magic[8];                       // "DOCSTAT1"
+    std::atomic<uint64_t> sequence;      // Odd while the writer is updating the totals
+    std::atomic<uint64_t> total_docs;    // Documents with a length > 0
+    std::atomic<uint64_t> total_length;  // Sum of all lengths
+    std::atomic<uint32_t> capacity;      // Slots in `lengths`; only grows
+    std::atomic<uint32_t> min_length;    // Smallest length written >= 1 (a lower bound, never raised)
+    std::atomic<uint32_t> replaced;      // Set once a rebuilt file has been renamed over this one's path
+    char reserved[20];
+};
+static_assert(sizeof(DocStatsHeader) == 64, "DocStatsHeader layout is part of the file format");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Doc stats are shared through lock-free atomics");
+
+struct DocStatsTotals {
+    uint64_t total_docs = 0;
+    uint64_t total_length = 0;
+    uint32_t min_length = 0;
+};
+
+// Single writer of a doc-stats file. Creates the file if it does not exist.
+// Throws std::runtime_error on I/O errors.
+class DocStatsWriter {
+public:
+    explicit DocStatsWriter(const std::string& path);
+    ~DocStatsWriter();
+
+    DocStatsWriter(const DocStatsWriter&) = delete;
+    DocStatsWriter& operator=(const DocStatsWriter&) = delete;
+
+    // Sets the length of each (doc_id, length) pair and publishes the new totals at once.
+    // A length of 0 removes the document from the totals.
+    void set_lengths(const std::vector<std::pair<uint32_t, uint32_t>>& lengths);
+
+    DocStatsTotals totals() const;
+    uint32_t length(uint32_t doc_id) const;
+
+    // Tells readers of this file to reopen its path, after a new file has been renamed over it.
+    void mark_replaced();
+
+private:
+    void map(size_t capacity);
+
+    std::string path;
+    int fd = -1;
+    char* data = nullptr;
+    size_t mapped_bytes = 0;
+};
+
+// Read-only mapping of a doc-stats file. Lengths are read in place; readers remap once the
+// writer has grown the file past the mapping or a rebuild has replaced it (see stale()).
+class DocStatsView {
+public:
+    // Throws std::runtime_error if the file is missing or not a doc-stats file.
+    explicit DocStatsView(const std::string& path);
+    ~DocStatsView();
+
+    DocStatsView(const DocStatsView&) = delete;
+    DocStatsView& operator=(const DocStatsView&) = delete;
+
+    // Consistent snapshot of the corpus totals.
+    DocStatsTotals totals() const;
+
+    // 0 for unknown documents, including ids past the mapping.
+    uint32_t length(uint32_t doc_id) const {
+        return doc_id < capacity ? lengths[doc_id].load(std::memory_order_relaxed) : 0;
+    }
+
+    // True once the writer has grown the file past this mapping, or the file has been replaced.
+    bool stale() const {
+        return header->capacity.load(std::memory_order_acquire) > capacity ||
+               header->replaced.load(std::memory_order_acquire) != 0;
+    }
+
+private:
+    const char* data = nullptr;
+    size_t mapped_bytes = 0;
+    const DocStatsHeader* header = nullptr;
+    const std::atomic<uint32_t>* lengths = nullptr;
+    uint32_t capacity = 0;
+};
+
+} // namespace indexer
+
+#endif // INDEXER_DOC_STATS_HPP
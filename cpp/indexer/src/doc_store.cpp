@@ -0,0 +1,55 @@
+#include "doc_store.hpp"
+#include "varint.hpp"
+
+#include <stdexcept>
+
+namespace indexer {
+
+namespace {
+
+const char* const FORMAT_NAME = "stored document";  // In varint errors
+
+void put_field(std::string& out, std::string_view field) {
+    put_varint(out, static_cast<uint32_t>(field.size()));
+    out.append(field.data(), field.size());
+}
+
+std::string get_field(std::string_view in, size_t& pos) {
+    uint32_t length = get_varint(in, pos, FORMAT_NAME);
+    if (in.size() - pos < length) throw std::runtime_error("Truncated stored document");
+    std::string field(in.substr(pos, length));
+    pos += length;
+    return field;
+}
+
+} // namespace
+
+std::string doc_key(uint32_t doc_id) {
+    std::string key = DOC_KEY_PREFIX;
+    for (int shift = 24; shift >= 0; shift -= 8) key += static_cast<char>((doc_id >> shift) & 0xFF);
+    return key;
+}
+
+std::string encode_stored_document(std::string_view url, std::string_view title, std::string_view snippet) {
+    std::string value;
+    value.reserve(1 + 3 * 2 + url.size() + title.size() + snippet.size());
+    value += static_cast<char>(DOC_FORMAT_VERSION);
+    put_field(value, url);
+    put_field(value, title);
+    put_field(value, snippet);
+    return value;
+}
+
+StoredDocument decode_stored_document(std::string_view value) {
+    if (value.empty() || static_cast<uint8_t>(value[0]) != DOC_FORMAT_VERSION) {
+        throw std::runtime_error("Unknown stored document format");
+    }
+    size_t pos = 1;
+    StoredDocument document;
+    document.url = get_field(value, pos);
+    document.title = get_field(value, pos);
+    document.snippet = get_field(value, pos);
+    return document;
+}
+
+} // namespace indexer
@@ -0,0 +1,35 @@
+#ifndef INDEXER_DOC_STORE_HPP
+#define INDEXER_DOC_STORE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace indexer {
+
+// "~doc/<4-byte big-endian doc_id>" holds what the ranker shows for a result, so a results page is one
+// MultiGet on the index DB instead of a Postgres query. Written by the indexer before the document's
+// postings, so a document is never found without it. Like the segment keys, never collides with a term.
+const std::string DOC_KEY_PREFIX = "~doc/";
+
+std::string doc_key(uint32_t doc_id);
+
+struct StoredDocument {
+    std::string url;
+    std::string title;
+    std::string snippet;
+};
+
+// Value layout:
+//   byte    DOC_FORMAT_VERSION
+//   3 x     varint byte_length, bytes   (url, title, snippet)
+const uint8_t DOC_FORMAT_VERSION = 1;
+
+std::string encode_stored_document(std::string_view url, std::string_view title, std::string_view snippet);
+
+// Throws std::runtime_error on malformed input.
+StoredDocument decode_stored_document(std::string_view value);
+
+} // namespace indexer
+
+#endif // INDEXER_DOC_STORE_HPP
@@ -0,0 +1,76 @@
+#include "document_batch.hpp"
+
+namespace indexer {
+
+std::vector<DocLocation> fetch_doc_locations(pqxx::connection& C, const std::vector<int>& doc_ids) {
+    std::vector<DocLocation> locations;
+    if (doc_ids.empty()) return locations;
+
+    // Postgres array literal, e.g. "{12,13,40}"
+    std::string id_array = "{";
+    for (size_t i = 0; i < doc_ids.size(); ++i) {
+        if (i > 0) id_array += ",";
+        id_array += std::to_string(doc_ids[i]);
+    }
+    id_array += "}";
+
+    pqxx::work W(C);
+    pqxx::result R = W.exec_params(
+        "SELECT id, file_path, \"offset\", length FROM documents "
+        "WHERE id = ANY($1::int[]) AND file_path IS NOT NULL AND \"offset\" IS NOT NULL AND length IS NOT NULL",
+        id_array);
+    W.commit();
+
+    locations.reserve(R.size());
+    for (const auto& row : R) {
+        locations.push_back({row[0].as<int>(), row[1].as<std::string>(), row[2].as<int64_t>(), row[3].as<int64_t>()});
+    }
+    return locations;
+}
+
+std::vector<DocLocation> fetch_all_doc_locations(pqxx::connection& C) {
+    pqxx::work W(C);
+    pqxx::result R = W.exec(
+        "SELECT id, file_path, \"offset\", length FROM documents "
+        "WHERE file_path IS NOT NULL AND \"offset\" IS NOT NULL AND length IS NOT NULL "
+        "ORDER BY file_path, \"offset\"");
+    W.commit();
+
+    std::vector<DocLocation> locations;
+    locations.reserve(R.size());
+    for (const auto& row : R) {
+        locations.push_back({row[0].as<int>(), row[1].as<std::string>(), row[2].as<int64_t>(), row[3].as<int64_t>()});
+    }
+    return locations;
+}
+
+std::vector<std::pair<int, int64_t>> fetch_doc_lengths(pqxx::connection& C) {
+    pqxx::work W(C);
+    pqxx::result R = W.exec("SELECT id, doc_length FROM documents WHERE doc_length IS NOT NULL");
+    W.commit();
+
+    std::vector<std::pair<int, int64_t>> lengths;
+    lengths.reserve(R.size());
+    for (const auto& row : R) lengths.emplace_back(row[0].as<int>(), row[1].as<int64_t>());
+    return lengths;
+}
+
+void write_doc_updates(pqxx::connection& C, const std::vector<DocUpdate>& updates) {
+    if (updates.empty()) return;
+
+    pqxx::work W(C);
+    std::string sql =
+        "UPDATE documents AS d SET doc_length = v.doc_length, title = v.title, snippet = v.snippet "
+        "FROM (VALUES ";
+    for (size_t i = 0; i < updates.size(); ++i) {
+        const DocUpdate& update = updates[i];
+        if (i > 0) sql += ",";
+        sql += "(" + std::to_string(update.doc_id) + ", " + std::to_string(update.doc_length) + ", " +
+               W.quote(update.title) + ", " + W.quote(update.snippet) + ")";
+    }
+    sql += ") AS v(id, doc_length, title, snippet) WHERE d.id = v.id";
+    W.exec(sql);
+    W.commit();
+}
+
+} // namespace indexer
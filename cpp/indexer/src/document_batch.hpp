@@ -0,0 +1,45 @@
+#ifndef INDEXER_DOCUMENT_BATCH_HPP
+#define INDEXER_DOCUMENT_BATCH_HPP
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <pqxx/pqxx>
+
+namespace indexer {
+
+// Where a crawled document's WARC record lives.
+struct DocLocation {
+    int doc_id;
+    std::string file_path;  // Relative to WARC_BASE_PATH
+    int64_t offset;
+    int64_t length;
+};
+
+// Per-document results written back after indexing.
+struct DocUpdate {
+    int doc_id;
+    size_t doc_length;
+    std::string title;
+    std::string snippet;
+    std::string url;  // From the WARC record; not written back, Postgres already has it
+    std::string text_record;  // For query-time snippets (snippet.hpp); dropped once in the doc store
+};
+
+// Look up the WARC locations of `doc_ids` with a single `WHERE id = ANY(...)` query.
+// Documents that do not exist or have no WARC record yet are left out.
+std::vector<DocLocation> fetch_doc_locations(pqxx::connection& C, const std::vector<int>& doc_ids);
+
+// Locations of every document that has a WARC record, in segment order (file_path, offset).
+std::vector<DocLocation> fetch_all_doc_locations(pqxx::connection& C);
+
+// (id, doc_length) of every document that has been indexed, for rebuilding derived state.
+std::vector<std::pair<int, int64_t>> fetch_doc_lengths(pqxx::connection& C);
+
+// Write doc_length, title and snippet for every document in one UPDATE ... FROM (VALUES ...) statement.
+void write_doc_updates(pqxx::connection& C, const std::vector<DocUpdate>& updates);
+
+} // namespace indexer
+
+#endif // INDEXER_DOCUMENT_BATCH_HPP
@@ -0,0 +1,68 @@
+#include "document_parser.hpp"
+
+#include <algorithm>
+
+namespace indexer {
+
+namespace {
+
+// Time since `start`, and restarts it
+std::chrono::microseconds lap(std::chrono::steady_clock::time_point& start) {
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - start);
+    start = now;
+    return elapsed;
+}
+
+} // namespace
+
+RawDocument read_document(const DocLocation& location, WarcReader& warc_reader, GzipDecompressor& decompressor) {
+    // A view into the mapped segment, no copy; inflated straight into a buffer of the record's size
+    WarcRecordView record = warc_reader.read_record(location.file_path, location.offset, location.length);
+    RawDocument raw{location.doc_id, {}};
+    decompressor.decompress(record.compressed, raw.record);
+    return raw;
+}
+
+std::optional<DocUpdate> parse_document(const RawDocument& raw, HtmlTextExtractor& extractor,
+                                        Tokenizer& tokenizer, TermCounts& counts, TextRecordWriter& text_writer,
+                                        ParseTimings* timings) {
+    // Skip WARC headers (find first double newline)
+    std::string_view html_content = warc_payload(raw.record);
+    if (html_content.empty()) return std::nullopt;
+
+    ParseTimings local;
+    ParseTimings& t = timings ? *timings : local;
+    auto start = std::chrono::steady_clock::now();
+
+    // Valid until the next document; tokenized in place
+    const ExtractedContent& content = extractor.extract(html_content);
+    const std::string& plain_text = content.text;
+
+    // Fallback snippet (first 200 bytes, whole characters); the ranker cuts query-specific ones from the text record
+    std::string snippet(utf8_prefix(plain_text, SNIPPET_LENGTH));
+    // Basic cleanup of snippet (remove newlines)
+    std::replace(snippet.begin(), snippet.end(), '\n', ' ');
+    std::replace(snippet.begin(), snippet.end(), '\r', ' ');
+
+    t.extract = lap(start);
+
+    const std::vector<std::string_view>& tokens = tokenizer.tokenize(plain_text);
+    counts.clear();
+    for (std::string_view token : tokens) counts.add(token);
+    t.tokenize = lap(start);
+
+    std::string text_record = text_writer.encode(plain_text, tokens, tokenizer);
+    t.text_record = lap(start);
+    return DocUpdate{raw.doc_id, tokens.size(), content.title, std::move(snippet),
+                     std::string(warc_header(raw.record, "WARC-Target-URI")), std::move(text_record)};
+}
+
+TermFrequencies copy_terms(const TermCounts& counts) {
+    TermFrequencies terms;
+    terms.reserve(counts.size());
+    for (const auto& [term, tf] : counts.entries()) terms.emplace_back(term, tf);
+    return terms;
+}
+
+} // namespace indexer
@@ -0,0 +1,50 @@
+#ifndef INDEXER_DOCUMENT_PARSER_HPP
+#define INDEXER_DOCUMENT_PARSER_HPP
+
+#include "document_batch.hpp"
+#include "gzip_decompressor.hpp"
+#include "html_text.hpp"
+#include "snippet.hpp"
+#include "index_builder.hpp"
+#include "tokenizer.hpp"
+#include "warc_reader.hpp"
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace indexer {
+
+const size_t SNIPPET_LENGTH = 200;
+
+// A decompressed WARC record on its way to be parsed.
+struct RawDocument {
+    int doc_id;
+    std::string record;
+};
+
+// Reads and inflates the record of `location` with the caller's (per-thread) decompressor.
+// Throws std::runtime_error on failure.
+RawDocument read_document(const DocLocation& location, WarcReader& warc_reader, GzipDecompressor& decompressor);
+
+// Time spent in each step of parse_document, for the service's metrics.
+struct ParseTimings {
+    std::chrono::microseconds extract{0};
+    std::chrono::microseconds tokenize{0};  // Tokenizing and counting terms
+    std::chrono::microseconds text_record{0};
+};
+
+// Extracts and tokenizes the payload of `raw` with the caller's (per-thread) buffers and counts its
+// terms into `counts`, whose keys then point into `tokenizer`'s buffer. Returns the metadata to write
+// back, with the text record for snippets, or nothing if the record has no payload. Fills `timings`
+// if given.
+std::optional<DocUpdate> parse_document(const RawDocument& raw, HtmlTextExtractor& extractor,
+                                        Tokenizer& tokenizer, TermCounts& counts, TextRecordWriter& text_writer,
+                                        ParseTimings* timings = nullptr);
+
+// Owned copy of `counts`, e.g. to hand them to another thread.
+TermFrequencies copy_terms(const TermCounts& counts);
+
+} // namespace indexer
+
+#endif // INDEXER_DOCUMENT_PARSER_HPP
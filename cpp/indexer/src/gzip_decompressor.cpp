@@ -0,0 +1,127 @@
+#include "gzip_decompressor.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <new>
+#include <stdexcept>
+
+#ifdef INDEXER_WITH_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
+namespace indexer {
+
+namespace {
+
+const size_t MIN_GZIP_MEMBER = 18;     // 10-byte header, empty deflate block, 8-byte trailer
+const size_t MAX_DEFLATE_RATIO = 1032; // Deflate cannot expand its input more than this
+const size_t GUESSED_RATIO = 4;        // Typical for HTML; only used without a trailer to go by
+const size_t MIN_OUTPUT_BYTES = 4096;
+
+} // namespace
+
+std::optional<uint32_t> gzip_isize(std::string_view member) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(member.data());
+    if (member.size() < MIN_GZIP_MEMBER || bytes[0] != 0x1f || bytes[1] != 0x8b) return std::nullopt;
+    const unsigned char* trailer = bytes + member.size() - 4;  // Little-endian
+    uint32_t isize = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | (static_cast<uint32_t>(trailer[3]) << 24);
+    if (isize > member.size() * MAX_DEFLATE_RATIO) return std::nullopt;
+    return isize;
+}
+
+GzipDecompressor::GzipDecompressor() {
+    stream = {};
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+        throw std::runtime_error("inflateInit2 failed");
+    }
+#ifdef INDEXER_WITH_LIBDEFLATE
+    whole_member_decompressor = libdeflate_alloc_decompressor();
+    if (!whole_member_decompressor) {
+        inflateEnd(&stream);
+        throw std::bad_alloc();
+    }
+#endif
+}
+
+GzipDecompressor::~GzipDecompressor() {
+    inflateEnd(&stream);
+#ifdef INDEXER_WITH_LIBDEFLATE
+    libdeflate_free_decompressor(whole_member_decompressor);
+#endif
+}
+
+void GzipDecompressor::start(std::string_view compressed) {
+    if (compressed.size() > UINT_MAX) {
+        throw std::runtime_error("Compressed data too large (> 4GB)");
+    }
+    if (inflateReset(&stream) != Z_OK) {
+        throw std::runtime_error("inflateReset failed");
+    }
+    stream.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(compressed.data()));
+    stream.avail_in = static_cast<uInt>(compressed.size());
+}
+
+bool GzipDecompressor::inflate_some(char* out, size_t capacity) {
+    stream.next_out = reinterpret_cast<Bytef*>(out);
+    stream.avail_out = static_cast<uInt>(std::min<size_t>(capacity, UINT_MAX));
+    int ret = inflate(&stream, Z_NO_FLUSH);
+    if (ret == Z_STREAM_END) return true;
+    if (ret != Z_OK && ret != Z_BUF_ERROR) {
+        throw std::runtime_error("inflate failed with code: " + std::to_string(ret));
+    }
+    // inflate() stops when either side runs out; with room left, the input ended early
+    if (stream.avail_out > 0) throw std::runtime_error("Truncated gzip member");
+    return false;
+}
+
+size_t GzipDecompressor::decompress(std::string_view compressed, std::string& out, bool whole_member) {
+    std::optional<uint32_t> isize = whole_member ? gzip_isize(compressed) : std::nullopt;
+    size_t size = isize ? *isize : std::max(MIN_OUTPUT_BYTES, compressed.size() * GUESSED_RATIO);
+    size = std::min(size, MAX_DECOMPRESSED_SIZE);
+
+#ifdef INDEXER_WITH_LIBDEFLATE
+    if (isize) {
+        out.resize(size);
+        size_t in_bytes = 0, out_bytes = 0;
+        libdeflate_result result = libdeflate_gzip_decompress_ex(whole_member_decompressor, compressed.data(), compressed.size(),
+                                                                 out.data(), out.size(), &in_bytes, &out_bytes);
+        if (result == LIBDEFLATE_SUCCESS) {
+            out.resize(out_bytes);
+            return in_bytes;
+        }
+        // The trailer did not describe this member after all (e.g. ISIZE wrapped past 4 GB): zlib can grow `out`
+    }
+#endif
+
+    start(compressed);
+    out.resize(size);
+    // Every pass that does not reach the end of the member fills `out`
+    while (!inflate_some(out.data() + stream.total_out, out.size() - stream.total_out)) {
+        if (out.size() >= MAX_DECOMPRESSED_SIZE) {
+            throw std::runtime_error("Decompressed data exceeds maximum allowed size");
+        }
+        out.resize(std::min(MAX_DECOMPRESSED_SIZE, std::max(MIN_OUTPUT_BYTES, out.size() * 2)));
+    }
+    out.resize(stream.total_out);
+    return stream.total_in;
+}
+
+size_t GzipDecompressor::decompress(std::string_view compressed, char* out, size_t capacity, size_t* consumed) {
+#ifdef INDEXER_WITH_LIBDEFLATE
+    size_t in_bytes = 0, out_bytes = 0;
+    libdeflate_result result = libdeflate_gzip_decompress_ex(whole_member_decompressor, compressed.data(), compressed.size(),
+                                                             out, capacity, &in_bytes, &out_bytes);
+    if (result == LIBDEFLATE_INSUFFICIENT_SPACE) throw std::runtime_error("Decompressed data does not fit the buffer");
+    if (result != LIBDEFLATE_SUCCESS) throw std::runtime_error("Corrupt gzip member");
+    if (consumed) *consumed = in_bytes;
+    return out_bytes;
+#else
+    start(compressed);
+    // An exactly full buffer may still leave the trailer to be checked
+    if (!inflate_some(out, capacity) && !inflate_some(out + capacity, 0)) throw std::runtime_error("Decompressed data does not fit the buffer");
+    if (consumed) *consumed = stream.total_in;
+    return stream.total_out;
+#endif
+}
+
+} // namespace indexer
@@ -0,0 +1,61 @@
+#ifndef INDEXER_GZIP_DECOMPRESSOR_HPP
+#define INDEXER_GZIP_DECOMPRESSOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <zlib.h>
+
+#ifdef INDEXER_WITH_LIBDEFLATE
+struct libdeflate_decompressor;
+#endif
+
+namespace indexer {
+
+const size_t MAX_DECOMPRESSED_SIZE = 100 * 1024 * 1024;  // Larger records are rejected
+
+// The ISIZE trailer of a gzip member that ends exactly at the end of `member`: its uncompressed size
+// mod 2^32. Nothing if `member` is too short to be gzip or the value is impossible for its size.
+std::optional<uint32_t> gzip_isize(std::string_view member);
+
+// Inflates gzip members with one long-lived inflate state, reset between members instead of being
+// set up and torn down for each. Output goes straight into the caller's buffer, pre-sized from the
+// ISIZE trailer so a whole record is normally inflated in one pass without growing it.
+// With INDEXER_WITH_LIBDEFLATE, whole members are inflated by libdeflate, with zlib as the fallback.
+// Not thread-safe: keep one per thread.
+class GzipDecompressor {
+public:
+    GzipDecompressor();
+    ~GzipDecompressor();
+
+    GzipDecompressor(const GzipDecompressor&) = delete;
+    GzipDecompressor& operator=(const GzipDecompressor&) = delete;
+
+    // Inflates the first gzip member of `compressed` into `out`, replacing its contents (a reused
+    // `out` keeps its capacity). Returns the compressed size of that member. Pass `whole_member = false`
+    // if `compressed` may continue past the member (e.g. the rest of a segment), so that the last
+    // member's trailer is not mistaken for this one's.
+    // Throws std::runtime_error on corrupt input or output over MAX_DECOMPRESSED_SIZE.
+    size_t decompress(std::string_view compressed, std::string& out, bool whole_member = true);
+
+    // Same, into `out[0, capacity)`. Returns the decompressed size; `consumed` receives the compressed
+    // size. Throws std::runtime_error on corrupt input or if the output does not fit.
+    size_t decompress(std::string_view compressed, char* out, size_t capacity, size_t* consumed = nullptr);
+
+private:
+    void start(std::string_view compressed);
+    // Continues the current member into `out[0, capacity)`. True at its end, false once `out` is full.
+    bool inflate_some(char* out, size_t capacity);
+
+    z_stream stream;
+#ifdef INDEXER_WITH_LIBDEFLATE
+    libdeflate_decompressor* whole_member_decompressor = nullptr;
+#endif
+};
+
+} // namespace indexer
+
+#endif // INDEXER_GZIP_DECOMPRESSOR_HPP
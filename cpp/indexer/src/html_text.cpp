@@ -0,0 +1,215 @@
+#include "html_text.hpp"
+
+#include <gumbo.h>
+
+#include <cctype>
+#include <cstdint>
+#include <stdexcept>
+
+namespace indexer {
+
+namespace {
+
+bool iequals_prefix(std::string_view text, size_t pos, std::string_view lower) {
+    if (text.size() - pos < lower.size()) return false;
+    for (size_t i = 0; i < lower.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(text[pos + i])) != lower[i]) return false;
+    }
+    return true;
+}
+
+// Position of the "</name" that closes a raw-text element (script, style, title), or npos.
+size_t find_closing_tag(std::string_view html, size_t from, std::string_view name) {
+    for (size_t pos = html.find("</", from); pos != std::string_view::npos; pos = html.find("</", pos + 2)) {
+        if (iequals_prefix(html, pos + 2, name)) return pos;
+    }
+    return std::string_view::npos;
+}
+
+// End of the tag starting at `pos` (one past its '>'), skipping '>' inside quoted attribute values.
+size_t skip_tag(std::string_view html, size_t pos) {
+    char quote = 0;
+    for (size_t i = pos + 1; i < html.size(); ++i) {
+        char c = html[i];
+        if (quote) {
+            if (c == quote) quote = 0;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '>') {
+            return i + 1;
+        }
+    }
+    return html.size();
+}
+
+void append_utf8(uint32_t cp, std::string& out) {
+    if (cp == 0 || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) cp = 0xFFFD;
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+// Decodes the character reference at html[pos] == '&' into `out`. Returns the number of input
+// bytes consumed; an unknown reference is copied literally.
+size_t decode_reference(std::string_view html, size_t pos, std::string& out) {
+    size_t semicolon = html.find(';', pos + 1);
+    if (semicolon == std::string_view::npos || semicolon - pos > 10) {
+        out.push_back('&');
+        return 1;
+    }
+    std::string_view name = html.substr(pos + 1, semicolon - pos - 1);
+    size_t consumed = semicolon - pos + 1;
+
+    if (name.size() > 1 && name[0] == '#') {
+        bool hex = name[1] == 'x' || name[1] == 'X';
+        uint32_t cp = 0;
+        size_t digits = 0;
+        for (size_t i = hex ? 2 : 1; i < name.size(); ++i, ++digits) {
+            char c = name[i];
+            uint32_t value;
+            if (c >= '0' && c <= '9') value = c - '0';
+            else if (hex && std::isxdigit(static_cast<unsigned char>(c))) value = std::tolower(c) - 'a' + 10;
+            else { digits = 0; break; }
+            cp = cp * (hex ? 16 : 10) + value;
+            if (cp > 0x10FFFF) cp = 0x110000;  // Stays invalid without overflowing
+        }
+        if (digits > 0) {
+            append_utf8(cp, out);
+            return consumed;
+        }
+    } else if (name == "amp") {
+        out.push_back('&');
+        return consumed;
+    } else if (name == "lt") {
+        out.push_back('<');
+        return consumed;
+    } else if (name == "gt") {
+        out.push_back('>');
+        return consumed;
+    } else if (name == "quot") {
+        out.push_back('"');
+        return consumed;
+    } else if (name == "apos") {
+        out.push_back('\'');
+        return consumed;
+    } else if (name == "nbsp") {
+        out.push_back(' ');
+        return consumed;
+    }
+    out.push_back('&');
+    return 1;
+}
+
+// Appends html[begin, end) to `out`, decoding character references.
+void append_text(std::string_view html, size_t begin, size_t end, std::string& out) {
+    while (begin < end) {
+        size_t amp = html.find('&', begin);
+        if (amp == std::string_view::npos || amp >= end) amp = end;
+        out.append(html.data() + begin, amp - begin);
+        if (amp == end) break;
+        begin = amp + decode_reference(html.substr(0, end), amp, out);
+    }
+}
+
+} // namespace
+
+HtmlExtractMode parse_html_extract_mode(const std::string& name) {
+    if (name == "dom") return HtmlExtractMode::Dom;
+    if (name == "strip") return HtmlExtractMode::StripTags;
+    throw std::invalid_argument("Unknown HTML extract mode: " + name);
+}
+
+void strip_html_tags(std::string_view html, ExtractedContent& content) {
+    std::string& out = content.text;
+    out.clear();
+    content.title.clear();
+
+    size_t pos = 0;
+    while (pos < html.size()) {
+        size_t lt = html.find('<', pos);
+        if (lt == std::string_view::npos) lt = html.size();
+        append_text(html, pos, lt, out);
+        if (lt == html.size()) break;
+
+        // Like the DOM walk, element boundaries separate words
+        if (html.compare(lt, 4, "<!--") == 0) {
+            size_t close = html.find("-->", lt + 4);
+            pos = close == std::string_view::npos ? html.size() : close + 3;
+            continue;
+        }
+        unsigned char next = lt + 1 < html.size() ? html[lt + 1] : 0;
+        if (!std::isalpha(next) && next != '/' && next != '!' && next != '?') {
+            out.push_back('<');  // A bare '<' is text
+            pos = lt + 1;
+            continue;
+        }
+        pos = skip_tag(html, lt);
+        if (!out.empty() && out.back() != ' ') out.push_back(' ');
+
+        std::string_view raw_element;
+        if (iequals_prefix(html, lt + 1, "script")) raw_element = "script";
+        else if (iequals_prefix(html, lt + 1, "style")) raw_element = "style";
+        else if (iequals_prefix(html, lt + 1, "title")) raw_element = "title";
+        if (raw_element.empty()) continue;
+        // Only the exact tag name (not e.g. <titles>) opens a raw-text element
+        size_t name_end = lt + 1 + raw_element.size();
+        if (name_end < html.size() && std::isalnum(static_cast<unsigned char>(html[name_end]))) continue;
+
+        size_t close = find_closing_tag(html, pos, raw_element);
+        if (close == std::string_view::npos) close = html.size();
+        if (raw_element == "title") {
+            size_t title_start = out.size();
+            append_text(html, pos, close, out);
+            content.title.assign(out, title_start, std::string::npos);
+        }
+        pos = close < html.size() ? skip_tag(html, close) : close;
+    }
+}
+
+HtmlTextExtractor::HtmlTextExtractor(HtmlExtractMode mode) : mode_(mode) {}
+
+const ExtractedContent& HtmlTextExtractor::extract(std::string_view html) {
+    // Extracted text is never longer than the markup (give or take separators), so this usually
+    // allocates only for the first, largest documents
+    content.text.reserve(html.size());
+    if (mode_ == HtmlExtractMode::StripTags) {
+        strip_html_tags(html, content);
+    } else {
+        extract_dom(html);
+    }
+    return content;
+}
+
+void HtmlTextExtractor::extract_dom(std::string_view html) {
+    arena.reset();  // Drops the previous document's tree
+
+    GumboOptions options = kGumboDefaultOptions;
+    options.allocator = &HtmlTextExtractor::arena_allocate;
+    options.deallocator = &HtmlTextExtractor::arena_deallocate;
+    options.userdata = &arena;
+
+    // Every node lives in the arena, so the tree is released by the next reset() instead of
+    // gumbo_destroy_output() freeing it node by node
+    GumboOutput* output = gumbo_parse_with_options(&options, html.data(), html.size());
+    extract_content(output->root, content);
+}
+
+void* HtmlTextExtractor::arena_allocate(void* arena, size_t size) {
+    return static_cast<BumpArena*>(arena)->allocate(size);
+}
+
+void HtmlTextExtractor::arena_deallocate(void*, void*) {}
+
+} // namespace indexer
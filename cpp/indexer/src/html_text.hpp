@@ -0,0 +1,49 @@
+#ifndef INDEXER_HTML_TEXT_HPP
+#define INDEXER_HTML_TEXT_HPP
+
+#include "arena.hpp"
+#include "utils.hpp"
+
+#include <string>
+#include <string_view>
+
+namespace indexer {
+
+enum class HtmlExtractMode {
+    Dom,        // Full HTML5 parse with Gumbo (handles malformed markup like a browser)
+    StripTags,  // Single streaming pass without a DOM, for bulk reindexing
+};
+
+// Parses "dom" or "strip". Throws std::invalid_argument for anything else.
+HtmlExtractMode parse_html_extract_mode(const std::string& name);
+
+// Extracts the text and title of HTML documents, reusing its memory across them: Gumbo allocates
+// the parse tree from an arena that is reset per document, and the output buffers keep their
+// capacity. Meant to be owned by one thread; not thread-safe.
+class HtmlTextExtractor {
+public:
+    explicit HtmlTextExtractor(HtmlExtractMode mode = HtmlExtractMode::Dom);
+
+    // The result is owned by the extractor and valid until the next call.
+    const ExtractedContent& extract(std::string_view html);
+
+    HtmlExtractMode mode() const { return mode_; }
+
+private:
+    void extract_dom(std::string_view html);
+
+    static void* arena_allocate(void* arena, size_t size);
+    static void arena_deallocate(void* arena, void* ptr);
+
+    HtmlExtractMode mode_;
+    BumpArena arena;
+    ExtractedContent content;
+};
+
+// Text of `html` with tags, comments, scripts and styles removed and common character references
+// decoded, plus the <title>. Coarser than a DOM parse but an order of magnitude cheaper.
+void strip_html_tags(std::string_view html, ExtractedContent& content);
+
+} // namespace indexer
+
+#endif // INDEXER_HTML_TEXT_HPP
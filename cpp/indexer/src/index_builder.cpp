@@ -0,0 +1,69 @@
+#include "index_builder.hpp"
+
+#include <algorithm>
+
+namespace indexer {
+
+namespace {
+
+// Rough per-term cost of the hash node, the key string and the vector header
+const size_t TERM_OVERHEAD_BYTES = 96;
+
+} // namespace
+
+template <class Terms>
+void IndexBuilder::add_terms(uint32_t doc_id, const Terms& frequencies) {
+    for (const auto& [token, tf] : frequencies) {
+        auto [it, inserted] = terms.try_emplace(std::string(token));
+        if (inserted) memory_bytes += TERM_OVERHEAD_BYTES + token.size();
+        it->second.push_back({doc_id, tf});
+        memory_bytes += sizeof(Posting);
+    }
+    ++documents;
+}
+
+void IndexBuilder::add_document(uint32_t doc_id, const TermCounts& counts) {
+    add_terms(doc_id, counts.entries());
+}
+
+void IndexBuilder::add_document_terms(uint32_t doc_id, const TermFrequencies& frequencies) {
+    add_terms(doc_id, frequencies);
+}
+
+void IndexBuilder::add_document(uint32_t doc_id, const std::vector<std::string_view>& tokens) {
+    scratch_counts.clear();
+    for (std::string_view token : tokens) scratch_counts.add(token);
+    add_document(doc_id, scratch_counts);
+}
+
+std::vector<TermPostings> IndexBuilder::take_segment() {
+    std::vector<TermPostings> segment;
+    segment.reserve(terms.size());
+    for (auto& [term, postings] : terms) {
+        // Documents usually arrive in id order; the stable sort keeps the latest version of a
+        // re-added document last, so the dedupe below can keep it.
+        auto by_doc = [](const Posting& a, const Posting& b) { return a.doc_id < b.doc_id; };
+        if (!std::is_sorted(postings.begin(), postings.end(), by_doc)) {
+            std::stable_sort(postings.begin(), postings.end(), by_doc);
+        }
+        std::vector<Posting> unique;
+        unique.reserve(postings.size());
+        for (const Posting& posting : postings) {
+            if (!unique.empty() && unique.back().doc_id == posting.doc_id) {
+                unique.back() = posting;
+            } else {
+                unique.push_back(posting);
+            }
+        }
+        segment.emplace_back(term, std::move(unique));
+    }
+    std::sort(segment.begin(), segment.end(),
+              [](const TermPostings& a, const TermPostings& b) { return a.first < b.first; });
+
+    terms.clear();
+    memory_bytes = 0;
+    documents = 0;
+    return segment;
+}
+
+} // namespace indexer
@@ -0,0 +1,58 @@
+#ifndef INDEXER_INDEX_BUILDER_HPP
+#define INDEXER_INDEX_BUILDER_HPP
+
+#include "posting_list.hpp"
+#include "tokenizer.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace indexer {
+
+// A term and its postings, sorted by doc_id.
+using TermPostings = std::pair<std::string, std::vector<Posting>>;
+
+// A document's terms with their frequencies, owning the terms (e.g. to hand them between threads).
+using TermFrequencies = std::vector<std::pair<std::string, uint32_t>>;
+
+// In-memory inverted index for the documents indexed since the last flush.
+//
+// Adding a document costs O(tokens): postings are appended to per-term vectors and never
+// read back from the store. take_segment() hands the buffered index over as one sorted,
+// immutable segment (see segment_store.hpp) and starts a new one.
+// Not thread-safe.
+class IndexBuilder {
+public:
+    // Buffer postings for the term frequencies of `doc_id`. Postings are only ever added: re-adding a
+    // document updates the tf of the terms it contains but does not remove it from terms it lost.
+    void add_document(uint32_t doc_id, const TermCounts& counts);
+    void add_document_terms(uint32_t doc_id, const TermFrequencies& frequencies);
+
+    // Same, counting `tokens` first.
+    void add_document(uint32_t doc_id, const std::vector<std::string_view>& tokens);
+
+    // Approximate heap usage of the buffered index in bytes.
+    size_t memory_usage() const { return memory_bytes; }
+    size_t document_count() const { return documents; }
+    bool empty() const { return documents == 0; }
+
+    // Terms in byte order, each with its postings sorted by doc_id. Clears the builder.
+    std::vector<TermPostings> take_segment();
+
+private:
+    template <class Terms>
+    void add_terms(uint32_t doc_id, const Terms& frequencies);
+
+    std::unordered_map<std::string, std::vector<Posting>> terms;
+    size_t memory_bytes = 0;
+    size_t documents = 0;
+    TermCounts scratch_counts;  // Reused by the token overloads
+};
+
+} // namespace indexer
+
+#endif // INDEXER_INDEX_BUILDER_HPP
@@ -0,0 +1,46 @@
+#ifndef INDEXER_INDEX_OPTIONS_HPP
+#define INDEXER_INDEX_OPTIONS_HPP
+
+#include <rocksdb/cache.h>
+#include <rocksdb/filter_policy.h>
+#include <rocksdb/table.h>
+
+#include <cstddef>
+#include <memory>
+
+namespace indexer {
+
+// Block-based table settings of the index DB. The indexer writes its SST files with them (so the files
+// carry bloom filters) and the ranker reads with them.
+struct IndexTableConfig {
+    size_t block_cache_bytes = 256 << 20;
+    bool clock_cache = false;                   // Falls back to LRU if this RocksDB build has no clock cache
+    int bloom_bits_per_key = 10;                // 0 disables the filter; ~1% false positives at 10
+    bool pin_l0_filter_and_index_blocks = true; // Keep the hottest files' metadata in the cache
+};
+
+inline std::shared_ptr<rocksdb::Cache> make_block_cache(const IndexTableConfig& config) {
+    std::shared_ptr<rocksdb::Cache> cache;
+    if (config.clock_cache) cache = rocksdb::NewClockCache(config.block_cache_bytes);
+    if (!cache) cache = rocksdb::NewLRUCache(config.block_cache_bytes);
+    return cache;
+}
+
+// Installs the table factory on `options`. Returns the block cache so callers can report its usage.
+inline std::shared_ptr<rocksdb::Cache> apply_index_table_config(rocksdb::Options& options, const IndexTableConfig& config) {
+    rocksdb::BlockBasedTableOptions table_options;
+    table_options.block_cache = make_block_cache(config);
+    if (config.bloom_bits_per_key > 0) {
+        table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(config.bloom_bits_per_key, false));
+    }
+    // Index and filter blocks compete with data blocks for the cache instead of living on the heap,
+    // except L0's, which every lookup touches
+    table_options.cache_index_and_filter_blocks = true;
+    table_options.pin_l0_filter_and_index_blocks_in_cache = config.pin_l0_filter_and_index_blocks;
+    options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+    return table_options.block_cache;
+}
+
+} // namespace indexer
+
+#endif // INDEXER_INDEX_OPTIONS_HPP
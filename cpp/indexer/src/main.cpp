@@ -1,18 +1,38 @@
 #include "utils.hpp"
+#include "warc_reader.hpp"
+#include "document_batch.hpp"
+#include "index_builder.hpp"
+#include "segment_store.hpp"
+#include "posting_merge_operator.hpp"
+#include "doc_stats.hpp"
+#include "index_options.hpp"
+#include "html_text.hpp"
+#include "tokenizer.hpp"
+#include "bounded_queue.hpp"
+#include "document_parser.hpp"
+#include "rebuild.hpp"
+#include "shard.hpp"
+#include "doc_store.hpp"
+#include "snippet.hpp"
+#include "../../common/log.hpp"
+#include "../../common/metrics.hpp"
 
 #include <iostream>
 #include <string>
 #include <vector>
-#include <sstream>
-#include <fstream>
+#include <map>
 #include <algorithm>
-#include <set>
+#include <limits>
 #include <thread>
 #include <chrono>
+#include <memory>
+#include <optional>
+#include <functional>
+#include <filesystem>
+#include <mutex>
 #include <pqxx/pqxx>
 #include <hiredis/hiredis.h>
 #include <rocksdb/db.h>
-#include <gumbo.h>
 
 using namespace indexer;
 
@@ -21,168 +41,634 @@ const std::string REDIS_HOST = get_env_or_default("REDIS_HOST", "redis_service")
 const std::string DB_CONN_STR = build_db_conn_str();
 const std::string ROCKSDB_PATH = get_env_or_default("ROCKSDB_PATH", "/shared_data/search_index.db");
 const std::string WARC_BASE_PATH = get_env_or_default("WARC_BASE_PATH", "/shared_data/");
+const int INDEX_BATCH_SIZE = std::stoi(get_env_or_default("INDEX_BATCH_SIZE", "64"));
+const int QUEUE_BLOCK_TIMEOUT_SECONDS = 5;
+const size_t INDEX_MEMORY_LIMIT_BYTES = std::stoul(get_env_or_default("INDEX_MEMORY_LIMIT_MB", "64")) * 1024 * 1024;
+const int INDEX_FLUSH_INTERVAL_SECONDS = std::stoi(get_env_or_default("INDEX_FLUSH_INTERVAL_SECONDS", "10"));
+const size_t INDEX_MERGE_SEGMENTS = 4;  // Flushed segments that trigger a merge
+const int FLUSH_RETRY_SECONDS = 5;      // Wait before retrying a flush that could not write to the index DB
+// "merge": append postings with RocksDB merge operands; "segments": write segments and merge them ourselves
+const std::string POSTING_WRITE_MODE = get_env_or_default("POSTING_WRITE_MODE", "merge");
+// Dense doc_id -> doc_length array the ranker maps for BM25
+const std::string DOC_STATS_PATH = get_env_or_default("DOC_STATS_PATH", "/shared_data/doc_stats.bin");
+// Bloom filter bits per key in the SST files the ranker reads (0 disables; must be set when they are written)
+const int ROCKSDB_BLOOM_BITS = std::stoi(get_env_or_default("ROCKSDB_BLOOM_BITS", "10"));
+const size_t INDEXER_BLOCK_CACHE_BYTES = 32 << 20;  // The indexer only reads during segment merges
+// "dom": full Gumbo parse; "strip": streaming tag stripper without a DOM (faster, coarser)
+const std::string HTML_EXTRACT_MODE = get_env_or_default("HTML_EXTRACT_MODE", "dom");
+// Pipeline: fetch metadata (main thread) -> read & decompress -> parse & tokenize -> index (one thread,
+// owns the builder) -> write back. Parsing is the CPU-heavy stage and gets every core by default.
+const int HARDWARE_THREADS = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+const int INDEX_READ_THREADS = std::stoi(get_env_or_default("INDEX_READ_THREADS", std::to_string(std::max(1, HARDWARE_THREADS / 2))));
+const int INDEX_PARSE_THREADS = std::stoi(get_env_or_default("INDEX_PARSE_THREADS", std::to_string(HARDWARE_THREADS)));
+const int INDEX_WRITE_THREADS = std::stoi(get_env_or_default("INDEX_WRITE_THREADS", "1"));
+// Documents queued between two stages before the upstream one blocks; bounds the pipeline's memory
+const size_t INDEX_QUEUE_CAPACITY = std::stoul(get_env_or_default("INDEX_QUEUE_CAPACITY", "256"));
+const size_t WRITE_BACK_QUEUE_CAPACITY = 4;  // Flushed batches waiting for Postgres
+const int POSTGRES_CONNECT_RETRIES = 10;
+const int METADATA_RETRY_SECONDS = 5;  // Wait before reconnecting after a batch's metadata could not be fetched
+// Offline rebuild (--rebuild): parse workers, term-range partitions (one SST file each) and postings
+// buffered in memory across the workers before they spill sorted runs to REBUILD_WORK_DIR
+const int REBUILD_THREADS = std::stoi(get_env_or_default("REBUILD_THREADS", std::to_string(HARDWARE_THREADS)));
+const int REBUILD_PARTITIONS = std::stoi(get_env_or_default("REBUILD_PARTITIONS", std::to_string(2 * std::max(1, REBUILD_THREADS))));
+const size_t REBUILD_MEMORY_LIMIT_BYTES = std::stoul(get_env_or_default("REBUILD_MEMORY_MB", "1024")) * 1024 * 1024;
+// Empty: next to the new index, so the SST files are moved into it without a copy
+const std::string REBUILD_WORK_DIR = get_env_or_default("REBUILD_WORK_DIR", "");
+// Document-partitioned shard this process indexes (doc_id % INDEX_SHARD_COUNT == INDEX_SHARD_ID).
+// Every shard needs its own ROCKSDB_PATH and DOC_STATS_PATH; the crawler must use the same count.
+const ShardConfig SHARD = parse_shard_config(get_env_or_default("INDEX_SHARD_ID", "0"),
+                                             get_env_or_default("INDEX_SHARD_COUNT", "1"));
+// Prometheus endpoint of the service (0 turns it off). LOG_LEVEL (debug, info, warn or error) is read in main().
+const int METRICS_PORT = std::stoi(get_env_or_default("METRICS_PORT", "9100"));
+const int METRICS_SAMPLE_INTERVAL_SECONDS = 5;  // Gauges that need a Redis round trip
+const uint32_t DOCUMENT_LOG_LINES_PER_SECOND = 10;
 
-int main() {
-    std::cout << "--- Indexer Service Started ---" << std::endl;
+// --- Metrics ---
+// Served on METRICS_PORT at /metrics. Durations are recorded in microseconds and exported in seconds.
+struct IndexerMetrics {
+    common::Histogram& inflate = common::metrics().histogram("indexer_inflate_seconds", "Time to read and inflate a WARC record");
+    common::Counter& inflated_bytes = common::metrics().counter("indexer_inflated_bytes_total", "Bytes of inflated WARC records");
+    common::Counter& read_errors = common::metrics().counter("indexer_read_errors_total", "Records that could not be read");
+    common::Histogram& parse = common::metrics().histogram("indexer_parse_seconds", "Time to extract the text of a page");
+    common::Histogram& tokenize = common::metrics().histogram("indexer_tokenize_seconds", "Time to tokenize a page and count its terms");
+    common::Histogram& text_record = common::metrics().histogram("indexer_text_record_seconds", "Time to encode a page's text record");
+    common::Counter& parse_errors = common::metrics().counter("indexer_parse_errors_total", "Records that could not be parsed");
+    common::Histogram& index_write = common::metrics().histogram("indexer_index_write_seconds", "Time to write a flush's doc store entries and postings");
+    common::Histogram& segment_merge = common::metrics().histogram("indexer_segment_merge_seconds", "Time to merge index segments");
+    common::Counter& documents_indexed = common::metrics().counter("indexer_documents_indexed_total", "Documents whose postings were written");
+    common::Histogram& db_write = common::metrics().histogram("indexer_db_write_seconds", "Time to write a flush's metadata to Postgres");
+    common::Gauge& queue_length = common::metrics().gauge("indexer_queue_length", "Documents waiting in this shard's Redis queue");
+    common::Gauge& read_queued = common::metrics().gauge("indexer_pipeline_queued{stage=\"read\"}", "Documents waiting for a pipeline stage");
+    common::Gauge& parse_queued = common::metrics().gauge("indexer_pipeline_queued{stage=\"parse\"}", "Documents waiting for a pipeline stage");
+    common::Gauge& index_queued = common::metrics().gauge("indexer_pipeline_queued{stage=\"index\"}", "Documents waiting for a pipeline stage");
+};
+const IndexerMetrics METRICS;
 
-    // 1. Connect to Redis
-    redisContext *redis = redisConnect(REDIS_HOST.c_str(), 6379);
-    if (redis == NULL || redis->err) {
-        std::cerr << "Redis connection failed" << std::endl;
-        return 1;
+// --- Helper: Parse Queue Entry ---
+void append_doc_id(const redisReply* element, std::vector<int>& doc_ids) {
+    if (element == nullptr || element->str == nullptr) return;
+    try {
+        doc_ids.push_back(std::stoi(element->str));
+    } catch (const std::exception&) {
+        std::cerr << "Skipping malformed queue entry: " << element->str << std::endl;
     }
+}
 
-    // 2. Connect to Postgres
-    pqxx::connection* C = nullptr;
-    int retries = 10;
-    while (retries > 0) {
+// --- Helper: Pop a Batch of Doc IDs ---
+// Takes up to `max_count` IDs with one LPOP from this shard's queue. When the queue is empty, blocks (bounded) for the
+// next ID and then grabs whatever else arrived with it, so a trickle of work is not delayed.
+std::vector<int> pop_doc_ids(redisContext* redis, int max_count) {
+    std::vector<int> doc_ids;
+
+    redisReply* reply = (redisReply*)redisCommand(redis, "LPOP %s %d", SHARD.queue_key().c_str(), max_count);
+    if (reply && reply->type == REDIS_REPLY_ARRAY) {
+        for (size_t i = 0; i < reply->elements; ++i) append_doc_id(reply->element[i], doc_ids);
+    }
+    bool queue_empty = reply && reply->type == REDIS_REPLY_NIL;
+    if (reply) freeReplyObject(reply);
+    if (!queue_empty) return doc_ids;
+
+    reply = (redisReply*)redisCommand(redis, "BLPOP %s %d", SHARD.queue_key().c_str(), QUEUE_BLOCK_TIMEOUT_SECONDS);
+    if (reply == NULL || reply->type != REDIS_REPLY_ARRAY || reply->elements < 2) {
+        if (reply) freeReplyObject(reply);
+        return doc_ids;  // Timed out
+    }
+    append_doc_id(reply->element[1], doc_ids);  // element[0] is the key
+    freeReplyObject(reply);
+
+    if (max_count > 1) {
+        reply = (redisReply*)redisCommand(redis, "LPOP %s %d", SHARD.queue_key().c_str(), max_count - 1);
+        if (reply && reply->type == REDIS_REPLY_ARRAY) {
+            for (size_t i = 0; i < reply->elements; ++i) append_doc_id(reply->element[i], doc_ids);
+        }
+        if (reply) freeReplyObject(reply);
+    }
+    return doc_ids;
+}
+
+// --- Helper: Requeue Docs ---
+// Pushes popped documents back to the queues of the shards that own them, one RPUSH per shard: documents of other
+// shards (e.g. pushed by a crawler configured with another INDEX_SHARD_COUNT), or a batch of this shard that could
+// not be processed. Returns how many could not be requeued.
+size_t requeue_to_owners(redisContext* redis, const std::vector<int>& doc_ids) {
+    std::map<std::string, std::vector<std::string>> by_queue;
+    for (int doc_id : doc_ids) by_queue[SHARD.owner(doc_id).queue_key()].push_back(std::to_string(doc_id));
+
+    size_t failed = 0;
+    for (const auto& [key, values] : by_queue) {
+        std::vector<const char*> argv{"RPUSH", key.c_str()};
+        std::vector<size_t> argvlen{5, key.size()};
+        for (const std::string& value : values) {
+            argv.push_back(value.data());
+            argvlen.push_back(value.size());
+        }
+        redisReply* reply = (redisReply*)redisCommandArgv(redis, static_cast<int>(argv.size()), argv.data(), argvlen.data());
+        if (reply == NULL || reply->type == REDIS_REPLY_ERROR) {
+            LOG(Error) << "Failed to requeue " << values.size() << " docs to " << key << ": "
+                       << (reply ? reply->str : redis->err ? redis->errstr : "NULL reply");
+            failed += values.size();
+        }
+        if (reply) freeReplyObject(reply);
+    }
+    return failed;
+}
+
+// Everything the index and write-back stages need from one document.
+struct ParsedDocument {
+    DocUpdate update;
+    TermFrequencies terms;
+};
+
+// --- Helper: Write Doc Metadata ---
+void write_doc_metadata(pqxx::connection& C, const std::vector<DocUpdate>& updates) {
+    try {
+        write_doc_updates(C, updates);
+    } catch (const std::exception &e) {
+        // One bad row (e.g. invalid UTF-8 in a title) fails the whole statement; isolate it
+        std::cerr << "Batch update failed, retrying per document: " << e.what() << std::endl;
+        for (const DocUpdate& update : updates) {
+            try {
+                write_doc_updates(C, {update});
+            } catch (const std::exception &row_error) {
+                LOG_RATE_LIMITED(Warn, DOCUMENT_LOG_LINES_PER_SECOND)
+                    << "Error updating doc " << update.doc_id << ": " << row_error.what();
+            }
+        }
+    }
+}
+
+// --- Helper: Write Doc Store ---
+// url, title and snippet of every document, and its text record, in one atomic batch for the ranker's
+// result pages. The text records are released afterwards; nothing downstream needs them.
+// Throws std::runtime_error on failure.
+void write_doc_store(rocksdb::DB* db, std::vector<DocUpdate>& updates) {
+    rocksdb::WriteBatch batch;
+    for (const DocUpdate& update : updates) {
+        batch.Put(doc_key(static_cast<uint32_t>(update.doc_id)),
+                  encode_stored_document(update.url, update.title, update.snippet));
+        if (!update.text_record.empty()) batch.Put(text_key(static_cast<uint32_t>(update.doc_id)), update.text_record);
+    }
+    rocksdb::Status status = db->Write(rocksdb::WriteOptions(), &batch);
+    if (!status.ok()) throw std::runtime_error("Failed to write doc store: " + status.ToString());
+    for (DocUpdate& update : updates) std::string().swap(update.text_record);
+}
+
+uint32_t clamp_length(int64_t length) {
+    return static_cast<uint32_t>(std::clamp<int64_t>(length, 0, std::numeric_limits<uint32_t>::max()));
+}
+
+// --- Helper: Backfill Doc Stats ---
+// A new doc-stats file starts empty; seed it with the lengths of this shard's documents indexed before it existed.
+void backfill_doc_stats(DocStatsWriter& doc_stats, pqxx::connection& C) {
+    if (doc_stats.totals().total_docs > 0) return;
+    try {
+        std::vector<std::pair<uint32_t, uint32_t>> lengths;
+        for (const auto& [doc_id, length] : fetch_doc_lengths(C)) {
+            if (doc_id >= 0 && SHARD.owns(doc_id)) lengths.emplace_back(static_cast<uint32_t>(doc_id), clamp_length(length));
+        }
+        doc_stats.set_lengths(lengths);
+        if (!lengths.empty()) std::cout << "Backfilled doc stats for " << lengths.size() << " docs" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "Failed to backfill doc stats: " << e.what() << std::endl;
+    }
+}
+
+// --- Helper: Flush Index ---
+// Persists the doc-store entries of the buffered documents, then their postings (as merge operands, or
+// as one segment that is merged once enough have piled up or `merge_all` is set), then publishes their
+// lengths and metadata. So a document is never found without its doc-store entry, and never looks
+// indexed without its postings; the metadata goes to the write-back stage.
+// Returns false if the index DB could not be written. The documents were already popped from Redis, so
+// nothing is dropped: their postings stay in `segment` and their metadata in `pending_updates` for the
+// next call. Both writes are atomic batches and the doc-store entries are idempotent, so retrying is safe.
+bool flush_index(IndexBuilder& builder, rocksdb::DB* db, SegmentStore& segments, bool merge_all, DocStatsWriter& doc_stats,
+                 BoundedQueue<std::vector<DocUpdate>>& write_back, std::vector<TermPostings>& segment,
+                 std::vector<DocUpdate>& pending_updates) {
+    if (!builder.empty()) segment = builder.take_segment();
+    size_t docs = pending_updates.size();
+    if (docs > 0) {
         try {
-            C = new pqxx::connection(DB_CONN_STR);
-            if (C->is_open()) {
-                std::cout << "Connected to DB" << std::endl;
-                break;
+            common::ScopedTimer timer(METRICS.index_write);
+            write_doc_store(db, pending_updates);
+            if (POSTING_WRITE_MODE == "segments") {
+                segments.write_segment(segment);
+            } else {
+                append_postings(db, segment);
             }
+            segment.clear();
+            METRICS.documents_indexed.add(docs);
+            LOG(Info) << "Flushed postings of " << docs << " docs";
+        } catch (const std::exception &e) {
+            std::cerr << "Failed to flush postings of " << docs << " docs, retrying in " << FLUSH_RETRY_SECONDS
+                      << "s: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    if (segments.unmerged_segments() >= INDEX_MERGE_SEGMENTS || (merge_all && segments.unmerged_segments() > 0)) {
+        try {
+            common::ScopedTimer timer(METRICS.segment_merge);
+            size_t terms = segments.merge_segments();
+            LOG(Info) << "Merged index segments into " << terms << " terms";
+        } catch (const std::exception &e) {
+            std::cerr << "Failed to merge index segments: " << e.what() << std::endl;
+        }
+    }
+
+    try {
+        std::vector<std::pair<uint32_t, uint32_t>> lengths;
+        lengths.reserve(pending_updates.size());
+        for (const DocUpdate& update : pending_updates) {
+            lengths.emplace_back(static_cast<uint32_t>(update.doc_id), clamp_length(static_cast<int64_t>(update.doc_length)));
+        }
+        doc_stats.set_lengths(lengths);
+    } catch (const std::exception &e) {
+        std::cerr << "Failed to update doc stats: " << e.what() << std::endl;
+    }
+
+    if (!pending_updates.empty()) write_back.push(std::move(pending_updates));
+    pending_updates.clear();
+    return true;
+}
+
+// --- Helper: Connect to Postgres ---
+// Retries every 5 seconds; null if every attempt failed.
+std::unique_ptr<pqxx::connection> connect_postgres(int retries) {
+    while (retries > 0) {
+        try {
+            auto C = std::make_unique<pqxx::connection>(DB_CONN_STR);
+            if (C->is_open()) return C;
         } catch (const std::exception &e) {
             std::cerr << "Postgres connection attempt failed" << std::endl;
-            if (C) { delete C; C = nullptr; }
         }
         std::cout << "Retrying Postgres connection in 5 seconds..." << std::endl;
         std::this_thread::sleep_for(std::chrono::seconds(5));
         retries--;
     }
+    return nullptr;
+}
 
-    if (!C || !C->is_open()) {
+// --- Stage: Read & Decompress ---
+// Inflating is CPU-bound and overlaps with the page-cache misses of the segment reads.
+void read_stage(BoundedQueue<DocLocation>& in, BoundedQueue<RawDocument>& out, WarcReader& warc_reader) {
+    GzipDecompressor decompressor;
+    while (std::optional<DocLocation> location = in.pop()) {
+        try {
+            auto start = std::chrono::steady_clock::now();
+            RawDocument raw = read_document(*location, warc_reader, decompressor);
+            METRICS.inflate.record(common::ScopedTimer::micros_since(start));
+            METRICS.inflated_bytes.add(raw.record.size());
+            out.push(std::move(raw));
+        } catch (const std::exception &e) {
+            LOG_RATE_LIMITED(Warn, DOCUMENT_LOG_LINES_PER_SECOND) << "Error reading doc " << location->doc_id << ": " << e.what();
+            METRICS.read_errors.add();
+        }
+    }
+}
+
+// --- Stage: Parse & Tokenize ---
+// Each worker owns its extractor, tokenizer and counts, so their buffers are reused without locking.
+void parse_stage(BoundedQueue<RawDocument>& in, BoundedQueue<ParsedDocument>& out, HtmlExtractMode mode) {
+    HtmlTextExtractor extractor(mode);
+    Tokenizer tokenizer;
+    TermCounts counts;
+    TextRecordWriter text_writer;
+    ParseTimings timings;
+    while (std::optional<RawDocument> raw = in.pop()) {
+        try {
+            // Terms are copied out of the tokenizer's buffer so they can cross to the index thread
+            if (auto update = parse_document(*raw, extractor, tokenizer, counts, text_writer, &timings)) {
+                METRICS.parse.record(static_cast<uint64_t>(timings.extract.count()));
+                METRICS.tokenize.record(static_cast<uint64_t>(timings.tokenize.count()));
+                METRICS.text_record.record(static_cast<uint64_t>(timings.text_record.count()));
+                out.push(ParsedDocument{std::move(*update), copy_terms(counts)});
+            }
+        } catch (const std::exception &e) {
+            LOG_RATE_LIMITED(Warn, DOCUMENT_LOG_LINES_PER_SECOND) << "Error parsing doc " << raw->doc_id << ": " << e.what();
+            METRICS.parse_errors.add();
+        }
+    }
+}
+
+// --- Stage: Index ---
+// The only thread that touches the builder, the index DB and the doc stats. Flushes once enough has
+// been buffered, and everything (merging segments) once no document has arrived for a while.
+void index_stage(BoundedQueue<ParsedDocument>& in, BoundedQueue<std::vector<DocUpdate>>& write_back,
+                 rocksdb::DB* db, DocStatsWriter& doc_stats) {
+    IndexBuilder builder;
+    SegmentStore segments(db);
+    std::vector<DocUpdate> pending_updates;  // Metadata of documents in the unflushed builder
+    size_t pending_text_bytes = 0;           // Their text records, which count towards the memory limit
+    std::vector<TermPostings> segment;       // Postings taken from the builder, until they are written
+    auto last_flush = std::chrono::steady_clock::now();
+    // Takes no more documents until the flush succeeds; the queues back up to the Redis pop meanwhile
+    auto flush = [&](bool merge_all) {
+        while (!flush_index(builder, db, segments, merge_all, doc_stats, write_back, segment, pending_updates)) {
+            std::this_thread::sleep_for(std::chrono::seconds(FLUSH_RETRY_SECONDS));
+        }
+        pending_text_bytes = 0;
+        last_flush = std::chrono::steady_clock::now();
+    };
+    try {
+        size_t terms = segments.merge_segments();  // Leftovers from a previous run
+        if (terms > 0) std::cout << "Merged leftover index segments into " << terms << " terms" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "Failed to merge leftover index segments: " << e.what() << std::endl;
+    }
+
+    while (true) {
+        std::optional<ParsedDocument> doc = in.pop_for(std::chrono::seconds(QUEUE_BLOCK_TIMEOUT_SECONDS));
+        if (!doc) {
+            // Idle (or shutting down): make everything indexed so far visible to readers
+            if (!builder.empty() || segments.unmerged_segments() > 0) flush(true);
+            if (in.closed()) return;
+            continue;
+        }
+
+        builder.add_document_terms(static_cast<uint32_t>(doc->update.doc_id), doc->terms);
+        pending_text_bytes += doc->update.text_record.size();
+        pending_updates.push_back(std::move(doc->update));
+
+        if (builder.memory_usage() + pending_text_bytes >= INDEX_MEMORY_LIMIT_BYTES ||
+            std::chrono::steady_clock::now() - last_flush >= std::chrono::seconds(INDEX_FLUSH_INTERVAL_SECONDS)) {
+            flush(false);
+        }
+    }
+}
+
+// --- Stage: Write Back ---
+// Doc Length, Title, and Snippet of each flushed batch, over this worker's own connection.
+void write_back_stage(BoundedQueue<std::vector<DocUpdate>>& in, std::unique_ptr<pqxx::connection> C) {
+    while (std::optional<std::vector<DocUpdate>> updates = in.pop()) {
+        {
+            common::ScopedTimer timer(METRICS.db_write);
+            write_doc_metadata(*C, *updates);
+        }
+        LOG(Info) << "Wrote metadata of " << updates->size() << " docs";
+    }
+}
+
+// --- Offline Rebuild ---
+// Reindexes every document of this shard with a WARC record into a new DB next to ROCKSDB_PATH and swaps the
+// ROCKSDB_PATH symlink over to it; the doc-stats file is rebuilt and renamed over the old one.
+// The queue-driven indexer must be stopped meanwhile: documents it indexed would be lost.
+int rebuild_index() {
+    std::cout << "--- Indexer Rebuild Started (shard " << SHARD.id << " of " << SHARD.count << ") ---" << std::endl;
+    std::unique_ptr<pqxx::connection> C = connect_postgres(POSTGRES_CONNECT_RETRIES);
+    std::vector<std::unique_ptr<pqxx::connection>> write_connections;
+    for (int i = 0; C && i < std::max(1, INDEX_WRITE_THREADS); ++i) {
+        write_connections.push_back(connect_postgres(POSTGRES_CONNECT_RETRIES));
+        if (!write_connections.back()) C.reset();
+    }
+    if (!C) {
+        std::cerr << "Failed to connect to Postgres after retries." << std::endl;
+        return 1;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    std::string stamp = std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    std::string db_path = ROCKSDB_PATH + ".rebuild-" + stamp;
+    std::string doc_stats_path = DOC_STATS_PATH + ".rebuild-" + stamp;
+
+    RebuildOptions options;
+    options.work_dir = REBUILD_WORK_DIR.empty() ? db_path + ".work" : REBUILD_WORK_DIR + "/rebuild-" + stamp;
+    options.threads = static_cast<size_t>(std::max(1, REBUILD_THREADS));
+    options.partitions = static_cast<size_t>(std::max(1, REBUILD_PARTITIONS));
+    options.memory_limit_bytes = REBUILD_MEMORY_LIMIT_BYTES;
+    options.extract_mode = parse_html_extract_mode(HTML_EXTRACT_MODE);
+    options.document_log_lines_per_second = DOCUMENT_LOG_LINES_PER_SECOND;
+    options.table.block_cache_bytes = INDEXER_BLOCK_CACHE_BYTES;
+    options.table.bloom_bits_per_key = ROCKSDB_BLOOM_BITS;
+
+    BoundedQueue<std::vector<DocUpdate>> write_back(WRITE_BACK_QUEUE_CAPACITY);
+    std::vector<std::thread> writers;
+    for (auto& connection : write_connections) {
+        writers.emplace_back(write_back_stage, std::ref(write_back), std::move(connection));
+    }
+    std::mutex updates_mutex;
+    std::vector<DocUpdate> pending_updates;
+    std::vector<std::pair<uint32_t, uint32_t>> lengths;
+    std::unique_ptr<rocksdb::DB> db;  // Gets the doc store while parsing, then the term SST files
+    auto write_batch = [&] {
+        write_doc_store(db.get(), pending_updates);
+        write_back.push(std::move(pending_updates));
+        pending_updates.clear();
+    };
+    auto on_document = [&](DocUpdate update) {
+        std::lock_guard<std::mutex> lock(updates_mutex);
+        lengths.emplace_back(static_cast<uint32_t>(update.doc_id), clamp_length(static_cast<int64_t>(update.doc_length)));
+        pending_updates.push_back(std::move(update));
+        // Blocks every worker while Postgres falls behind, like the pipeline's write-back queue
+        if (pending_updates.size() >= static_cast<size_t>(INDEX_BATCH_SIZE)) write_batch();
+    };
+    auto stop_writers = [&] {
+        if (!pending_updates.empty()) write_back.push(std::move(pending_updates));
+        write_back.close();
+        for (auto& thread : writers) thread.join();
+    };
+
+    try {
+        db = create_index_db(db_path, options.table);
+        std::vector<DocLocation> documents = fetch_all_doc_locations(*C);
+        documents.erase(std::remove_if(documents.begin(), documents.end(),
+                                       [](const DocLocation& location) { return !SHARD.owns(location.doc_id); }),
+                        documents.end());
+        std::cout << "Rebuilding the index of " << documents.size() << " docs into " << db_path << " with "
+                  << options.threads << " threads" << std::endl;
+
+        WarcReader warc_reader(WARC_BASE_PATH);
+        RebuildStats stats;
+        std::vector<std::string> sst_files = build_sst_files(documents, warc_reader, options, on_document, &stats);
+        std::cout << "Built " << sst_files.size() << " SST files with " << stats.terms << " terms from "
+                  << stats.documents << " docs (" << stats.runs << " runs)" << std::endl;
+        if (!pending_updates.empty()) write_batch();
+        ingest_sst_files(*db, sst_files);  // Doc-store keys sort after every term
+        db.reset();
+        std::filesystem::remove_all(options.work_dir);
+
+        // The metadata has to be in Postgres too before anything is published
+        stop_writers();
+        {
+            DocStatsWriter rebuilt_stats(doc_stats_path);
+            rebuilt_stats.set_lengths(lengths);
+        }
+
+        std::string previous = publish_index(ROCKSDB_PATH, db_path);
+        std::unique_ptr<DocStatsWriter> old_stats;
+        if (std::filesystem::exists(DOC_STATS_PATH)) old_stats = std::make_unique<DocStatsWriter>(DOC_STATS_PATH);
+        std::filesystem::rename(doc_stats_path, DOC_STATS_PATH);
+        if (old_stats) old_stats->mark_replaced();  // Readers reopen the path
+
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - started).count();
+        std::cout << "Published " << db_path << " as " << ROCKSDB_PATH << " after " << seconds << "s" << std::endl;
+        if (!previous.empty()) {
+            std::cout << "Previous index left at " << previous << "; remove it once no reader has it open" << std::endl;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Rebuild failed: " << e.what() << std::endl;
+        if (!writers.empty() && !write_back.closed()) stop_writers();
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    common::set_log_level_from_env();
+    if (argc > 1) {
+        if (std::string(argv[1]) == "--rebuild") return rebuild_index();
+        std::cerr << "Usage: " << argv[0] << " [--rebuild]" << std::endl;
+        return 2;
+    }
+
+    std::cout << "--- Indexer Service Started (shard " << SHARD.id << " of " << SHARD.count << ", queue "
+              << SHARD.queue_key() << ") ---" << std::endl;
+
+    // Scraped from its own thread for as long as the service runs
+    std::unique_ptr<common::MetricsServer> metrics_server;
+    if (METRICS_PORT > 0) {
+        try {
+            metrics_server = std::make_unique<common::MetricsServer>(common::metrics(), METRICS_PORT);
+            std::cout << "Serving metrics on port " << metrics_server->port() << std::endl;
+        } catch (const std::exception &e) {
+            std::cerr << "Metrics endpoint disabled: " << e.what() << std::endl;
+        }
+    }
+
+    // 1. Connect to Redis
+    redisContext *redis = redisConnect(REDIS_HOST.c_str(), 6379);
+    if (redis == NULL || redis->err) {
+        std::cerr << "Redis connection failed" << std::endl;
+        return 1;
+    }
+
+    // 2. Connect to Postgres: one connection for fetching, one per write-back worker
+    HtmlExtractMode extract_mode = parse_html_extract_mode(HTML_EXTRACT_MODE);
+    std::unique_ptr<pqxx::connection> C = connect_postgres(POSTGRES_CONNECT_RETRIES);
+    std::vector<std::unique_ptr<pqxx::connection>> write_connections;
+    for (int i = 0; C && i < std::max(1, INDEX_WRITE_THREADS); ++i) {
+        write_connections.push_back(connect_postgres(POSTGRES_CONNECT_RETRIES));
+        if (!write_connections.back()) C.reset();
+    }
+    if (!C) {
         std::cerr << "Failed to connect to Postgres after retries." << std::endl;
         redisFree(redis);
         return 1;
     }
+    std::cout << "Connected to DB" << std::endl;
 
     // 3. Open RocksDB
     rocksdb::DB* db;
     rocksdb::Options options;
     options.create_if_missing = true;
+    options.merge_operator = std::make_shared<PostingAppendOperator>();  // Readers must register it too
+    IndexTableConfig table_config;
+    table_config.block_cache_bytes = INDEXER_BLOCK_CACHE_BYTES;
+    table_config.bloom_bits_per_key = ROCKSDB_BLOOM_BITS;
+    apply_index_table_config(options, table_config);
     rocksdb::Status status = rocksdb::DB::Open(options, ROCKSDB_PATH, &db);
     if (!status.ok()) {
         std::cerr << "RocksDB Open failed: " << status.ToString() << std::endl;
-        delete C;
         redisFree(redis);
         return 1;
     }
 
+    // 4. Segments are mapped once and shared by every reader thread
+    WarcReader warc_reader(WARC_BASE_PATH);
+
+    // 5. Document lengths for the ranker
+    std::unique_ptr<DocStatsWriter> doc_stats;
+    try {
+        doc_stats = std::make_unique<DocStatsWriter>(DOC_STATS_PATH);
+    } catch (const std::exception &e) {
+        std::cerr << "Failed to open doc stats: " << e.what() << std::endl;
+        delete db;
+        redisFree(redis);
+        return 1;
+    }
+    backfill_doc_stats(*doc_stats, *C);
+
+    // 6. Start the stages downstream of the fetch loop. Bounded queues between them apply
+    //    backpressure all the way up to the Redis pop.
+    BoundedQueue<DocLocation> locations(INDEX_QUEUE_CAPACITY);
+    BoundedQueue<RawDocument> raw_documents(INDEX_QUEUE_CAPACITY);
+    BoundedQueue<ParsedDocument> parsed_documents(INDEX_QUEUE_CAPACITY);
+    BoundedQueue<std::vector<DocUpdate>> write_back(WRITE_BACK_QUEUE_CAPACITY);
+    std::vector<std::thread> readers, parsers, writers;
+    for (int i = 0; i < std::max(1, INDEX_READ_THREADS); ++i) {
+        readers.emplace_back(read_stage, std::ref(locations), std::ref(raw_documents), std::ref(warc_reader));
+    }
+    for (int i = 0; i < std::max(1, INDEX_PARSE_THREADS); ++i) {
+        parsers.emplace_back(parse_stage, std::ref(raw_documents), std::ref(parsed_documents), extract_mode);
+    }
+    std::thread indexer(index_stage, std::ref(parsed_documents), std::ref(write_back), db, std::ref(*doc_stats));
+    for (auto& connection : write_connections) {
+        writers.emplace_back(write_back_stage, std::ref(write_back), std::move(connection));
+    }
+    std::cout << "Pipeline: " << readers.size() << " read, " << parsers.size() << " parse, 1 index, "
+              << writers.size() << " write-back threads; tokenizer kernel " << tokenizer_kernel() << std::endl;
+
+    // 7. Fetch metadata for queued documents and feed the pipeline
+    auto last_metrics_sample = std::chrono::steady_clock::time_point();
     while (true) {
-        // A. Pop from Queue
-        redisReply *reply = (redisReply*)redisCommand(redis, "BLPOP indexing_queue 0");
-        if (reply == NULL || reply->type != REDIS_REPLY_ARRAY) {
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_metrics_sample >= std::chrono::seconds(METRICS_SAMPLE_INTERVAL_SECONDS)) {
+            redisReply* reply = (redisReply*)redisCommand(redis, "LLEN %s", SHARD.queue_key().c_str());
+            if (reply && reply->type == REDIS_REPLY_INTEGER) METRICS.queue_length.set(reply->integer);
             if (reply) freeReplyObject(reply);
-            continue; // Should not happen with BLPOP unless timeout/error
+            last_metrics_sample = now;
         }
+        METRICS.read_queued.set(static_cast<int64_t>(locations.size()));
+        METRICS.parse_queued.set(static_cast<int64_t>(raw_documents.size()));
+        METRICS.index_queued.set(static_cast<int64_t>(parsed_documents.size()));
 
-        if (reply->elements < 2 || reply->element[1] == nullptr || reply->element[1]->str == nullptr) {
-            freeReplyObject(reply);
-            continue;
+        // A. Pop a batch from the queue
+        std::vector<int> doc_ids = pop_doc_ids(redis, INDEX_BATCH_SIZE);
+        auto foreign = std::stable_partition(doc_ids.begin(), doc_ids.end(), [](int doc_id) { return SHARD.owns(doc_id); });
+        if (foreign != doc_ids.end()) {
+            std::vector<int> others(foreign, doc_ids.end());
+            doc_ids.erase(foreign, doc_ids.end());
+            size_t failed = requeue_to_owners(redis, others);
+            LOG(Warn) << "Requeued " << (others.size() - failed) << " of " << others.size() << " docs of other shards from "
+                      << SHARD.queue_key() << "; is the crawler's INDEX_SHARD_COUNT " << SHARD.count << "?";
         }
+        if (doc_ids.empty()) continue;  // The index stage flushes on its own once it runs dry
 
-        std::string doc_id_str = reply->element[1]->str;
-        int doc_id;
+        // B. Get Metadata for the whole batch in one query
+        std::vector<DocLocation> batch;
         try {
-            doc_id = std::stoi(doc_id_str);
-        } catch (const std::exception&) {
-            freeReplyObject(reply);
+            batch = fetch_doc_locations(*C, doc_ids);
+        } catch (const std::exception &e) {
+            // The LPOP already took the batch off the queue: put it back, and reconnect in case Postgres restarted
+            size_t failed = requeue_to_owners(redis, doc_ids);
+            std::cerr << "Error fetching metadata for " << doc_ids.size() << " docs (" << (doc_ids.size() - failed)
+                      << " requeued), reconnecting in " << METADATA_RETRY_SECONDS << "s: " << e.what() << std::endl;
+            std::this_thread::sleep_for(std::chrono::seconds(METADATA_RETRY_SECONDS));
+            if (std::unique_ptr<pqxx::connection> reconnected = connect_postgres(POSTGRES_CONNECT_RETRIES)) {
+                C = std::move(reconnected);
+            }
             continue;
         }
-        freeReplyObject(reply);
-        
-        std::cout << "Indexing Doc ID: " << doc_id << std::endl;
-
-        try {
-            // B. Get Metadata
-            pqxx::work W(*C);
-            pqxx::row row = W.exec_params1("SELECT file_path, \"offset\", length FROM documents WHERE id = $1", doc_id);
-            std::string file_path = WARC_BASE_PATH + row[0].as<std::string>();
-            long offset = row[1].as<long>();
-            long length = row[2].as<long>();
-            W.commit();
-
-            // C. Read WARC Record
-            std::ifstream infile(file_path, std::ios::binary);
-            if (!infile) {
-                std::cerr << "Could not open file: " << file_path << std::endl;
-                continue;
-            }
-            infile.seekg(offset);
-            std::vector<char> buffer(length);
-            infile.read(buffer.data(), length);
-            std::streamsize readBytes = infile.gcount();
-            if (readBytes != length) {
-                std::cerr << "Failed to read full record: expected " << length << " bytes, got " << readBytes << std::endl;
-                continue;
-            }
-            std::string compressed_data(buffer.begin(), buffer.end());
-            
-            // D. Decompress & Parse
-            std::string full_warc_record = decompress_gzip(compressed_data);
-            // Skip WARC headers (find first double newline)
-            size_t header_end = full_warc_record.find("\r\n\r\n");
-            if (header_end == std::string::npos) continue;
-            
-            std::string html_content = full_warc_record.substr(header_end + 4);
-            
-            GumboOutput* output = gumbo_parse(html_content.c_str());
-            ExtractedContent content = extract_content(output->root);
-            std::string plain_text = content.text;
-            std::string title = content.title;
-            gumbo_destroy_output(&kGumboDefaultOptions, output);
-
-            // Generate Snippet (first 200 chars)
-            std::string snippet = plain_text.substr(0, 200);
-            // Basic cleanup of snippet (remove newlines)
-            std::replace(snippet.begin(), snippet.end(), '\n', ' ');
-            std::replace(snippet.begin(), snippet.end(), '\r', ' ');
-
-            // E. Tokenize & Index
-            std::vector<std::string> tokens = tokenize(plain_text);
-            std::set<std::string> unique_tokens(tokens.begin(), tokens.end()); // Simple boolean index for now
-
-            for (const auto& token : unique_tokens) {
-                std::string current_list;
-                status = db->Get(rocksdb::ReadOptions(), token, &current_list);
-                
-                std::set<std::string> doc_ids;
-                if (status.ok() && !current_list.empty()) {
-                    std::stringstream ss(current_list);
-                    std::string id;
-                    while (std::getline(ss, id, ',')) {
-                        doc_ids.insert(id);
-                    }
-                }
-                
-                std::string doc_id_str = std::to_string(doc_id);
-                if (doc_ids.find(doc_id_str) == doc_ids.end()) {
-                    doc_ids.insert(doc_id_str);
-                    current_list = "";
-                    for (auto it = doc_ids.begin(); it != doc_ids.end(); ++it) {
-                        if (it != doc_ids.begin()) current_list += ",";
-                        current_list += *it;
-                    }
-                    db->Put(rocksdb::WriteOptions(), token, current_list);
-                }
-            }
-
-            // F. Update Doc Length, Title, and Snippet
-            pqxx::work W2(*C);
-            W2.exec_params("UPDATE documents SET doc_length = $1, title = $2, snippet = $3 WHERE id = $4", 
-                           tokens.size(), title, snippet, doc_id);
-            W2.commit();
-            
-            std::cout << "Indexed " << tokens.size() << " words for Doc " << doc_id << std::endl;
-
-        } catch (const std::exception &e) {
-            std::cerr << "Error indexing doc " << doc_id << ": " << e.what() << std::endl;
+        if (batch.size() < doc_ids.size()) {
+            std::cerr << (doc_ids.size() - batch.size()) << " docs in batch have no WARC record, skipping" << std::endl;
         }
+        LOG(Debug) << "Queued batch of " << batch.size() << " docs";
+
+        // C. Blocks while the pipeline is full
+        for (DocLocation& location : batch) locations.push(std::move(location));
     }
 
+    // Shut down stage by stage so every queued document is finished and flushed
+    locations.close();
+    for (auto& thread : readers) thread.join();
+    raw_documents.close();
+    for (auto& thread : parsers) thread.join();
+    parsed_documents.close();
+    indexer.join();
+    write_back.close();
+    for (auto& thread : writers) thread.join();
+
     delete db;
-    delete C;
     redisFree(redis);
     return 0;
 }
@@ -0,0 +1,182 @@
+#include "posting_list.hpp"
+#include "varint.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+
+namespace indexer {
+
+namespace {
+
+const char* const FORMAT_NAME = "posting list";  // In varint errors
+
+bool is_binary(std::string_view value) {
+    return !value.empty() && static_cast<uint8_t>(value[0]) == POSTING_FORMAT_MARKER;
+}
+
+std::vector<Posting> decode_legacy(std::string_view value) {
+    std::vector<Posting> postings;
+    size_t pos = 0;
+    while (pos < value.size()) {
+        size_t end = value.find(',', pos);
+        if (end == std::string_view::npos) end = value.size();
+
+        uint32_t doc_id = 0;
+        auto [ptr, ec] = std::from_chars(value.data() + pos, value.data() + end, doc_id);
+        if (ec == std::errc() && ptr == value.data() + end) postings.push_back({doc_id, 1});
+        pos = end + 1;
+    }
+
+    auto by_doc = [](const Posting& a, const Posting& b) { return a.doc_id < b.doc_id; };
+    if (!std::is_sorted(postings.begin(), postings.end(), by_doc)) {
+        std::stable_sort(postings.begin(), postings.end(), by_doc);
+    }
+    postings.erase(std::unique(postings.begin(), postings.end(),
+                               [](const Posting& a, const Posting& b) { return a.doc_id == b.doc_id; }),
+                   postings.end());
+    return postings;
+}
+
+} // namespace
+
+PostingListReader::PostingListReader(std::string_view value) : value(value) {
+    if (!is_binary(value)) {
+        legacy = decode_legacy(value);
+        posting_count = legacy.size();
+        uint32_t base = 0;
+        for (size_t start = 0; start < legacy.size(); start += POSTING_BLOCK_SIZE) {
+            size_t end = std::min(start + POSTING_BLOCK_SIZE, legacy.size());
+            uint32_t max_doc_id = legacy[end - 1].doc_id;
+            blocks.push_back({static_cast<uint32_t>(end - start), max_doc_id, 1, base, start, 0});
+            base = max_doc_id;
+        }
+        return;
+    }
+
+    if (value.size() < 2 || static_cast<uint8_t>(value[1]) != POSTING_FORMAT_VERSION) {
+        throw std::runtime_error("Unsupported posting list version");
+    }
+    size_t pos = 2;
+    posting_count = get_varint(value, pos, FORMAT_NAME);
+    uint32_t block_total = get_varint(value, pos, FORMAT_NAME);
+    if (block_total > posting_count) throw std::runtime_error("Malformed posting list header");
+
+    blocks.reserve(block_total);
+    uint32_t base = 0;
+    size_t counted = 0;
+    for (uint32_t i = 0; i < block_total; ++i) {
+        PostingBlockHeader header{};
+        header.count = get_varint(value, pos, FORMAT_NAME);
+        header.max_doc_id = base + get_varint(value, pos, FORMAT_NAME);
+        header.byte_length = get_varint(value, pos, FORMAT_NAME);
+        header.max_tf = get_varint(value, pos, FORMAT_NAME);
+        header.base_doc_id = base;
+        base = header.max_doc_id;
+        counted += header.count;
+        blocks.push_back(header);
+    }
+    if (counted != posting_count) throw std::runtime_error("Posting list block counts do not add up");
+
+    for (auto& header : blocks) {
+        header.offset = pos;
+        pos += header.byte_length;
+    }
+    if (pos != value.size()) throw std::runtime_error("Posting list payload size mismatch");
+}
+
+void PostingListReader::decode_block(size_t i, std::vector<Posting>& out) const {
+    const PostingBlockHeader& header = blocks.at(i);
+    out.clear();
+    out.reserve(header.count);
+    if (!legacy.empty()) {
+        out.assign(legacy.begin() + header.offset, legacy.begin() + header.offset + header.count);
+        return;
+    }
+
+    std::string_view payload = value.substr(header.offset, header.byte_length);
+    size_t pos = 0;
+    uint32_t doc_id = header.base_doc_id;
+    for (uint32_t n = 0; n < header.count; ++n) {
+        doc_id += get_varint(payload, pos, FORMAT_NAME);
+        uint32_t tf = get_varint(payload, pos, FORMAT_NAME);
+        out.push_back({doc_id, tf});
+    }
+    if (pos != payload.size() || doc_id != header.max_doc_id) {
+        throw std::runtime_error("Corrupt posting list block");
+    }
+}
+
+std::string encode_posting_list(const std::vector<Posting>& postings) {
+    std::string directory;
+    std::string payload;
+    payload.reserve(postings.size() * 3);
+
+    uint32_t base = 0;
+    size_t block_total = 0;
+    for (size_t start = 0; start < postings.size(); start += POSTING_BLOCK_SIZE) {
+        size_t end = std::min(start + POSTING_BLOCK_SIZE, postings.size());
+        size_t payload_start = payload.size();
+        uint32_t previous = base;
+        uint32_t max_tf = 0;
+        for (size_t i = start; i < end; ++i) {
+            put_varint(payload, postings[i].doc_id - previous);
+            put_varint(payload, postings[i].tf);
+            previous = postings[i].doc_id;
+            max_tf = std::max(max_tf, postings[i].tf);
+        }
+
+        put_varint(directory, static_cast<uint32_t>(end - start));
+        put_varint(directory, previous - base);
+        put_varint(directory, static_cast<uint32_t>(payload.size() - payload_start));
+        put_varint(directory, max_tf);
+        base = previous;
+        ++block_total;
+    }
+
+    std::string value;
+    value.reserve(2 + 10 + directory.size() + payload.size());
+    value += static_cast<char>(POSTING_FORMAT_MARKER);
+    value += static_cast<char>(POSTING_FORMAT_VERSION);
+    put_varint(value, static_cast<uint32_t>(postings.size()));
+    put_varint(value, static_cast<uint32_t>(block_total));
+    value += directory;
+    value += payload;
+    return value;
+}
+
+std::vector<Posting> decode_posting_list(std::string_view value) {
+    if (!is_binary(value)) return decode_legacy(value);
+
+    PostingListReader reader(value);
+    std::vector<Posting> postings;
+    postings.reserve(reader.size());
+    std::vector<Posting> block;
+    for (size_t i = 0; i < reader.block_count(); ++i) {
+        reader.decode_block(i, block);
+        postings.insert(postings.end(), block.begin(), block.end());
+    }
+    return postings;
+}
+
+std::vector<Posting> merge_posting_lists(const std::vector<Posting>& older, const std::vector<Posting>& newer) {
+    std::vector<Posting> merged;
+    merged.reserve(older.size() + newer.size());
+
+    size_t i = 0, j = 0;
+    while (i < older.size() && j < newer.size()) {
+        if (older[i].doc_id < newer[j].doc_id) {
+            merged.push_back(older[i++]);
+        } else if (newer[j].doc_id < older[i].doc_id) {
+            merged.push_back(newer[j++]);
+        } else {
+            merged.push_back(newer[j++]);  // Re-indexed document
+            ++i;
+        }
+    }
+    merged.insert(merged.end(), older.begin() + i, older.end());
+    merged.insert(merged.end(), newer.begin() + j, newer.end());
+    return merged;
+}
+
+} // namespace indexer
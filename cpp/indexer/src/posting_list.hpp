@@ -0,0 +1,75 @@
+#ifndef INDEXER_POSTING_LIST_HPP
+#define INDEXER_POSTING_LIST_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace indexer {
+
+// One document in a term's posting list.
+struct Posting {
+    uint32_t doc_id;
+    uint32_t tf;  // Occurrences of the term in the document
+};
+
+// Binary posting list format, version 1:
+//
+//   0x00 0x01                       marker (legacy ASCII values never start with 0x00) + version
+//   varint  posting_count
+//   varint  block_count
+//   block_count x header            varint count, varint max_doc_id delta (to the previous block's
+//                                   max_doc_id), varint byte_length, varint max_tf
+//   block_count x payload           count x (varint doc_id delta, varint tf); the first delta of a
+//                                   block is relative to the previous block's max_doc_id (0 for the first)
+//
+// Doc ids are strictly increasing. The header directory sits in front of the payloads so a reader
+// can skip whole blocks by max_doc_id (or bound scores by max_tf) without decoding them.
+const uint8_t POSTING_FORMAT_MARKER = 0x00;
+const uint8_t POSTING_FORMAT_VERSION = 1;
+const size_t POSTING_BLOCK_SIZE = 128;
+
+struct PostingBlockHeader {
+    uint32_t count;
+    uint32_t max_doc_id;
+    uint32_t max_tf;
+    uint32_t base_doc_id;  // max_doc_id of the previous block, 0 for the first
+    size_t offset;         // Start of the payload within the encoded value (first index for legacy values)
+    size_t byte_length;
+};
+
+// Parses the header of an encoded posting list and decodes its blocks on demand.
+// Also accepts the legacy comma-separated ASCII format ("12,57,103", tf = 1), which it decodes eagerly.
+// The value must outlive the reader. Throws std::runtime_error on malformed input.
+class PostingListReader {
+public:
+    explicit PostingListReader(std::string_view value);
+
+    size_t size() const { return posting_count; }
+    size_t block_count() const { return blocks.size(); }
+    const PostingBlockHeader& block(size_t i) const { return blocks[i]; }
+
+    // Replaces `out` with the postings of block `i`.
+    void decode_block(size_t i, std::vector<Posting>& out) const;
+
+private:
+    std::string_view value;
+    size_t posting_count = 0;
+    std::vector<PostingBlockHeader> blocks;
+    std::vector<Posting> legacy;  // Only set for ASCII values, exposed as blocks of POSTING_BLOCK_SIZE
+};
+
+// Serialize postings (sorted by doc_id, no duplicates) in the current binary format.
+std::string encode_posting_list(const std::vector<Posting>& postings);
+
+// Parse an index value in any supported format. The result is sorted numerically by doc_id and
+// free of duplicates, even for ASCII lists written with the old lexicographic ordering.
+std::vector<Posting> decode_posting_list(std::string_view value);
+
+// Union of two sorted posting lists. For a doc_id present in both, `newer` wins.
+std::vector<Posting> merge_posting_lists(const std::vector<Posting>& older, const std::vector<Posting>& newer);
+
+} // namespace indexer
+
+#endif // INDEXER_POSTING_LIST_HPP
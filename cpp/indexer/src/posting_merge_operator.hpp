@@ -0,0 +1,90 @@
+#ifndef INDEXER_POSTING_MERGE_OPERATOR_HPP
+#define INDEXER_POSTING_MERGE_OPERATOR_HPP
+
+#include "posting_list.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+#include <rocksdb/merge_operator.h>
+
+namespace indexer {
+
+// Merge operator for posting lists: every operand is a posting list appended to the term's value.
+//
+// The indexer writes db->Merge(term, postings) instead of Get + Put, so updating a term never
+// reads it, and concurrent indexers cannot lose each other's updates. RocksDB folds operands on
+// reads and during compaction, so readers see the merged list transparently. Both the indexer
+// and every reader (python/ranker/rocksdb_client.cpp) must open the DB with this operator.
+//
+// Merging is a union by doc_id in which later operands win, which is associative, so operands
+// may also be combined among themselves (PartialMergeMulti).
+class PostingAppendOperator : public rocksdb::MergeOperator {
+public:
+    // Returning false reports a corrupt value to RocksDB instead of letting an exception escape
+    bool FullMergeV2(const MergeOperationInput& merge_in, MergeOperationOutput* merge_out) const override {
+        try {
+            full_merge(merge_in, merge_out);
+            return true;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    bool PartialMergeMulti(const rocksdb::Slice& /*key*/, const std::deque<rocksdb::Slice>& operand_list,
+                           std::string* new_value, rocksdb::Logger* /*logger*/) const override {
+        try {
+            std::vector<std::string_view> operands;
+            operands.reserve(operand_list.size());
+            for (const auto& operand : operand_list) operands.emplace_back(operand.data(), operand.size());
+            *new_value = encode_posting_list(fold(operands));
+            return true;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    const char* Name() const override { return "PostingAppendOperator"; }
+
+private:
+    static void full_merge(const MergeOperationInput& merge_in, MergeOperationOutput* merge_out) {
+        std::vector<Posting> base;
+        if (merge_in.existing_value) {
+            base = decode_posting_list(std::string_view(merge_in.existing_value->data(), merge_in.existing_value->size()));
+        }
+        std::vector<std::string_view> operands;
+        operands.reserve(merge_in.operand_list.size());
+        for (const auto& operand : merge_in.operand_list) operands.emplace_back(operand.data(), operand.size());
+
+        merge_out->new_value = encode_posting_list(merge_posting_lists(base, fold(operands)));
+    }
+
+    // Combine operands (oldest first) into one sorted list in a single pass, instead of
+    // re-merging a growing list once per operand.
+    static std::vector<Posting> fold(const std::vector<std::string_view>& operands) {
+        if (operands.size() == 1) return decode_posting_list(operands[0]);
+
+        std::vector<Posting> all;
+        for (std::string_view operand : operands) {
+            std::vector<Posting> postings = decode_posting_list(operand);
+            all.insert(all.end(), postings.begin(), postings.end());
+        }
+        std::stable_sort(all.begin(), all.end(), [](const Posting& a, const Posting& b) { return a.doc_id < b.doc_id; });
+
+        std::vector<Posting> folded;
+        folded.reserve(all.size());
+        for (const Posting& posting : all) {
+            if (!folded.empty() && folded.back().doc_id == posting.doc_id) {
+                folded.back() = posting;  // Newer operand wins
+            } else {
+                folded.push_back(posting);
+            }
+        }
+        return folded;
+    }
+};
+
+} // namespace indexer
+
+#endif // INDEXER_POSTING_MERGE_OPERATOR_HPP
@@ -0,0 +1,316 @@
+#include "rebuild.hpp"
+#include "document_parser.hpp"
+#include "index_builder.hpp"
+#include "posting_list.hpp"
+#include "posting_merge_operator.hpp"
+#include "../../common/log.hpp"
+
+#include <rocksdb/db.h>
+#include <rocksdb/sst_file_writer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+
+namespace indexer {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+const size_t DOCUMENTS_PER_CHUNK = 64;  // Workers claim consecutive documents to keep reads sequential
+const size_t FIRST_BYTE_RANKS = 36;     // Tokens start with [0-9a-z]
+
+// Rank of a term's first byte among [0-9a-z]. Monotone over all bytes, so every partition is a key range.
+size_t first_byte_rank(std::string_view term) {
+    unsigned char c = term.empty() ? 0 : static_cast<unsigned char>(term[0]);
+    if (c < '0') return 0;
+    if (c <= '9') return c - '0';
+    if (c < 'a') return 10;
+    if (c <= 'z') return 10 + (c - 'a');
+    return FIRST_BYTE_RANKS - 1;
+}
+
+size_t partition_of(std::string_view term, size_t partitions) {
+    return first_byte_rank(term) * partitions / FIRST_BYTE_RANKS;
+}
+
+// A run is a file of (term, encoded posting list) records sorted by term:
+//   uint32_t term_length, term bytes, uint32_t value_length, value bytes   (host byte order)
+class RunWriter {
+public:
+    explicit RunWriter(const std::string& path) : path(path), out(path, std::ios::binary | std::ios::trunc) {
+        if (!out) throw std::runtime_error("Failed to create run " + path);
+    }
+
+    void add(std::string_view term, std::string_view value) {
+        write_field(term);
+        write_field(value);
+    }
+
+    void finish() {
+        out.close();
+        if (!out) throw std::runtime_error("Failed to write run " + path);
+    }
+
+private:
+    void write_field(std::string_view field) {
+        uint32_t length = static_cast<uint32_t>(field.size());
+        out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        out.write(field.data(), field.size());
+    }
+
+    std::string path;
+    std::ofstream out;
+};
+
+class RunReader {
+public:
+    explicit RunReader(const std::string& path) : path(path), in(path, std::ios::binary) {
+        if (!in) throw std::runtime_error("Failed to open run " + path);
+    }
+
+    // Advances to the next record; false at the end of the run.
+    bool next() {
+        if (!read_field(term_)) return false;
+        if (!read_field(value_)) throw std::runtime_error("Truncated run " + path);
+        return true;
+    }
+
+    const std::string& term() const { return term_; }
+    const std::string& value() const { return value_; }
+
+private:
+    bool read_field(std::string& field) {
+        uint32_t length;
+        if (!in.read(reinterpret_cast<char*>(&length), sizeof(length))) return false;
+        field.resize(length);
+        return static_cast<bool>(in.read(field.data(), length));
+    }
+
+    std::string path;
+    std::ifstream in;
+    std::string term_;
+    std::string value_;
+};
+
+// Writes the builder's postings as one run per partition they fall into. Returns the runs by partition.
+std::vector<std::pair<size_t, std::string>> spill(IndexBuilder& builder, const std::string& prefix, size_t partitions) {
+    std::vector<TermPostings> segment = builder.take_segment();  // Sorted by term, so partitions are slices
+    std::vector<std::pair<size_t, std::string>> runs;
+    size_t begin = 0;
+    while (begin < segment.size()) {
+        size_t partition = partition_of(segment[begin].first, partitions);
+        std::string path = prefix + "-p" + std::to_string(partition);
+        RunWriter writer(path);
+        size_t end = begin;
+        for (; end < segment.size() && partition_of(segment[end].first, partitions) == partition; ++end) {
+            writer.add(segment[end].first, encode_posting_list(segment[end].second));
+        }
+        writer.finish();
+        runs.emplace_back(partition, path);
+        begin = end;
+    }
+    return runs;
+}
+
+// K-way merge of one partition's runs into an SST file; nothing is written if the runs are empty.
+// Returns the number of terms written.
+size_t merge_runs(const std::vector<std::string>& runs, const std::string& sst_path, const rocksdb::Options& options) {
+    std::vector<std::unique_ptr<RunReader>> readers;
+    // (term, reader) with the smallest term on top; the view stays valid until that reader advances
+    using Head = std::pair<std::string_view, size_t>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+    for (const std::string& run : runs) {
+        readers.push_back(std::make_unique<RunReader>(run));
+        if (readers.back()->next()) heads.emplace(readers.back()->term(), readers.size() - 1);
+    }
+    if (heads.empty()) return 0;
+
+    rocksdb::SstFileWriter writer(rocksdb::EnvOptions(), options);
+    rocksdb::Status status = writer.Open(sst_path);
+    if (!status.ok()) throw std::runtime_error("Failed to create " + sst_path + ": " + status.ToString());
+
+    size_t terms = 0;
+    std::vector<Posting> postings;
+    while (!heads.empty()) {
+        std::string term(heads.top().first);
+        postings.clear();
+        while (!heads.empty() && heads.top().first == term) {
+            size_t reader = heads.top().second;
+            heads.pop();
+            std::vector<Posting> run_postings = decode_posting_list(readers[reader]->value());
+            postings.insert(postings.end(), run_postings.begin(), run_postings.end());
+            if (readers[reader]->next()) heads.emplace(readers[reader]->term(), reader);
+        }
+        // Every document is in exactly one run, but runs of different workers interleave by doc_id
+        std::sort(postings.begin(), postings.end(), [](const Posting& a, const Posting& b) { return a.doc_id < b.doc_id; });
+        status = writer.Put(term, encode_posting_list(postings));
+        if (!status.ok()) throw std::runtime_error("Failed to write " + sst_path + ": " + status.ToString());
+        ++terms;
+    }
+    status = writer.Finish();
+    if (!status.ok()) throw std::runtime_error("Failed to finish " + sst_path + ": " + status.ToString());
+    return terms;
+}
+
+// Runs fn(worker) on `threads` threads and rethrows the first exception any of them threw.
+void run_workers(size_t threads, const std::function<void(size_t)>& fn) {
+    std::mutex mutex;
+    std::exception_ptr failure;
+    std::vector<std::thread> workers;
+    for (size_t worker = 0; worker < threads; ++worker) {
+        workers.emplace_back([&, worker] {
+            try {
+                fn(worker);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!failure) failure = std::current_exception();
+            }
+        });
+    }
+    for (auto& thread : workers) thread.join();
+    if (failure) std::rethrow_exception(failure);
+}
+
+} // namespace
+
+std::vector<std::string> build_sst_files(const std::vector<DocLocation>& documents, WarcReader& warc_reader,
+                                         const RebuildOptions& options,
+                                         const std::function<void(DocUpdate)>& on_document,
+                                         RebuildStats* stats) {
+    size_t threads = std::max<size_t>(1, options.threads);
+    size_t partitions = std::clamp<size_t>(options.partitions, 1, FIRST_BYTE_RANKS);
+    size_t worker_memory_limit = std::max<size_t>(1, options.memory_limit_bytes / threads);
+    fs::create_directories(options.work_dir);
+
+    // 1. Parse every document and spill sorted runs
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<size_t> indexed{0};
+    std::atomic<bool> failed{false};
+    std::mutex runs_mutex;
+    std::vector<std::vector<std::string>> runs(partitions);
+    run_workers(threads, [&](size_t worker) {
+        GzipDecompressor decompressor;
+        HtmlTextExtractor extractor(options.extract_mode);
+        Tokenizer tokenizer;
+        TermCounts counts;
+        TextRecordWriter text_writer;
+        IndexBuilder builder;
+        size_t spills = 0;
+        auto spill_builder = [&] {
+            std::string prefix = options.work_dir + "/run-" + std::to_string(worker) + "-" + std::to_string(spills++);
+            auto spilled = spill(builder, prefix, partitions);
+            std::lock_guard<std::mutex> lock(runs_mutex);
+            for (auto& [partition, path] : spilled) runs[partition].push_back(std::move(path));
+        };
+        try {
+            for (size_t chunk = next_chunk++; chunk * DOCUMENTS_PER_CHUNK < documents.size() && !failed; chunk = next_chunk++) {
+                size_t end = std::min(documents.size(), (chunk + 1) * DOCUMENTS_PER_CHUNK);
+                for (size_t i = chunk * DOCUMENTS_PER_CHUNK; i < end; ++i) {
+                    const DocLocation& location = documents[i];
+                    try {
+                        RawDocument raw = read_document(location, warc_reader, decompressor);
+                        std::optional<DocUpdate> update = parse_document(raw, extractor, tokenizer, counts, text_writer);
+                        if (!update) continue;
+                        builder.add_document(static_cast<uint32_t>(location.doc_id), counts);
+                        on_document(std::move(*update));
+                        ++indexed;
+                    } catch (const std::exception &e) {
+                        LOG_RATE_LIMITED(Warn, options.document_log_lines_per_second)
+                            << "Error indexing doc " << location.doc_id << ": " << e.what();
+                    }
+                }
+                if (builder.memory_usage() >= worker_memory_limit) spill_builder();
+            }
+            if (!builder.empty()) spill_builder();
+        } catch (...) {
+            failed = true;  // Stop the other workers early; the exception is rethrown after they joined
+            throw;
+        }
+    });
+
+    // 2. Merge each partition's runs into one SST file
+    rocksdb::Options sst_options;
+    apply_index_table_config(sst_options, options.table);
+    std::vector<std::string> sst_files(partitions);
+    std::atomic<size_t> next_partition{0};
+    std::atomic<size_t> terms{0};
+    run_workers(std::min(threads, partitions), [&](size_t) {
+        for (size_t partition = next_partition++; partition < partitions; partition = next_partition++) {
+            std::string path = options.work_dir + "/partition-" + std::to_string(partition) + ".sst";
+            size_t written = merge_runs(runs[partition], path, sst_options);
+            if (written > 0) sst_files[partition] = path;
+            terms += written;
+            for (const std::string& run : runs[partition]) fs::remove(run);
+        }
+    });
+
+    if (stats) {
+        stats->documents = indexed;
+        stats->terms = terms;
+        stats->runs = 0;
+        for (const auto& partition_runs : runs) stats->runs += partition_runs.size();
+    }
+    sst_files.erase(std::remove(sst_files.begin(), sst_files.end(), std::string()), sst_files.end());
+    return sst_files;
+}
+
+std::unique_ptr<rocksdb::DB> create_index_db(const std::string& db_path, const IndexTableConfig& table) {
+    if (fs::exists(db_path)) throw std::runtime_error("Refusing to ingest into existing path " + db_path);
+
+    rocksdb::Options options;
+    options.create_if_missing = true;
+    options.merge_operator = std::make_shared<PostingAppendOperator>();  // The indexer appends to it later
+    apply_index_table_config(options, table);
+    rocksdb::DB* raw = nullptr;
+    rocksdb::Status status = rocksdb::DB::Open(options, db_path, &raw);
+    if (!status.ok()) throw std::runtime_error("Failed to create RocksDB at " + db_path + ": " + status.ToString());
+    return std::unique_ptr<rocksdb::DB>(raw);
+}
+
+void ingest_sst_files(rocksdb::DB& db, const std::vector<std::string>& sst_files) {
+    if (sst_files.empty()) return;
+    rocksdb::IngestExternalFileOptions ingest;
+    ingest.move_files = true;  // Hard-linked when on the same filesystem: no copy
+    rocksdb::Status status = db.IngestExternalFile(sst_files, ingest);
+    if (!status.ok()) throw std::runtime_error("Failed to ingest SST files into " + db.GetName() + ": " + status.ToString());
+}
+
+void ingest_into_new_db(const std::vector<std::string>& sst_files, const std::string& db_path,
+                        const IndexTableConfig& table) {
+    std::unique_ptr<rocksdb::DB> db = create_index_db(db_path, table);
+    ingest_sst_files(*db, sst_files);
+}
+
+std::string publish_index(const std::string& link_path, const std::string& target) {
+    fs::path link(link_path);
+    std::string previous;
+    fs::file_status current = fs::symlink_status(link);
+    if (fs::is_symlink(current)) {
+        previous = (link.parent_path() / fs::read_symlink(link)).lexically_normal().string();
+    } else if (fs::exists(current)) {
+        previous = link_path + ".pre-rebuild";
+        for (int i = 1; fs::exists(fs::symlink_status(previous)); ++i) previous = link_path + ".pre-rebuild-" + std::to_string(i);
+        fs::rename(link, previous);
+    }
+
+    // A sibling is linked by name, so the link survives the volume being mounted elsewhere
+    fs::path target_path(target);
+    fs::path link_target = target_path.parent_path() == link.parent_path() ? target_path.filename() : fs::absolute(target_path);
+    fs::path temp = link_path + ".swap";
+    fs::remove(temp);
+    fs::create_symlink(link_target, temp);
+    fs::rename(temp, link);  // rename(2) replaces the old link atomically
+    return previous;
+}
+
+} // namespace indexer
@@ -0,0 +1,70 @@
+#ifndef INDEXER_REBUILD_HPP
+#define INDEXER_REBUILD_HPP
+
+#include "document_batch.hpp"
+#include "html_text.hpp"
+#include "index_options.hpp"
+#include "warc_reader.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <rocksdb/db.h>
+
+namespace indexer {
+
+struct RebuildOptions {
+    std::string work_dir;                 // Scratch space for spilled runs and SST files; created if missing
+    size_t threads = 1;                   // Parse workers, then merge workers
+    size_t partitions = 16;               // Term ranges, each merged into one SST file (at most 36 are used)
+    size_t memory_limit_bytes = 1 << 30;  // Buffered postings across all workers before they spill to runs
+    HtmlExtractMode extract_mode = HtmlExtractMode::Dom;
+    IndexTableConfig table;               // Must match the DB the files are ingested into
+    uint32_t document_log_lines_per_second = 10;  // Rate limit of the per-document error lines
+};
+
+struct RebuildStats {
+    size_t documents = 0;  // Documents indexed
+    size_t runs = 0;       // Sorted runs spilled
+    size_t terms = 0;      // Keys in the SST files
+};
+
+// Builds the whole index as SST files without writing through a DB (offline reindex).
+//
+// `documents` are read and parsed on `threads` workers, in order (a sorted list is read sequentially).
+// Each worker buffers postings in an IndexBuilder and spills them as sorted runs, one per term range,
+// whenever its share of the memory limit is used up. Each range's runs are then merged into one SST
+// file. Ranges do not overlap, so the files can be ingested straight into the bottommost level.
+//
+// `on_document` is called concurrently from the workers with the metadata of every indexed document.
+// A document that fails to read or parse is skipped. Returns the SST files in key order.
+// Throws std::runtime_error if the runs or SST files cannot be written.
+std::vector<std::string> build_sst_files(const std::vector<DocLocation>& documents, WarcReader& warc_reader,
+                                         const RebuildOptions& options,
+                                         const std::function<void(DocUpdate)>& on_document,
+                                         RebuildStats* stats = nullptr);
+
+// Creates a new, empty index DB at `db_path`, which must not exist yet. Throws std::runtime_error on failure.
+std::unique_ptr<rocksdb::DB> create_index_db(const std::string& db_path, const IndexTableConfig& table);
+
+// Moves `sst_files` into `db`. Keys written to it meanwhile (e.g. the doc store) must not fall in the
+// files' term ranges. Throws std::runtime_error on failure.
+void ingest_sst_files(rocksdb::DB& db, const std::vector<std::string>& sst_files);
+
+// Creates a new index DB at `db_path`, which must not exist yet, and moves `sst_files` into it.
+// Throws std::runtime_error on failure.
+void ingest_into_new_db(const std::vector<std::string>& sst_files, const std::string& db_path,
+                        const IndexTableConfig& table);
+
+// Points `link_path` at `target` by atomically renaming a new symlink over it, so readers that
+// follow the path (see the ranker's LiveIndex) switch over in one step. A plain directory at
+// `link_path` (an index that was never rebuilt) is first moved aside; only that first swap leaves
+// a moment without an index. Returns where `link_path` pointed before, or an empty string.
+// Throws std::filesystem::filesystem_error on failure.
+std::string publish_index(const std::string& link_path, const std::string& target);
+
+} // namespace indexer
+
+#endif // INDEXER_REBUILD_HPP
@@ -0,0 +1,116 @@
+#include "segment_store.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <rocksdb/write_batch.h>
+
+namespace indexer {
+
+namespace {
+
+// Merged terms are committed in batches of roughly this size
+const size_t MERGE_BATCH_BYTES = 4 * 1024 * 1024;
+
+std::string encode_be64(uint64_t value) {
+    std::string out(8, '\0');
+    for (int i = 7; i >= 0; --i) {
+        out[i] = static_cast<char>(value & 0xFF);
+        value >>= 8;
+    }
+    return out;
+}
+
+uint64_t decode_be64(const std::string& in) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < 8 && i < in.size(); ++i) {
+        value = (value << 8) | static_cast<unsigned char>(in[i]);
+    }
+    return value;
+}
+
+void check(const rocksdb::Status& status, const std::string& what) {
+    if (!status.ok()) throw std::runtime_error(what + ": " + status.ToString());
+}
+
+} // namespace
+
+SegmentStore::SegmentStore(rocksdb::DB* db) : db(db) {
+    std::string value;
+    rocksdb::Status status = db->Get(rocksdb::ReadOptions(), NEXT_SEGMENT_KEY, &value);
+    if (status.ok()) {
+        next_segment = decode_be64(value);
+    } else if (!status.IsNotFound()) {
+        check(status, "Failed to read segment counter");
+    }
+}
+
+void SegmentStore::write_segment(const std::vector<TermPostings>& segment) {
+    if (segment.empty()) return;
+
+    std::string suffix = "/" + encode_be64(next_segment);
+    rocksdb::WriteBatch batch;
+    for (const auto& [term, postings] : segment) {
+        batch.Put(SEGMENT_KEY_PREFIX + term + suffix, encode_posting_list(postings));
+    }
+    batch.Put(NEXT_SEGMENT_KEY, encode_be64(next_segment + 1));
+    check(db->Write(rocksdb::WriteOptions(), &batch), "Failed to write index segment");
+
+    ++next_segment;
+    ++unmerged;
+}
+
+size_t SegmentStore::merge_segments() {
+    // Segment keys sort by term, then by segment number, so each term's segments arrive oldest first
+    std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(rocksdb::ReadOptions()));
+    rocksdb::WriteBatch batch;
+    size_t merged_terms = 0;
+
+    std::string term;
+    std::vector<Posting> postings;
+    auto finish_term = [&]() {
+        if (term.empty()) return;
+        batch.Put(term, encode_posting_list(postings));
+        ++merged_terms;
+        if (batch.GetDataSize() >= MERGE_BATCH_BYTES) {
+            // Only whole terms are committed: a term's segment deletes always travel with its new list
+            check(db->Write(rocksdb::WriteOptions(), &batch), "Failed to write merged postings");
+            batch.Clear();
+        }
+    };
+
+    const size_t suffix_size = 1 + 8;  // "/" + segment number
+    for (it->Seek(SEGMENT_KEY_PREFIX); it->Valid() && it->key().starts_with(SEGMENT_KEY_PREFIX); it->Next()) {
+        std::string key = it->key().ToString();
+        if (key.size() <= SEGMENT_KEY_PREFIX.size() + suffix_size) continue;
+        std::string key_term = key.substr(SEGMENT_KEY_PREFIX.size(), key.size() - SEGMENT_KEY_PREFIX.size() - suffix_size);
+
+        if (key_term != term) {
+            finish_term();
+            term = key_term;
+            std::string current;
+            rocksdb::Status status = db->Get(rocksdb::ReadOptions(), term, &current);
+            if (!status.ok() && !status.IsNotFound()) check(status, "Failed to read postings for " + term);
+            postings = status.ok() ? decode_posting_list(current) : std::vector<Posting>();
+        }
+        postings = merge_posting_lists(postings, decode_posting_list(it->value().ToString()));
+        batch.Delete(key);
+    }
+    check(it->status(), "Failed to scan index segments");
+    finish_term();
+    if (batch.Count() > 0) check(db->Write(rocksdb::WriteOptions(), &batch), "Failed to write merged postings");
+
+    unmerged = 0;
+    return merged_terms;
+}
+
+void append_postings(rocksdb::DB* db, const std::vector<TermPostings>& segment) {
+    if (segment.empty()) return;
+
+    rocksdb::WriteBatch batch;
+    for (const auto& [term, postings] : segment) {
+        batch.Merge(term, encode_posting_list(postings));
+    }
+    check(db->Write(rocksdb::WriteOptions(), &batch), "Failed to append postings");
+}
+
+} // namespace indexer
@@ -0,0 +1,53 @@
+#ifndef INDEXER_SEGMENT_STORE_HPP
+#define INDEXER_SEGMENT_STORE_HPP
+
+#include "index_builder.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <rocksdb/db.h>
+
+namespace indexer {
+
+// Keys below '~' never collide with terms, which are lowercase alphanumeric.
+// "~seg/<term>/<8-byte big-endian segment number>" holds one flushed segment's postings for a term.
+const std::string SEGMENT_KEY_PREFIX = "~seg/";
+const std::string NEXT_SEGMENT_KEY = "~meta/next_segment";
+
+// Persists IndexBuilder segments and folds them into the term keys readers look up.
+//
+// A flushed segment is immutable and written in one atomic batch. merge_segments() later
+// combines every segment of a term with its current posting list, oldest first, so the cost
+// of updating a popular term is paid once per merge instead of once per document.
+// Readers only look at the term keys and see a segment once it has been merged.
+// Not thread-safe.
+class SegmentStore {
+public:
+    explicit SegmentStore(rocksdb::DB* db);
+
+    // Write `segment` under the next segment number. Throws std::runtime_error on failure.
+    void write_segment(const std::vector<TermPostings>& segment);
+
+    // Merge all flushed segments, including ones left by a previous run, into the term keys.
+    // Returns the number of terms updated. Throws std::runtime_error on failure.
+    size_t merge_segments();
+
+    // Segments written by this instance since the last merge.
+    size_t unmerged_segments() const { return unmerged; }
+
+private:
+    rocksdb::DB* db;
+    uint64_t next_segment = 0;
+    size_t unmerged = 0;
+};
+
+// Lighter alternative to SegmentStore for a DB opened with PostingAppendOperator: writes each
+// term's postings as one merge operand, all in one atomic batch. The postings are visible to
+// readers immediately and RocksDB folds them into the term's list during compaction.
+// Throws std::runtime_error on failure.
+void append_postings(rocksdb::DB* db, const std::vector<TermPostings>& segment);
+
+} // namespace indexer
+
+#endif // INDEXER_SEGMENT_STORE_HPP
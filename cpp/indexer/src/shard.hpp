@@ -0,0 +1,38 @@
+#ifndef INDEXER_SHARD_HPP
+#define INDEXER_SHARD_HPP
+
+#include <stdexcept>
+#include <string>
+
+namespace indexer {
+
+// Which document-partitioned index shard this indexer builds: documents with doc_id % count == id.
+// Every shard has its own queue, RocksDB and doc-stats file, and is served by its own ranker.
+struct ShardConfig {
+    int id = 0;
+    int count = 1;
+
+    bool owns(int doc_id) const { return ((doc_id % count) + count) % count == id; }
+
+    // The shard of the same partitioning that indexes `doc_id`.
+    ShardConfig owner(int doc_id) const { return {((doc_id % count) + count) % count, count}; }
+
+    // Redis list the crawler pushes this shard's documents to; unsharded, the original one.
+    // The crawler builds the same names.
+    std::string queue_key() const {
+        return count == 1 ? "indexing_queue" : "indexing_queue:" + std::to_string(id);
+    }
+};
+
+// Throws std::invalid_argument unless count >= 1 and 0 <= id < count.
+inline ShardConfig parse_shard_config(const std::string& id, const std::string& count) {
+    ShardConfig shard{std::stoi(id), std::stoi(count)};
+    if (shard.count < 1 || shard.id < 0 || shard.id >= shard.count) {
+        throw std::invalid_argument("Invalid index shard " + id + " of " + count);
+    }
+    return shard;
+}
+
+} // namespace indexer
+
+#endif // INDEXER_SHARD_HPP
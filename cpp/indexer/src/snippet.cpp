@@ -0,0 +1,219 @@
+#include "snippet.hpp"
+#include "varint.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace indexer {
+
+namespace {
+
+const char* const FORMAT_NAME = "text record";  // In varint errors
+
+std::string_view get_bytes(std::string_view in, size_t& pos) {
+    uint32_t length = get_varint(in, pos, FORMAT_NAME);
+    if (in.size() - pos < length) throw std::runtime_error("Truncated text record");
+    std::string_view bytes = in.substr(pos, length);
+    pos += length;
+    return bytes;
+}
+
+inline bool is_continuation(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+inline bool is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+const int RAW_DEFLATE_WINDOW_BITS = -15;  // Raw deflate: no zlib or gzip header and trailer
+const int TEXT_COMPRESSION_LEVEL = 6;
+
+} // namespace
+
+std::string text_key(uint32_t doc_id) {
+    std::string key = TEXT_KEY_PREFIX;
+    for (int shift = 24; shift >= 0; shift -= 8) key += static_cast<char>((doc_id >> shift) & 0xFF);
+    return key;
+}
+
+std::string_view utf8_prefix(std::string_view text, size_t max_bytes) {
+    if (text.size() <= max_bytes) return text;
+    size_t end = max_bytes;
+    // A sequence is at most 4 bytes: back up over at most 3 continuation bytes to its lead byte
+    for (int i = 0; i < 3 && end > 0 && is_continuation(text[end]); ++i) --end;
+    return text.substr(0, end);
+}
+
+TextRecordWriter::TextRecordWriter() {
+    stream = {};
+    if (deflateInit2(&stream, TEXT_COMPRESSION_LEVEL, Z_DEFLATED, RAW_DEFLATE_WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("deflateInit2 failed");
+    }
+}
+
+TextRecordWriter::~TextRecordWriter() {
+    deflateEnd(&stream);
+}
+
+std::string TextRecordWriter::encode(std::string_view text, const std::vector<std::string_view>& tokens,
+                                     const Tokenizer& tokenizer) {
+    std::string_view stored = utf8_prefix(text, MAX_STORED_TEXT_BYTES);
+
+    std::string record;
+    record += static_cast<char>(TEXT_FORMAT_VERSION);
+    put_varint(record, static_cast<uint32_t>(stored.size()));
+
+    deflateReset(&stream);
+    std::string compressed(deflateBound(&stream, static_cast<uLong>(stored.size())), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(stored.data()));
+    stream.avail_in = static_cast<uInt>(stored.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+    stream.avail_out = static_cast<uInt>(compressed.size());
+    if (deflate(&stream, Z_FINISH) != Z_STREAM_END) throw std::runtime_error("deflate failed");
+    compressed.resize(compressed.size() - stream.avail_out);
+    put_varint(record, static_cast<uint32_t>(compressed.size()));
+    record += compressed;
+
+    // Group the occurrences by term; the stable sort keeps each term's offsets ascending
+    occurrences.clear();
+    for (std::string_view token : tokens) {
+        size_t offset = tokenizer.offset(token);
+        if (offset + token.size() > stored.size()) break;
+        occurrences.emplace_back(token, static_cast<uint32_t>(offset));
+    }
+    std::stable_sort(occurrences.begin(), occurrences.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    size_t term_count = 0;
+    for (size_t i = 0; i < occurrences.size(); ++i) {
+        if (i == 0 || occurrences[i].first != occurrences[i - 1].first) ++term_count;
+    }
+    put_varint(record, static_cast<uint32_t>(term_count));
+    for (size_t i = 0; i < occurrences.size();) {
+        size_t end = i;
+        while (end < occurrences.size() && occurrences[end].first == occurrences[i].first) ++end;
+        std::string_view term = occurrences[i].first;
+        size_t kept = std::min(end - i, MAX_POSITIONS_PER_TERM);
+        put_varint(record, static_cast<uint32_t>(term.size()));
+        record.append(term.data(), term.size());
+        put_varint(record, static_cast<uint32_t>(kept));
+        uint32_t previous = 0;
+        for (size_t k = i; k < i + kept; ++k) {
+            put_varint(record, occurrences[k].second - previous);
+            previous = occurrences[k].second;
+        }
+        i = end;
+    }
+    return record;
+}
+
+SnippetGenerator::SnippetGenerator() {
+    stream = {};
+    if (inflateInit2(&stream, RAW_DEFLATE_WINDOW_BITS) != Z_OK) throw std::runtime_error("inflateInit2 failed");
+}
+
+SnippetGenerator::~SnippetGenerator() {
+    inflateEnd(&stream);
+}
+
+void SnippetGenerator::inflate_prefix(std::string_view compressed, size_t length) {
+    inflateReset(&stream);
+    text.resize(length);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+    stream.avail_in = static_cast<uInt>(compressed.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&text[0]);
+    stream.avail_out = static_cast<uInt>(length);
+    while (stream.avail_out > 0) {
+        int status = inflate(&stream, Z_NO_FLUSH);
+        if (status == Z_STREAM_END) break;
+        if (status != Z_OK) throw std::runtime_error("Corrupt text in text record");
+    }
+    if (stream.avail_out > 0) throw std::runtime_error("Truncated text in text record");
+}
+
+std::string SnippetGenerator::generate(std::string_view record, const std::vector<std::string>& terms,
+                                       size_t max_bytes) {
+    if (record.empty() || static_cast<uint8_t>(record[0]) != TEXT_FORMAT_VERSION) {
+        throw std::runtime_error("Unknown text record format");
+    }
+    size_t pos = 1;
+    size_t text_length = get_varint(record, pos, FORMAT_NAME);
+    std::string_view compressed = get_bytes(record, pos);
+
+    // Occurrences of the query terms, from the forward index
+    hits.clear();
+    uint32_t term_count = get_varint(record, pos, FORMAT_NAME);
+    for (uint32_t t = 0; t < term_count; ++t) {
+        std::string_view term = get_bytes(record, pos);
+        uint32_t positions = get_varint(record, pos, FORMAT_NAME);
+        auto query_term = std::find(terms.begin(), terms.end(), term);
+        uint32_t offset = 0;
+        for (uint32_t p = 0; p < positions; ++p) {
+            offset += get_varint(record, pos, FORMAT_NAME);
+            if (offset + term.size() > text_length) throw std::runtime_error("Term position past the stored text");
+            if (query_term != terms.end()) hits.emplace_back(offset, static_cast<uint32_t>(query_term - terms.begin()));
+        }
+    }
+    std::sort(hits.begin(), hits.end());
+
+    // Densest window: the most distinct terms, then the most occurrences, within max_bytes
+    size_t window_start = 0, window_end = 0;
+    if (!hits.empty()) {
+        std::vector<uint32_t> in_window(terms.size(), 0);
+        size_t distinct = 0, best_distinct = 0, best_count = 0;
+        size_t left = 0;
+        for (size_t right = 0; right < hits.size(); ++right) {
+            size_t end = hits[right].first + terms[hits[right].second].size();
+            if (in_window[hits[right].second]++ == 0) ++distinct;
+            while (end - hits[left].first > max_bytes && left < right) {
+                if (--in_window[hits[left].second] == 0) --distinct;
+                ++left;
+            }
+            size_t count = right - left + 1;
+            if (distinct > best_distinct || (distinct == best_distinct && count > best_count)) {
+                best_distinct = distinct;
+                best_count = count;
+                window_start = hits[left].first;
+                window_end = std::min(end, window_start + max_bytes);
+            }
+        }
+    }
+
+    // Context around the window, a third of it before
+    size_t slack = max_bytes - (window_end - window_start);
+    size_t start = window_start - std::min<size_t>(window_start, slack / 3);
+    size_t end = std::min(text_length, start + max_bytes);
+    if (end - start < max_bytes) start = end > max_bytes ? end - max_bytes : 0;
+
+    // The byte after `end` tells whether it splits a character or a word
+    inflate_prefix(compressed, std::min(text_length, end + 1));
+
+    if (start > 0 && !is_space(text[start - 1])) {
+        size_t space = start;
+        while (space < window_start && !is_space(text[space])) ++space;
+        if (space < window_start) {
+            start = space + 1;
+        } else {
+            while (start < window_start && is_continuation(text[start])) ++start;
+        }
+    }
+    if (end < text_length) {
+        size_t space = end;
+        while (space > window_end && !is_space(text[space])) --space;
+        if (space > window_end) {
+            end = space;
+        } else {
+            while (end > window_end && is_continuation(text[end])) --end;
+        }
+    }
+
+    std::string snippet;
+    snippet.reserve(end - start + 8);
+    if (start > 0) snippet += "... ";
+    for (size_t i = start; i < end; ++i) snippet += is_space(text[i]) ? ' ' : text[i];
+    if (end < text_length) snippet += " ...";
+    return snippet;
+}
+
+} // namespace indexer
@@ -0,0 +1,85 @@
+#ifndef INDEXER_SNIPPET_HPP
+#define INDEXER_SNIPPET_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <zlib.h>
+
+#include "tokenizer.hpp"
+
+namespace indexer {
+
+// "~text/<4-byte big-endian doc_id>" holds a document's extracted text for query-time snippets,
+// next to its doc-store entry (doc_store.hpp) and written with it.
+const std::string TEXT_KEY_PREFIX = "~text/";
+
+std::string text_key(uint32_t doc_id);
+
+const size_t MAX_STORED_TEXT_BYTES = 32 * 1024;  // Snippets only come from the start of longer documents
+const size_t MAX_POSITIONS_PER_TERM = 32;        // Occurrences of a term kept for snippets, earliest first
+
+// Value layout:
+//   byte    TEXT_FORMAT_VERSION
+//   varint  text_length                  Stored prefix of the text, cut at a character boundary
+//   varint  compressed_length, bytes     Raw deflate of that prefix
+//   varint  term_count
+//   term_count x (varint term_length, term bytes, varint position_count,
+//                 position_count x varint byte offset delta)   Terms sorted bytewise
+// The term table is the document's forward index: snippets find the query terms in it instead of
+// re-tokenizing, and only inflate the text up to the end of the chosen window.
+const uint8_t TEXT_FORMAT_VERSION = 1;
+
+// The longest prefix of `text` of at most `max_bytes` that does not split a UTF-8 sequence.
+std::string_view utf8_prefix(std::string_view text, size_t max_bytes);
+
+// Builds text records with one long-lived deflate state. Not thread-safe: keep one per thread.
+class TextRecordWriter {
+public:
+    TextRecordWriter();
+    ~TextRecordWriter();
+
+    TextRecordWriter(const TextRecordWriter&) = delete;
+    TextRecordWriter& operator=(const TextRecordWriter&) = delete;
+
+    // Record of `text`, given `tokens` just returned by `tokenizer.tokenize(text)`.
+    // Throws std::runtime_error if compression fails.
+    std::string encode(std::string_view text, const std::vector<std::string_view>& tokens, const Tokenizer& tokenizer);
+
+private:
+    z_stream stream;
+    std::vector<std::pair<std::string_view, uint32_t>> occurrences;  // (term, offset); reused between documents
+};
+
+// Picks snippets out of text records. A snippet is the window of at most `max_bytes` that holds the most
+// distinct query terms (then the most occurrences, then the earliest), cut at word boundaries; without
+// any query term in the stored text, its start. Work per snippet is bounded by the position caps, the
+// query length, and inflating at most MAX_STORED_TEXT_BYTES. Not thread-safe: keep one per thread.
+class SnippetGenerator {
+public:
+    SnippetGenerator();
+    ~SnippetGenerator();
+
+    SnippetGenerator(const SnippetGenerator&) = delete;
+    SnippetGenerator& operator=(const SnippetGenerator&) = delete;
+
+    // Valid UTF-8 if the stored text was, with "..." where it was cut. `terms` are tokenized query terms.
+    // Throws std::runtime_error on a malformed record.
+    std::string generate(std::string_view record, const std::vector<std::string>& terms, size_t max_bytes);
+
+private:
+    // Inflates the first `length` bytes of the stored text into `text`.
+    void inflate_prefix(std::string_view compressed, size_t length);
+
+    z_stream stream;
+    std::string text;
+    std::vector<std::pair<uint32_t, uint32_t>> hits;  // (offset, query term index), by offset
+};
+
+} // namespace indexer
+
+#endif // INDEXER_SNIPPET_HPP
@@ -0,0 +1,198 @@
+#include "tokenizer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace indexer {
+
+namespace {
+
+// Each kernel lowercases 64 bytes of `in` into `out` (separators become 0) and returns the
+// alphanumeric bits. ASCII letters differ from their lowercase only in bit 0x20, which digits
+// already have set, so `c | 0x20` lowercases every byte we keep.
+
+uint64_t classify_scalar(const char* in, char* out) {
+    uint64_t mask = 0;
+    for (int i = 0; i < 64; ++i) {
+        unsigned char c = static_cast<unsigned char>(in[i]);
+        unsigned char lower = c | 0x20;
+        bool keep = static_cast<unsigned char>(lower - 'a') < 26 || static_cast<unsigned char>(c - '0') < 10;
+        out[i] = keep ? static_cast<char>(lower) : 0;
+        mask |= static_cast<uint64_t>(keep) << i;
+    }
+    return mask;
+}
+
+#if defined(__AVX2__)
+
+const char* const KERNEL = "avx2";
+
+uint64_t classify_simd(const char* in, char* out) {
+    uint64_t mask = 0;
+    for (int i = 0; i < 64; i += 32) {
+        // Signed compares: bytes >= 0x80 are negative and never match
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+        __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+        __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+        __m256i keep = _mm256_or_si256(alpha, digit);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_and_si256(lower, keep));
+        mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(keep))) << i;
+    }
+    return mask;
+}
+
+#elif defined(__SSE2__)
+
+const char* const KERNEL = "sse2";
+
+uint64_t classify_simd(const char* in, char* out) {
+    uint64_t mask = 0;
+    for (int i = 0; i < 64; i += 16) {
+        // Signed compares: bytes >= 0x80 are negative and never match
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+        __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                      _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                      _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+        __m128i keep = _mm_or_si128(alpha, digit);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_and_si128(lower, keep));
+        mask |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(keep))) << i;
+    }
+    return mask;
+}
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+const char* const KERNEL = "neon";
+
+uint64_t classify_simd(const char* in, char* out) {
+    static const uint8_t BIT_WEIGHTS[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t weights = vld1q_u8(BIT_WEIGHTS);
+    uint64_t mask = 0;
+    for (int i = 0; i < 64; i += 16) {
+        uint8x16_t c = vld1q_u8(reinterpret_cast<const uint8_t*>(in + i));
+        uint8x16_t lower = vorrq_u8(c, vdupq_n_u8(0x20));
+        uint8x16_t alpha = vcltq_u8(vsubq_u8(lower, vdupq_n_u8('a')), vdupq_n_u8(26));
+        uint8x16_t digit = vcltq_u8(vsubq_u8(c, vdupq_n_u8('0')), vdupq_n_u8(10));
+        uint8x16_t keep = vorrq_u8(alpha, digit);
+        vst1q_u8(reinterpret_cast<uint8_t*>(out + i), vandq_u8(lower, keep));
+        // No movemask on NEON: weight each lane by its bit and add up each half
+        uint8x16_t bits = vandq_u8(keep, weights);
+        uint64_t half_mask = vaddv_u8(vget_low_u8(bits)) | (static_cast<uint64_t>(vaddv_u8(vget_high_u8(bits))) << 8);
+        mask |= half_mask << i;
+    }
+    return mask;
+}
+
+#else
+
+const char* const KERNEL = "scalar";
+
+uint64_t classify_simd(const char* in, char* out) {
+    return classify_scalar(in, out);
+}
+
+#endif
+
+} // namespace
+
+const char* tokenizer_kernel() {
+    return KERNEL;
+}
+
+const std::vector<std::string_view>& Tokenizer::tokenize(std::string_view text) {
+    tokens.clear();
+    size_t words = (text.size() + 63) / 64;
+    if (lowered.size() < words * 64) lowered.resize(words * 64);
+    alnum.resize(words);
+
+    auto classify = force_scalar ? classify_scalar : classify_simd;
+    size_t full_words = text.size() / 64;
+    for (size_t w = 0; w < full_words; ++w) {
+        alnum[w] = classify(text.data() + w * 64, &lowered[w * 64]);
+    }
+    if (full_words < words) {
+        // The tail goes through a zero-padded copy; zero bytes are separators
+        char tail[64] = {};
+        std::memcpy(tail, text.data() + full_words * 64, text.size() - full_words * 64);
+        alnum[full_words] = classify(tail, &lowered[full_words * 64]);
+    }
+
+    // Token boundaries are where a bit differs from the one before it: a set bit starts a token,
+    // a clear bit ends one
+    size_t start = 0;
+    uint64_t carry = 0;
+    for (size_t w = 0; w < words; ++w) {
+        uint64_t bits = alnum[w];
+        uint64_t edges = bits ^ ((bits << 1) | carry);
+        carry = bits >> 63;
+        while (edges) {
+            size_t pos = w * 64 + __builtin_ctzll(edges);
+            if (bits & (uint64_t(1) << (pos % 64))) {
+                start = pos;
+            } else if (pos - start >= MIN_TOKEN_LENGTH) {
+                tokens.emplace_back(lowered.data() + start, pos - start);
+            }
+            edges &= edges - 1;
+        }
+    }
+    if (carry && text.size() - start >= MIN_TOKEN_LENGTH) {  // Token runs to the end of the text
+        tokens.emplace_back(lowered.data() + start, text.size() - start);
+    }
+    return tokens;
+}
+
+void TermCounts::add(std::string_view term) {
+    if ((entries_.size() + 1) * 2 > slots.size()) grow();  // Keep the load factor at most 1/2
+
+    uint64_t hash = std::hash<std::string_view>{}(term);
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        uint32_t entry = slots[i];
+        if (entry == EMPTY) {
+            slots[i] = static_cast<uint32_t>(entries_.size());
+            entries_.emplace_back(term, 1);
+            hashes.push_back(hash);
+            return;
+        }
+        if (hashes[entry] == hash && entries_[entry].first == term) {
+            ++entries_[entry].second;
+            return;
+        }
+    }
+}
+
+void TermCounts::clear() {
+    // Clears only the used slots, so a table grown by one large document stays cheap to reuse
+    size_t mask = slots.size() - 1;
+    for (uint32_t entry = 0; entry < entries_.size(); ++entry) {
+        size_t i = hashes[entry] & mask;
+        while (slots[i] != entry) i = (i + 1) & mask;
+        slots[i] = EMPTY;
+    }
+    entries_.clear();
+    hashes.clear();
+}
+
+void TermCounts::grow() {
+    slots.assign(std::max<size_t>(16, slots.size() * 2), EMPTY);
+    size_t mask = slots.size() - 1;
+    for (uint32_t entry = 0; entry < entries_.size(); ++entry) {
+        size_t i = hashes[entry] & mask;
+        while (slots[i] != EMPTY) i = (i + 1) & mask;
+        slots[i] = entry;
+    }
+}
+
+} // namespace indexer
@@ -0,0 +1,64 @@
+#ifndef INDEXER_TOKENIZER_HPP
+#define INDEXER_TOKENIZER_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace indexer {
+
+const size_t MIN_TOKEN_LENGTH = 3;
+
+// Which classification kernel this build uses: "avx2", "sse2", "neon" or "scalar".
+const char* tokenizer_kernel();
+
+// Splits text into lowercase ASCII alphanumeric words of at least MIN_TOKEN_LENGTH bytes; every other
+// byte (including all non-ASCII bytes) separates words. Independent of the C locale.
+//
+// Bytes are classified and lowercased a vector register at a time into a buffer the tokenizer
+// reuses, and tokens are views into that buffer, so tokenizing allocates nothing once the buffers
+// have grown to the largest document. Meant to be owned by one thread; not thread-safe.
+class Tokenizer {
+public:
+    // `force_scalar` selects the portable kernel, whose output the SIMD kernels must match.
+    explicit Tokenizer(bool force_scalar = false) : force_scalar(force_scalar) {}
+
+    // The tokens of `text` in order. Views and vector are valid until the next call.
+    const std::vector<std::string_view>& tokenize(std::string_view text);
+
+    // Byte offset of one of those tokens in `text`.
+    size_t offset(std::string_view token) const { return static_cast<size_t>(token.data() - lowered.data()); }
+
+private:
+    bool force_scalar;
+    std::string lowered;            // Lowercased text, padded to whole 64-byte words
+    std::vector<uint64_t> alnum;    // Bit i of word w: byte 64w+i is a letter or digit
+    std::vector<std::string_view> tokens;
+};
+
+// Term frequencies of one document in a flat open-addressing table (linear probing over indices
+// into a dense entry array). Keys are views, so the counted text must outlive the counts.
+// clear() keeps the capacity. Not thread-safe.
+class TermCounts {
+public:
+    void add(std::string_view term);
+    void clear();
+
+    // (term, tf) in first-occurrence order.
+    const std::vector<std::pair<std::string_view, uint32_t>>& entries() const { return entries_; }
+    size_t size() const { return entries_.size(); }
+
+private:
+    void grow();
+
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+    std::vector<uint32_t> slots;  // Index into entries_, or EMPTY; size is a power of two
+    std::vector<uint64_t> hashes; // Hash of each entry, so growing does not rehash the terms
+    std::vector<std::pair<std::string_view, uint32_t>> entries_;
+};
+
+} // namespace indexer
+
+#endif // INDEXER_TOKENIZER_HPP
@@ -1,11 +1,11 @@
 #include "utils.hpp"
+#include "tokenizer.hpp"
+#include "gzip_decompressor.hpp"
 
 #include <cstdlib>
-#include <cctype>
 #include <sstream>
 #include <stdexcept>
-#include <climits>
-#include <zlib.h>
+#include <utility>
 
 namespace indexer {
 
@@ -34,94 +34,62 @@ std::string build_db_conn_str() {
     }
 }
 
-void extract_content_recursive(GumboNode* node, ExtractedContent& content) {
-    if (node->type == GUMBO_NODE_TEXT) {
-        content.text.append(node->v.text.text);
-    } else if (node->type == GUMBO_NODE_ELEMENT &&
-               node->v.element.tag != GUMBO_TAG_SCRIPT &&
-               node->v.element.tag != GUMBO_TAG_STYLE) {
-        
-        if (node->v.element.tag == GUMBO_TAG_TITLE) {
-            if (node->v.element.children.length > 0) {
-                GumboNode* title_text = static_cast<GumboNode*>(node->v.element.children.data[0]);
+void extract_content(GumboNode* node, ExtractedContent& content) {
+    content.text.clear();
+    content.title.clear();
+
+    // Depth-first walk with an explicit stack (deeply nested markup must not overflow the call
+    // stack). Each frame is an element's children and the index of the next one to visit;
+    // siblings are separated by a space.
+    std::vector<std::pair<const GumboVector*, unsigned int>> stack;
+    GumboVector root = {reinterpret_cast<void**>(&node), 1, 1};
+    stack.emplace_back(&root, 0);
+    while (!stack.empty()) {
+        auto& [children, next] = stack.back();
+        if (next == children->length) {
+            stack.pop_back();
+            continue;
+        }
+        if (next > 0) content.text.push_back(' ');
+        GumboNode* child = static_cast<GumboNode*>(children->data[next++]);
+
+        if (child->type == GUMBO_NODE_TEXT) {
+            content.text.append(child->v.text.text);
+        } else if (child->type == GUMBO_NODE_ELEMENT &&
+                   child->v.element.tag != GUMBO_TAG_SCRIPT &&
+                   child->v.element.tag != GUMBO_TAG_STYLE) {
+            const GumboVector& grandchildren = child->v.element.children;
+            if (child->v.element.tag == GUMBO_TAG_TITLE && grandchildren.length > 0) {
+                GumboNode* title_text = static_cast<GumboNode*>(grandchildren.data[0]);
                 if (title_text->type == GUMBO_NODE_TEXT) {
                     content.title = title_text->v.text.text;
                 }
             }
-        }
-
-        GumboVector* children = &node->v.element.children;
-        for (unsigned int i = 0; i < children->length; ++i) {
-            extract_content_recursive(static_cast<GumboNode*>(children->data[i]), content);
-            if (i != children->length - 1) {
-                content.text.append(" ");
-            }
+            stack.emplace_back(&grandchildren, 0);  // Invalidates `children` and `next`
         }
     }
 }
 
 ExtractedContent extract_content(GumboNode* node) {
     ExtractedContent content;
-    extract_content_recursive(node, content);
+    extract_content(node, content);
     return content;
 }
 
-std::string decompress_gzip(const std::string& compressed_data) {
-    if (compressed_data.size() > UINT_MAX) {
-        throw std::runtime_error("Compressed data too large (> 4GB)");
-    }
-    
-    const size_t MAX_DECOMPRESSED_SIZE = 100 * 1024 * 1024; // 100MB limit
-
-    z_stream zs;
-    zs.zalloc = Z_NULL;
-    zs.zfree = Z_NULL;
-    zs.opaque = Z_NULL;
-    zs.avail_in = (uInt)compressed_data.size();
-    zs.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(compressed_data.data()));
-
-    if (inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK) {
-        throw std::runtime_error("inflateInit2 failed");
-    }
-
-    int ret;
-    char buffer[32768];
-    std::string outstring;
-
-    do {
-        zs.avail_out = sizeof(buffer);
-        zs.next_out = (Bytef*)buffer;
-        ret = inflate(&zs, Z_NO_FLUSH);
-        if (ret != Z_OK && ret != Z_STREAM_END) {
-            inflateEnd(&zs);
-            throw std::runtime_error("inflate failed with code: " + std::to_string(ret));
-        }
-        if (outstring.size() < zs.total_out) {
-            outstring.append(buffer, zs.total_out - outstring.size());
-        }
-        if (outstring.size() > MAX_DECOMPRESSED_SIZE) {
-            inflateEnd(&zs);
-            throw std::runtime_error("Decompressed data exceeds maximum allowed size");
-        }
-    } while (ret == Z_OK);
-
-    inflateEnd(&zs);
-    return outstring;
+std::string decompress_gzip(std::string_view compressed_data, size_t* consumed) {
+    // One inflate state per thread, reset between calls
+    thread_local GzipDecompressor decompressor;
+    std::string out;
+    // Callers that want the consumed size may pass data that continues past the member
+    size_t used = decompressor.decompress(compressed_data, out, consumed == nullptr);
+    if (consumed) *consumed = used;
+    return out;
 }
 
 std::vector<std::string> tokenize(const std::string& text) {
-    std::vector<std::string> tokens;
-    std::string token;
-    for (char c : text) {
-        if (isalnum(static_cast<unsigned char>(c))) {
-            token += tolower(static_cast<unsigned char>(c));
-        } else if (!token.empty()) {
-            if (token.length() > 2) tokens.push_back(token); // Min word length 3
-            token = "";
-        }
-    }
-    if (!token.empty() && token.length() > 2) tokens.push_back(token);
-    return tokens;
+    Tokenizer tokenizer;
+    const std::vector<std::string_view>& tokens = tokenizer.tokenize(text);
+    return std::vector<std::string>(tokens.begin(), tokens.end());
 }
 
 } // namespace indexer
@@ -2,6 +2,7 @@
 #define INDEXER_UTILS_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <gumbo.h>
 
@@ -21,10 +22,16 @@ struct ExtractedContent {
 };
 ExtractedContent extract_content(GumboNode* node);
 
-// Decompress a gzip-compressed string.
-std::string decompress_gzip(const std::string& compressed_data);
+// Same, into `content` (cleared first) so its buffers can be reused across documents.
+void extract_content(GumboNode* node, ExtractedContent& content);
+
+// Decompress the first gzip member of `compressed_data`.
+// If `consumed` is given, it receives the compressed size of that member, and `compressed_data` may
+// continue past it. Hot paths keep their own GzipDecompressor (gzip_decompressor.hpp) instead.
+std::string decompress_gzip(std::string_view compressed_data, size_t* consumed = nullptr);
 
 // Tokenize a string into words (lowercase, alphanumeric, min length 3).
+// Copies every token; hot paths reuse a Tokenizer (tokenizer.hpp) instead.
 std::vector<std::string> tokenize(const std::string& text);
 
 } // namespace indexer
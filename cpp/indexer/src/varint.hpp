@@ -0,0 +1,38 @@
+#ifndef INDEXER_VARINT_HPP
+#define INDEXER_VARINT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace indexer {
+
+// LEB128 varints of the index's wire formats (posting lists, stored documents, text records):
+// 7 bits per byte, least significant first, high bit set on every byte but the last.
+
+inline void put_varint(std::string& out, uint32_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+// Reads the varint at `pos` and moves past it. Throws std::runtime_error naming `format` (e.g.
+// "posting list") if `in` ends first or the varint is longer than the 5 bytes a uint32_t needs.
+inline uint32_t get_varint(std::string_view in, size_t& pos, const char* format) {
+    uint32_t value = 0;
+    for (int shift = 0; shift <= 28; shift += 7) {
+        if (pos >= in.size()) throw std::runtime_error(std::string("Truncated ") + format);
+        uint8_t byte = static_cast<uint8_t>(in[pos++]);
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    throw std::runtime_error(std::string("Malformed varint in ") + format);
+}
+
+} // namespace indexer
+
+#endif // INDEXER_VARINT_HPP
@@ -0,0 +1,135 @@
+#include "warc_reader.hpp"
+#include "gzip_decompressor.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace indexer {
+
+MappedSegment::MappedSegment(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open file: " + path + " (" + std::strerror(errno) + ")");
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Could not stat file: " + path);
+    }
+    size_ = static_cast<size_t>(st.st_size);
+
+    // mmap() rejects empty mappings; an empty segment simply has no records yet
+    if (size_ > 0) {
+        void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Could not map file: " + path + " (" + std::strerror(errno) + ")");
+        }
+        data_ = static_cast<const char*>(addr);
+    }
+    ::close(fd);  // The mapping stays valid without the descriptor
+}
+
+MappedSegment::~MappedSegment() {
+    if (data_) ::munmap(const_cast<char*>(data_), size_);
+}
+
+std::string_view warc_payload(std::string_view record) {
+    size_t header_end = record.find("\r\n\r\n");
+    if (header_end == std::string_view::npos) return {};
+    return record.substr(header_end + 4);
+}
+
+std::string_view warc_header(std::string_view record, std::string_view name) {
+    size_t header_end = record.find("\r\n\r\n");
+    std::string_view headers = record.substr(0, header_end);
+
+    size_t pos = 0;
+    while (pos < headers.size()) {
+        size_t line_end = headers.find("\r\n", pos);
+        if (line_end == std::string_view::npos) line_end = headers.size();
+        std::string_view line = headers.substr(pos, line_end - pos);
+        if (line.size() > name.size() && line.compare(0, name.size(), name) == 0 && line[name.size()] == ':') {
+            std::string_view value = line.substr(name.size() + 1);
+            while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+            return value;
+        }
+        pos = line_end + 2;
+    }
+    return {};
+}
+
+WarcReader::WarcReader(std::string base_path, size_t max_mapped_segments)
+    : base_path(std::move(base_path)), max_mapped_segments(max_mapped_segments > 0 ? max_mapped_segments : 1) {}
+
+std::shared_ptr<const MappedSegment> WarcReader::segment_for(const std::string& file_name, uint64_t min_size) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = segments.find(file_name);
+    if (it != segments.end()) {
+        lru.splice(lru.begin(), lru, it->second.lru_position);
+        if (it->second.segment->size() >= min_size) return it->second.segment;
+        // The segment grew since it was mapped; views of the old mapping keep it alive
+        it->second.segment = std::make_shared<const MappedSegment>(base_path + file_name);
+        return it->second.segment;
+    }
+
+    auto segment = std::make_shared<const MappedSegment>(base_path + file_name);
+    lru.push_front(file_name);
+    segments.emplace(file_name, CacheEntry{segment, lru.begin()});
+    if (segments.size() > max_mapped_segments) {
+        segments.erase(lru.back());
+        lru.pop_back();
+    }
+    return segment;
+}
+
+WarcRecordView WarcReader::read_record(const std::string& file_name, int64_t offset, int64_t length) {
+    if (offset < 0 || length <= 0) {
+        throw std::runtime_error("Invalid WARC record range in " + file_name);
+    }
+    uint64_t end = static_cast<uint64_t>(offset) + static_cast<uint64_t>(length);
+    auto segment = segment_for(file_name, end);
+    if (segment->size() < end) {
+        throw std::runtime_error("Failed to read full record: " + file_name + " has " + std::to_string(segment->size()) +
+                                 " bytes, record ends at " + std::to_string(end));
+    }
+    return {std::string_view(segment->data() + offset, static_cast<size_t>(length)), segment};
+}
+
+size_t WarcReader::scan_segment(const std::string& file_name,
+                                const std::function<void(int64_t offset, int64_t length, const std::string& record)>& fn) {
+    // Map the whole file as it is now; records appended later belong to the next scan
+    auto segment = segment_for(file_name, 0);
+    std::string_view data(segment->data(), segment->size());
+
+    GzipDecompressor decompressor;
+    std::string record;  // Reused, so it only grows for the largest record
+    size_t records = 0;
+    size_t pos = 0;
+    while (pos < data.size()) {
+        size_t consumed = 0;
+        try {
+            // Stops at the end of the first member, so the rest of the segment is never read
+            consumed = decompressor.decompress(data.substr(pos, std::min<size_t>(data.size() - pos, UINT_MAX)), record, false);
+        } catch (const std::exception&) {
+            break;
+        }
+        if (consumed == 0) break;
+
+        fn(static_cast<int64_t>(pos), static_cast<int64_t>(consumed), record);
+        ++records;
+        pos += consumed;
+    }
+    return records;
+}
+
+} // namespace indexer
@@ -0,0 +1,83 @@
+#ifndef INDEXER_WARC_READER_HPP
+#define INDEXER_WARC_READER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace indexer {
+
+// Read-only memory mapping of a whole WARC segment.
+class MappedSegment {
+public:
+    explicit MappedSegment(const std::string& path);
+    ~MappedSegment();
+
+    MappedSegment(const MappedSegment&) = delete;
+    MappedSegment& operator=(const MappedSegment&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// A compressed record (one gzip member) viewed in place inside its segment's mapping.
+struct WarcRecordView {
+    std::string_view compressed;
+    std::shared_ptr<const MappedSegment> segment;  // Keeps `compressed` valid for as long as the view lives
+};
+
+// Returns the payload of a decompressed WARC record (everything after the header block),
+// or an empty view if the record has no header terminator.
+std::string_view warc_payload(std::string_view record);
+
+// Returns the value of a WARC header (e.g. "WARC-Target-URI"), or an empty view if absent.
+std::string_view warc_header(std::string_view record, std::string_view name);
+
+// Serves WARC records straight out of memory-mapped segment files.
+//
+// Segments are mapped on first use and kept in a small LRU; a segment that has grown past its
+// mapping (the crawler's active segment) is remapped on demand. Views hold a reference to their
+// mapping, so eviction or remapping never invalidates a view that is still in use.
+// All methods are thread-safe.
+class WarcReader {
+public:
+    // `base_path` is prepended to every file name (as in documents.file_path).
+    explicit WarcReader(std::string base_path, size_t max_mapped_segments = 64);
+
+    // Zero-copy view of the record at [offset, offset + length) of `file_name`.
+    // Throws std::runtime_error if the segment cannot be mapped or the range lies outside it.
+    WarcRecordView read_record(const std::string& file_name, int64_t offset, int64_t length);
+
+    // Decompresses every record of a segment in file order and calls fn(offset, length, record).
+    // Stops at the first member that does not decode, which for an active segment is its
+    // unflushed tail. Returns the number of records visited.
+    size_t scan_segment(const std::string& file_name,
+                        const std::function<void(int64_t offset, int64_t length, const std::string& record)>& fn);
+
+private:
+    std::shared_ptr<const MappedSegment> segment_for(const std::string& file_name, uint64_t min_size);
+
+    struct CacheEntry {
+        std::shared_ptr<const MappedSegment> segment;
+        std::list<std::string>::iterator lru_position;
+    };
+
+    std::string base_path;
+    size_t max_mapped_segments;
+    std::mutex mutex;
+    std::list<std::string> lru;  // Most recently used first
+    std::unordered_map<std::string, CacheEntry> segments;
+};
+
+} // namespace indexer
+
+#endif // INDEXER_WARC_READER_HPP
@@ -0,0 +1,100 @@
+#include "../src/bounded_queue.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Simple assertion macro
+#define ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "Assertion failed: " << (message) << "\n" \
+                      << "File: " << __FILE__ << ", Line: " << __LINE__ << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+// --- Test: FIFO order and close semantics ---
+void test_fifo_and_close() {
+    indexer::BoundedQueue<std::string> queue(4);
+    ASSERT(queue.push("a") && queue.push("b"), "Push should succeed while open");
+    ASSERT(*queue.pop() == "a", "Items come out in FIFO order");
+
+    queue.close();
+    ASSERT(!queue.push("c"), "Push should fail once closed");
+    ASSERT(queue.closed(), "Queue should report closed");
+    auto rest = queue.pop();
+    ASSERT(rest && *rest == "b", "Items queued before close are still drained");
+    ASSERT(!queue.pop(), "Pop should fail once closed and empty");
+    std::cout << "test_fifo_and_close passed" << std::endl;
+}
+
+// --- Test: pop_for times out on an open, empty queue ---
+void test_pop_for_timeout() {
+    indexer::BoundedQueue<int> queue(1);
+    auto start = std::chrono::steady_clock::now();
+    ASSERT(!queue.pop_for(std::chrono::milliseconds(20)), "Empty queue should time out");
+    ASSERT(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20), "Should wait for the timeout");
+    ASSERT(!queue.closed(), "A timeout is not a close");
+    std::cout << "test_pop_for_timeout passed" << std::endl;
+}
+
+// --- Test: a full queue blocks producers until a consumer makes room ---
+void test_backpressure() {
+    indexer::BoundedQueue<int> queue(2);
+    queue.push(1);
+    queue.push(2);
+    std::atomic<bool> pushed{false};
+    std::thread producer([&] {
+        queue.push(3);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT(!pushed, "Push should block while the queue is full");
+    ASSERT(queue.size() == 2, "Queue must not exceed its capacity");
+    queue.pop();
+    producer.join();
+    ASSERT(pushed && queue.size() == 2, "Push should complete once there is room");
+
+    // close() also releases a blocked producer
+    std::thread blocked([&] { ASSERT(!queue.push(4), "Blocked push should fail on close"); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    queue.close();
+    blocked.join();
+    std::cout << "test_backpressure passed" << std::endl;
+}
+
+// --- Test: every item is delivered exactly once across producers and consumers ---
+void test_many_producers_and_consumers() {
+    const int PRODUCERS = 4, CONSUMERS = 4, ITEMS = 10000;
+    indexer::BoundedQueue<int> queue(8);
+    std::vector<std::atomic<int>> seen(PRODUCERS * ITEMS);
+    std::vector<std::thread> producers, consumers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&, p] {
+            for (int i = 0; i < ITEMS; ++i) queue.push(p * ITEMS + i);
+        });
+    }
+    for (int c = 0; c < CONSUMERS; ++c) {
+        consumers.emplace_back([&] {
+            while (auto item = queue.pop()) seen[*item].fetch_add(1);
+        });
+    }
+    for (auto& thread : producers) thread.join();
+    queue.close();
+    for (auto& thread : consumers) thread.join();
+    for (const auto& count : seen) ASSERT(count == 1, "Every item should be delivered exactly once");
+    std::cout << "test_many_producers_and_consumers passed" << std::endl;
+}
+
+int main() {
+    test_fifo_and_close();
+    test_pop_for_timeout();
+    test_backpressure();
+    test_many_producers_and_consumers();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
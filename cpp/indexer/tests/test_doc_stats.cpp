@@ -0,0 +1,103 @@
+#include "../src/doc_stats.hpp"
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+// Simple assertion macro
+#define ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "Assertion failed: " << (message) << "\n" \
+                      << "File: " << __FILE__ << ", Line: " << __LINE__ << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+std::string temp_path(const std::string& name) {
+    return "/tmp/" + name + "_" + std::to_string(::getpid()) + ".bin";
+}
+
+// --- Test: totals follow updates and re-indexing ---
+void test_writer_totals() {
+    std::string path = temp_path("doc_stats_totals");
+    std::remove(path.c_str());
+    {
+        indexer::DocStatsWriter writer(path);
+        ASSERT(writer.totals().total_docs == 0, "New file should be empty");
+
+        writer.set_lengths({{1, 100}, {2, 50}, {7, 30}});
+        auto totals = writer.totals();
+        ASSERT(totals.total_docs == 3 && totals.total_length == 180, "Totals should count every new document");
+        ASSERT(totals.min_length == 30, "Min length should track the shortest document");
+
+        writer.set_lengths({{2, 80}, {7, 0}});  // Re-indexed, and dropped
+        totals = writer.totals();
+        ASSERT(totals.total_docs == 2 && totals.total_length == 180, "Re-indexing should replace the old length");
+        ASSERT(writer.length(2) == 80 && writer.length(7) == 0, "Lengths should be updated in place");
+    }
+
+    // Reopening recomputes the totals from the stored lengths
+    indexer::DocStatsWriter reopened(path);
+    auto totals = reopened.totals();
+    ASSERT(totals.total_docs == 2 && totals.total_length == 180 && totals.min_length == 80,
+           "Reopened file should keep the lengths");
+    std::remove(path.c_str());
+    std::cout << "test_writer_totals passed" << std::endl;
+}
+
+// --- Test: readers see updates and detect growth ---
+void test_view_follows_writer() {
+    std::string path = temp_path("doc_stats_view");
+    std::remove(path.c_str());
+    indexer::DocStatsWriter writer(path);
+    writer.set_lengths({{3, 40}});
+
+    indexer::DocStatsView view(path);
+    ASSERT(view.length(3) == 40 && view.length(4) == 0, "View should read lengths in place");
+    ASSERT(view.totals().total_docs == 1, "View should read the totals");
+
+    writer.set_lengths({{5, 60}});
+    ASSERT(view.length(5) == 60 && view.totals().total_length == 100, "Updates should be visible without remapping");
+    ASSERT(!view.stale(), "View should cover the file until it grows");
+
+    uint32_t far_id = 5000000;
+    writer.set_lengths({{far_id, 10}});
+    ASSERT(view.stale(), "Growing the file should make old views stale");
+    ASSERT(view.length(far_id) == 0, "Stale view should not read past its mapping");
+    ASSERT(view.totals().total_docs == 3, "Stale view should still see current totals");
+
+    indexer::DocStatsView remapped(path);
+    ASSERT(!remapped.stale() && remapped.length(far_id) == 10, "New view should cover the grown file");
+
+    writer.mark_replaced();  // A rebuilt file took its path
+    ASSERT(remapped.stale(), "Replacing the file should make every view stale");
+    std::remove(path.c_str());
+    std::cout << "test_view_follows_writer passed" << std::endl;
+}
+
+void test_view_rejects_other_files() {
+    std::string path = temp_path("doc_stats_bogus");
+    FILE* f = std::fopen(path.c_str(), "wb");
+    std::string junk(128, 'x');
+    std::fwrite(junk.data(), 1, junk.size(), f);
+    std::fclose(f);
+
+    bool threw = false;
+    try {
+        indexer::DocStatsView view(path);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT(threw, "View should reject a file without the doc stats magic");
+    std::remove(path.c_str());
+    std::cout << "test_view_rejects_other_files passed" << std::endl;
+}
+
+int main() {
+    test_writer_totals();
+    test_view_follows_writer();
+    test_view_rejects_other_files();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
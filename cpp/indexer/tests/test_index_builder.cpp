@@ -0,0 +1,196 @@
+#include "../src/index_builder.hpp"
+#include "../src/posting_list.hpp"
+#include "../src/posting_merge_operator.hpp"
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Simple assertion macro
+#define ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "Assertion failed: " << (message) << "\n" \
+                      << "File: " << __FILE__ << ", Line: " << __LINE__ << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+std::vector<uint32_t> doc_ids_of(const std::vector<indexer::Posting>& postings) {
+    std::vector<uint32_t> ids;
+    for (const auto& posting : postings) ids.push_back(posting.doc_id);
+    return ids;
+}
+
+// --- Test: posting lists ---
+void test_decode_legacy_ascii() {
+    // Lists written by the old std::set<std::string> indexer are in lexicographic order
+    auto postings = indexer::decode_posting_list("10,100,9,9");
+    ASSERT((doc_ids_of(postings) == std::vector<uint32_t>{9, 10, 100}), "Decoded ids should be numeric and unique");
+    ASSERT(postings[0].tf == 1, "Legacy postings have tf = 1");
+    ASSERT(indexer::decode_posting_list("").empty(), "Empty value should decode to no postings");
+
+    indexer::PostingListReader reader("10,100,9");
+    ASSERT(reader.size() == 3 && reader.block_count() == 1 && reader.block(0).max_doc_id == 100,
+           "Legacy values should be readable block-wise");
+    std::cout << "test_decode_legacy_ascii passed" << std::endl;
+}
+
+void test_binary_round_trip() {
+    std::vector<indexer::Posting> postings;
+    uint32_t doc_id = 0;
+    for (uint32_t i = 0; i < 300; ++i) {
+        doc_id += 1 + (i * 37) % 1000;  // Mixed small and multi-byte deltas
+        postings.push_back({doc_id, 1 + i % 17});
+    }
+    postings.push_back({4000000000u, 70000});
+
+    std::string value = indexer::encode_posting_list(postings);
+    ASSERT(value.size() >= 2 && value[0] == '\0' && value[1] == 1, "Value should start with the format marker and version");
+    ASSERT(value.size() < indexer::encode_posting_list({}).size() + postings.size() * 4,
+           "Binary format should be compact");
+
+    auto decoded = indexer::decode_posting_list(value);
+    ASSERT(decoded.size() == postings.size(), "Round trip should keep every posting");
+    for (size_t i = 0; i < postings.size(); ++i) {
+        ASSERT(decoded[i].doc_id == postings[i].doc_id && decoded[i].tf == postings[i].tf, "Round trip should be exact");
+    }
+
+    indexer::PostingListReader reader(value);
+    ASSERT(reader.block_count() == 3, "301 postings should form three blocks of 128");
+    ASSERT(reader.block(0).count == 128 && reader.block(2).count == 45, "Blocks should hold up to 128 postings");
+    ASSERT(reader.block(0).max_doc_id == postings[127].doc_id, "Block header should carry the max doc id");
+    ASSERT(reader.block(2).max_tf == 70000, "Block header should carry the max tf");
+
+    std::vector<indexer::Posting> block;
+    reader.decode_block(1, block);
+    ASSERT(block.front().doc_id == postings[128].doc_id, "Blocks should decode independently");
+
+    ASSERT(indexer::decode_posting_list(indexer::encode_posting_list({})).empty(), "Empty list should round trip");
+    std::cout << "test_binary_round_trip passed" << std::endl;
+}
+
+void test_binary_rejects_corruption() {
+    std::string value = indexer::encode_posting_list({{1, 1}, {5, 2}});
+    bool threw = false;
+    try {
+        indexer::decode_posting_list(value.substr(0, value.size() - 1));
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT(threw, "Truncated value should be rejected");
+
+    threw = false;
+    value[1] = 99;
+    try {
+        indexer::decode_posting_list(value);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT(threw, "Unknown version should be rejected");
+    std::cout << "test_binary_rejects_corruption passed" << std::endl;
+}
+
+void test_merge_posting_lists() {
+    std::vector<indexer::Posting> older = {{1, 1}, {5, 2}, {9, 1}};
+    std::vector<indexer::Posting> newer = {{2, 1}, {5, 7}, {12, 3}};
+    auto merged = indexer::merge_posting_lists(older, newer);
+    ASSERT((doc_ids_of(merged) == std::vector<uint32_t>{1, 2, 5, 9, 12}), "Merge should be a sorted union");
+    ASSERT(merged[2].tf == 7, "Newer posting should win for the same doc");
+    std::cout << "test_merge_posting_lists passed" << std::endl;
+}
+
+// --- Test: IndexBuilder ---
+void test_builder_segment() {
+    indexer::IndexBuilder builder;
+    builder.add_document(20, {"zebra", "apple", "apple"});
+    builder.add_document(3, {"apple", "mango"});
+    ASSERT(builder.document_count() == 2, "Builder should count documents");
+    ASSERT(builder.memory_usage() > 0, "Builder should account for memory");
+
+    auto segment = builder.take_segment();
+    ASSERT(builder.empty() && builder.memory_usage() == 0, "take_segment should reset the builder");
+    ASSERT(segment.size() == 3, "Segment should hold one entry per term");
+    ASSERT(segment[0].first == "apple" && segment[1].first == "mango" && segment[2].first == "zebra",
+           "Terms should be in byte order");
+    ASSERT((doc_ids_of(segment[0].second) == std::vector<uint32_t>{3, 20}), "Postings should be sorted by doc id");
+    ASSERT(segment[0].second[1].tf == 2, "Term frequency should be counted");
+    std::cout << "test_builder_segment passed" << std::endl;
+}
+
+void test_builder_readded_document() {
+    indexer::IndexBuilder builder;
+    builder.add_document(7, {"apple"});
+    builder.add_document(7, {"apple", "apple", "apple"});
+    auto segment = builder.take_segment();
+    ASSERT(segment.size() == 1 && segment[0].second.size() == 1, "Re-added document should appear once");
+    ASSERT(segment[0].second[0].tf == 3, "Latest version of a document should win");
+    std::cout << "test_builder_readded_document passed" << std::endl;
+}
+
+// --- Test: PostingAppendOperator ---
+void test_merge_operator_full_merge() {
+    indexer::PostingAppendOperator op;
+    rocksdb::Slice key("apple");
+    std::string existing_value = indexer::encode_posting_list({{3, 1}, {9, 1}});
+    rocksdb::Slice existing(existing_value);
+    std::string first = indexer::encode_posting_list({{12, 1}, {3, 1}});
+    std::string second = indexer::encode_posting_list({{1, 1}});
+    std::vector<rocksdb::Slice> operands = {rocksdb::Slice(first), rocksdb::Slice(second)};
+
+    std::string new_value;
+    rocksdb::Slice existing_operand;
+    rocksdb::MergeOperator::MergeOperationInput in(key, &existing, operands, nullptr);
+    rocksdb::MergeOperator::MergeOperationOutput out(new_value, existing_operand);
+    ASSERT(op.FullMergeV2(in, &out), "Full merge should succeed");
+    ASSERT((doc_ids_of(indexer::decode_posting_list(new_value)) == std::vector<uint32_t>{1, 3, 9, 12}),
+           "Full merge should union the base with every operand");
+
+    // No existing value: the operands alone form the list
+    rocksdb::MergeOperator::MergeOperationInput fresh(key, nullptr, operands, nullptr);
+    new_value.clear();
+    ASSERT(op.FullMergeV2(fresh, &out), "Merge without a base should succeed");
+    ASSERT((doc_ids_of(indexer::decode_posting_list(new_value)) == std::vector<uint32_t>{1, 3, 12}),
+           "Merge without a base should use the operands");
+
+    // A legacy ASCII base is upgraded to the binary format
+    std::string legacy = "9,10";
+    rocksdb::Slice legacy_slice(legacy);
+    rocksdb::MergeOperator::MergeOperationInput upgrade(key, &legacy_slice, operands, nullptr);
+    new_value.clear();
+    ASSERT(op.FullMergeV2(upgrade, &out) && new_value[0] == '\0', "Merged value should be binary");
+
+    // Corrupt operands are reported instead of throwing
+    std::string corrupt("\0\1\5", 3);
+    std::vector<rocksdb::Slice> bad_operands = {rocksdb::Slice(corrupt)};
+    rocksdb::MergeOperator::MergeOperationInput bad(key, nullptr, bad_operands, nullptr);
+    ASSERT(!op.FullMergeV2(bad, &out), "Corrupt operand should fail the merge");
+    std::cout << "test_merge_operator_full_merge passed" << std::endl;
+}
+
+void test_merge_operator_partial_merge() {
+    indexer::PostingAppendOperator op;
+    std::string a = indexer::encode_posting_list({{5, 1}, {7, 1}});
+    std::string b = indexer::encode_posting_list({{6, 1}});
+    std::string c = indexer::encode_posting_list({{5, 4}});
+    std::deque<rocksdb::Slice> operands = {rocksdb::Slice(a), rocksdb::Slice(b), rocksdb::Slice(c)};
+    std::string combined;
+    ASSERT(op.PartialMergeMulti(rocksdb::Slice("k"), operands, &combined, nullptr), "Partial merge should succeed");
+    auto folded = indexer::decode_posting_list(combined);
+    ASSERT((doc_ids_of(folded) == std::vector<uint32_t>{5, 6, 7}), "Partial merge should fold operands into one sorted list");
+    ASSERT(folded[0].tf == 4, "Later operands should win");
+    std::cout << "test_merge_operator_partial_merge passed" << std::endl;
+}
+
+int main() {
+    test_decode_legacy_ascii();
+    test_binary_round_trip();
+    test_binary_rejects_corruption();
+    test_merge_posting_lists();
+    test_builder_segment();
+    test_builder_readded_document();
+    test_merge_operator_full_merge();
+    test_merge_operator_partial_merge();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
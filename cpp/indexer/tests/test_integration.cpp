@@ -1,4 +1,5 @@
 #include "../src/utils.hpp"
+#include "../src/warc_reader.hpp"
 #include "../../crawler/src/warc_writer.hpp"
 #include <iostream>
 #include <fstream>
@@ -80,9 +81,77 @@ void test_crawler_indexer_integration() {
     std::cout << "test_crawler_indexer_integration passed" << std::endl;
 }
 
+void test_warc_reader_views() {
+    std::string filename = "test_reader_views.warc.gz";
+    FileCleaner cleaner(filename);
+
+    crawler::WarcWriter writer(filename);
+    indexer::WarcReader reader("");
+
+    auto first = writer.write_record("http://example.com/1", "<html>first</html>");
+    writer.flush();
+    auto view = reader.read_record(filename, first.offset, first.length);
+    ASSERT(view.compressed.size() == static_cast<size_t>(first.length), "View should cover exactly the record");
+    std::string record = indexer::decompress_gzip(view.compressed);
+    ASSERT(indexer::warc_payload(record) == "<html>first</html>\r\n\r\n", "Payload should follow the WARC headers");
+    ASSERT(indexer::warc_header(record, "WARC-Target-URI") == "http://example.com/1", "Header lookup should find the URL");
+
+    // The segment grows after it was mapped; the reader remaps while the old view stays usable
+    auto second = writer.write_record("http://example.com/2", "<html>second</html>");
+    writer.flush();
+    auto second_view = reader.read_record(filename, second.offset, second.length);
+    ASSERT(indexer::decompress_gzip(second_view.compressed).find("<html>second</html>") != std::string::npos,
+           "Reader should see records appended after the first mapping");
+    ASSERT(indexer::decompress_gzip(view.compressed) == record, "Earlier views should survive a remap");
+
+    bool threw = false;
+    try {
+        reader.read_record(filename, second.offset, second.length + 1);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT(threw, "Reading past the end of a segment should throw");
+
+    std::cout << "test_warc_reader_views passed" << std::endl;
+}
+
+void test_warc_reader_scan() {
+    std::string filename = "test_reader_scan.warc.gz";
+    FileCleaner cleaner(filename);
+
+    std::vector<crawler::WarcRecordInfo> infos;
+    {
+        crawler::WarcWriter writer(filename);
+        for (int i = 0; i < 10; ++i) {
+            infos.push_back(writer.write_record("http://example.com/" + std::to_string(i),
+                                                "<html>page " + std::to_string(i) + "</html>"));
+        }
+    }
+    {
+        // Simulate an unflushed, partially written tail
+        std::ofstream out(filename, std::ios::binary | std::ios::app);
+        out.write("\x1f\x8b\x08\x00", 4);
+    }
+
+    indexer::WarcReader reader("");
+    size_t index = 0;
+    size_t count = reader.scan_segment(filename, [&](int64_t offset, int64_t length, const std::string& record) {
+        ASSERT(index < infos.size(), "Scan should not invent records");
+        ASSERT(offset == infos[index].offset && length == infos[index].length, "Scan should report writer offsets");
+        ASSERT(indexer::warc_header(record, "WARC-Target-URI") == "http://example.com/" + std::to_string(index),
+               "Scan should return records in file order");
+        ++index;
+    });
+    ASSERT(count == infos.size(), "Scan should stop at the truncated tail");
+
+    std::cout << "test_warc_reader_scan passed" << std::endl;
+}
+
 int main() {
     try {
         test_crawler_indexer_integration();
+        test_warc_reader_views();
+        test_warc_reader_scan();
         std::cout << "All integration tests passed!" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Integration test failed: " << e.what() << std::endl;
@@ -0,0 +1,205 @@
+#include "../src/rebuild.hpp"
+#include "../src/document_parser.hpp"
+#include "../src/doc_store.hpp"
+#include "../src/snippet.hpp"
+#include "../src/index_builder.hpp"
+#include "../src/posting_list.hpp"
+#include "../src/posting_merge_operator.hpp"
+#include "../../crawler/src/warc_writer.hpp"
+#include <rocksdb/db.h>
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Simple assertion macro
+#define ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "Assertion failed: " << (message) << "\n" \
+                      << "File: " << __FILE__ << ", Line: " << __LINE__ << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+namespace fs = std::filesystem;
+
+std::string temp_dir(const std::string& name) {
+    std::string path = "/tmp/" + name + "_" + std::to_string(::getpid());
+    fs::remove_all(path);
+    fs::create_directories(path);
+    return path;
+}
+
+// Pages with terms spread over every leading character, so each partition gets some
+std::string page(int i) {
+    static const char* const WORDS[] = {"alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel",
+                                        "india", "juliet", "kilo", "lima", "mike", "november", "oscar", "papa",
+                                        "quebec", "romeo", "sierra", "tango", "uniform", "victor", "whiskey",
+                                        "xray", "yankee", "zulu", "2024", "9000"};
+    std::string body;
+    for (int w = 0; w < 28; ++w) {
+        if ((i + w) % 3 == 0) continue;
+        for (int r = 0; r <= (i * w) % 4; ++r) body += std::string(WORDS[w]) + " ";
+    }
+    body += "unique" + std::to_string(i);
+    return "<html><head><title>Page " + std::to_string(i) + "</title></head><body><p>" + body + "</p></body></html>";
+}
+
+// --- Test: the rebuilt index matches the incremental builder ---
+void test_rebuild_matches_index_builder() {
+    std::string dir = temp_dir("rebuild_index");
+    std::vector<indexer::DocLocation> documents;
+    {
+        crawler::WarcWriter writer(dir + "/segment.warc.gz");
+        for (int i = 0; i < 300; ++i) {
+            auto info = writer.write_record("http://example.com/" + std::to_string(i), page(i));
+            documents.push_back({i + 1, info.filename, info.offset, info.length});
+        }
+        writer.flush();
+    }
+    documents.push_back({999, "segment.warc.gz", 1 << 30, 100});  // Past the end of the segment: skipped
+
+    indexer::WarcReader warc_reader(dir + "/");
+    indexer::IndexBuilder expected_builder;
+    {
+        indexer::GzipDecompressor decompressor;
+        indexer::HtmlTextExtractor extractor(indexer::HtmlExtractMode::Dom);
+        indexer::Tokenizer tokenizer;
+        indexer::TermCounts counts;
+        indexer::TextRecordWriter text_writer;
+        for (size_t i = 0; i + 1 < documents.size(); ++i) {
+            auto raw = indexer::read_document(documents[i], warc_reader, decompressor);
+            ASSERT(indexer::parse_document(raw, extractor, tokenizer, counts, text_writer), "Test pages should parse");
+            expected_builder.add_document(static_cast<uint32_t>(documents[i].doc_id), counts);
+        }
+    }
+    std::vector<indexer::TermPostings> expected = expected_builder.take_segment();
+
+    indexer::RebuildOptions options;
+    options.work_dir = dir + "/work";
+    options.threads = 3;
+    options.partitions = 5;
+    options.memory_limit_bytes = 3 * 16 * 1024;  // Small enough to spill several runs per worker
+    std::mutex updates_mutex;
+    std::map<int, indexer::DocUpdate> updates;
+    indexer::RebuildStats stats;
+    std::vector<std::string> sst_files = indexer::build_sst_files(
+        documents, warc_reader, options, [&](indexer::DocUpdate update) {
+            ASSERT(update.doc_length > 0 && !update.title.empty(), "Every indexed document should report its metadata");
+            std::lock_guard<std::mutex> lock(updates_mutex);
+            updates.emplace(update.doc_id, std::move(update));
+        }, &stats);
+    ASSERT(updates.size() == 300 && stats.documents == 300, "Every readable document should be indexed once");
+    ASSERT(updates.at(7).url == "http://example.com/6", "Documents should carry the URL of their WARC record");
+    ASSERT(stats.runs > options.partitions, "Workers should spill more than once under the memory limit");
+    ASSERT(stats.terms == expected.size(), "SST files should hold every term once");
+    ASSERT(sst_files.size() == options.partitions, "Every partition should produce one file");
+
+    // The doc store is written while parsing, before the term files are ingested (as the indexer does)
+    std::string db_path = dir + "/index.db";
+    {
+        std::unique_ptr<rocksdb::DB> new_db = indexer::create_index_db(db_path, options.table);
+        rocksdb::WriteBatch batch;
+        for (const auto& [doc_id, update] : updates) {
+            batch.Put(indexer::doc_key(doc_id), indexer::encode_stored_document(update.url, update.title, update.snippet));
+            batch.Put(indexer::text_key(doc_id), update.text_record);
+        }
+        ASSERT(new_db->Write(rocksdb::WriteOptions(), &batch).ok(), "Doc store should be written");
+        indexer::ingest_sst_files(*new_db, sst_files);
+    }
+    fs::remove_all(options.work_dir);
+
+    rocksdb::Options db_options;
+    db_options.merge_operator = std::make_shared<indexer::PostingAppendOperator>();
+    rocksdb::DB* raw_db = nullptr;
+    ASSERT(rocksdb::DB::Open(db_options, db_path, &raw_db).ok(), "Rebuilt DB should open");
+    std::unique_ptr<rocksdb::DB> db(raw_db);
+    for (const auto& [term, postings] : expected) {
+        std::string value;
+        ASSERT(db->Get(rocksdb::ReadOptions(), term, &value).ok(), "Rebuilt DB should hold every term");
+        auto decoded = indexer::decode_posting_list(value);
+        ASSERT(decoded.size() == postings.size(), "Rebuilt postings should match the builder's: " + term);
+        for (size_t i = 0; i < postings.size(); ++i) {
+            ASSERT(decoded[i].doc_id == postings[i].doc_id && decoded[i].tf == postings[i].tf,
+                   "Rebuilt postings should be sorted by doc_id with the same tf: " + term);
+        }
+    }
+    std::string value;
+    ASSERT(db->Get(rocksdb::ReadOptions(), indexer::doc_key(42), &value).ok(), "Rebuilt DB should hold the doc store");
+    indexer::StoredDocument stored = indexer::decode_stored_document(value);
+    ASSERT(stored.url == "http://example.com/41" && stored.title == "Page 41" && stored.snippet == updates.at(42).snippet,
+           "Doc-store entries should survive ingestion");
+    ASSERT(db->Get(rocksdb::ReadOptions(), indexer::text_key(42), &value).ok(), "Rebuilt DB should hold the text records");
+    indexer::SnippetGenerator generator;
+    std::string text = generator.generate(value, {"unique41"}, 1000);
+    ASSERT(text.rfind(updates.at(42).snippet, 0) == 0 && text.find("unique41") != std::string::npos,
+           "Text records should hold the parsed text: " + text);
+    size_t keys = 0;
+    std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(rocksdb::ReadOptions()));
+    for (it->SeekToFirst(); it->Valid(); it->Next()) ++keys;
+    ASSERT(keys == expected.size() + 2 * updates.size(), "Rebuilt DB should hold nothing else");
+
+    ASSERT(!fs::exists(options.work_dir), "Runs and SST files should not outlive the rebuild");
+    it.reset();
+    db.reset();
+    fs::remove_all(dir);
+    std::cout << "test_rebuild_matches_index_builder passed" << std::endl;
+}
+
+// --- Test: publishing swaps the index path over ---
+void test_publish_index_swaps_symlink() {
+    std::string dir = temp_dir("rebuild_publish");
+    std::string live = dir + "/index.db";
+    fs::create_directories(live);
+    fs::create_directories(dir + "/index.db.rebuild-1");
+    fs::create_directories(dir + "/index.db.rebuild-2");
+
+    std::string previous = indexer::publish_index(live, dir + "/index.db.rebuild-1");
+    ASSERT(previous == live + ".pre-rebuild" && fs::is_directory(previous), "A plain index directory should be moved aside");
+    ASSERT(fs::is_symlink(live) && fs::read_symlink(live) == "index.db.rebuild-1",
+           "The index path should link to its sibling by name");
+
+    previous = indexer::publish_index(live, dir + "/index.db.rebuild-2");
+    ASSERT(previous == dir + "/index.db.rebuild-1", "Republishing should return the previous target");
+    ASSERT(fs::read_symlink(live) == "index.db.rebuild-2", "The link should point at the new index");
+    ASSERT(!fs::exists(fs::symlink_status(live + ".swap")), "No temporary link should be left behind");
+
+    fs::remove_all(dir);
+    std::cout << "test_publish_index_swaps_symlink passed" << std::endl;
+}
+
+// --- Test: doc-store encoding ---
+void test_doc_store_encoding() {
+    std::string value = indexer::encode_stored_document("http://example.com/", "", std::string(300, 'x'));
+    indexer::StoredDocument stored = indexer::decode_stored_document(value);
+    ASSERT(stored.url == "http://example.com/" && stored.title.empty() && stored.snippet == std::string(300, 'x'),
+           "Stored documents should round-trip, empty and multi-byte-length fields included");
+    ASSERT(indexer::doc_key(1) < indexer::doc_key(256) && indexer::doc_key(256) < indexer::doc_key(0x01000000),
+           "Doc keys should sort by doc_id");
+    ASSERT(indexer::doc_key(0) > "zzzz" && indexer::doc_key(0) > "9999", "Doc keys should sort after every term");
+
+    for (const std::string& malformed : {std::string(), std::string("\x02"), value.substr(0, value.size() - 1)}) {
+        bool threw = false;
+        try {
+            indexer::decode_stored_document(malformed);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        ASSERT(threw, "Malformed doc-store values should be rejected");
+    }
+    std::cout << "test_doc_store_encoding passed" << std::endl;
+}
+
+int main() {
+    test_doc_store_encoding();
+    test_rebuild_matches_index_builder();
+    test_publish_index_swaps_symlink();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -1,4 +1,10 @@
 #include "../src/utils.hpp"
+#include "../src/html_text.hpp"
+#include "../src/arena.hpp"
+#include "../src/tokenizer.hpp"
+#include "../src/gzip_decompressor.hpp"
+#include "../src/shard.hpp"
+#include "../src/snippet.hpp"
 #include <iostream>
 #include <cassert>
 #include <vector>
@@ -6,6 +12,7 @@
 #include <gumbo.h>
 #include <sstream>
 #include <zlib.h>
+#include <random>
 
 // Simple assertion macro
 #define ASSERT(condition, message) \
@@ -41,6 +48,65 @@ void test_tokenize_special_chars() {
     std::cout << "test_tokenize_special_chars passed" << std::endl;
 }
 
+// Byte-at-a-time reference: ASCII letters and digits, lowercased, min length 3
+std::vector<std::string> reference_tokenize(const std::string& text) {
+    std::vector<std::string> tokens;
+    std::string token;
+    for (char ch : text) {
+        unsigned char c = static_cast<unsigned char>(ch);
+        bool alnum = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+        if (alnum) {
+            token += static_cast<char>(c >= 'A' && c <= 'Z' ? c + 32 : c);
+        } else {
+            if (token.size() >= 3) tokens.push_back(token);
+            token.clear();
+        }
+    }
+    if (token.size() >= 3) tokens.push_back(token);
+    return tokens;
+}
+
+void test_tokenize_kernels_match_reference() {
+    // Biased towards word characters so that tokens cross the 64-byte word boundaries
+    const std::string alphabet = "abcXYZ019 .-\x80\xC3\xA9@[`{/:";
+    std::mt19937 rng(42);
+    indexer::Tokenizer simd;
+    indexer::Tokenizer scalar(true);
+    for (int trial = 0; trial < 2000; ++trial) {
+        std::string text(rng() % 300, ' ');
+        for (char& c : text) c = rng() % 4 ? alphabet[rng() % 9] : alphabet[rng() % alphabet.size()];
+        std::vector<std::string> expected = reference_tokenize(text);
+        const auto& simd_tokens = simd.tokenize(text);
+        ASSERT(std::vector<std::string>(simd_tokens.begin(), simd_tokens.end()) == expected,
+               std::string(indexer::tokenizer_kernel()) + " kernel should match the reference");
+        const auto& scalar_tokens = scalar.tokenize(text);
+        ASSERT(std::vector<std::string>(scalar_tokens.begin(), scalar_tokens.end()) == expected,
+               "Scalar kernel should match the reference");
+    }
+    ASSERT(simd.tokenize("").empty(), "Empty text has no tokens");
+    ASSERT(simd.tokenize(std::string(64, 'A')).size() == 1, "A token may end exactly at a word boundary");
+    ASSERT(simd.tokenize("caf\xC3\xA9 na\xC3\xAFve").size() == 1, "Non-ASCII bytes separate tokens");
+    std::cout << "test_tokenize_kernels_match_reference passed" << std::endl;
+}
+
+void test_term_counts() {
+    indexer::TermCounts counts;
+    for (int round = 0; round < 2; ++round) {  // The second round reuses the cleared table
+        std::vector<std::string> terms;
+        for (int i = 0; i < 1000; ++i) terms.push_back("term" + std::to_string(i % 300));
+        for (const std::string& term : terms) counts.add(term);
+        ASSERT(counts.size() == 300, "Should count distinct terms");
+        ASSERT(counts.entries()[0].first == "term0", "Entries keep first-occurrence order");
+        for (const auto& [term, tf] : counts.entries()) {
+            uint32_t expected = std::stoi(std::string(term.substr(4))) < 100 ? 4 : 3;
+            ASSERT(tf == expected, "Should count every occurrence");
+        }
+        counts.clear();
+        ASSERT(counts.size() == 0, "Clear should drop every term");
+    }
+    std::cout << "test_term_counts passed" << std::endl;
+}
+
 // --- Test: extract_content ---
 void test_clean_text_simple() {
     const char* html = "<html><body><p>Hello World</p></body></html>";
@@ -82,6 +148,73 @@ void test_extract_title() {
     std::cout << "test_extract_title passed" << std::endl;
 }
 
+void test_clean_text_deep_nesting() {
+    std::string html = "<html><body>";
+    for (int i = 0; i < 20000; ++i) html += "<div>";
+    html += "Deep";
+    // The extractor never calls gumbo_destroy_output, whose recursive teardown would dominate here
+    indexer::HtmlTextExtractor extractor;
+    ASSERT(extractor.extract(html).text.find("Deep") != std::string::npos, "Should extract deeply nested text");
+    std::cout << "test_clean_text_deep_nesting passed" << std::endl;
+}
+
+// --- Test: HtmlTextExtractor ---
+void test_extractor_matches_extract_content() {
+    const char* html = "<html><head><title>My Title</title><script>x()</script></head>"
+                       "<body><p>First</p><p>Second <b>bold</b></p></body></html>";
+    GumboOutput* output = gumbo_parse(html);
+    indexer::ExtractedContent expected = indexer::extract_content(output->root);
+    gumbo_destroy_output(&kGumboDefaultOptions, output);
+
+    indexer::HtmlTextExtractor extractor;
+    for (int i = 0; i < 3; ++i) {  // Reuses the arena and buffers
+        const indexer::ExtractedContent& content = extractor.extract(html);
+        ASSERT(content.text == expected.text, "Arena-backed extraction should match extract_content");
+        ASSERT(content.title == "My Title", "Should extract title");
+    }
+    ASSERT(extractor.extract("<p>Other</p>").title.empty(), "Title should not leak into the next document");
+    std::cout << "test_extractor_matches_extract_content passed" << std::endl;
+}
+
+void test_strip_tags() {
+    indexer::HtmlTextExtractor extractor(indexer::HtmlExtractMode::StripTags);
+    const indexer::ExtractedContent& content = extractor.extract(
+        "<!DOCTYPE html><html><head><TITLE>Fish &amp; Chips</TITLE>"
+        "<style>p{color:red}</style><script>if (a < b) alert('</p>')</script></head>"
+        "<body><!-- <p>hidden</p> --><p class=\"a>b\">one</p><p>two&nbsp;3 &lt; 4 &#233;&#x41;</p>"
+        "a<b>c</b> &bogus; x</body></html>");
+    ASSERT(content.title == "Fish & Chips", "Should extract and decode the title");
+    ASSERT(content.text.find("color") == std::string::npos, "Should not contain style content");
+    ASSERT(content.text.find("alert") == std::string::npos, "Should not contain script content");
+    ASSERT(content.text.find("hidden") == std::string::npos, "Should not contain comments");
+    ASSERT(content.text.find("b\">") == std::string::npos, "Should skip quoted '>' in attributes");
+    ASSERT(content.text.find("one two 3 < 4 \xC3\xA9" "A") != std::string::npos, "Should decode references");
+    ASSERT(content.text.find("a c") != std::string::npos, "Tags should separate words");
+    ASSERT(content.text.find("&bogus;") != std::string::npos, "Unknown references stay literal");
+
+    ASSERT(indexer::parse_html_extract_mode("strip") == indexer::HtmlExtractMode::StripTags, "Should parse 'strip'");
+    bool threw = false;
+    try {
+        indexer::parse_html_extract_mode("sax");
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ASSERT(threw, "Unknown modes should be rejected");
+    std::cout << "test_strip_tags passed" << std::endl;
+}
+
+void test_bump_arena() {
+    indexer::BumpArena arena(1024);
+    void* first = arena.allocate(10);
+    ASSERT(reinterpret_cast<uintptr_t>(first) % alignof(std::max_align_t) == 0, "Allocations should be aligned");
+    for (int i = 0; i < 100; ++i) arena.allocate(100);
+    ASSERT(arena.bytes_used() >= 10100, "Should account every allocation");
+    arena.reset();
+    ASSERT(arena.bytes_used() == 0, "Reset should release everything");
+    ASSERT(arena.bytes_reserved() >= 10100, "Reset should keep one chunk large enough for the last document");
+    std::cout << "test_bump_arena passed" << std::endl;
+}
+
 // --- Test: decompress_gzip ---
 // Helper to compress a string with gzip
 std::string compress_gzip(const std::string& data) {
@@ -133,17 +266,210 @@ void test_decompress_gzip_empty() {
     std::cout << "test_decompress_gzip_empty passed" << std::endl;
 }
 
+void test_gzip_decompressor_reuse() {
+    std::mt19937 rng(7);
+    std::string noisy;
+    for (int i = 0; i < 200000; ++i) noisy.push_back(static_cast<char>('a' + rng() % 26));
+    std::vector<std::string> originals = {"short record", "", noisy, std::string(1 << 20, 'x'), "after the large ones"};
+
+    indexer::GzipDecompressor decompressor;
+    std::string out;
+    for (const std::string& original : originals) {
+        std::string compressed = compress_gzip(original);
+        ASSERT(indexer::gzip_isize(compressed) == original.size(), "ISIZE should be the uncompressed size");
+        size_t consumed = decompressor.decompress(compressed, out);
+        ASSERT(out == original && consumed == compressed.size(), "One decompressor should inflate every member");
+
+        std::string fresh;
+        decompressor.decompress(compressed, fresh);
+        ASSERT(fresh.capacity() < original.size() + 64, "Output should be sized from ISIZE, not grown");
+
+        // Without trusting the trailer, a highly compressible member grows the buffer instead
+        std::string grown;
+        ASSERT(decompressor.decompress(compressed, grown, false) == compressed.size() && grown == original,
+               "Decompressing without a size hint should give the same result");
+    }
+    ASSERT(!indexer::gzip_isize("not gzip at all, just text"), "Non-gzip data has no ISIZE");
+    std::cout << "test_gzip_decompressor_reuse passed" << std::endl;
+}
+
+void test_gzip_decompressor_members_and_buffers() {
+    std::string first = compress_gzip("first member payload");
+    std::string second = compress_gzip("second");
+    indexer::GzipDecompressor decompressor;
+
+    // A segment scan passes the rest of the file: only the first member is inflated
+    std::string out;
+    ASSERT(decompressor.decompress(first + second, out, false) == first.size() && out == "first member payload",
+           "Decompression should stop at the end of the first member");
+
+    char buffer[20];
+    size_t consumed = 0;
+    size_t size = decompressor.decompress(first, buffer, sizeof(buffer), &consumed);
+    ASSERT(size == 20 && std::string(buffer, size) == "first member payload" && consumed == first.size(),
+           "An exactly sized caller buffer should be enough");
+    bool threw = false;
+    try {
+        decompressor.decompress(first, buffer, 10);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT(threw, "A caller buffer that is too small should be an error");
+
+    threw = false;
+    try {
+        decompressor.decompress(std::string_view(first).substr(0, first.size() / 2), out);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT(threw, "A truncated member should be an error");
+    ASSERT(decompressor.decompress(second, out) == second.size() && out == "second", "Errors should not poison the decompressor");
+    std::cout << "test_gzip_decompressor_members_and_buffers passed" << std::endl;
+}
+
+void test_shard_config() {
+    indexer::ShardConfig single = indexer::parse_shard_config("0", "1");
+    ASSERT(single.owns(0) && single.owns(17) && single.queue_key() == "indexing_queue",
+           "A single shard should own every document and keep the original queue");
+
+    indexer::ShardConfig shard = indexer::parse_shard_config("2", "3");
+    ASSERT(shard.owns(2) && shard.owns(5) && !shard.owns(3) && !shard.owns(4), "Documents should be split by doc_id % count");
+    ASSERT(shard.queue_key() == "indexing_queue:2", "Every shard should have its own queue");
+    ASSERT(shard.owner(7).id == 1 && shard.owner(7).count == 3 && shard.owner(7).queue_key() == "indexing_queue:1",
+           "A document of another shard should map to that shard's queue");
+    ASSERT(shard.owner(5).owns(5) && shard.owner(-4).owns(-4), "Every document's owner should own it");
+
+    for (auto [id, count] : {std::pair<const char*, const char*>{"3", "3"}, {"-1", "3"}, {"0", "0"}}) {
+        bool threw = false;
+        try {
+            indexer::parse_shard_config(id, count);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        ASSERT(threw, "Shard IDs outside [0, count) should be rejected");
+    }
+    std::cout << "test_shard_config passed" << std::endl;
+}
+
+// --- Test: snippets ---
+std::string encode_text(indexer::TextRecordWriter& writer, const std::string& text) {
+    indexer::Tokenizer tokenizer;
+    return writer.encode(text, tokenizer.tokenize(text), tokenizer);
+}
+
+void test_snippet_window() {
+    indexer::TextRecordWriter writer;
+    indexer::SnippetGenerator generator;
+    std::string filler;
+    for (int i = 0; i < 40; ++i) filler += "lorem ipsum dolor ";
+    std::string text = "Rust appears early. " + filler + "Here the rust compiler meets the borrow checker. " + filler;
+    std::string record = encode_text(writer, text);
+
+    std::string snippet = generator.generate(record, {"rust", "borrow"}, 80);
+    ASSERT(snippet.find("rust compiler meets the borrow") != std::string::npos,
+           "The window with the most distinct query terms should win: " + snippet);
+    ASSERT(snippet.rfind("... ", 0) == 0 && snippet.size() >= 4 && snippet.compare(snippet.size() - 4, 4, " ...") == 0,
+           "Cut snippets should be marked on both sides: " + snippet);
+    ASSERT(snippet.size() <= 80 + 8, "Snippets should stay within the length, plus markers");
+    ASSERT(snippet.find("... lorem") == 0 || snippet.find("... ipsum") == 0 || snippet.find("... dolor") == 0,
+           "Snippets should start at a word boundary: " + snippet);
+
+    std::string lead = generator.generate(record, {"absent"}, 30);
+    ASSERT(lead.rfind("Rust appears early.", 0) == 0 && lead.compare(lead.size() - 4, 4, " ...") == 0,
+           "Without a query term the snippet should be the start of the text: " + lead);
+
+    std::string whole = generator.generate(encode_text(writer, "short\npage about rust"), {"rust"}, 200);
+    ASSERT(whole == "short page about rust", "Short texts should be returned whole, with whitespace flattened: " + whole);
+    std::cout << "test_snippet_window passed" << std::endl;
+}
+
+void test_snippet_utf8() {
+    // "\xc3\xa9" is a 2-byte character and "\xe2\x82\xac" a 3-byte one
+    ASSERT(indexer::utf8_prefix("caf\xc3\xa9", 4) == "caf", "Prefixes should not split a character");
+    ASSERT(indexer::utf8_prefix("caf\xc3\xa9", 5) == "caf\xc3\xa9", "Whole characters should be kept");
+    ASSERT(indexer::utf8_prefix("\xe2\x82\xac\xe2\x82\xac", 5) == "\xe2\x82\xac", "Prefixes should back up to the lead byte");
+
+    indexer::TextRecordWriter writer;
+    indexer::SnippetGenerator generator;
+    std::string text;
+    for (int i = 0; i < 60; ++i) text += "\xe2\x82\xac\xc3\xa9";  // No spaces to cut at
+    text += "target";
+    for (int i = 0; i < 60; ++i) text += "\xc3\xa9\xe2\x82\xac";
+    std::string record = encode_text(writer, text);
+    for (size_t max_bytes : {20, 21, 22, 23, 24}) {
+        std::string snippet = generator.generate(record, {"target"}, max_bytes);
+        ASSERT(snippet.find("target") != std::string::npos, "The query term should be in the snippet");
+        std::string_view body(snippet);
+        body.remove_prefix(4);
+        body.remove_suffix(4);
+        ASSERT(!body.empty() && (static_cast<unsigned char>(body.front()) & 0xC0) != 0x80,
+               "Snippets should not start inside a character");
+        ASSERT(indexer::utf8_prefix(body, body.size() - 1).size() < body.size() - 1 ||
+                   (static_cast<unsigned char>(body.back()) & 0x80) == 0,
+               "Snippets should not end inside a character");
+    }
+    std::cout << "test_snippet_utf8 passed" << std::endl;
+}
+
+void test_snippet_bounds() {
+    indexer::TextRecordWriter writer;
+    indexer::SnippetGenerator generator;
+
+    // Only the first MAX_POSITIONS_PER_TERM occurrences are kept
+    std::string text;
+    for (size_t i = 0; i < indexer::MAX_POSITIONS_PER_TERM; ++i) text += "spam ";
+    text += std::string(400, 'x') + " spam";
+    std::string snippet = generator.generate(encode_text(writer, text), {"spam"}, 40);
+    ASSERT(snippet.rfind("spam spam", 0) == 0, "Snippets should come from the kept occurrences: " + snippet);
+
+    // Text past MAX_STORED_TEXT_BYTES is dropped, with its positions
+    std::string long_text;
+    while (long_text.size() < indexer::MAX_STORED_TEXT_BYTES) long_text += "filler ";
+    long_text += "needle";
+    std::string record = encode_text(writer, long_text);
+    ASSERT(record.size() < 1024, "Stored text should be compressed");
+    snippet = generator.generate(record, {"needle"}, 50);
+    ASSERT(snippet.find("needle") == std::string::npos && snippet.size() <= 50 + 4,
+           "Terms past the stored prefix should not be found");
+
+    // Malformed records throw
+    record = encode_text(writer, "a page about rust");
+    for (std::string bad : {std::string(), std::string(1, '\x7f') + record.substr(1), record.substr(0, record.size() - 1),
+                            record.substr(0, 3)}) {
+        bool threw = false;
+        try {
+            generator.generate(bad, {"rust"}, 50);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        ASSERT(threw, "Malformed text records should be rejected");
+    }
+    std::cout << "test_snippet_bounds passed" << std::endl;
+}
+
 int main() {
     try {
         test_tokenize_basic();
         test_tokenize_min_length();
         test_tokenize_special_chars();
+        test_tokenize_kernels_match_reference();
+        test_term_counts();
         test_clean_text_simple();
         test_clean_text_ignores_script();
         test_clean_text_ignores_style();
         test_extract_title();
+        test_clean_text_deep_nesting();
+        test_extractor_matches_extract_content();
+        test_strip_tags();
+        test_bump_arena();
         test_decompress_gzip_basic();
         test_decompress_gzip_empty();
+        test_gzip_decompressor_reuse();
+        test_gzip_decompressor_members_and_buffers();
+        test_shard_config();
+        test_snippet_window();
+        test_snippet_utf8();
+        test_snippet_bounds();
         std::cout << "All tests passed!" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Test failed with exception: " << e.what() << std::endl;
@@ -2,7 +2,7 @@
 CREATE TABLE IF NOT EXISTS documents (
     id SERIAL PRIMARY KEY,
     url TEXT UNIQUE NOT NULL,
-    status VARCHAR(20) DEFAULT 'pending', -- pending, crawled, error
+    status VARCHAR(20) DEFAULT 'pending', -- pending, processing, crawled, crawled_not_queued, duplicate, error
     crawled_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
     file_path TEXT, -- Path in shared volume
     "offset" BIGINT, -- Byte offset in the file
@@ -10,8 +10,13 @@ CREATE TABLE IF NOT EXISTS documents (
     doc_length INT DEFAULT 0, -- Number of words in the document
     title TEXT, -- Page title extracted from HTML
     snippet TEXT, -- Short text preview (first ~200 chars)
-    content_hash VARCHAR(64) -- To detect duplicates
+    content_hash VARCHAR(64), -- Hex "<exact hash>:<simhash>" (or "<exact hash>" for short pages), to detect duplicates
+    claimed_by TEXT -- CRAWLER_ID of the crawler that claimed the URL; on restart it recovers only its own 'processing' rows
 );
 
+-- Migration for databases created before claimed_by
+ALTER TABLE documents ADD COLUMN IF NOT EXISTS claimed_by TEXT;
+
 CREATE INDEX idx_url ON documents(url);
-CREATE INDEX idx_status ON documents(status);
\ No newline at end of file
+CREATE INDEX idx_status ON documents(status);
+CREATE INDEX IF NOT EXISTS idx_processing_claims ON documents(claimed_by) WHERE status = 'processing';
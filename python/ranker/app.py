@@ -1,49 +1,99 @@
 from flask import Flask, jsonify, request
 from engine import Ranker
+from coordinator import ShardCoordinator
+import os
 import time
 import atexit
 
 app = Flask(__name__)
 
+# Comma-separated base URLs of the shard rankers (e.g. "http://ranker_shard0:5000,http://ranker_shard1:5000").
+# If set, this process is the coordinator: it serves /search by fanning out to them and opens no index itself.
+RANKER_SHARDS = [url.strip() for url in os.environ.get("RANKER_SHARDS", "").split(",") if url.strip()]
+SHARD_TIMEOUT_SECONDS = float(os.environ.get("SHARD_TIMEOUT_SECONDS", "2"))
+
 # Initialize Ranker (Global Singleton)
 ranker = None
-try:
-    ranker = Ranker()
-    atexit.register(ranker.close)
-except Exception as e:
-    print(f"Failed to initialize Ranker: {e}")
+coordinator = None
+if RANKER_SHARDS:
+    coordinator = ShardCoordinator(RANKER_SHARDS, SHARD_TIMEOUT_SECONDS)
+    atexit.register(coordinator.close)
+    print(f"Coordinating {len(RANKER_SHARDS)} shards: {', '.join(RANKER_SHARDS)}")
+else:
+    try:
+        ranker = Ranker()
+        atexit.register(ranker.close)
+    except Exception as e:
+        print(f"Failed to initialize Ranker: {e}")
 
 @app.route('/health')
 def health():
+    if coordinator:
+        shards = coordinator.health()
+        healthy = all(shard and shard.get("status") == "healthy" for shard in shards.values())
+        return jsonify({"status": "healthy" if healthy else "degraded", "service": "coordinator", "shards": shards})
+
     status = "healthy" if ranker else "degraded"
-    return jsonify({"status": status, "service": "ranker"})
+    body = {"status": status, "service": "ranker"}
+    if ranker:
+        body["block_cache"] = ranker.cache_stats()
+        body["query_cache"] = ranker.query_cache_stats()
+        body["index_generation"] = ranker.index_generation()
+    return jsonify(body)
 
-@app.route('/search')
-def search():
+def get_ranker():
     global ranker
     if not ranker:
         # Fallback for dev/restart if before_first_request didn't fire or failed
-        try:
-            ranker = Ranker()
-        except Exception as e:
-            return jsonify({"error": f"Ranker not initialized: {str(e)}"}), 500
+        ranker = Ranker()
+    return ranker
 
+@app.route('/search')
+def search():
     query = request.args.get('q', '').lower()
     print(f"Received query: {query}")
-    
+
     start_time = time.time()
-    results = ranker.search(query)
+    meta = {}
+    if coordinator:
+        results, failed = coordinator.search(query)
+        meta["shards"] = len(RANKER_SHARDS)
+        if failed:
+            meta["failed_shards"] = failed
+    else:
+        try:
+            results = get_ranker().search(query)
+        except Exception as e:
+            return jsonify({"error": f"Ranker not initialized: {str(e)}"}), 500
     duration_ms = (time.time() - start_time) * 1000
-    
+
+    meta["count"] = len(results)
+    meta["latency_ms"] = round(duration_ms, 2)
     return jsonify({
-        "query": query, 
+        "query": query,
         "results": results,
-        "meta": {
-            "count": len(results),
-            "latency_ms": round(duration_ms, 2)
-        }
+        "meta": meta
     })
 
+# --- Shard endpoints, called by the coordinator ---
+
+@app.route('/shard/term_stats', methods=['POST'])
+def shard_term_stats():
+    body = request.get_json(force=True)
+    try:
+        return jsonify(get_ranker().term_stats(body.get("tokens", [])))
+    except Exception as e:
+        return jsonify({"error": str(e)}), 500
+
+@app.route('/shard/search', methods=['POST'])
+def shard_search():
+    body = request.get_json(force=True)
+    try:
+        results = get_ranker().search(body.get("tokens", []), int(body.get("k", 10)), body.get("corpus"))
+    except Exception as e:
+        return jsonify({"error": str(e)}), 500
+    return jsonify({"results": results})
+
 if __name__ == '__main__':
     # host='0.0.0.0' is CRITICAL for Docker networking
-    app.run(host='0.0.0.0', port=5000, debug=True)
\ No newline at end of file
+    app.run(host='0.0.0.0', port=5000, debug=True)
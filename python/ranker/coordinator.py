@@ -0,0 +1,102 @@
+import heapq
+import json
+import urllib.request
+from concurrent.futures import ThreadPoolExecutor
+
+from engine import tokenize
+
+
+class ShardCoordinator:
+    """
+    Scatter-gather search over document-partitioned index shards, each served by its own ranker
+    (the indexer of shard i indexes doc_id % N == i).
+
+    A query runs in two rounds: every shard reports its share of the corpus statistics for the query
+    terms, then every shard scores its documents with the summed totals, so a document gets the same
+    BM25 score it would in one unsharded index. The per-shard top-k lists are merged into the global top-k.
+    """
+
+    def __init__(self, shard_urls, timeout_seconds=2.0):
+        if not shard_urls:
+            raise ValueError("At least one shard URL is required")
+        self.shard_urls = [url.rstrip("/") for url in shard_urls]
+        self.timeout_seconds = timeout_seconds
+        self.pool = ThreadPoolExecutor(max_workers=2 * len(self.shard_urls), thread_name_prefix="shard")
+
+    def _post(self, url, path, payload):
+        request = urllib.request.Request(url + path, data=json.dumps(payload).encode("utf-8"),
+                                         headers={"Content-Type": "application/json"})
+        with urllib.request.urlopen(request, timeout=self.timeout_seconds) as response:
+            return json.loads(response.read())
+
+    def _fan_out(self, urls, path, payload):
+        """
+        POSTs `payload` to every shard in parallel. Returns {url: response} for those that answered,
+        and the URLs of those that failed or timed out.
+        """
+        futures = {url: self.pool.submit(self._post, url, path, payload) for url in urls}
+        answers, failed = {}, []
+        for url, future in futures.items():
+            try:
+                answers[url] = future.result()
+            except Exception as e:
+                print(f"Shard {url} failed on {path}: {e}")
+                failed.append(url)
+        return answers, failed
+
+    @staticmethod
+    def merge_corpus_stats(stats):
+        """Sums per-shard term_stats() into the corpus totals every shard scores with."""
+        corpus = {"total_docs": 0, "total_length": 0, "doc_freqs": {}}
+        for shard in stats:
+            corpus["total_docs"] += shard["total_docs"]
+            corpus["total_length"] += shard["total_length"]
+            for token, n in shard["doc_freqs"].items():
+                corpus["doc_freqs"][token] = corpus["doc_freqs"].get(token, 0) + n
+        return corpus
+
+    @staticmethod
+    def merge_top_k(result_lists, k):
+        """The k best of the per-shard top-k lists, highest score first (ties broken by lower doc id)."""
+        return heapq.nlargest(k, (r for results in result_lists for r in results),
+                              key=lambda r: (r["score"], -r["id"]))
+
+    def search(self, query, k=10):
+        """
+        Returns (results, failed_shard_urls). Shards that fail are left out, so results are
+        partial (but still scored consistently among the shards that answered).
+        """
+        tokens = tokenize(query)
+        if not tokens:
+            return [], []
+
+        urls = self.shard_urls
+        failed = []
+        corpus = None
+        # With one shard its own statistics are the global ones
+        if len(urls) > 1:
+            stats, failed = self._fan_out(urls, "/shard/term_stats", {"tokens": tokens})
+            urls = [url for url in urls if url in stats]
+            corpus = self.merge_corpus_stats(stats.values())
+
+        answers, search_failed = self._fan_out(urls, "/shard/search", {"tokens": tokens, "k": k, "corpus": corpus})
+        failed += search_failed
+        return self.merge_top_k([answer["results"] for answer in answers.values()], k), failed
+
+    def health(self):
+        """Per-shard /health bodies, None for shards that are unreachable."""
+        def get(url):
+            with urllib.request.urlopen(url + "/health", timeout=self.timeout_seconds) as response:
+                return json.loads(response.read())
+
+        futures = {url: self.pool.submit(get, url) for url in self.shard_urls}
+        health = {}
+        for url, future in futures.items():
+            try:
+                health[url] = future.result()
+            except Exception:
+                health[url] = None
+        return health
+
+    def close(self):
+        self.pool.shutdown(wait=False)
@@ -12,6 +12,35 @@ except ImportError:
     ROCKSDB_AVAILABLE = False
     print("WARNING: rocksdb_client extension not available. Using Mock Index.")
 
+# Document lengths and corpus totals maintained by the indexer, mapped by the native scorer
+DOC_STATS_PATH = os.environ.get("DOC_STATS_PATH", "/shared_data/doc_stats.bin")
+# RocksDB read tuning: block cache size and type ("lru" or "clock"), SST bloom filter bits per key,
+# pinning of L0 index/filter blocks, and mmap reads
+ROCKSDB_BLOCK_CACHE_MB = int(os.environ.get("ROCKSDB_BLOCK_CACHE_MB", "256"))
+ROCKSDB_CACHE_TYPE = os.environ.get("ROCKSDB_CACHE_TYPE", "lru")
+ROCKSDB_BLOOM_BITS = int(os.environ.get("ROCKSDB_BLOOM_BITS", "10"))
+ROCKSDB_PIN_L0 = os.environ.get("ROCKSDB_PIN_L0", "1") == "1"
+ROCKSDB_MMAP_READS = os.environ.get("ROCKSDB_MMAP_READS", "0") == "1"
+# Follow the indexer as a RocksDB secondary instance, catching up every N seconds (0: read-only snapshot)
+ROCKSDB_REFRESH_SECONDS = float(os.environ.get("ROCKSDB_REFRESH_SECONDS", "5"))
+ROCKSDB_SECONDARY_PATH = os.environ.get("ROCKSDB_SECONDARY_PATH", "/tmp/ranker_secondary")
+# Top-k evaluation of the native scorer: "bmw" (Block-Max WAND), "wand" or "exhaustive" (reference)
+QUERY_ALGORITHM = os.environ.get("QUERY_ALGORITHM", "bmw")
+# Ranker-side caches of parsed posting lists and of top-k results, both dropped when the index changes
+POSTING_CACHE_MB = int(os.environ.get("POSTING_CACHE_MB", "64"))
+RESULT_CACHE_MB = int(os.environ.get("RESULT_CACHE_MB", "16"))
+
+def tokenize(query):
+    """
+    Query terms, preprocessed to match the Indexer:
+    1. Lowercase
+    2. Remove non-alphanumeric (keep spaces)
+    3. Split by whitespace
+    4. Filter length >= 3
+    """
+    query_clean = re.sub(r'[^a-z0-9\s]', '', query.lower())
+    return [t for t in query_clean.split() if len(t) >= 3]
+
 class Ranker:
     def __init__(self):
         # 1. Connect to Postgres (Metadata)
@@ -42,21 +71,41 @@ class Ranker:
         if ROCKSDB_AVAILABLE:
             try:
                 # We only need read access
-                self.index_db = RocksDBReader(rocksdb_path)
+                self.index_db = RocksDBReader(
+                    rocksdb_path,
+                    DOC_STATS_PATH,
+                    block_cache_mb=ROCKSDB_BLOCK_CACHE_MB,
+                    cache_type=ROCKSDB_CACHE_TYPE,
+                    bloom_bits_per_key=ROCKSDB_BLOOM_BITS,
+                    pin_l0=ROCKSDB_PIN_L0,
+                    mmap_reads=ROCKSDB_MMAP_READS,
+                    refresh_seconds=ROCKSDB_REFRESH_SECONDS,
+                    secondary_path=ROCKSDB_SECONDARY_PATH,
+                    posting_cache_mb=POSTING_CACHE_MB,
+                    result_cache_mb=RESULT_CACHE_MB
+                )
                 print(f"Opened RocksDB at {rocksdb_path}")
             except Exception as e:
                 print(f"Failed to open RocksDB: {e}")
         
-        # Mock Index for fallback
+        # Mock Index for fallback: token -> [(doc_id, tf)]
         self.mock_index = {
-            "computer": "1,2",
-            "cats": "3,4"
+            "computer": [(1, 2), (2, 1)],
+            "cats": [(3, 1), (4, 3)]
         }
         
-        # 3. Load Global Stats (avgdl, total_docs)
-        self.avgdl = self._calculate_avgdl()
-        self.total_docs = self._get_total_docs()
-        print(f"Ranker initialized. AvgDL: {self.avgdl}, Total Docs: {self.total_docs}")
+        # 3. Global Stats (avgdl, total_docs): the native scorer reads them live from the doc-stats
+        # file; only the mock index needs them from Postgres
+        if self.index_db:
+            totals = self.index_db.doc_stats_totals()
+            if totals:
+                print(f"Ranker initialized. AvgDL: {totals['avgdl']}, Total Docs: {totals['total_docs']}")
+            else:
+                print(f"Ranker initialized. Doc stats not found at {DOC_STATS_PATH} yet")
+        else:
+            self.avgdl = self._calculate_avgdl()
+            self.total_docs = self._get_total_docs()
+            print(f"Ranker initialized. AvgDL: {self.avgdl}, Total Docs: {self.total_docs}")
 
     def _calculate_avgdl(self):
         if not self.db_conn:
@@ -110,131 +159,131 @@ class Ranker:
             print(f"Error fetching doc lengths: {e}")
         return lengths
 
-    def search(self, query, k=10):
+    def _get_stored_metadata(self, doc_ids, tokens=()):
         """
-        Performs BM25 search for the given query.
-        Returns top k results: [{'url': ..., 'title': ..., 'score': ...}]
+        url/title/snippet of `doc_ids` from the indexer's doc store, in one MultiGet, with snippets
+        around the query `tokens` where the document's text is stored.
+        Returns {doc_id: {'url', 'title', 'snippet'}}, without the documents that have no entry.
         """
-        # Preprocessing to match Indexer:
-        # 1. Lowercase
-        # 2. Remove non-alphanumeric (keep spaces)
-        # 3. Split by whitespace
-        # 4. Filter length >= 3
-        
-        query_clean = re.sub(r'[^a-z0-9\s]', '', query.lower())
-        tokens = [t for t in query_clean.split() if len(t) >= 3]
-        
-        if not tokens:
-            return []
+        if not self.index_db:
+            return {}
+        meta_map = {}
+        try:
+            for doc_id, stored in zip(doc_ids, self.index_db.get_documents(doc_ids, list(tokens))):
+                if stored is not None:
+                    url, title, snippet = (field.decode("utf-8", errors="replace") for field in stored)
+                    meta_map[doc_id] = {'url': url, 'title': title, 'snippet': snippet}
+        except Exception as e:
+            print(f"Error reading doc store: {e}")
+        return meta_map
+
+    def _get_postgres_metadata(self, doc_ids):
+        """Same as _get_stored_metadata(), from Postgres."""
+        if not self.db_conn:
+            return {}
+        try:
+            with self.db_conn.cursor() as cur:
+                # Fetch all metadata in one query
+                if len(doc_ids) == 1:
+                    query = "SELECT id, url, title, snippet FROM documents WHERE id = %s"
+                    params = (doc_ids[0],)
+                else:
+                    query = "SELECT id, url, title, snippet FROM documents WHERE id IN %s"
+                    params = (tuple(doc_ids),)
+
+                cur.execute(query, params)
+                return {r[0]: {'url': r[1], 'title': r[2], 'snippet': r[3]} for r in cur.fetchall()}
+        except Exception as e:
+            print(f"Error fetching metadata: {e}")
+            return {}
 
-        # BM25 Constants
+    def _search_mock(self, tokens, k, corpus=None):
+        """
+        Pure-Python BM25 over the mock index, for running without the extension.
+        Returns [(doc_id, score)] sorted by score.
+        """
         k1 = 1.5
         b = 0.75
-        
-        # Accumulate scores: doc_id -> score
-        scores = defaultdict(float)
-        
-        # 1. Retrieve all posting lists and candidate docs
-        token_postings = {} # token -> [doc_ids]
-        candidate_doc_ids = set()
+        token_postings = {t: self.mock_index[t] for t in tokens if t in self.mock_index}
+        doc_lengths = self._get_doc_lengths(list({d for p in token_postings.values() for d, _ in p}))
+        N = self.total_docs or 1
+        avgdl = self.avgdl
+        if corpus:
+            N = corpus["total_docs"]
+            avgdl = corpus["total_length"] / N
 
+        scores = defaultdict(float)
         for token in tokens:
-            # A. Get Posting List from RocksDB or Mock
-            postings_str = None
-            
-            if self.index_db:
-                try:
-                    val = self.index_db.get(token.encode('utf-8'))
-                    if val:
-                        postings_str = val.decode('utf-8')
-                except Exception as e:
-                    print(f"Error fetching token {token}: {e}")
-            else:
-                # Fallback to mock
-                postings_str = self.mock_index.get(token)
+            postings = token_postings.get(token, [])
+            n_qi = corpus["doc_freqs"].get(token, 0) if corpus else len(postings)
+            idf = np.log((N - n_qi + 0.5) / (n_qi + 0.5) + 1)
+            for doc_id, tf in postings:
+                doc_len = doc_lengths.get(doc_id) or avgdl
+                scores[doc_id] += idf * tf * (k1 + 1) / (tf + k1 * (1 - b + b * (doc_len / avgdl)))
+        return sorted(scores.items(), key=lambda item: (-item[1], item[0]))[:k]
 
-            if not postings_str:
-                continue
-                
-            # Format: "doc_id1,doc_id2,..." (Simplified for now, ideally should have TF)
-            # For this phase, we assume TF=1 for all occurrences in the simplified index
-            if isinstance(postings_str, bytes):
-                postings_str = postings_str.decode('utf-8')
-            
-            doc_ids = [int(d) for d in postings_str.split(',')]
-            token_postings[token] = doc_ids
-            candidate_doc_ids.update(doc_ids)
+    def term_stats(self, tokens):
+        """
+        This shard's share of the corpus statistics BM25 needs for `tokens`:
+        {'total_docs': ..., 'total_length': ..., 'doc_freqs': {token: n}}. A coordinator sums them
+        over every shard and passes the totals back to search() so scores are comparable.
+        """
+        if self.index_db:
+            return self.index_db.term_stats(tokens)
+        total_docs = self.total_docs or 1
+        return {
+            "total_docs": total_docs,
+            "total_length": int(self.avgdl * total_docs),
+            "doc_freqs": {t: len(self.mock_index.get(t, [])) for t in tokens}
+        }
 
-        if not candidate_doc_ids:
+    def search(self, query, k=10, corpus=None):
+        """
+        Performs BM25 search for the given query (a string, or tokens from tokenize()).
+        With `corpus` (summed term_stats() of every shard), IDF and avgdl are global instead of this shard's.
+        Returns top k results: [{'url': ..., 'title': ..., 'score': ...}]
+        """
+        tokens = tokenize(query) if isinstance(query, str) else list(query)
+        
+        if not tokens:
             return []
+        if corpus and corpus.get("total_docs", 0) <= 0:
+            corpus = None  # Empty corpus: nothing global to score against
 
-        # 2. Batch fetch document lengths
-        doc_lengths = self._get_doc_lengths(list(candidate_doc_ids))
-
-        # 3. Calculate BM25 Scores
-        for token in tokens:
-            doc_ids = token_postings.get(token, [])
-            if not doc_ids:
-                continue
-
-            # Calculate IDF
-            # IDF(q_i) = log( (N - n(q_i) + 0.5) / (n(q_i) + 0.5) + 1 )
-            N = self.total_docs
-            if N == 0: N = 1 # Avoid division by zero issues if DB is empty
-            
-            n_qi = len(doc_ids)
-            idf = np.log((N - n_qi + 0.5) / (n_qi + 0.5) + 1)
-            
-            for doc_id in doc_ids:
-                # TODO: Fetch real TF from index. Currently index only stores doc_ids.
-                # We assume TF=1 for now.
-                tf = 1 
-                
-                # Get doc_len, fallback to avgdl if missing (e.g. sync issue)
-                doc_len = doc_lengths.get(doc_id, self.avgdl)
-                if doc_len is None or doc_len == 0:
-                    doc_len = self.avgdl # Safety fallback
-                
-                # BM25 Score for this term
-                numerator = idf * tf * (k1 + 1)
-                denominator = tf + k1 * (1 - b + b * (doc_len / self.avgdl))
-                scores[doc_id] += numerator / denominator
-
-        # Sort by score
-        sorted_docs = sorted(scores.items(), key=lambda item: item[1], reverse=True)[:k]
-        
-        # Fetch Metadata for top results
-        results = []
-        if self.db_conn and sorted_docs:
+        # 1. Score: BM25 and top-k selection run in the native extension
+        if self.index_db:
             try:
-                top_doc_ids = [doc_id for doc_id, _ in sorted_docs]
-                with self.db_conn.cursor() as cur:
-                    # Fetch all metadata in one query
-                    if len(top_doc_ids) == 1:
-                        query = "SELECT id, url, title, snippet FROM documents WHERE id = %s"
-                        params = (top_doc_ids[0],)
-                    else:
-                        query = "SELECT id, url, title, snippet FROM documents WHERE id IN %s"
-                        params = (tuple(top_doc_ids),)
-                    
-                    cur.execute(query, params)
-                    rows = cur.fetchall()
-                    
-                    # Create a lookup map
-                    meta_map = {r[0]: {'url': r[1], 'title': r[2], 'snippet': r[3]} for r in rows}
-                    
-                    for doc_id, score in sorted_docs:
-                        if doc_id in meta_map:
-                            meta = meta_map[doc_id]
-                            results.append({
-                                "id": doc_id,
-                                "url": meta['url'],
-                                "score": score,
-                                "title": meta['title'] if meta['title'] else meta['url'], # Fallback to URL if title is missing
-                                "snippet": meta['snippet'] if meta['snippet'] else "No preview available."
-                            })
+                if corpus:
+                    sorted_docs = self.index_db.search(tokens, k, QUERY_ALGORITHM, corpus["total_docs"],
+                                                       corpus["total_length"], corpus["doc_freqs"])
+                else:
+                    sorted_docs = self.index_db.search(tokens, k, QUERY_ALGORITHM)
             except Exception as e:
-                print(f"Error fetching metadata: {e}")
+                print(f"Error searching index: {e}")
+                return []
+        else:
+            sorted_docs = self._search_mock(tokens, k, corpus)
+        
+        # 2. Fetch Metadata for top results: one MultiGet on the doc store, Postgres only for
+        #    documents indexed before the doc store existed
+        results = []
+        if (self.index_db or self.db_conn) and sorted_docs:
+            top_doc_ids = [doc_id for doc_id, _ in sorted_docs]
+            meta_map = self._get_stored_metadata(top_doc_ids, tokens)
+            missing = [doc_id for doc_id in top_doc_ids if doc_id not in meta_map]
+            if missing:
+                meta_map.update(self._get_postgres_metadata(missing))
+
+            for doc_id, score in sorted_docs:
+                if doc_id in meta_map:
+                    meta = meta_map[doc_id]
+                    results.append({
+                        "id": doc_id,
+                        "url": meta['url'],
+                        "score": score,
+                        "title": meta['title'] if meta['title'] else meta['url'], # Fallback to URL if title is missing
+                        "snippet": meta['snippet'] if meta['snippet'] else "No preview available."
+                    })
         else:
             # Fallback if DB is down or no results
             for doc_id, score in sorted_docs:
@@ -248,6 +297,28 @@ class Ranker:
                     
         return results
 
+    def cache_stats(self):
+        """Block cache usage of the index, or None without the native reader."""
+        if not self.index_db:
+            return None
+        try:
+            return self.index_db.cache_stats()
+        except Exception as e:
+            print(f"Error reading cache stats: {e}")
+            return None
+
+    def query_cache_stats(self):
+        """Hit/miss counters of the posting-list and result caches, or None without the native reader."""
+        if not self.index_db:
+            return None
+        return self.index_db.query_cache_stats()
+
+    def index_generation(self):
+        """Changes whenever a refresh makes new index data visible; None without the native reader."""
+        if not self.index_db:
+            return None
+        return self.index_db.generation()
+
     def close(self):
         """Closes the database connection."""
         if self.index_db:
@@ -0,0 +1,160 @@
+#include "live_index.hpp"
+#include "posting_merge_operator.hpp"
+
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+
+namespace ranker {
+
+namespace {
+
+// Where `path` points right now; the path itself if it cannot be resolved (e.g. mid-swap)
+std::string resolve(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::path resolved = std::filesystem::canonical(path, ec);
+    return ec ? path : resolved.string();
+}
+
+uint64_t read_version(rocksdb::DB& db) {
+    uint64_t version = 0;
+    if (db.GetIntProperty("rocksdb.current-super-version-number", &version)) return version;
+    return db.GetLatestSequenceNumber();
+}
+
+} // namespace
+
+std::vector<std::optional<std::string>> read_values(const IndexSnapshot& snapshot,
+                                                    const std::vector<std::string>& keys) {
+    std::vector<std::optional<std::string>> result(keys.size());
+    if (!snapshot.db || keys.empty()) return result;
+
+    std::vector<rocksdb::Slice> slices(keys.begin(), keys.end());
+    std::vector<std::string> values;
+    std::vector<rocksdb::Status> statuses = snapshot.db->MultiGet(rocksdb::ReadOptions(), slices, &values);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (statuses[i].IsNotFound()) continue;
+        if (!statuses[i].ok()) {
+            throw std::runtime_error("Error reading key: " + statuses[i].ToString());
+        }
+        result[i] = std::move(values[i]);
+    }
+    return result;
+}
+
+LiveIndex::LiveIndex(LiveIndexOptions options) : options(std::move(options)) {
+    // Posting lists may still be pending merge operands written by the indexer
+    db_options.merge_operator = std::make_shared<indexer::PostingAppendOperator>();
+    // One cache for every instance this reader opens, so a swap starts warm for unchanged files
+    block_cache_ = indexer::apply_index_table_config(db_options, this->options.table);
+    db_options.allow_mmap_reads = this->options.mmap_reads;
+    db_options.max_open_files = -1;  // Required for secondary instances
+
+    opened_path = resolve(this->options.path);
+    db = open(opened_path);
+    version = read_version(*db);
+
+    if (this->options.refresh_interval.count() > 0) {
+        refresher = std::thread(&LiveIndex::refresh_loop, this);
+    }
+}
+
+LiveIndex::~LiveIndex() {
+    close();
+}
+
+std::shared_ptr<rocksdb::DB> LiveIndex::open(const std::string& resolved_path) {
+    rocksdb::DB* raw = nullptr;
+    rocksdb::Status status;
+    if (options.refresh_interval.count() > 0) {
+        // Each target needs its own secondary directory; name it after the target
+        std::string secondary = options.secondary_path + "/" + std::filesystem::path(resolved_path).filename().string();
+        std::error_code ec;
+        std::filesystem::create_directories(secondary, ec);
+        status = rocksdb::DB::OpenAsSecondary(db_options, resolved_path, secondary, &raw);
+    } else {
+        status = rocksdb::DB::OpenForReadOnly(db_options, resolved_path, &raw);
+    }
+    if (!status.ok()) {
+        throw std::runtime_error("Failed to open RocksDB at " + resolved_path + ": " + status.ToString());
+    }
+    return std::shared_ptr<rocksdb::DB>(raw);
+}
+
+IndexSnapshot LiveIndex::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return {db, generation()};
+}
+
+bool LiveIndex::refresh() {
+    std::lock_guard<std::mutex> refresh_lock(refresh_mutex);
+
+    std::shared_ptr<rocksdb::DB> current;
+    std::string current_path;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = db;
+        current_path = opened_path;
+    }
+    if (!current) return false;
+
+    // A rebuilt index was published by repointing the symlink: swap in the new DB
+    std::string resolved = resolve(options.path);
+    if (resolved != current_path) {
+        std::shared_ptr<rocksdb::DB> next = open(resolved);
+        uint64_t next_version = read_version(*next);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!db) return false;  // Closed meanwhile
+            db = std::move(next);
+            opened_path = resolved;
+            version = next_version;
+        }
+        generation_.fetch_add(1, std::memory_order_acq_rel);
+        std::cout << "Switched index to " << resolved << std::endl;
+        return true;
+    }
+
+    if (options.refresh_interval.count() == 0) return false;  // Read-only instances cannot catch up
+
+    rocksdb::Status status = current->TryCatchUpWithPrimary();
+    if (!status.ok()) {
+        throw std::runtime_error("Failed to catch up with the indexer: " + status.ToString());
+    }
+    uint64_t current_version = read_version(*current);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (db != current || current_version == version) return false;
+        version = current_version;
+    }
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    return true;
+}
+
+void LiveIndex::refresh_loop() {
+    std::unique_lock<std::mutex> lock(stop_mutex);
+    while (!stop_cv.wait_for(lock, options.refresh_interval, [this] { return stopping; })) {
+        lock.unlock();
+        try {
+            refresh();
+        } catch (const std::exception& e) {
+            std::cerr << "Index refresh failed: " << e.what() << std::endl;
+        }
+        lock.lock();
+    }
+}
+
+void LiveIndex::close() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex);
+        stopping = true;
+    }
+    stop_cv.notify_all();
+    if (refresher.joinable()) refresher.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    db.reset();
+}
+
+} // namespace ranker
@@ -0,0 +1,91 @@
+#ifndef RANKER_LIVE_INDEX_HPP
+#define RANKER_LIVE_INDEX_HPP
+
+#include "index_options.hpp"
+
+#include <rocksdb/db.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ranker {
+
+struct LiveIndexOptions {
+    std::string path;                   // The indexer's DB directory (or a symlink to it)
+    std::string secondary_path;         // Scratch directory of the secondary instance
+    std::chrono::milliseconds refresh_interval{0};  // 0: open read-only and never refresh
+    indexer::IndexTableConfig table;
+    bool mmap_reads = false;
+};
+
+// The DB as one query sees it. Holding it keeps that instance open even if a refresh
+// swaps in a new one meanwhile.
+struct IndexSnapshot {
+    std::shared_ptr<rocksdb::DB> db;  // Null once the index is closed
+    uint64_t generation = 0;
+};
+
+// Values of `keys` in `snapshot`, read in one MultiGet; nullopt for missing keys, all of them once
+// the index is closed. Throws std::runtime_error on a read error.
+std::vector<std::optional<std::string>> read_values(const IndexSnapshot& snapshot,
+                                                    const std::vector<std::string>& keys);
+
+// Read side of the index DB that follows the indexer while it runs.
+//
+// With a refresh interval, the DB is opened as a RocksDB secondary instance and a background
+// thread calls TryCatchUpWithPrimary() periodically. If `path` is a symlink that has been
+// repointed (a rebuilt index was published), the new target is opened and atomically swapped in.
+// Queries running on the old instance finish on it; it is closed when the last one drops it.
+// Every change that can alter query results bumps generation(). All methods are thread-safe.
+class LiveIndex {
+public:
+    // Throws std::runtime_error if the DB cannot be opened.
+    explicit LiveIndex(LiveIndexOptions options);
+    ~LiveIndex();
+
+    LiveIndex(const LiveIndex&) = delete;
+    LiveIndex& operator=(const LiveIndex&) = delete;
+
+    IndexSnapshot snapshot() const;
+    uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
+    const std::shared_ptr<rocksdb::Cache>& block_cache() const { return block_cache_; }
+
+    // Catches up with the primary and picks up a repointed symlink. Returns true if the view changed.
+    // Throws std::runtime_error if either fails; the current view stays in place.
+    bool refresh();
+
+    // Stops refreshing and releases the DB (in-flight queries keep theirs until they finish).
+    void close();
+
+private:
+    std::shared_ptr<rocksdb::DB> open(const std::string& resolved_path);
+    void refresh_loop();
+
+    LiveIndexOptions options;
+    rocksdb::Options db_options;
+    std::shared_ptr<rocksdb::Cache> block_cache_;
+
+    mutable std::mutex mutex;  // Guards db, opened_path and version
+    std::shared_ptr<rocksdb::DB> db;
+    std::string opened_path;  // Resolved target of options.path
+    uint64_t version = 0;     // Super version of `db` last seen; changes on every flush, compaction or catch-up
+    std::atomic<uint64_t> generation_{1};
+
+    std::mutex refresh_mutex;  // Serializes refresh() calls
+    std::mutex stop_mutex;
+    std::condition_variable stop_cv;
+    bool stopping = false;
+    std::thread refresher;
+};
+
+} // namespace ranker
+
+#endif // RANKER_LIVE_INDEX_HPP
@@ -0,0 +1,151 @@
+"""
+Replays a query log against a ranker's (or coordinator's) /search and reports latency percentiles and QPS.
+
+The log is JSON Lines, one query per line as {"q": "..."} or {"query": "..."}; lines that are not
+JSON objects are taken as the query text itself. Queries are sent in log order by `--concurrency`
+closed-loop workers (each sends its next query as soon as the previous answer arrives).
+
+    python loadtest.py queries.jsonl --url http://localhost:5000 --concurrency 8 --duration 30
+"""
+import argparse
+import json
+import math
+import sys
+import threading
+import time
+import urllib.error
+import urllib.parse
+import urllib.request
+
+
+def load_queries(path):
+    queries = []
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            try:
+                entry = json.loads(line)
+            except ValueError:
+                entry = line
+            if isinstance(entry, dict):
+                entry = entry.get("q", entry.get("query"))
+            if isinstance(entry, str) and entry.strip():
+                queries.append(entry.strip())
+    return queries
+
+
+def percentile(sorted_values, p):
+    """Nearest-rank percentile of an ascending list."""
+    if not sorted_values:
+        return 0.0
+    rank = max(1, min(len(sorted_values), math.ceil(p / 100.0 * len(sorted_values))))
+    return sorted_values[rank - 1]
+
+
+class LoadTest:
+    def __init__(self, url, queries, timeout_seconds):
+        self.url = url.rstrip("/") + "/search?q="
+        self.queries = queries
+        self.timeout_seconds = timeout_seconds
+        self.lock = threading.Lock()
+        self.next_query = 0
+        self.latencies_ms = []
+        self.errors = 0
+
+    def _take(self, limit):
+        with self.lock:
+            if limit is not None and self.next_query >= limit:
+                return None
+            query = self.queries[self.next_query % len(self.queries)]
+            self.next_query += 1
+            return query
+
+    def _send(self, query):
+        start = time.perf_counter()
+        with urllib.request.urlopen(self.url + urllib.parse.quote(query), timeout=self.timeout_seconds) as response:
+            response.read()
+        return (time.perf_counter() - start) * 1000
+
+    def _worker(self, limit, deadline, record):
+        while deadline is None or time.perf_counter() < deadline:
+            query = self._take(limit)
+            if query is None:
+                return
+            try:
+                latency = self._send(query)
+            except (urllib.error.URLError, OSError):
+                if record:
+                    with self.lock:
+                        self.errors += 1
+                continue
+            if record:
+                with self.lock:
+                    self.latencies_ms.append(latency)
+
+    def run(self, concurrency, requests=None, duration=None, record=True):
+        """Sends `requests` queries (default: the log once) or keeps going for `duration` seconds."""
+        if requests is None and duration is None:
+            requests = len(self.queries)
+        limit = None if requests is None else self.next_query + requests
+        deadline = None if duration is None else time.perf_counter() + duration
+        workers = [threading.Thread(target=self._worker, args=(limit, deadline, record), daemon=True)
+                   for _ in range(concurrency)]
+        start = time.perf_counter()
+        for worker in workers:
+            worker.start()
+        for worker in workers:
+            worker.join()
+        return time.perf_counter() - start
+
+    def report(self, elapsed_seconds):
+        latencies = sorted(self.latencies_ms)
+        return {
+            "requests": len(latencies) + self.errors,
+            "errors": self.errors,
+            "elapsed_seconds": round(elapsed_seconds, 3),
+            "qps": round(len(latencies) / elapsed_seconds, 1) if elapsed_seconds > 0 else 0.0,
+            "latency_ms": {
+                "p50": round(percentile(latencies, 50), 2),
+                "p95": round(percentile(latencies, 95), 2),
+                "p99": round(percentile(latencies, 99), 2),
+                "max": round(latencies[-1], 2) if latencies else 0.0,
+            },
+        }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("log", help="Query log (JSON Lines)")
+    parser.add_argument("--url", default="http://localhost:5000", help="Ranker base URL")
+    parser.add_argument("--concurrency", type=int, default=4, help="Concurrent workers")
+    parser.add_argument("--requests", type=int, help="Queries to send, cycling through the log (default: the log once)")
+    parser.add_argument("--duration", type=float, help="Seconds to keep sending, instead of --requests")
+    parser.add_argument("--warmup", type=int, default=0, help="Queries sent first and left out of the report")
+    parser.add_argument("--timeout", type=float, default=10.0, help="Per-request timeout in seconds")
+    parser.add_argument("--json", action="store_true", help="Print the report as JSON")
+    args = parser.parse_args()
+
+    queries = load_queries(args.log)
+    if not queries:
+        sys.exit(f"No queries in {args.log}")
+
+    test = LoadTest(args.url, queries, args.timeout)
+    if args.warmup:
+        test.run(args.concurrency, requests=args.warmup, record=False)
+    elapsed = test.run(args.concurrency, requests=args.requests, duration=args.duration)
+    report = test.report(elapsed)
+
+    if args.json:
+        print(json.dumps(report))
+        return
+    latency = report["latency_ms"]
+    print(f"{report['requests']} requests ({report['errors']} errors) in {report['elapsed_seconds']} s "
+          f"with {args.concurrency} workers")
+    print(f"QPS: {report['qps']}")
+    print(f"Latency ms: p50 {latency['p50']}  p95 {latency['p95']}  p99 {latency['p99']}  max {latency['max']}")
+
+
+if __name__ == "__main__":
+    main()
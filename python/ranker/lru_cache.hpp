@@ -0,0 +1,128 @@
+#ifndef RANKER_LRU_CACHE_HPP
+#define RANKER_LRU_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ranker {
+
+struct CacheCounters {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t entries = 0;
+    uint64_t usage_bytes = 0;
+    uint64_t capacity_bytes = 0;
+};
+
+// Byte-bounded LRU cache split into independently locked shards, so concurrent queries rarely
+// contend. Values are shared immutable objects: an evicted value stays valid for whoever holds it.
+// A capacity of 0 disables the cache. All methods are thread-safe.
+template <class Value>
+class ShardedLruCache {
+public:
+    explicit ShardedLruCache(size_t capacity_bytes, size_t shard_count = 16)
+        : capacity_bytes(capacity_bytes), shards(shard_count > 0 ? shard_count : 1) {
+        shard_capacity = capacity_bytes / shards.size();
+    }
+
+    // Null on a miss.
+    std::shared_ptr<const Value> get(const std::string& key) {
+        if (shard_capacity == 0) return nullptr;
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            misses.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return it->second->value;
+    }
+
+    // Inserts or replaces `key`. `charge` is the value's approximate size in bytes; values larger
+    // than a shard are not cached.
+    void put(const std::string& key, std::shared_ptr<const Value> value, size_t charge) {
+        charge += key.size();
+        if (charge > shard_capacity) return;
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.usage -= it->second->charge;
+            shard.lru.erase(it->second);
+            shard.index.erase(it);
+        }
+        while (shard.usage + charge > shard_capacity && !shard.lru.empty()) {
+            Entry& victim = shard.lru.back();
+            shard.usage -= victim.charge;
+            shard.index.erase(victim.key);
+            shard.lru.pop_back();
+            evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+        shard.lru.push_front({key, std::move(value), charge});
+        shard.index[key] = shard.lru.begin();
+        shard.usage += charge;
+    }
+
+    void clear() {
+        for (Shard& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.index.clear();
+            shard.lru.clear();
+            shard.usage = 0;
+        }
+    }
+
+    CacheCounters counters() {
+        CacheCounters result;
+        result.hits = hits.load(std::memory_order_relaxed);
+        result.misses = misses.load(std::memory_order_relaxed);
+        result.evictions = evictions.load(std::memory_order_relaxed);
+        result.capacity_bytes = capacity_bytes;
+        for (Shard& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            result.entries += shard.index.size();
+            result.usage_bytes += shard.usage;
+        }
+        return result;
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const Value> value;
+        size_t charge;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru;  // Most recently used first
+        std::unordered_map<std::string, typename std::list<Entry>::iterator> index;
+        size_t usage = 0;
+    };
+
+    Shard& shard_for(const std::string& key) {
+        return shards[std::hash<std::string>{}(key) % shards.size()];
+    }
+
+    size_t capacity_bytes;
+    size_t shard_capacity;
+    std::vector<Shard> shards;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+};
+
+} // namespace ranker
+
+#endif // RANKER_LRU_CACHE_HPP
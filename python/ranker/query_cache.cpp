@@ -0,0 +1,81 @@
+#include "query_cache.hpp"
+
+#include <optional>
+
+namespace ranker {
+
+QueryCache::QueryCache(size_t posting_bytes, size_t result_bytes)
+    : posting_cache(posting_bytes), result_cache(result_bytes) {}
+
+// Drops every cached entry the first time a newer index generation is seen. Entries of older
+// generations that in-flight queries insert afterwards can never be hit again and just age out.
+void QueryCache::invalidate(uint64_t generation) {
+    uint64_t seen = cache_generation.load(std::memory_order_acquire);
+    while (generation > seen) {
+        if (cache_generation.compare_exchange_weak(seen, generation, std::memory_order_acq_rel)) {
+            posting_cache.clear();
+            result_cache.clear();
+            return;
+        }
+    }
+}
+
+TermPostings QueryCache::postings(const IndexSnapshot& snapshot, const std::map<std::string, uint32_t>& query_tf) {
+    invalidate(snapshot.generation);
+    std::string prefix = std::to_string(snapshot.generation) + "/";
+    TermPostings postings;
+    std::vector<std::string> missing;
+    std::vector<size_t> missing_positions;
+    for (const auto& entry : query_tf) {
+        postings.emplace_back(entry.first, posting_cache.get(prefix + entry.first));
+        if (!postings.back().second) {
+            missing.push_back(entry.first);
+            missing_positions.push_back(postings.size() - 1);
+        }
+    }
+
+    std::vector<std::optional<std::string>> values = read_values(snapshot, missing);
+    for (size_t i = 0; i < missing.size(); ++i) {
+        if (!values[i]) continue;
+        auto list = std::make_shared<const PostingList>(std::move(*values[i]));
+        posting_cache.put(prefix + missing[i], list, list->memory_usage());
+        postings[missing_positions[i]].second = std::move(list);
+    }
+    return postings;
+}
+
+std::shared_ptr<const std::vector<ScoredDoc>> QueryCache::top_k(const IndexSnapshot& snapshot, const DocStats& stats,
+                                                                const std::map<std::string, uint32_t>& query_tf,
+                                                                size_t k, QueryAlgorithm algorithm,
+                                                                const CorpusTotals* corpus) {
+    invalidate(snapshot.generation);
+    DocStats scoring = corpus ? stats.with_corpus(corpus->docs, corpus->length) : stats;
+    auto doc_freq = [&](const std::string& token) -> uint64_t {
+        if (!corpus) return 0;
+        auto it = corpus->doc_freqs.find(token);
+        return it != corpus->doc_freqs.end() ? it->second : 0;
+    };
+
+    // Every algorithm returns the same results, so it is not part of the key; N is, because the
+    // doc stats move on even when the postings a query reads do not, and so are the corpus totals
+    std::string result_key = std::to_string(snapshot.generation) + "/" + std::to_string(scoring.total_docs) + "/" +
+                             std::to_string(k);
+    if (corpus) result_key += "/" + std::to_string(corpus->length);
+    for (const auto& [token, count] : query_tf) {
+        result_key += "/" + token + "*" + std::to_string(count);
+        if (corpus) result_key += "~" + std::to_string(doc_freq(token));
+    }
+
+    std::shared_ptr<const std::vector<ScoredDoc>> top = result_cache.get(result_key);
+    if (top) return top;
+
+    std::vector<QueryTerm> terms;
+    for (auto& [token, list] : postings(snapshot, query_tf)) {
+        if (list) terms.push_back({std::move(list), query_tf.at(token), doc_freq(token)});
+    }
+    auto computed = std::make_shared<const std::vector<ScoredDoc>>(bm25_top_k(terms, scoring, k, algorithm));
+    result_cache.put(result_key, computed, computed->size() * sizeof(ScoredDoc));
+    return computed;
+}
+
+} // namespace ranker
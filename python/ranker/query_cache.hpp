@@ -0,0 +1,61 @@
+#ifndef RANKER_QUERY_CACHE_HPP
+#define RANKER_QUERY_CACHE_HPP
+
+#include "live_index.hpp"
+#include "lru_cache.hpp"
+#include "query_engine.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ranker {
+
+// Corpus totals and document frequencies a coordinator summed over every shard (term_stats()),
+// so that scores are comparable across shards.
+struct CorpusTotals {
+    uint64_t docs = 0;
+    uint64_t length = 0;
+    std::map<std::string, uint64_t> doc_freqs;  // Missing tokens fall back to this shard's list length
+};
+
+using TermPostings = std::vector<std::pair<std::string, std::shared_ptr<const PostingList>>>;
+
+// Decoded posting lists and top-k results of recent queries, keyed by the generation of the
+// snapshot they were read from. Both caches are dropped the first time a query runs on a newer
+// generation, so a refresh that makes new data visible never serves results computed before it.
+// All methods are thread-safe.
+class QueryCache {
+public:
+    // A capacity of 0 disables that cache.
+    QueryCache(size_t posting_bytes, size_t result_bytes);
+
+    // Posting lists of the query terms in `snapshot`, null for unindexed ones: cached lists first,
+    // the rest in one MultiGet.
+    TermPostings postings(const IndexSnapshot& snapshot, const std::map<std::string, uint32_t>& query_tf);
+
+    // BM25 top-k of the query (token -> count) in `snapshot`. With `corpus`, IDF and avgdl come from it
+    // instead of `stats`. Throws std::runtime_error if the index cannot be read.
+    std::shared_ptr<const std::vector<ScoredDoc>> top_k(const IndexSnapshot& snapshot, const DocStats& stats,
+                                                        const std::map<std::string, uint32_t>& query_tf, size_t k,
+                                                        QueryAlgorithm algorithm,
+                                                        const CorpusTotals* corpus = nullptr);
+
+    CacheCounters posting_counters() { return posting_cache.counters(); }
+    CacheCounters result_counters() { return result_cache.counters(); }
+
+private:
+    void invalidate(uint64_t generation);
+
+    ShardedLruCache<PostingList> posting_cache;
+    ShardedLruCache<std::vector<ScoredDoc>> result_cache;
+    std::atomic<uint64_t> cache_generation{0};
+};
+
+} // namespace ranker
+
+#endif // RANKER_QUERY_CACHE_HPP
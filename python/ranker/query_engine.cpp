@@ -0,0 +1,284 @@
+#include "query_engine.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <stdexcept>
+
+namespace ranker {
+
+namespace {
+
+// Upper bounds are inflated by this factor so rounding in the summed bounds never prunes a
+// document whose exact score would enter the top k.
+const double BOUND_SLACK = 1.0 + 1e-9;
+
+// Heap order that keeps the worst of the current top-k on top
+struct WorseFirst {
+    bool operator()(const ScoredDoc& a, const ScoredDoc& b) const {
+        if (a.score != b.score) return a.score > b.score;
+        return a.doc_id < b.doc_id;
+    }
+};
+
+class TopK {
+public:
+    explicit TopK(size_t k) : k(k) {}
+
+    // Score a document must beat to enter. Documents arrive in doc_id order, so a tie never does.
+    double threshold() const {
+        return heap.size() < k ? -std::numeric_limits<double>::infinity() : heap.top().score;
+    }
+
+    void offer(uint32_t doc_id, double score) {
+        ScoredDoc candidate{doc_id, score};
+        if (heap.size() < k) {
+            heap.push(candidate);
+        } else if (WorseFirst()(candidate, heap.top())) {
+            heap.pop();
+            heap.push(candidate);
+        }
+    }
+
+    std::vector<ScoredDoc> take() {
+        std::vector<ScoredDoc> results(heap.size());
+        for (size_t i = results.size(); i > 0; --i) {
+            results[i - 1] = heap.top();
+            heap.pop();
+        }
+        return results;
+    }
+
+private:
+    size_t k;
+    std::priority_queue<ScoredDoc, std::vector<ScoredDoc>, WorseFirst> heap;
+};
+
+struct TermCursor {
+    PostingCursor cursor;
+    double weight;       // idf * (k1 + 1) * query_tf
+    double upper_bound;  // Best score this term can add to any document
+};
+
+class Scorer {
+public:
+    Scorer(const std::vector<QueryTerm>& query, const DocStats& stats, const Bm25Params& params,
+           QueryCounters* counters)
+        : stats(stats), params(params), counters(counters),
+          avgdl(stats.avgdl > 0 ? stats.avgdl : 1.0), min_norm(norm(stats.min_length)) {
+        terms.reserve(query.size());
+        for (const QueryTerm& term : query) {
+            PostingCursor cursor(term.postings->reader(), counters);
+            if (cursor.size() == 0) continue;
+            size_t doc_freq = term.doc_freq > 0 ? static_cast<size_t>(term.doc_freq) : cursor.size();
+            double weight = bm25_idf(stats.total_docs, doc_freq) * (params.k1 + 1.0) * term.query_tf;
+            double upper_bound = bound(weight, cursor.max_tf());
+            terms.push_back({std::move(cursor), weight, upper_bound});
+        }
+    }
+
+    // k1 * (1 - b + b * dl / avgdl)
+    double norm(double doc_length) const {
+        return params.k1 * (1.0 - params.b + params.b * (doc_length / avgdl));
+    }
+
+    // Largest contribution of a term with weight `weight` to a document where it occurs at most `max_tf`
+    // times: tf / (tf + norm) grows with tf and shrinks with the document length.
+    double bound(double weight, uint32_t max_tf) const {
+        if (max_tf == 0 || weight <= 0) return 0.0;  // idf drops below 0 only with stale corpus totals
+        return weight * max_tf / (max_tf + min_norm) * BOUND_SLACK;
+    }
+
+    // Scores `doc_id` and moves every cursor positioned on it past it. Terms are summed in query
+    // order so all algorithms produce bit-identical scores.
+    void score(uint32_t doc_id, TopK& top) {
+        double doc_norm = norm(stats.length(doc_id));
+        double total = 0.0;
+        for (TermCursor& term : terms) {
+            if (term.cursor.doc() != doc_id) continue;
+            double tf = term.cursor.tf();
+            total += term.weight * tf / (tf + doc_norm);
+            term.cursor.next();
+        }
+        if (counters) ++counters->docs_scored;
+        top.offer(doc_id, total);
+    }
+
+    void exhaustive(TopK& top) {
+        while (true) {
+            uint32_t doc_id = PostingCursor::END;
+            for (const TermCursor& term : terms) doc_id = std::min(doc_id, term.cursor.doc());
+            if (doc_id == PostingCursor::END) break;
+            score(doc_id, top);
+        }
+    }
+
+    void wand(TopK& top, bool block_max) {
+        std::vector<TermCursor*> order;
+        for (TermCursor& term : terms) order.push_back(&term);
+
+        while (true) {
+            std::sort(order.begin(), order.end(),
+                      [](const TermCursor* a, const TermCursor* b) { return a->cursor.doc() < b->cursor.doc(); });
+
+            // Pivot: the first document whose summed upper bounds could beat the threshold.
+            // Every document before it only holds terms whose bounds add up to less.
+            double threshold = top.threshold();
+            double reachable = 0.0;
+            size_t pivot = order.size();
+            for (size_t i = 0; i < order.size() && order[i]->cursor.doc() != PostingCursor::END; ++i) {
+                reachable += order[i]->upper_bound;
+                if (reachable > threshold) {
+                    pivot = i;
+                    break;
+                }
+            }
+            if (pivot == order.size()) break;
+
+            uint32_t pivot_doc = order[pivot]->cursor.doc();
+            while (pivot + 1 < order.size() && order[pivot + 1]->cursor.doc() == pivot_doc) ++pivot;
+
+            if (block_max) {
+                // Tighter bound from the blocks that would hold pivot_doc. If even that cannot beat the
+                // threshold, no document before the end of the nearest of those blocks can either.
+                double block_bound = 0.0;
+                uint64_t skip_to = pivot + 1 < order.size() ? order[pivot + 1]->cursor.doc() : PostingCursor::END;
+                for (size_t i = 0; i <= pivot; ++i) {
+                    uint32_t block_end = order[i]->cursor.shallow_next_geq(pivot_doc);
+                    block_bound += bound(order[i]->weight, order[i]->cursor.shallow_max_tf());
+                    if (block_end != PostingCursor::END) skip_to = std::min<uint64_t>(skip_to, uint64_t(block_end) + 1);
+                }
+                if (block_bound <= threshold) {
+                    uint32_t target = static_cast<uint32_t>(std::min<uint64_t>(skip_to, PostingCursor::END));
+                    for (size_t i = 0; i <= pivot; ++i) order[i]->cursor.next_geq(target);
+                    continue;
+                }
+            }
+
+            if (order[0]->cursor.doc() == pivot_doc) {
+                score(pivot_doc, top);
+            } else {
+                for (size_t i = 0; i < pivot && order[i]->cursor.doc() < pivot_doc; ++i) {
+                    order[i]->cursor.next_geq(pivot_doc);
+                }
+            }
+        }
+    }
+
+private:
+    const DocStats& stats;
+    const Bm25Params& params;
+    QueryCounters* counters;
+    double avgdl;
+    double min_norm;
+    std::vector<TermCursor> terms;
+};
+
+} // namespace
+
+DocStats DocStats::from(const indexer::DocStatsView* view) {
+    DocStats stats;
+    stats.lengths = view;
+    if (view) {
+        indexer::DocStatsTotals totals = view->totals();
+        stats.total_docs = totals.total_docs;
+        if (totals.total_docs > 0) stats.avgdl = static_cast<double>(totals.total_length) / totals.total_docs;
+        // Documents without a length are scored with avgdl
+        stats.min_length = totals.min_length > 0 ? std::min<double>(totals.min_length, stats.avgdl) : 0.0;
+    }
+    return stats;
+}
+
+DocStats DocStats::with_corpus(uint64_t corpus_docs, uint64_t corpus_length) const {
+    DocStats stats = *this;
+    stats.total_docs = corpus_docs;
+    if (corpus_docs > 0) stats.avgdl = static_cast<double>(corpus_length) / corpus_docs;
+    // Documents without a length are now scored with the corpus avgdl
+    stats.min_length = std::min(min_length, stats.avgdl);
+    return stats;
+}
+
+QueryAlgorithm parse_query_algorithm(const std::string& name) {
+    if (name == "exhaustive") return QueryAlgorithm::Exhaustive;
+    if (name == "wand") return QueryAlgorithm::Wand;
+    if (name == "bmw") return QueryAlgorithm::BlockMaxWand;
+    throw std::invalid_argument("Unknown query algorithm: " + name);
+}
+
+PostingCursor::PostingCursor(const indexer::PostingListReader& reader, QueryCounters* counters)
+    : reader(reader), counters(counters) {
+    for (size_t i = 0; i < reader.block_count(); ++i) list_max_tf = std::max(list_max_tf, reader.block(i).max_tf);
+    if (counters) counters->postings_total += reader.size();
+    if (reader.block_count() > 0) load_block(0);
+}
+
+void PostingCursor::load_block(size_t i) {
+    block = i;
+    shallow_block = std::max(shallow_block, i);
+    reader.decode_block(i, block_postings);
+    if (counters) ++counters->blocks_decoded;
+    pos = 0;
+    current_doc = block_postings[0].doc_id;
+}
+
+void PostingCursor::next() {
+    if (current_doc == END) return;
+    if (++pos < block_postings.size()) {
+        current_doc = block_postings[pos].doc_id;
+    } else if (block + 1 < reader.block_count()) {
+        load_block(block + 1);
+    } else {
+        current_doc = END;
+    }
+}
+
+void PostingCursor::next_geq(uint32_t target) {
+    if (current_doc >= target) return;
+
+    size_t b = block;
+    while (b < reader.block_count() && reader.block(b).max_doc_id < target) ++b;
+    if (b == reader.block_count()) {
+        current_doc = END;
+        return;
+    }
+    if (b != block) load_block(b);
+
+    // The block's max_doc_id >= target, so this always lands on a posting
+    auto it = std::lower_bound(block_postings.begin() + pos, block_postings.end(), target,
+                               [](const indexer::Posting& p, uint32_t id) { return p.doc_id < id; });
+    pos = static_cast<size_t>(it - block_postings.begin());
+    current_doc = it->doc_id;
+}
+
+uint32_t PostingCursor::shallow_next_geq(uint32_t target) {
+    size_t b = std::max(shallow_block, block);
+    while (b < reader.block_count() && reader.block(b).max_doc_id < target) ++b;
+    shallow_block = b;
+    return b < reader.block_count() ? reader.block(b).max_doc_id : END;
+}
+
+uint32_t PostingCursor::shallow_max_tf() const {
+    return shallow_block < reader.block_count() ? reader.block(shallow_block).max_tf : 0;
+}
+
+double bm25_idf(uint64_t total_docs, size_t doc_freq) {
+    double N = total_docs > 0 ? static_cast<double>(total_docs) : 1.0;  // Empty DB: avoid a negative ratio
+    double n = static_cast<double>(doc_freq);
+    return std::log((N - n + 0.5) / (n + 0.5) + 1.0);
+}
+
+std::vector<ScoredDoc> bm25_top_k(const std::vector<QueryTerm>& terms, const DocStats& stats, size_t k,
+                                  QueryAlgorithm algorithm, const Bm25Params& params, QueryCounters* counters) {
+    if (k == 0) return {};
+
+    Scorer scorer(terms, stats, params, counters);
+    TopK top(k);
+    switch (algorithm) {
+        case QueryAlgorithm::Exhaustive: scorer.exhaustive(top); break;
+        case QueryAlgorithm::Wand: scorer.wand(top, false); break;
+        case QueryAlgorithm::BlockMaxWand: scorer.wand(top, true); break;
+    }
+    return top.take();
+}
+
+} // namespace ranker
@@ -0,0 +1,144 @@
+#ifndef RANKER_QUERY_ENGINE_HPP
+#define RANKER_QUERY_ENGINE_HPP
+
+#include "doc_stats.hpp"
+#include "posting_list.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ranker {
+
+// Corpus statistics BM25 needs, read from the indexer's doc-stats file.
+struct DocStats {
+    const indexer::DocStatsView* lengths = nullptr;  // Indexed by doc_id; none before the indexer created it
+    uint64_t total_docs = 0;
+    double avgdl = 100.0;
+    double min_length = 0.0;  // Lower bound of length() over all documents, for score upper bounds
+
+    // Snapshot of the file's totals. Without a file, every document has the default avgdl.
+    static DocStats from(const indexer::DocStatsView* view);
+
+    // The same lengths with the corpus totals of every shard, so scores are comparable across shards.
+    DocStats with_corpus(uint64_t corpus_docs, uint64_t corpus_length) const;
+
+    // Length of `doc_id`, falling back to avgdl when it is unknown (e.g. not indexed yet). Lengths are
+    // read live, so one written after this snapshot is clamped to min_length to keep score bounds valid.
+    double length(uint32_t doc_id) const {
+        uint32_t len = lengths ? lengths->length(doc_id) : 0;
+        return len > 0 ? std::max(static_cast<double>(len), min_length) : avgdl;
+    }
+};
+
+struct Bm25Params {
+    double k1 = 1.5;
+    double b = 0.75;
+};
+
+struct ScoredDoc {
+    uint32_t doc_id;
+    double score;
+};
+
+// An encoded posting list with its parsed block directory, shareable between concurrent queries.
+// Blocks are decoded by each cursor as it reaches them.
+class PostingList {
+public:
+    // Throws std::runtime_error on malformed input.
+    explicit PostingList(std::string value) : value(std::move(value)), reader_(this->value) {}
+
+    PostingList(const PostingList&) = delete;
+    PostingList& operator=(const PostingList&) = delete;
+
+    const indexer::PostingListReader& reader() const { return reader_; }
+
+    // Approximate heap footprint, for cache accounting.
+    size_t memory_usage() const {
+        return sizeof(*this) + value.capacity() + reader_.block_count() * sizeof(indexer::PostingBlockHeader);
+    }
+
+private:
+    std::string value;
+    indexer::PostingListReader reader_;  // Views `value`
+};
+
+// One query term: its posting list and how often it occurs in the query.
+struct QueryTerm {
+    std::shared_ptr<const PostingList> postings;
+    uint32_t query_tf = 1;
+    uint64_t doc_freq = 0;  // Documents containing the term in every shard, for its IDF; 0: this list's length
+};
+
+enum class QueryAlgorithm {
+    Exhaustive,    // Scores every posting; the reference the pruned modes must match
+    Wand,          // Skips documents whose summed term upper bounds cannot enter the top k
+    BlockMaxWand,  // WAND, refined with the per-block max_tf of the posting format
+};
+
+// "exhaustive", "wand" or "bmw". Throws std::invalid_argument otherwise.
+QueryAlgorithm parse_query_algorithm(const std::string& name);
+
+// Work done by one query, to compare algorithms.
+struct QueryCounters {
+    size_t postings_total = 0;   // Length of all query term lists
+    size_t docs_scored = 0;
+    size_t blocks_decoded = 0;
+};
+
+// Iterates an encoded posting list, decoding a block only when a document in it is needed.
+// Throws std::runtime_error on malformed input.
+class PostingCursor {
+public:
+    static constexpr uint32_t END = std::numeric_limits<uint32_t>::max();
+
+    // `reader` must outlive the cursor.
+    explicit PostingCursor(const indexer::PostingListReader& reader, QueryCounters* counters = nullptr);
+
+    size_t size() const { return reader.size(); }
+    uint32_t max_tf() const { return list_max_tf; }
+
+    uint32_t doc() const { return current_doc; }  // END once exhausted
+    uint32_t tf() const { return block_postings[pos].tf; }
+
+    void next();
+    // Moves to the first posting with doc_id >= target.
+    void next_geq(uint32_t target);
+
+    // Moves the block pointer to the first block that may contain `target`, without decoding it,
+    // and returns that block's max doc_id (END past the last block).
+    uint32_t shallow_next_geq(uint32_t target);
+    // max_tf of the block selected by shallow_next_geq(); 0 past the last block.
+    uint32_t shallow_max_tf() const;
+
+private:
+    void load_block(size_t i);
+
+    const indexer::PostingListReader& reader;
+    QueryCounters* counters;
+    uint32_t list_max_tf = 0;
+    size_t block = 0;          // Decoded block
+    size_t shallow_block = 0;  // Block selected by shallow_next_geq(), never behind `block`
+    size_t pos = 0;
+    uint32_t current_doc = END;
+    std::vector<indexer::Posting> block_postings;
+};
+
+// IDF(q) = log((N - n + 0.5) / (n + 0.5) + 1)
+double bm25_idf(uint64_t total_docs, size_t doc_freq);
+
+// Scores the documents matching at least one term and returns the `k` best, highest score first
+// (ties broken by lower doc_id). Documents are visited in doc_id order across all lists at once,
+// so only a k-sized heap is kept. Every algorithm returns the same documents and scores; the
+// pruned ones just score fewer of them.
+std::vector<ScoredDoc> bm25_top_k(const std::vector<QueryTerm>& terms, const DocStats& stats, size_t k,
+                                  QueryAlgorithm algorithm = QueryAlgorithm::BlockMaxWand,
+                                  const Bm25Params& params = Bm25Params(), QueryCounters* counters = nullptr);
+
+} // namespace ranker
+
+#endif // RANKER_QUERY_ENGINE_HPP
@@ -1,23 +1,60 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <rocksdb/db.h>
+#include "doc_store.hpp"
+#include "live_index.hpp"
+#include "posting_list.hpp"
+#include "query_cache.hpp"
+#include "query_engine.hpp"
+#include "snippet.hpp"
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace py = pybind11;
 
+const size_t QUERY_SNIPPET_BYTES = 200;  // As long as the indexer's lead snippets
+
 class RocksDBReader {
-    rocksdb::DB* db;
-    bool is_open;
+    // Swapped out by close(); queries running without the GIL hold their own reference
+    std::shared_ptr<ranker::LiveIndex> index;
+    std::mutex index_mutex;
+    std::string doc_stats_path;
+    std::mutex stats_mutex;
+    std::shared_ptr<const indexer::DocStatsView> doc_stats;
+    std::chrono::steady_clock::time_point last_stats_attempt;
+    ranker::QueryCache query_cache;
 public:
-    RocksDBReader(const std::string& path) : db(nullptr), is_open(false) {
-        rocksdb::Options options;
-        // Use default comparator (Bytewise)
-        rocksdb::Status status = rocksdb::DB::OpenForReadOnly(options, path, &db);
-        if (!status.ok()) {
-            throw std::runtime_error("Failed to open RocksDB: " + status.ToString());
+    // `cache_type` is "lru" or "clock". A bloom filter only helps for SST files the indexer wrote with one.
+    // With `refresh_seconds` > 0 the reader follows the indexer as a secondary instance (scratch files
+    // under `secondary_path`); with 0 it opens a read-only snapshot as of now.
+    RocksDBReader(const std::string& path, const std::string& doc_stats_path = "", size_t block_cache_mb = 256,
+                  const std::string& cache_type = "lru", int bloom_bits_per_key = 10, bool pin_l0 = true,
+                  bool mmap_reads = false, double refresh_seconds = 0, const std::string& secondary_path = "",
+                  size_t posting_cache_mb = 64, size_t result_cache_mb = 16)
+        : doc_stats_path(doc_stats_path), query_cache(posting_cache_mb << 20, result_cache_mb << 20) {
+        if (cache_type != "lru" && cache_type != "clock") {
+            throw std::invalid_argument("Unknown block cache type: " + cache_type);
         }
-        is_open = true;
+        if (refresh_seconds > 0 && secondary_path.empty()) {
+            throw std::invalid_argument("secondary_path is required to refresh the index");
+        }
+        ranker::LiveIndexOptions options;
+        options.path = path;
+        options.secondary_path = secondary_path;
+        options.refresh_interval = std::chrono::milliseconds(static_cast<int64_t>(refresh_seconds * 1000));
+        options.table.block_cache_bytes = block_cache_mb << 20;
+        options.table.clock_cache = cache_type == "clock";
+        options.table.bloom_bits_per_key = bloom_bits_per_key;
+        options.table.pin_l0_filter_and_index_blocks = pin_l0;
+        options.mmap_reads = mmap_reads;
+        index = std::make_shared<ranker::LiveIndex>(options);
     }
 
     ~RocksDBReader() {
@@ -25,33 +62,266 @@ public:
     }
 
     py::object get(const py::bytes& key) {
-        if (!is_open) return py::none();
-        
         std::string key_str = key;
         std::string value;
-        rocksdb::Status status = db->Get(rocksdb::ReadOptions(), key_str, &value);
-        
-        if (status.IsNotFound()) {
-            return py::none();
-        }
-        if (!status.ok()) {
-            throw std::runtime_error("Error reading key: " + status.ToString());
+        bool found;
+        {
+            py::gil_scoped_release release;
+            found = read_value(snapshot(), key_str, value);
         }
+        if (!found) return py::none();
         return py::bytes(value);
     }
-    
+
+    // Values of `keys` in one DB::MultiGet, None for missing keys.
+    std::vector<py::object> multi_get(const std::vector<std::string>& keys) {
+        std::vector<std::optional<std::string>> values;
+        {
+            py::gil_scoped_release release;
+            values = ranker::read_values(snapshot(), keys);
+        }
+        std::vector<py::object> result;
+        result.reserve(values.size());
+        for (auto& value : values) result.push_back(value ? py::object(py::bytes(*value)) : py::none());
+        return result;
+    }
+
+    // Doc-store entries of `doc_ids` in one MultiGet: (url, title, snippet) as bytes, or None for documents
+    // indexed before the doc store existed. Bytes, because a snippet cut mid-character is not valid UTF-8.
+    // With query `tokens`, snippets are picked around them from the documents' text records (snippet.hpp),
+    // falling back to the stored lead snippet for documents without one.
+    std::vector<py::object> get_documents(const std::vector<uint32_t>& doc_ids,
+                                          const std::vector<std::string>& tokens = {}) {
+        std::vector<std::string> keys;
+        keys.reserve(2 * doc_ids.size());
+        for (uint32_t doc_id : doc_ids) keys.push_back(indexer::doc_key(doc_id));
+        if (!tokens.empty()) {
+            for (uint32_t doc_id : doc_ids) keys.push_back(indexer::text_key(doc_id));
+        }
+        std::vector<std::optional<indexer::StoredDocument>> documents(doc_ids.size());
+        {
+            py::gil_scoped_release release;
+            // One generator per thread keeps its inflate state and buffers between queries
+            thread_local indexer::SnippetGenerator snippets;
+            std::vector<std::optional<std::string>> values = ranker::read_values(snapshot(), keys);
+            for (size_t i = 0; i < doc_ids.size(); ++i) {
+                if (!values[i]) continue;
+                documents[i] = indexer::decode_stored_document(*values[i]);
+                if (tokens.empty() || !values[doc_ids.size() + i]) continue;
+                try {
+                    documents[i]->snippet = snippets.generate(*values[doc_ids.size() + i], tokens, QUERY_SNIPPET_BYTES);
+                } catch (const std::exception&) {
+                    // Keep the lead snippet
+                }
+            }
+        }
+        std::vector<py::object> result;
+        result.reserve(documents.size());
+        for (auto& document : documents) {
+            if (!document) {
+                result.push_back(py::none());
+                continue;
+            }
+            result.push_back(py::make_tuple(py::bytes(document->url), py::bytes(document->title),
+                                            py::bytes(document->snippet)));
+        }
+        return result;
+    }
+
+    // Block cache capacity, usage and pinned usage in bytes.
+    std::map<std::string, size_t> cache_stats() {
+        std::shared_ptr<ranker::LiveIndex> current = live_index();
+        if (!current) return {};
+        const std::shared_ptr<rocksdb::Cache>& cache = current->block_cache();
+        return {{"capacity", cache->GetCapacity()},
+                {"usage", cache->GetUsage()},
+                {"pinned_usage", cache->GetPinnedUsage()}};
+    }
+
+    // Hit/miss counters and usage of the posting-list and result caches.
+    std::map<std::string, std::map<std::string, uint64_t>> query_cache_stats() {
+        auto describe = [](const ranker::CacheCounters& c) {
+            return std::map<std::string, uint64_t>{{"hits", c.hits}, {"misses", c.misses}, {"evictions", c.evictions},
+                                                   {"entries", c.entries}, {"usage_bytes", c.usage_bytes},
+                                                   {"capacity_bytes", c.capacity_bytes}};
+        };
+        return {{"postings", describe(query_cache.posting_counters())},
+                {"results", describe(query_cache.result_counters())}};
+    }
+
+    // Bumped whenever a refresh changes what queries can see.
+    uint64_t generation() {
+        std::shared_ptr<ranker::LiveIndex> current = live_index();
+        return current ? current->generation() : 0;
+    }
+
+    // Catches up with the indexer now instead of waiting for the next periodic refresh.
+    // Returns True if new data became visible.
+    bool refresh() {
+        std::shared_ptr<ranker::LiveIndex> current = live_index();
+        if (!current) return false;
+        py::gil_scoped_release release;
+        return current->refresh();
+    }
+
+    // Decoded posting list of `term` as [(doc_id, tf), ...]; empty if the term is not indexed
+    std::vector<std::pair<uint32_t, uint32_t>> get_postings(const std::string& term) {
+        std::vector<indexer::Posting> postings;
+        {
+            py::gil_scoped_release release;
+            std::string value;
+            if (read_value(snapshot(), term, value)) postings = indexer::decode_posting_list(value);
+        }
+        std::vector<std::pair<uint32_t, uint32_t>> result;
+        result.reserve(postings.size());
+        for (const indexer::Posting& posting : postings) result.emplace_back(posting.doc_id, posting.tf);
+        return result;
+    }
+
+    // Statistics of this shard a coordinator sums over all shards before searching them with the totals:
+    // {"total_docs", "total_length", "doc_freqs": {token: documents containing it}}. The posting lists
+    // read for the document frequencies are cached for the search that follows.
+    py::dict term_stats(const std::vector<std::string>& tokens) {
+        indexer::DocStatsTotals totals;
+        std::map<std::string, uint64_t> doc_freqs;
+        {
+            py::gil_scoped_release release;
+            ranker::IndexSnapshot index_view = snapshot();
+            std::shared_ptr<const indexer::DocStatsView> view = current_doc_stats();
+            if (view) totals = view->totals();
+
+            std::map<std::string, uint32_t> query_tf;
+            for (const std::string& token : tokens) ++query_tf[token];
+            for (auto& [token, postings] : query_cache.postings(index_view, query_tf)) {
+                doc_freqs[token] = postings ? postings->reader().size() : 0;
+            }
+        }
+        py::dict stats;
+        stats["total_docs"] = totals.total_docs;
+        stats["total_length"] = totals.total_length;
+        stats["doc_freqs"] = doc_freqs;
+        return stats;
+    }
+
+    // BM25 top-k for the (already tokenized) query, entirely in C++ with the GIL released.
+    // `algorithm` is "bmw" (default), "wand" or "exhaustive". With `corpus_docs` > 0, IDF and avgdl come
+    // from the given corpus totals and `doc_freqs` (summed over every shard by term_stats()) instead of
+    // this shard's. Returns [(doc_id, score), ...], best first.
+    std::vector<std::pair<uint32_t, double>> search(const std::vector<std::string>& tokens, size_t k,
+                                                    const std::string& algorithm, uint64_t corpus_docs,
+                                                    uint64_t corpus_length,
+                                                    const std::map<std::string, uint64_t>& doc_freqs) {
+        ranker::QueryAlgorithm mode = ranker::parse_query_algorithm(algorithm);
+        std::shared_ptr<const std::vector<ranker::ScoredDoc>> top;
+        {
+            py::gil_scoped_release release;
+            ranker::IndexSnapshot index_view = snapshot();
+            std::shared_ptr<const indexer::DocStatsView> view = current_doc_stats();
+            ranker::DocStats stats = ranker::DocStats::from(view.get());
+
+            // A repeated query token is fetched once and weighted by its count
+            std::map<std::string, uint32_t> query_tf;
+            for (const std::string& token : tokens) ++query_tf[token];
+
+            if (corpus_docs > 0) {
+                ranker::CorpusTotals corpus{corpus_docs, corpus_length, doc_freqs};
+                top = query_cache.top_k(index_view, stats, query_tf, k, mode, &corpus);
+            } else {
+                top = query_cache.top_k(index_view, stats, query_tf, k, mode);
+            }
+        }
+
+        std::vector<std::pair<uint32_t, double>> result;
+        result.reserve(top->size());
+        for (const ranker::ScoredDoc& doc : *top) result.emplace_back(doc.doc_id, doc.score);
+        return result;
+    }
+
     void close() {
-        if (is_open && db) {
-            delete db;
-            db = nullptr;
-            is_open = false;
+        std::shared_ptr<ranker::LiveIndex> closing;
+        {
+            std::lock_guard<std::mutex> lock(index_mutex);
+            closing = std::move(index);
+        }
+        if (closing) closing->close();
+    }
+
+    // Corpus totals from the doc-stats file, or None before the indexer has created it.
+    py::object doc_stats_totals() {
+        std::shared_ptr<const indexer::DocStatsView> view = current_doc_stats();
+        if (!view) return py::none();
+        ranker::DocStats stats = ranker::DocStats::from(view.get());
+        py::dict totals;
+        totals["total_docs"] = stats.total_docs;
+        totals["avgdl"] = stats.avgdl;
+        return totals;
+    }
+
+private:
+    std::shared_ptr<ranker::LiveIndex> live_index() {
+        std::lock_guard<std::mutex> lock(index_mutex);
+        return index;
+    }
+
+    // The DB instance for one request; its db is null once the reader is closed.
+    ranker::IndexSnapshot snapshot() {
+        std::shared_ptr<ranker::LiveIndex> current = live_index();
+        return current ? current->snapshot() : ranker::IndexSnapshot();
+    }
+
+    // The current mapping of the doc-stats file: (re)mapped once it exists and whenever the indexer
+    // grows it. Searches keep the mapping they started with alive.
+    std::shared_ptr<const indexer::DocStatsView> current_doc_stats() {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        if (doc_stats_path.empty() || (doc_stats && !doc_stats->stale())) return doc_stats;
+
+        auto now = std::chrono::steady_clock::now();
+        if (doc_stats || now - last_stats_attempt >= std::chrono::seconds(1)) {  // Missing file: retry at most 1/s
+            last_stats_attempt = now;
+            try {
+                doc_stats = std::make_shared<const indexer::DocStatsView>(doc_stats_path);
+            } catch (const std::exception&) {
+                // Not created yet, or mid-creation; keep serving with what we have
+            }
+        }
+        return doc_stats;
+    }
+
+    // False if the key does not exist or the reader is closed.
+    static bool read_value(const ranker::IndexSnapshot& snapshot, const std::string& key, std::string& value) {
+        if (!snapshot.db) return false;
+        rocksdb::Status status = snapshot.db->Get(rocksdb::ReadOptions(), key, &value);
+        if (status.IsNotFound()) {
+            return false;
+        }
+        if (!status.ok()) {
+            throw std::runtime_error("Error reading key: " + status.ToString());
         }
+        return true;
     }
 };
 
 PYBIND11_MODULE(rocksdb_client, m) {
     py::class_<RocksDBReader>(m, "RocksDBReader")
-        .def(py::init<const std::string&>())
+        .def(py::init<const std::string&, const std::string&, size_t, const std::string&, int, bool, bool, double,
+                      const std::string&, size_t, size_t>(),
+             py::arg("path"), py::arg("doc_stats_path") = "", py::arg("block_cache_mb") = 256,
+             py::arg("cache_type") = "lru", py::arg("bloom_bits_per_key") = 10, py::arg("pin_l0") = true,
+             py::arg("mmap_reads") = false, py::arg("refresh_seconds") = 0.0, py::arg("secondary_path") = "",
+             py::arg("posting_cache_mb") = 64, py::arg("result_cache_mb") = 16)
         .def("get", &RocksDBReader::get)
+        .def("multi_get", &RocksDBReader::multi_get)
+        .def("get_documents", &RocksDBReader::get_documents, py::arg("doc_ids"),
+             py::arg("tokens") = std::vector<std::string>())
+        .def("cache_stats", &RocksDBReader::cache_stats)
+        .def("query_cache_stats", &RocksDBReader::query_cache_stats)
+        .def("generation", &RocksDBReader::generation)
+        .def("refresh", &RocksDBReader::refresh)
+        .def("get_postings", &RocksDBReader::get_postings)
+        .def("doc_stats_totals", &RocksDBReader::doc_stats_totals)
+        .def("term_stats", &RocksDBReader::term_stats, py::arg("tokens"))
+        .def("search", &RocksDBReader::search, py::arg("tokens"), py::arg("k") = 10, py::arg("algorithm") = "bmw",
+             py::arg("corpus_docs") = 0, py::arg("corpus_length") = 0,
+             py::arg("doc_freqs") = std::map<std::string, uint64_t>())
         .def("close", &RocksDBReader::close);
 }
@@ -1,14 +1,21 @@
+import os
 from setuptools import setup, Extension
 import pybind11
 
+# Posting-list code shared with the indexer (the merge operator readers must register).
+# In the Docker image this resolves to /cpp/indexer/src, next to /app.
+INDEXER_SRC = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "cpp", "indexer", "src")
+
 ext_modules = [
     Extension(
         "rocksdb_client",
-        ["rocksdb_client.cpp"],
-        include_dirs=[pybind11.get_include()],
-        libraries=["rocksdb"],
+        ["rocksdb_client.cpp", "query_engine.cpp", "query_cache.cpp", "live_index.cpp",
+         os.path.join(INDEXER_SRC, "posting_list.cpp"), os.path.join(INDEXER_SRC, "doc_stats.cpp"),
+         os.path.join(INDEXER_SRC, "doc_store.cpp"), os.path.join(INDEXER_SRC, "snippet.cpp")],
+        include_dirs=[pybind11.get_include(), INDEXER_SRC],
+        libraries=["rocksdb", "z"],
         language="c++",
-        extra_compile_args=["-std=c++17"],
+        extra_compile_args=["-std=c++17", "-O3"],
     ),
 ]
 
@@ -0,0 +1,152 @@
+#include "../live_index.hpp"
+#include "posting_merge_operator.hpp"
+
+#include <rocksdb/db.h>
+
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+// Simple assertion macro
+#define ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "Assertion failed: " << (message) << "\n" \
+                      << "File: " << __FILE__ << ", Line: " << __LINE__ << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+namespace fs = std::filesystem;
+
+// The indexer's side: a primary instance at `path`
+std::unique_ptr<rocksdb::DB> open_primary(const std::string& path) {
+    rocksdb::Options options;
+    options.create_if_missing = true;
+    options.merge_operator = std::make_shared<indexer::PostingAppendOperator>();
+    fs::create_directories(path);
+    rocksdb::DB* db = nullptr;
+    rocksdb::Status status = rocksdb::DB::Open(options, path, &db);
+    ASSERT(status.ok(), "Primary should open: " + status.ToString());
+    return std::unique_ptr<rocksdb::DB>(db);
+}
+
+void put(rocksdb::DB& db, const std::string& key, const std::string& value) {
+    ASSERT(db.Put(rocksdb::WriteOptions(), key, value).ok(), "Put should succeed");
+    ASSERT(db.Flush(rocksdb::FlushOptions()).ok(), "Flush should succeed");
+}
+
+// Value of `key` in the snapshot, "" if missing
+std::string get(const ranker::IndexSnapshot& snapshot, const std::string& key) {
+    std::string value;
+    rocksdb::Status status = snapshot.db->Get(rocksdb::ReadOptions(), key, &value);
+    ASSERT(status.ok() || status.IsNotFound(), "Get should succeed: " + status.ToString());
+    return status.ok() ? value : "";
+}
+
+// Points `link` at `target` atomically, as the rebuild publishes an index
+void repoint(const fs::path& link, const fs::path& target) {
+    fs::path tmp = link.string() + ".tmp";
+    fs::remove(tmp);
+    fs::create_directory_symlink(target, tmp);
+    fs::rename(tmp, link);
+}
+
+fs::path temp_dir(const std::string& name) {
+    fs::path dir = fs::canonical(fs::temp_directory_path()) / (name + "_" + std::to_string(::getpid()));
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    return dir;
+}
+
+ranker::LiveIndexOptions live_options(const fs::path& dir, std::chrono::milliseconds refresh_interval) {
+    ranker::LiveIndexOptions options;
+    options.path = (dir / "current").string();
+    options.secondary_path = (dir / "secondary").string();
+    options.refresh_interval = refresh_interval;
+    options.table.block_cache_bytes = 1 << 20;
+    return options;
+}
+
+// --- Test: a secondary instance catches up with the indexer ---
+void test_refresh_catches_up() {
+    fs::path dir = temp_dir("live_index_catch_up");
+    std::unique_ptr<rocksdb::DB> primary = open_primary((dir / "index-a").string());
+    put(*primary, "apple", "1");
+    repoint(dir / "current", dir / "index-a");
+
+    // Refreshed by hand; the period only has to outlast the test
+    ranker::LiveIndex index(live_options(dir, std::chrono::hours(1)));
+    uint64_t generation = index.generation();
+    ranker::IndexSnapshot before = index.snapshot();
+    ASSERT(get(before, "apple") == "1", "Data written before opening should be visible");
+    ASSERT(before.generation == generation, "Snapshots should carry the current generation");
+
+    put(*primary, "banana", "2");
+    ASSERT(index.refresh(), "refresh() should report new data");
+    ASSERT(index.generation() > generation, "A refresh with new data should bump the generation");
+    ranker::IndexSnapshot after = index.snapshot();
+    ASSERT(after.generation == index.generation() && get(after, "banana") == "2",
+           "The new key should be visible after the refresh");
+
+    generation = index.generation();
+    ASSERT(!index.refresh() && index.generation() == generation, "A refresh without changes should change nothing");
+
+    index.close();
+    ASSERT(!index.snapshot().db && !index.refresh(), "A closed index should have no DB");
+    fs::remove_all(dir);
+    std::cout << "test_refresh_catches_up passed" << std::endl;
+}
+
+// --- Test: a repointed symlink swaps in the rebuilt index ---
+void test_refresh_swaps_rebuilt_index() {
+    fs::path dir = temp_dir("live_index_swap");
+    std::unique_ptr<rocksdb::DB> old_primary = open_primary((dir / "index-a").string());
+    put(*old_primary, "apple", "old");
+    repoint(dir / "current", dir / "index-a");
+
+    for (auto refresh_interval : {std::chrono::milliseconds(0), std::chrono::milliseconds(3600 * 1000)}) {
+        repoint(dir / "current", dir / "index-a");
+        ranker::LiveIndex index(live_options(dir, refresh_interval));
+        std::string mode = refresh_interval.count() == 0 ? "read-only" : "secondary";
+
+        // A query that started before the swap
+        ranker::IndexSnapshot held = index.snapshot();
+        uint64_t generation = index.generation();
+        ASSERT(get(held, "apple") == "old", mode + ": the old index should be open");
+
+        std::unique_ptr<rocksdb::DB> new_primary = open_primary((dir / ("index-b-" + mode)).string());
+        put(*new_primary, "apple", "new");
+        put(*new_primary, "cherry", "3");
+        repoint(dir / "current", dir / ("index-b-" + mode));
+
+        ASSERT(index.refresh(), mode + ": refresh() should pick up the repointed symlink");
+        ASSERT(index.generation() > generation, mode + ": a swap should bump the generation");
+        ranker::IndexSnapshot swapped = index.snapshot();
+        ASSERT(get(swapped, "apple") == "new" && get(swapped, "cherry") == "3",
+               mode + ": new snapshots should read the rebuilt index");
+
+        // The held snapshot keeps the old instance open and unchanged
+        ASSERT(get(held, "apple") == "old" && get(held, "cherry").empty(),
+               mode + ": a snapshot held across the swap should still read the old index");
+        index.close();
+        ASSERT(get(held, "apple") == "old", mode + ": a held snapshot should outlive close()");
+    }
+
+    fs::remove_all(dir);
+    std::cout << "test_refresh_swaps_rebuilt_index passed" << std::endl;
+}
+
+int main() {
+    try {
+        test_refresh_catches_up();
+        test_refresh_swaps_rebuilt_index();
+        std::cout << "All tests passed!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
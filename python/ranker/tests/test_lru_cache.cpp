@@ -0,0 +1,151 @@
+#include "../lru_cache.hpp"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Simple assertion macro
+#define ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "Assertion failed: " << (message) << "\n" \
+                      << "File: " << __FILE__ << ", Line: " << __LINE__ << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+using Cache = ranker::ShardedLruCache<std::string>;
+
+std::shared_ptr<const std::string> value(const std::string& text) {
+    return std::make_shared<const std::string>(text);
+}
+
+// Value cached under `key`, "" on a miss
+std::string get(Cache& cache, const std::string& key) {
+    std::shared_ptr<const std::string> cached = cache.get(key);
+    return cached ? *cached : "";
+}
+
+// --- Test: the least recently used entry is evicted first ---
+void test_eviction_order() {
+    // One shard, room for three entries of 10 bytes (the 1-byte key included)
+    Cache cache(30, 1);
+    cache.put("a", value("A"), 9);
+    cache.put("b", value("B"), 9);
+    cache.put("c", value("C"), 9);
+    ASSERT(get(cache, "a") == "A", "a should be cached");  // b is now the least recently used
+
+    cache.put("d", value("D"), 9);
+    ASSERT(get(cache, "b").empty(), "The least recently used entry should be evicted");
+    ASSERT(get(cache, "a") == "A" && get(cache, "c") == "C" && get(cache, "d") == "D",
+           "The other entries should stay");
+
+    ranker::CacheCounters counters = cache.counters();
+    ASSERT(counters.evictions == 1, "One entry should have been evicted");
+    ASSERT(counters.entries == 3 && counters.usage_bytes == 30, "Three entries should be charged");
+    ASSERT(counters.capacity_bytes == 30, "The capacity should be reported");
+    std::cout << "test_eviction_order passed" << std::endl;
+}
+
+// --- Test: replacing a key replaces its value and its charge ---
+void test_replace_updates_charge() {
+    Cache cache(100, 1);
+    cache.put("a", value("old"), 49);
+    cache.put("a", value("new"), 9);
+    ASSERT(get(cache, "a") == "new", "The new value should replace the old one");
+    ranker::CacheCounters counters = cache.counters();
+    ASSERT(counters.entries == 1 && counters.usage_bytes == 10, "Only the new charge should count");
+    ASSERT(counters.evictions == 0, "A replacement is not an eviction");
+
+    // The freed bytes are usable: 10 + 89 fits in 100 without evicting "a"
+    cache.put("b", value("B"), 88);
+    ASSERT(get(cache, "a") == "new" && get(cache, "b") == "B", "Both entries should fit");
+    std::cout << "test_replace_updates_charge passed" << std::endl;
+}
+
+// --- Test: a value larger than a shard is not cached and evicts nothing ---
+void test_oversized_value() {
+    Cache cache(64, 4);  // 16 bytes per shard
+    cache.put("a", value("A"), 15);
+    ASSERT(get(cache, "a") == "A", "A value filling its shard should be cached");
+
+    cache.put("big", value("B"), 14);  // 17 bytes with its key
+    ASSERT(get(cache, "big").empty(), "A value larger than a shard should not be cached");
+    ranker::CacheCounters counters = cache.counters();
+    ASSERT(counters.entries == 1 && counters.evictions == 0, "Nothing should be evicted for it");
+    std::cout << "test_oversized_value passed" << std::endl;
+}
+
+// --- Test: a capacity of 0 disables the cache ---
+void test_zero_capacity() {
+    Cache cache(0);
+    cache.put("a", value("A"), 0);
+    ASSERT(get(cache, "a").empty(), "A disabled cache should never hit");
+    ranker::CacheCounters counters = cache.counters();
+    ASSERT(counters.entries == 0 && counters.usage_bytes == 0 && counters.hits == 0,
+           "A disabled cache should hold nothing");
+    std::cout << "test_zero_capacity passed" << std::endl;
+}
+
+// --- Test: clear() drops every entry but keeps the counters ---
+void test_clear() {
+    Cache cache(1 << 10, 4);
+    for (int i = 0; i < 20; ++i) cache.put("key" + std::to_string(i), value("v"), 1);
+    ASSERT(get(cache, "key3") == "v", "Entries should be cached");
+
+    cache.clear();
+    ASSERT(get(cache, "key3").empty(), "clear() should drop the entries");
+    ranker::CacheCounters counters = cache.counters();
+    ASSERT(counters.entries == 0 && counters.usage_bytes == 0, "clear() should release the charge");
+    ASSERT(counters.hits == 1 && counters.misses == 1, "clear() should keep the counters");
+
+    cache.put("key3", value("again"), 1);
+    ASSERT(get(cache, "key3") == "again", "A cleared cache should be usable");
+    std::cout << "test_clear passed" << std::endl;
+}
+
+// --- Test: counters stay exact under concurrent gets and puts ---
+void test_concurrent_counters() {
+    const int threads = 8;
+    const int operations = 5000;
+    const int keys = 64;
+    Cache cache(16 * 100, 4);  // ~400 bytes per shard: enough churn to evict
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&cache, t] {
+            for (int i = 0; i < operations; ++i) {
+                std::string key = "key" + std::to_string((i * 7 + t) % keys);
+                std::shared_ptr<const std::string> cached = cache.get(key);
+                if (cached) {
+                    ASSERT(*cached == key, "A hit should return the value stored for its key");
+                } else {
+                    cache.put(key, std::make_shared<const std::string>(key), 30);
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    ranker::CacheCounters counters = cache.counters();
+    ASSERT(counters.hits + counters.misses == uint64_t(threads) * operations, "Every get should be counted once");
+    ASSERT(counters.misses >= uint64_t(keys), "Each key should miss at least once");
+    ASSERT(counters.usage_bytes <= counters.capacity_bytes, "Usage should stay within the capacity");
+    ASSERT(counters.entries + counters.evictions <= counters.misses,
+           "Only missed keys should have been inserted");
+    std::cout << "test_concurrent_counters passed" << std::endl;
+}
+
+int main() {
+    test_eviction_order();
+    test_replace_updates_charge();
+    test_oversized_value();
+    test_zero_capacity();
+    test_clear();
+    test_concurrent_counters();
+
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
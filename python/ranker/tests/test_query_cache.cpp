@@ -0,0 +1,178 @@
+#include "../query_cache.hpp"
+#include "posting_list.hpp"
+#include "posting_merge_operator.hpp"
+
+#include <rocksdb/db.h>
+
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Simple assertion macro
+#define ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "Assertion failed: " << (message) << "\n" \
+                      << "File: " << __FILE__ << ", Line: " << __LINE__ << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+namespace fs = std::filesystem;
+
+// The indexer's side: a primary instance at `path`
+std::unique_ptr<rocksdb::DB> open_primary(const std::string& path) {
+    rocksdb::Options options;
+    options.create_if_missing = true;
+    options.merge_operator = std::make_shared<indexer::PostingAppendOperator>();
+    fs::create_directories(path);
+    rocksdb::DB* db = nullptr;
+    rocksdb::Status status = rocksdb::DB::Open(options, path, &db);
+    ASSERT(status.ok(), "Primary should open: " + status.ToString());
+    return std::unique_ptr<rocksdb::DB>(db);
+}
+
+void put_postings(rocksdb::DB& db, const std::string& term, const std::vector<indexer::Posting>& postings) {
+    ASSERT(db.Put(rocksdb::WriteOptions(), term, indexer::encode_posting_list(postings)).ok(), "Put should succeed");
+    ASSERT(db.Flush(rocksdb::FlushOptions()).ok(), "Flush should succeed");
+}
+
+// No doc-stats file: every document has avgdl, in a shard of 100 documents
+ranker::DocStats shard_stats() {
+    ranker::DocStats stats;
+    stats.total_docs = 100;
+    return stats;
+}
+
+fs::path temp_dir(const std::string& name) {
+    fs::path dir = fs::canonical(fs::temp_directory_path()) / (name + "_" + std::to_string(::getpid()));
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    return dir;
+}
+
+// A secondary instance following the primary at dir/index, refreshed by hand
+std::unique_ptr<ranker::LiveIndex> open_live(const fs::path& dir) {
+    ranker::LiveIndexOptions options;
+    options.path = (dir / "index").string();
+    options.secondary_path = (dir / "secondary").string();
+    options.refresh_interval = std::chrono::hours(1);
+    options.table.block_cache_bytes = 1 << 20;
+    return std::make_unique<ranker::LiveIndex>(options);
+}
+
+std::vector<uint32_t> doc_ids(const std::vector<ranker::ScoredDoc>& docs) {
+    std::vector<uint32_t> ids;
+    for (const ranker::ScoredDoc& doc : docs) ids.push_back(doc.doc_id);
+    return ids;
+}
+
+// --- Test: repeated queries are served from the caches ---
+void test_repeated_query_hits() {
+    fs::path dir = temp_dir("query_cache_hits");
+    std::unique_ptr<rocksdb::DB> primary = open_primary((dir / "index").string());
+    put_postings(*primary, "apple", {{1, 2}, {4, 1}});
+    put_postings(*primary, "banana", {{4, 3}});
+    std::unique_ptr<ranker::LiveIndex> index = open_live(dir);
+
+    ranker::QueryCache cache(1 << 20, 1 << 20);
+    ranker::DocStats stats = shard_stats();
+    std::map<std::string, uint32_t> query{{"apple", 1}, {"banana", 1}};
+    auto first = cache.top_k(index->snapshot(), stats, query, 10, ranker::QueryAlgorithm::BlockMaxWand);
+    ASSERT((doc_ids(*first) == std::vector<uint32_t>{4, 1}), "Both matching documents should be found");
+
+    auto second = cache.top_k(index->snapshot(), stats, query, 10, ranker::QueryAlgorithm::Wand);
+    ASSERT(second == first, "The same query should be served from the result cache, whatever the algorithm");
+    ASSERT(cache.result_counters().hits == 1, "The result cache should count the hit");
+
+    auto other_k = cache.top_k(index->snapshot(), stats, query, 1, ranker::QueryAlgorithm::BlockMaxWand);
+    ASSERT((doc_ids(*other_k) == std::vector<uint32_t>{4}), "k should be part of the result key");
+    ASSERT(cache.posting_counters().hits == 2, "A new k should reuse the cached posting lists");
+
+    ranker::TermPostings postings = cache.postings(index->snapshot(), {{"apple", 1}, {"cherry", 1}});
+    ASSERT(postings.size() == 2 && postings[0].second && postings[0].second->reader().size() == 2,
+           "Indexed terms should get their posting list");
+    ASSERT(!postings[1].second, "An unindexed term should get none");
+    fs::remove_all(dir);
+    std::cout << "test_repeated_query_hits passed" << std::endl;
+}
+
+// --- Test: a refresh that shows new data is never answered from the old caches ---
+void test_refresh_invalidates() {
+    fs::path dir = temp_dir("query_cache_refresh");
+    std::unique_ptr<rocksdb::DB> primary = open_primary((dir / "index").string());
+    put_postings(*primary, "apple", {{1, 1}});
+    std::unique_ptr<ranker::LiveIndex> index = open_live(dir);
+
+    ranker::QueryCache cache(1 << 20, 1 << 20);
+    ranker::DocStats stats = shard_stats();
+    std::map<std::string, uint32_t> query{{"apple", 1}};
+    ranker::IndexSnapshot before = index->snapshot();
+    auto stale = cache.top_k(before, stats, query, 10, ranker::QueryAlgorithm::BlockMaxWand);
+    ASSERT((doc_ids(*stale) == std::vector<uint32_t>{1}), "The first result should have the indexed document");
+
+    // The indexer adds a better match for the same term; the reader catches up
+    put_postings(*primary, "apple", {{1, 1}, {7, 5}});
+    ASSERT(index->refresh(), "The refresh should show the new data");
+    ranker::IndexSnapshot after = index->snapshot();
+    ASSERT(after.generation > before.generation, "The refresh should bump the generation");
+
+    auto fresh = cache.top_k(after, stats, query, 10, ranker::QueryAlgorithm::BlockMaxWand);
+    ASSERT((doc_ids(*fresh) == std::vector<uint32_t>{7, 1}), "The new document should be found after the refresh");
+    ASSERT(cache.result_counters().hits == 0, "The stale result should not be served");
+    ranker::TermPostings postings = cache.postings(after, query);
+    ASSERT(postings[0].second && postings[0].second->reader().size() == 2, "The new posting list should be cached");
+
+    // The first query of the new generation dropped the old entries: only this generation's remain
+    ranker::CacheCounters results = cache.result_counters();
+    ranker::CacheCounters lists = cache.posting_counters();
+    ASSERT(results.entries == 1 && lists.entries == 1, "Entries of the old generation should be dropped");
+
+    // A query still running on the old snapshot cannot bring the stale entries back for new queries
+    cache.top_k(before, stats, query, 10, ranker::QueryAlgorithm::BlockMaxWand);
+    auto again = cache.top_k(index->snapshot(), stats, query, 10, ranker::QueryAlgorithm::BlockMaxWand);
+    ASSERT(again == fresh, "Queries on the new generation should keep getting its results");
+    fs::remove_all(dir);
+    std::cout << "test_refresh_invalidates passed" << std::endl;
+}
+
+// --- Test: corpus totals are part of the result key ---
+void test_corpus_totals_in_key() {
+    fs::path dir = temp_dir("query_cache_corpus");
+    std::unique_ptr<rocksdb::DB> primary = open_primary((dir / "index").string());
+    put_postings(*primary, "apple", {{1, 1}, {2, 1}});
+    put_postings(*primary, "banana", {{3, 1}});
+    std::unique_ptr<ranker::LiveIndex> index = open_live(dir);
+
+    ranker::QueryCache cache(1 << 20, 1 << 20);
+    ranker::DocStats stats = shard_stats();
+    std::map<std::string, uint32_t> query{{"apple", 1}, {"banana", 1}};
+    ranker::IndexSnapshot snapshot = index->snapshot();
+    auto local = cache.top_k(snapshot, stats, query, 10, ranker::QueryAlgorithm::Exhaustive);
+    ASSERT(local->front().doc_id == 3, "Locally, the rarer term should score higher");
+
+    // Across every shard, banana is the common term
+    ranker::CorpusTotals corpus{1000, 100000, {{"apple", 2}, {"banana", 900}}};
+    auto global = cache.top_k(snapshot, stats, query, 10, ranker::QueryAlgorithm::Exhaustive, &corpus);
+    ASSERT(global != local && global->back().doc_id == 3, "Corpus totals should not hit the local result");
+
+    corpus.doc_freqs["banana"] = 1;
+    auto changed = cache.top_k(snapshot, stats, query, 10, ranker::QueryAlgorithm::Exhaustive, &corpus);
+    ASSERT(changed->front().doc_id == 3, "New document frequencies should not hit the old result");
+    ASSERT(cache.result_counters().hits == 0, "Every query should have missed");
+    fs::remove_all(dir);
+    std::cout << "test_corpus_totals_in_key passed" << std::endl;
+}
+
+int main() {
+    test_repeated_query_hits();
+    test_refresh_invalidates();
+    test_corpus_totals_in_key();
+
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
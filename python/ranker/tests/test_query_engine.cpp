@@ -0,0 +1,268 @@
+#include "../query_engine.hpp"
+#include "doc_stats.hpp"
+#include "posting_list.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Simple assertion macro
+#define ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "Assertion failed: " << (message) << "\n" \
+                      << "File: " << __FILE__ << ", Line: " << __LINE__ << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+using ranker::QueryTerm;
+using ranker::ScoredDoc;
+
+std::string temp_path(const std::string& name) {
+    return "/tmp/" + name + "_" + std::to_string(::getpid()) + ".bin";
+}
+
+bool near(double a, double b) {
+    return std::fabs(a - b) <= 1e-12 * std::max(1.0, std::fabs(b));
+}
+
+QueryTerm make_term(const std::vector<indexer::Posting>& postings, uint32_t query_tf = 1, uint64_t doc_freq = 0) {
+    return {std::make_shared<const ranker::PostingList>(indexer::encode_posting_list(postings)), query_tf, doc_freq};
+}
+
+// --- Test: BM25 scores against a hand computation ---
+// N = 3 documents of lengths 10, 20 and 30 (avgdl 20); k1 = 1.5, b = 0.75.
+void test_bm25_hand_computed() {
+    std::string path = temp_path("query_engine_bm25");
+    std::remove(path.c_str());
+    indexer::DocStatsWriter writer(path);
+    writer.set_lengths({{1, 10}, {2, 20}, {3, 30}});
+    indexer::DocStatsView view(path);
+    ranker::DocStats stats = ranker::DocStats::from(&view);
+    ASSERT(stats.total_docs == 3 && stats.avgdl == 20.0 && stats.min_length == 10.0, "Stats should come from the file");
+
+    // "apple" occurs twice in doc 1 and once in doc 3: n = 2, IDF = ln((3 - 2 + 0.5) / (2 + 0.5) + 1) = ln(1.6)
+    QueryTerm apple = make_term({{1, 2}, {3, 1}});
+    double idf = std::log(1.6);
+    ASSERT(near(ranker::bm25_idf(3, 2), idf), "IDF should follow the BM25 formula");
+    // score = idf * tf * (k1 + 1) / (tf + k1 * (1 - b + b * dl / avgdl))
+    double doc1 = idf * 2 * 2.5 / (2 + 1.5 * (0.25 + 0.75 * 10 / 20));
+    double doc3 = idf * 1 * 2.5 / (1 + 1.5 * (0.25 + 0.75 * 30 / 20));
+
+    std::vector<ScoredDoc> top = ranker::bm25_top_k({apple}, stats, 10, ranker::QueryAlgorithm::Exhaustive);
+    ASSERT(top.size() == 2, "Only matching documents should be returned");
+    ASSERT(top[0].doc_id == 1 && near(top[0].score, doc1), "doc 1 should score " + std::to_string(doc1));
+    ASSERT(top[1].doc_id == 3 && near(top[1].score, doc3), "doc 3 should score " + std::to_string(doc3));
+
+    // Scores of several terms add up; doc 2 only has "banana", doc 3 has both (n = 2, IDF = ln(1.6))
+    QueryTerm banana = make_term({{2, 3}, {3, 1}});
+    double banana_idf = std::log(1.6);
+    double doc2 = banana_idf * 3 * 2.5 / (3 + 1.5 * (0.25 + 0.75 * 20 / 20));
+    double doc3_both = doc3 + banana_idf * 1 * 2.5 / (1 + 1.5 * (0.25 + 0.75 * 30 / 20));
+    top = ranker::bm25_top_k({apple, banana}, stats, 10, ranker::QueryAlgorithm::Exhaustive);
+    ASSERT(top.size() == 3, "Documents matching either term should be returned");
+    for (const ScoredDoc& doc : top) {
+        double expected = doc.doc_id == 1 ? doc1 : doc.doc_id == 2 ? doc2 : doc3_both;
+        ASSERT(near(doc.score, expected), "Term scores should add up for doc " + std::to_string(doc.doc_id));
+    }
+    ASSERT(top[0].score >= top[1].score && top[1].score >= top[2].score, "Results should be best first");
+
+    // A document without a length (not in the file yet) is scored with avgdl
+    QueryTerm cherry = make_term({{9, 1}});
+    top = ranker::bm25_top_k({cherry}, stats, 10, ranker::QueryAlgorithm::Exhaustive);
+    double doc9 = std::log(2.5 / 1.5 + 1) * 1 * 2.5 / (1 + 1.5 * (0.25 + 0.75 * 20 / 20));
+    ASSERT(top.size() == 1 && near(top[0].score, doc9), "Unknown lengths should fall back to avgdl");
+
+    std::remove(path.c_str());
+    std::cout << "test_bm25_hand_computed passed" << std::endl;
+}
+
+// --- Test: a repeated query token weighs its term by the count ---
+void test_query_tf() {
+    ranker::DocStats stats;  // No doc-stats file: N = 0 (IDF as for N = 1), every document has avgdl 100
+    QueryTerm once = make_term({{4, 1}, {5, 3}});
+    QueryTerm twice = make_term({{4, 1}, {5, 3}}, 2);
+
+    for (auto algorithm : {ranker::QueryAlgorithm::Exhaustive, ranker::QueryAlgorithm::BlockMaxWand}) {
+        std::vector<ScoredDoc> single = ranker::bm25_top_k({once}, stats, 10, algorithm);
+        std::vector<ScoredDoc> doubled = ranker::bm25_top_k({twice}, stats, 10, algorithm);
+        ASSERT(single.size() == 2 && doubled.size() == 2, "Both queries should match both documents");
+        for (size_t i = 0; i < single.size(); ++i) {
+            ASSERT(doubled[i].doc_id == single[i].doc_id && near(doubled[i].score, 2 * single[i].score),
+                   "query_tf 2 should double the term's score");
+        }
+        // Same as listing the term twice
+        std::vector<ScoredDoc> listed = ranker::bm25_top_k({once, once}, stats, 10, algorithm);
+        for (size_t i = 0; i < single.size(); ++i) {
+            ASSERT(listed[i].doc_id == doubled[i].doc_id && near(listed[i].score, doubled[i].score),
+                   "query_tf should equal repeating the term");
+        }
+    }
+    std::cout << "test_query_tf passed" << std::endl;
+}
+
+// --- Test: global IDF and avgdl from corpus totals (sharded search) ---
+void test_with_corpus() {
+    std::string path = temp_path("query_engine_corpus");
+    std::remove(path.c_str());
+    indexer::DocStatsWriter writer(path);
+    writer.set_lengths({{1, 10}, {2, 20}, {3, 30}});
+    indexer::DocStatsView view(path);
+    ranker::DocStats shard = ranker::DocStats::from(&view);
+
+    // Every shard together: N = 40 documents with 1200 words (avgdl 30)
+    ranker::DocStats global = shard.with_corpus(40, 1200);
+    ASSERT(global.total_docs == 40 && global.avgdl == 30.0, "Corpus totals should replace the shard's");
+    ASSERT(global.lengths == shard.lengths && global.length(2) == 20.0, "Lengths should stay the shard's");
+    ASSERT(global.min_length == 10.0, "min_length should stay a lower bound");
+
+    // 6 documents of the corpus contain the term, only 2 of them in this shard
+    QueryTerm term = make_term({{1, 2}, {2, 1}}, 1, 6);
+    double idf = std::log((40 - 6 + 0.5) / (6 + 0.5) + 1);
+    double doc1 = idf * 2 * 2.5 / (2 + 1.5 * (0.25 + 0.75 * 10 / 30.0));
+    double doc2 = idf * 1 * 2.5 / (1 + 1.5 * (0.25 + 0.75 * 20 / 30.0));
+    for (auto algorithm : {ranker::QueryAlgorithm::Exhaustive, ranker::QueryAlgorithm::Wand,
+                           ranker::QueryAlgorithm::BlockMaxWand}) {
+        std::vector<ScoredDoc> top = ranker::bm25_top_k({term}, global, 10, algorithm);
+        ASSERT(top.size() == 2 && top[0].doc_id == 1 && near(top[0].score, doc1) && top[1].doc_id == 2 &&
+               near(top[1].score, doc2), "Scores should use the corpus N, avgdl and doc_freq");
+    }
+
+    // Without doc_freq the list length is the document frequency
+    QueryTerm local = make_term({{1, 2}, {2, 1}});
+    double local_idf = std::log((40 - 2 + 0.5) / (2 + 0.5) + 1);
+    std::vector<ScoredDoc> top = ranker::bm25_top_k({local}, global, 1, ranker::QueryAlgorithm::Exhaustive);
+    ASSERT(top.size() == 1 && near(top[0].score, local_idf * 2 * 2.5 / (2 + 1.5 * (0.25 + 0.75 * 10 / 30.0))),
+           "doc_freq 0 should fall back to the posting list's length");
+
+    // A corpus avgdl below this shard's shortest document still bounds every length from below
+    ASSERT(shard.with_corpus(10, 50).min_length == 5.0, "min_length should not exceed the corpus avgdl");
+
+    std::remove(path.c_str());
+    std::cout << "test_with_corpus passed" << std::endl;
+}
+
+// Runs every algorithm on `terms` and requires exactly the exhaustive results: same documents in the
+// same order, bit-identical scores.
+void expect_same_results(const std::vector<QueryTerm>& terms, const ranker::DocStats& stats, size_t k,
+                         const std::string& context) {
+    std::vector<ScoredDoc> reference = ranker::bm25_top_k(terms, stats, k, ranker::QueryAlgorithm::Exhaustive);
+    for (auto algorithm : {ranker::QueryAlgorithm::Wand, ranker::QueryAlgorithm::BlockMaxWand}) {
+        std::vector<ScoredDoc> pruned = ranker::bm25_top_k(terms, stats, k, algorithm);
+        std::string name = algorithm == ranker::QueryAlgorithm::Wand ? "wand" : "bmw";
+        ASSERT(pruned.size() == reference.size(), name + " should return as many results as exhaustive: " + context);
+        for (size_t i = 0; i < reference.size(); ++i) {
+            ASSERT(pruned[i].doc_id == reference[i].doc_id && pruned[i].score == reference[i].score,
+                   name + " should match exhaustive at rank " + std::to_string(i) + ": " + context);
+        }
+    }
+}
+
+// Sorted, distinct doc_ids below `max_doc` with tfs in [1, max_tf]
+std::vector<indexer::Posting> random_postings(std::mt19937& rng, size_t count, uint32_t max_doc, uint32_t max_tf) {
+    std::vector<char> taken(max_doc, 0);
+    std::vector<indexer::Posting> postings;
+    std::uniform_int_distribution<uint32_t> doc(0, max_doc - 1), tf(1, max_tf);
+    while (postings.size() < std::min<size_t>(count, max_doc)) {
+        uint32_t id = doc(rng);
+        if (taken[id]) continue;
+        taken[id] = 1;
+        postings.push_back({id, tf(rng)});
+    }
+    std::sort(postings.begin(), postings.end(),
+              [](const indexer::Posting& a, const indexer::Posting& b) { return a.doc_id < b.doc_id; });
+    return postings;
+}
+
+// --- Test: WAND and Block-Max WAND return exactly the exhaustive top k ---
+void test_pruned_match_exhaustive() {
+    std::mt19937 rng(20240611);
+    std::string path = temp_path("query_engine_fuzz");
+    std::remove(path.c_str());
+    const uint32_t max_doc = 4000;
+    {
+        // Skewed lengths, and every 7th document without one (scored with avgdl)
+        indexer::DocStatsWriter writer(path);
+        std::vector<std::pair<uint32_t, uint32_t>> lengths;
+        std::lognormal_distribution<double> length(4.5, 0.8);
+        for (uint32_t id = 0; id < max_doc; ++id) {
+            if (id % 7 != 0) lengths.emplace_back(id, 1 + static_cast<uint32_t>(length(rng)));
+        }
+        writer.set_lengths(lengths);
+    }
+    indexer::DocStatsView view(path);
+    ranker::DocStats stats = ranker::DocStats::from(&view);
+
+    std::uniform_int_distribution<int> term_count(1, 5);
+    std::uniform_int_distribution<size_t> list_size(1, 1500);
+    std::uniform_int_distribution<uint32_t> max_tf(1, 20);
+    for (int corpus = 0; corpus < 300; ++corpus) {
+        std::vector<QueryTerm> terms;
+        int count = term_count(rng);
+        for (int t = 0; t < count; ++t) {
+            // Mix short single-block lists with long multi-block ones
+            size_t size = corpus % 3 == 0 ? list_size(rng) % indexer::POSTING_BLOCK_SIZE + 1 : list_size(rng);
+            terms.push_back(make_term(random_postings(rng, size, max_doc, max_tf(rng)), 1 + (t % 3 == 2)));
+        }
+        for (size_t k : {1, 5, 10, 100, 5000}) {
+            expect_same_results(terms, stats, k, "corpus " + std::to_string(corpus) + ", " + std::to_string(count) +
+                                                     " terms, k = " + std::to_string(k));
+        }
+    }
+    std::remove(path.c_str());
+    std::cout << "test_pruned_match_exhaustive passed" << std::endl;
+}
+
+// --- Test: the cases BOUND_SLACK has to get right ---
+void test_pruned_edge_cases() {
+    ranker::DocStats stats;  // Every document has avgdl, so equal tfs give equal scores
+
+    // Equal scores at and around the k-th slot: ties go to the lower doc_id, whichever algorithm prunes
+    std::vector<indexer::Posting> flat, flat_other;
+    for (uint32_t id = 0; id < 1000; ++id) flat.push_back({id * 3, 2});
+    for (uint32_t id = 0; id < 1000; ++id) flat_other.push_back({id * 5, 2});
+    for (size_t k : {1, 10, 128, 129, 1500}) {
+        expect_same_results({make_term(flat)}, stats, k, "one flat list, k = " + std::to_string(k));
+        expect_same_results({make_term(flat), make_term(flat_other)}, stats, k, "two flat lists, k = " + std::to_string(k));
+    }
+    std::vector<ScoredDoc> tied = ranker::bm25_top_k({make_term(flat)}, stats, 10, ranker::QueryAlgorithm::BlockMaxWand);
+    for (size_t i = 0; i < tied.size(); ++i) {
+        ASSERT(tied[i].doc_id == i * 3 && tied[i].score == tied[0].score, "Ties should keep the lowest doc_ids");
+    }
+
+    // Single-block lists, where the block bound is the list bound
+    std::vector<indexer::Posting> short_a{{1, 1}, {4, 3}, {9, 1}}, short_b{{4, 1}, {9, 5}, {12, 1}};
+    for (size_t k : {1, 2, 3}) {
+        expect_same_results({make_term(short_a), make_term(short_b)}, stats, k, "single blocks, k = " + std::to_string(k));
+    }
+
+    // k larger than the number of matching documents: every match comes back, none invented
+    std::vector<ScoredDoc> all = ranker::bm25_top_k({make_term(short_a), make_term(short_b)}, stats, 100,
+                                                    ranker::QueryAlgorithm::BlockMaxWand);
+    ASSERT(all.size() == 4, "Every matching document should be returned when k exceeds them");
+    expect_same_results({make_term(short_a), make_term(short_b)}, stats, 100, "k above the hits");
+    ASSERT(ranker::bm25_top_k({make_term(short_a)}, stats, 0).empty(), "k = 0 should return nothing");
+    std::cout << "test_pruned_edge_cases passed" << std::endl;
+}
+
+int main() {
+    try {
+        test_bm25_hand_computed();
+        test_query_tf();
+        test_with_corpus();
+        test_pruned_match_exhaustive();
+        test_pruned_edge_cases();
+        std::cout << "All tests passed!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}